@@ -64,9 +64,12 @@ struct FlagSets {
   FlagSet interpret_flags;
 };
 
-void GenerateFlagSets(InterpretOptions& interpret_options, DebugOptions& debug_options,
-                      FlagSets& flag_sets) {
+void GenerateFlagSets(FormatOptions& format_options, InterpretOptions& interpret_options,
+                      DebugOptions& debug_options, FlagSets& flag_sets) {
   flag_sets.format_flags = flag_sets.check_flags.CreateChild();
+  flag_sets.format_flags.Add<bool>("binary",
+                                   "If true, writes files in the binary IR format instead of text.",
+                                   format_options.binary);
   flag_sets.interpret_flags = flag_sets.check_flags.CreateChild();
   flag_sets.interpret_flags.Add<bool>("sanitize",
                                       "If true, performs dynamic checks during interpretation.",
@@ -164,10 +167,11 @@ ErrorCode Execute(std::vector<std::string> args, Context* ctx) {
     return ErrorCode::kNoError;
   }
 
+  FormatOptions format_options;
   InterpretOptions interpret_options;
   DebugOptions debug_options;
   FlagSets flag_sets;
-  GenerateFlagSets(interpret_options, debug_options, flag_sets);
+  GenerateFlagSets(format_options, interpret_options, debug_options, flag_sets);
 
   switch (*command) {
     case Command::kHelp:
@@ -193,7 +197,7 @@ ErrorCode Execute(std::vector<std::string> args, Context* ctx) {
     case Command::kFormat: {
       flag_sets.format_flags.Parse(args, ctx->stderr());
       std::vector<std::filesystem::path> paths = ArgsToPaths(args);
-      return Format(paths, ctx);
+      return Format(paths, format_options, ctx);
     }
     case Command::kInterpret: {
       flag_sets.interpret_flags.Parse(args, ctx->stderr());
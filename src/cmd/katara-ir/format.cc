@@ -9,12 +9,14 @@
 #include "format.h"
 
 #include "src/cmd/katara-ir/check.h"
+#include "src/ir/serialization/binary_writer.h"
 #include "src/ir/serialization/print.h"
 
 namespace cmd {
 namespace katara_ir {
 
-ErrorCode Format(std::vector<std::filesystem::path>& paths, Context* ctx) {
+ErrorCode Format(std::vector<std::filesystem::path>& paths, FormatOptions& format_options,
+                 Context* ctx) {
   ErrorCode error_code = ErrorCode::kNoError;
   for (std::filesystem::path path : paths) {
     std::variant<std::unique_ptr<ir::Program>, ErrorCode> program_or_error = Check(path, ctx);
@@ -23,8 +25,12 @@ ErrorCode Format(std::vector<std::filesystem::path>& paths, Context* ctx) {
       continue;
     }
     auto program = std::get<std::unique_ptr<ir::Program>>(std::move(program_or_error));
-    ctx->filesystem()->WriteFile(path, [&program](std::ostream* stream) {
-      ir_serialization::Print(program.get(), *stream);
+    ctx->filesystem()->WriteFile(path, [&program, &format_options](std::ostream* stream) {
+      if (format_options.binary) {
+        ir_serialization::WriteBinary(program.get(), *stream);
+      } else {
+        ir_serialization::Print(program.get(), *stream);
+      }
     });
   }
   return error_code;
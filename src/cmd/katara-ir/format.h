@@ -18,7 +18,12 @@
 namespace cmd {
 namespace katara_ir {
 
-ErrorCode Format(std::vector<std::filesystem::path>& paths, Context* ctx);
+struct FormatOptions {
+  bool binary = false;
+};
+
+ErrorCode Format(std::vector<std::filesystem::path>& paths, FormatOptions& format_options,
+                 Context* ctx);
 
 }
 }  // namespace cmd
@@ -13,6 +13,7 @@
 
 #include "src/common/positions/positions.h"
 #include "src/ir/issues/issues.h"
+#include "src/ir/serialization/binary_reader.h"
 #include "src/ir/serialization/parse.h"
 
 namespace cmd {
@@ -21,6 +22,17 @@ namespace katara_ir {
 ParseDetails ParseWithDetails(std::filesystem::path path, Context* ctx) {
   ParseDetails result;
   std::string code = ctx->filesystem()->ReadContentsOfFile(path);
+  if (ir_serialization::BinaryProgramReader::HasBinaryFormat(code)) {
+    std::unique_ptr<ir_serialization::BinaryProgramReader> reader =
+        ir_serialization::BinaryProgramReader::FromData(std::move(code));
+    if (reader == nullptr) {
+      result.error_code = ErrorCode::kParseFailed;
+      return result;
+    }
+    result.program = reader->ReadProgram();
+    result.error_code = ErrorCode::kNoError;
+    return result;
+  }
   common::positions::File* file = result.file_set.AddFile(path, code);
   result.program = ir_serialization::ParseProgram(file, result.issue_tracker);
   if (result.program == nullptr || !result.issue_tracker.issues().empty()) {
@@ -8,17 +8,33 @@
 
 #include "build.h"
 
+#include <optional>
 #include <unordered_map>
 
 #include "src/cmd/katara/load.h"
+#include "src/common/concurrency/thread_pool.h"
 #include "src/ir/analyzers/func_call_graph_builder.h"
 #include "src/ir/analyzers/interference_graph_builder.h"
 #include "src/ir/analyzers/live_range_analyzer.h"
 #include "src/ir/check/check.h"
+#include "src/ir/check/check_cache.h"
 #include "src/ir/info/func_call_graph.h"
 #include "src/ir/info/func_live_ranges.h"
 #include "src/ir/info/interference_graph.h"
+#include "src/ir/optimizers/constant_propagation_optimizer.h"
+#include "src/ir/optimizers/dead_code_optimizer.h"
+#include "src/ir/optimizers/devirtualization_optimizer.h"
 #include "src/ir/optimizers/func_call_graph_optimizer.h"
+#include "src/ir/optimizers/if_conversion_optimizer.h"
+#include "src/ir/optimizers/inlining_optimizer.h"
+#include "src/ir/optimizers/loop_invariant_code_motion_optimizer.h"
+#include "src/ir/optimizers/loop_unrolling_optimizer.h"
+#include "src/ir/optimizers/memory_access_optimizer.h"
+#include "src/ir/optimizers/stack_allocation_optimizer.h"
+#include "src/ir/optimizers/strength_reduction_optimizer.h"
+#include "src/ir/optimizers/tail_call_optimizer.h"
+#include "src/ir/optimizers/value_numbering_optimizer.h"
+#include "src/ir/processors/phi_resolver.h"
 #include "src/ir/representation/func.h"
 #include "src/ir/representation/num_types.h"
 #include "src/ir/serialization/print.h"
@@ -30,6 +46,9 @@
 #include "src/lang/processors/ir/optimizers/unique_pointer_to_local_value_optimizer.h"
 #include "src/lang/processors/packages/package.h"
 #include "src/lang/processors/packages/package_manager.h"
+#include "src/x86_64/elf_writer.h"
+#include "src/x86_64/ir_translator/ir_translator.h"
+#include "src/x86_64/optimizers/peephole_optimizer.h"
 
 namespace cmd {
 namespace katara {
@@ -71,7 +90,8 @@ void GenerateIrDebugInfo(ir::Program* program, std::string iter, DebugHandler& d
 }
 
 std::variant<std::unique_ptr<ir::Program>, ErrorCode> BuildIrProgram(
-    std::vector<std::filesystem::path>& paths, DebugHandler& debug_handler, Context* ctx) {
+    std::vector<std::filesystem::path>& paths, ::ir_check::CheckOptions check_options,
+    DebugHandler& debug_handler, Context* ctx) {
   std::variant<LoadResult, ErrorCode> load_result_or_error = Load(paths, debug_handler, ctx);
   if (std::holds_alternative<ErrorCode>(load_result_or_error)) {
     return std::get<ErrorCode>(load_result_or_error);
@@ -97,7 +117,7 @@ std::variant<std::unique_ptr<ir::Program>, ErrorCode> BuildIrProgram(
     // TODO: actually generate IR positions
     common::positions::FileSet ir_file_set;
     ir_issues::IssueTracker issue_tracker(&ir_file_set);
-    ::lang::ir_check::CheckProgram(program.get(), issue_tracker);
+    ::lang::ir_check::CheckProgram(program.get(), issue_tracker, check_options);
     if (!issue_tracker.issues().empty()) {
       *ctx->stderr() << "init IR program has issues:\n";
       issue_tracker.PrintIssues(common::issues::Format::kTerminal, ctx->stderr());
@@ -107,7 +127,8 @@ std::variant<std::unique_ptr<ir::Program>, ErrorCode> BuildIrProgram(
   return program;
 }
 
-void OptimizeIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Context* ctx) {
+void OptimizeIrExtProgram(ir::Program* program, ::ir_check::CheckOptions check_options,
+                          DebugHandler& debug_handler, Context* ctx) {
   lang::ir_optimizers::ConvertSharedToUniquePointersInProgram(program);
   lang::ir_optimizers::ConvertUniquePointersToLocalValuesInProgram(program);
   if (debug_handler.GenerateDebugInfo()) {
@@ -119,7 +140,7 @@ void OptimizeIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Con
     // TODO: actually generate IR positions
     common::positions::FileSet ir_file_set;
     ir_issues::IssueTracker issue_tracker(&ir_file_set);
-    ::lang::ir_check::CheckProgram(program, issue_tracker);
+    ::lang::ir_check::CheckProgram(program, issue_tracker, check_options);
     if (!issue_tracker.issues().empty()) {
       *ctx->stderr() << "ext_optimized IR program has issues:\n";
       issue_tracker.PrintIssues(common::issues::Format::kTerminal, ctx->stderr());
@@ -127,7 +148,8 @@ void OptimizeIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Con
   }
 }
 
-void LowerIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Context* ctx) {
+void LowerIrExtProgram(ir::Program* program, ::ir_check::CheckOptions check_options,
+                       DebugHandler& debug_handler, Context* ctx) {
   lang::ir_lowerers::LowerSharedPointersInProgram(program);
   lang::ir_lowerers::LowerUniquePointersInProgram(program);
   if (debug_handler.GenerateDebugInfo()) {
@@ -139,7 +161,7 @@ void LowerIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Contex
     // TODO: actually generate IR positions
     common::positions::FileSet ir_file_set;
     ir_issues::IssueTracker issue_tracker(&ir_file_set);
-    ::lang::ir_check::CheckProgram(program, issue_tracker);
+    ::lang::ir_check::CheckProgram(program, issue_tracker, check_options);
     if (!issue_tracker.issues().empty()) {
       *ctx->stderr() << "lowered IR program has issues:\n";
       issue_tracker.PrintIssues(common::issues::Format::kTerminal, ctx->stderr());
@@ -147,8 +169,32 @@ void LowerIrExtProgram(ir::Program* program, DebugHandler& debug_handler, Contex
   }
 }
 
-void OptimizeIrProgram(ir::Program* program, DebugHandler& debug_handler, Context* ctx) {
+void OptimizeIrProgram(ir::Program* program, BuildOptions& options,
+                       ::ir_check::CheckOptions check_options, DebugHandler& debug_handler,
+                       Context* ctx) {
+  if (options.optimization_level >= 1) {
+    ir_optimizers::DevirtualizeCallsInProgram(program);
+  }
+  if (options.optimization_level >= 2) {
+    ir_optimizers::InlineFuncCallsInProgram(program);
+  }
   ir_optimizers::RemoveUnusedFunctions(program);
+  if (options.optimization_level >= 1) {
+    ir_optimizers::EliminateSelfTailCallsInProgram(program);
+    ir_optimizers::PropagateConstantsInProgram(program);
+    ir_optimizers::ReplaceNonEscapingAllocationsInProgram(program);
+    ir_optimizers::RemoveRedundantComputationsInProgram(program);
+    ir_optimizers::RemoveRedundantMemoryAccessesInProgram(program);
+    if (options.optimization_level >= 2) {
+      ir_optimizers::HoistLoopInvariantCodeInProgram(program);
+      ir_optimizers::ReduceStrengthInProgram(program);
+      ir_optimizers::ConvertIfsInProgram(program);
+    }
+    if (options.optimization_level >= 3) {
+      ir_optimizers::UnrollLoopsInProgram(program);
+    }
+    ir_optimizers::RemoveDeadCodeInProgram(program);
+  }
   if (debug_handler.GenerateDebugInfo()) {
     GenerateIrDebugInfo(program, "optimized", debug_handler);
   }
@@ -156,7 +202,7 @@ void OptimizeIrProgram(ir::Program* program, DebugHandler& debug_handler, Contex
     // TODO: actually generate IR positions
     common::positions::FileSet ir_file_set;
     ir_issues::IssueTracker issue_tracker(&ir_file_set);
-    ::ir_check::CheckProgram(program, issue_tracker);
+    ::ir_check::CheckProgram(program, issue_tracker, check_options);
     if (!issue_tracker.issues().empty()) {
       *ctx->stderr() << "optimized IR program has issues:\n";
       issue_tracker.PrintIssues(common::issues::Format::kTerminal, ctx->stderr());
@@ -164,28 +210,126 @@ void OptimizeIrProgram(ir::Program* program, DebugHandler& debug_handler, Contex
   }
 }
 
+void GenerateX86_64DebugInfo(
+    ir::Program* ir_program,
+    std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph>& interference_graphs,
+    ir_to_x86_64_translator::TranslationResults& translation_results, DebugHandler& debug_handler) {
+  debug_handler.WriteToDebugFile(translation_results.program->ToString(), /* subdir_name= */ "",
+                                 "x86_64.asm.txt");
+
+  for (auto& func : ir_program->funcs()) {
+    std::string subdir_name = SubdirNameForFunc(func.get());
+
+    const ir::func_num_t ir_func_num = func->number();
+    const x86_64::func_num_t x86_64_func_num =
+        translation_results.ir_to_x86_64_func_nums.at(ir_func_num);
+    const x86_64::Func* x86_64_func =
+        translation_results.program->DefinedFuncWithNumber(x86_64_func_num);
+    const ir_info::InterferenceGraph& func_interference_graph =
+        interference_graphs.at(func->number());
+    const ir_info::InterferenceGraphColors& func_interference_graph_colors =
+        translation_results.interference_graph_colors.at(func->number());
+
+    debug_handler.WriteToDebugFile(x86_64_func->ToString(), subdir_name, "x86_64.asm.txt");
+    debug_handler.WriteToDebugFile(
+        func_interference_graph.ToGraph(&func_interference_graph_colors).ToDotFormat(), subdir_name,
+        "x86_64.interference_graph.dot");
+    debug_handler.WriteToDebugFile(func_interference_graph_colors.ToString(), subdir_name,
+                                   "x86_64.colors.txt");
+  }
+}
+
 }  // namespace
 
 std::variant<std::unique_ptr<ir::Program>, ErrorCode> Build(
     std::vector<std::filesystem::path>& paths, BuildOptions& options, DebugHandler& debug_handler,
     Context* ctx) {
+  // Funcs get checked concurrently. The lang checks share a cache, such that funcs unchanged
+  // between stages do not get checked again.
+  std::optional<common::concurrency::ThreadPool> check_thread_pool;
+  if (debug_handler.CheckIr()) {
+    check_thread_pool.emplace(options.jobs);
+  }
+  ::ir_check::CheckCache lang_check_cache;
+  ::ir_check::CheckOptions lang_check_options{
+      .thread_pool = check_thread_pool ? &check_thread_pool.value() : nullptr,
+      .cache = &lang_check_cache,
+  };
+  ::ir_check::CheckOptions check_options{
+      .thread_pool = lang_check_options.thread_pool,
+  };
+
   std::variant<std::unique_ptr<ir::Program>, ErrorCode> program_or_error =
-      BuildIrProgram(paths, debug_handler, ctx);
+      BuildIrProgram(paths, lang_check_options, debug_handler, ctx);
   if (std::holds_alternative<ErrorCode>(program_or_error)) {
     return std::get<ErrorCode>(program_or_error);
   }
   auto ir_program = std::get<std::unique_ptr<ir::Program>>(std::move(program_or_error));
 
   if (options.optimize_ir_ext) {
-    OptimizeIrExtProgram(ir_program.get(), debug_handler, ctx);
+    OptimizeIrExtProgram(ir_program.get(), lang_check_options, debug_handler, ctx);
   }
-  LowerIrExtProgram(ir_program.get(), debug_handler, ctx);
+  LowerIrExtProgram(ir_program.get(), lang_check_options, debug_handler, ctx);
   if (options.optimize_ir) {
-    OptimizeIrProgram(ir_program.get(), debug_handler, ctx);
+    OptimizeIrProgram(ir_program.get(), options, check_options, debug_handler, ctx);
   }
 
   return std::move(ir_program);
 }
 
+std::unique_ptr<x86_64::Program> BuildX86_64Program(ir::Program* ir_program, BuildOptions& options,
+                                                    DebugHandler& debug_handler) {
+  common::concurrency::ThreadPool thread_pool(options.jobs);
+  const std::size_t func_count = ir_program->funcs().size();
+
+  std::vector<std::optional<const ir_info::FuncLiveRanges>> func_live_ranges(func_count);
+  std::vector<std::optional<const ir_info::InterferenceGraph>> func_interference_graphs(func_count);
+  common::concurrency::ParallelFor(thread_pool, func_count, [&](int64_t i) {
+    ir::Func* func = ir_program->funcs().at(i).get();
+    const ir_info::FuncLiveRanges& live_ranges =
+        func_live_ranges.at(i).emplace(ir_analyzers::FindLiveRangesForFunc(func));
+    func_interference_graphs.at(i).emplace(
+        ir_analyzers::BuildInterferenceGraphForFunc(func, live_ranges));
+    ir_processors::ResolvePhisInFunc(func);
+  });
+
+  std::unordered_map<ir::func_num_t, const ir_info::FuncLiveRanges> live_ranges;
+  std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph> interference_graphs;
+  for (std::size_t i = 0; i < func_count; i++) {
+    ir::func_num_t func_num = ir_program->funcs().at(i)->number();
+    live_ranges.insert({func_num, *func_live_ranges.at(i)});
+    interference_graphs.insert({func_num, *func_interference_graphs.at(i)});
+  }
+
+  ir_to_x86_64_translator::TranslationResults translation_results =
+      ir_to_x86_64_translator::Translate(ir_program, live_ranges, interference_graphs,
+                                         debug_handler.GenerateDebugInfo(), &thread_pool);
+  if (options.optimization_level >= 1) {
+    x86_64_optimizers::OptimizePeepholesInProgram(translation_results.program.get());
+  }
+  if (debug_handler.GenerateDebugInfo()) {
+    GenerateX86_64DebugInfo(ir_program, interference_graphs, translation_results, debug_handler);
+  }
+  return std::move(translation_results.program);
+}
+
+ErrorCode WriteOutput(ir::Program* ir_program, BuildOptions& options, OutputOptions& output_options,
+                      DebugHandler& debug_handler, Context* ctx) {
+  if (output_options.output_path.empty()) {
+    return kNoError;
+  }
+  std::unique_ptr<x86_64::Program> x86_64_program =
+      BuildX86_64Program(ir_program, options, debug_handler);
+  if (output_options.object_file) {
+    ctx->filesystem()->WriteContentsOfFile(output_options.output_path,
+                                           x86_64::WriteObjectFile(x86_64_program.get()));
+  } else {
+    ctx->filesystem()->WriteContentsOfFile(output_options.output_path,
+                                           x86_64::WriteExecutable(x86_64_program.get()));
+    ctx->filesystem()->MakeExecutable(output_options.output_path);
+  }
+  return kNoError;
+}
+
 }  // namespace katara
 }  // namespace cmd
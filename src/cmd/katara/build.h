@@ -9,6 +9,7 @@
 #ifndef katara_build_h
 #define katara_build_h
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
 #include <variant>
@@ -26,12 +27,33 @@ namespace katara {
 struct BuildOptions {
   bool optimize_ir_ext = true;
   bool optimize_ir = true;
+  // 0: only removes unused funcs, 1: also devirtualizes indirect calls with few possible callees,
+  // turns self tail calls into loops, propagates constants, allocates non-escaping objects on the
+  // stack or in registers, removes redundant and dead computations, forwards stored values to
+  // loads, removes dead stores and applies x86-64 peephole optimizations, 2: also inlines func
+  // calls, hoists loop invariant computations, reduces induction variable strength and hoists the
+  // computations of small branches to enable conditional moves, 3: also unrolls small counted loops
+  int64_t optimization_level = 1;
+  int64_t jobs = 0;  // zero selects one job per hardware thread
+};
+
+struct OutputOptions {
+  std::filesystem::path output_path;  // empty if no output should be written
+  bool object_file = false;           // relocatable object file instead of static executable
 };
 
 std::variant<std::unique_ptr<ir::Program>, ErrorCode> Build(
     std::vector<std::filesystem::path>& paths, BuildOptions& options, DebugHandler& debug_handler,
     Context* ctx);
 
+// Translates the IR program to x86-64, resolving phis in the IR program.
+std::unique_ptr<x86_64::Program> BuildX86_64Program(ir::Program* ir_program, BuildOptions& options,
+                                                    DebugHandler& debug_handler);
+
+// Writes the program as an ELF64 file to the output path (if set).
+ErrorCode WriteOutput(ir::Program* ir_program, BuildOptions& options, OutputOptions& output_options,
+                      DebugHandler& debug_handler, Context* ctx);
+
 }  // namespace katara
 }  // namespace cmd
 
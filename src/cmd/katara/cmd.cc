@@ -60,13 +60,15 @@ std::optional<Command> ParseCommand(std::string command) {
 struct FlagSets {
   FlagSet debug_flags;
   FlagSet build_flags;
+  FlagSet output_flags;
   FlagSet doc_flags;
   FlagSet interpret_flags;
   FlagSet run_flags;
 };
 
 void GenerateFlagSets(DebugConfig& debug_config, BuildOptions& build_options,
-                      InterpretOptions& interpret_options, FlagSets& flag_sets) {
+                      OutputOptions& output_options, InterpretOptions& interpret_options,
+                      FlagSets& flag_sets) {
   flag_sets.debug_flags.Add<bool>("debug_output",
                                   "If true, debug information will be written in the directory "
                                   "specified with -debug_output_path.",
@@ -86,6 +88,31 @@ void GenerateFlagSets(DebugConfig& debug_config, BuildOptions& build_options,
   flag_sets.build_flags.Add<bool>(
       "optimize_ir", "If true, optimizes the program based on the intermediate representation.",
       build_options.optimize_ir);
+  flag_sets.build_flags.Add<int64_t>(
+      "optimization_level",
+      "The level of optimizations based on the intermediate representation (if enabled). Zero only "
+      "removes unused functions, one also devirtualizes indirect calls with few possible callees, "
+      "turns self tail calls into loops, propagates constants, allocates non-escaping objects on "
+      "the stack or in registers, removes redundant and dead computations, forwards stored values "
+      "to loads, and removes dead stores, two also inlines function calls, hoists loop invariant "
+      "computations, reduces the strength of induction variables, and hoists the computations of "
+      "small branches to enable conditional moves, three also unrolls small counted loops.",
+      build_options.optimization_level);
+  flag_sets.build_flags.Add<int64_t>(
+      "jobs",
+      "The number of threads used for building the program. Zero selects one thread per hardware "
+      "thread. The build result does not depend on the number of threads.",
+      build_options.jobs);
+
+  flag_sets.output_flags = flag_sets.build_flags.CreateChild();
+  flag_sets.output_flags.Add<std::filesystem::path>(
+      "o", "The file the built x86-64 program gets written to. No file is written if empty.",
+      output_options.output_path);
+  flag_sets.output_flags.Add<bool>(
+      "object_file",
+      "If true, writes a relocatable ELF object file (to be linked with a C runtime providing "
+      "malloc and free) instead of a static ELF executable.",
+      output_options.object_file);
 
   flag_sets.doc_flags = flag_sets.debug_flags.CreateChild();
   flag_sets.interpret_flags = flag_sets.build_flags.CreateChild();
@@ -148,7 +175,7 @@ void PrintHelpForArgs(std::vector<std::string> args, FlagSets& flag_sets, Contex
   }
   switch (*command) {
     case Command::kBuild:
-      PrintHelpForCommand("build", /*has_args=*/true, &flag_sets.build_flags, ctx);
+      PrintHelpForCommand("build", /*has_args=*/true, &flag_sets.output_flags, ctx);
       break;
     case Command::kDoc:
       PrintHelpForCommand("doc", /*has_args=*/true, &flag_sets.doc_flags, ctx);
@@ -185,9 +212,10 @@ ErrorCode Execute(std::vector<std::string> args, Context* ctx) {
 
   DebugConfig debug_config;
   BuildOptions build_options;
+  OutputOptions output_options;
   InterpretOptions interpret_options;
   FlagSets flag_sets;
-  GenerateFlagSets(debug_config, build_options, interpret_options, flag_sets);
+  GenerateFlagSets(debug_config, build_options, output_options, interpret_options, flag_sets);
 
   switch (*command) {
     case Command::kHelp:
@@ -197,16 +225,17 @@ ErrorCode Execute(std::vector<std::string> args, Context* ctx) {
       Version(ctx);
       return kNoError;
     case Command::kBuild: {
-      flag_sets.build_flags.Parse(args, ctx->stderr());
+      flag_sets.output_flags.Parse(args, ctx->stderr());
       std::vector<std::filesystem::path> paths = ArgsToPaths(args);
       DebugHandler debug_handler(debug_config, ctx);
       std::variant<std::unique_ptr<ir::Program>, ErrorCode> program_or_error =
           Build(paths, build_options, debug_handler, ctx);
       if (std::holds_alternative<ErrorCode>(program_or_error)) {
         return std::get<ErrorCode>(program_or_error);
-      } else {
-        return kNoError;
       }
+      std::unique_ptr<ir::Program> program =
+          std::get<std::unique_ptr<ir::Program>>(std::move(program_or_error));
+      return WriteOutput(program.get(), build_options, output_options, debug_handler, ctx);
     }
     case Command::kDoc: {
       flag_sets.doc_flags.Parse(args, ctx->stderr());
@@ -38,6 +38,9 @@ constexpr bool IsUnsigned(IntType type) { return !IsSigned(type); }
 constexpr IntType ToSigned(IntType type);
 constexpr IntType ToUnsigned(IntType type);
 
+// Returns whether every value of the int type can be converted to the result type.
+constexpr bool CanConvertAllValues(IntType type, IntType result_type);
+
 std::optional<IntType> ToIntType(std::string_view str);
 std::string ToString(IntType type);
 
@@ -233,6 +236,13 @@ constexpr IntType ToUnsigned(IntType type) {
   }
 }
 
+constexpr bool CanConvertAllValues(IntType type, IntType result_type) {
+  if (IsSigned(type) == IsSigned(result_type)) {
+    return BitSizeOf(type) <= BitSizeOf(result_type);
+  }
+  return IsUnsigned(type) && BitSizeOf(type) < BitSizeOf(result_type);
+}
+
 constexpr Int Bool::ConvertTo(IntType type, bool a) {
   switch (type) {
     case IntType::kI8:
@@ -416,6 +416,18 @@ TEST(IntTest, HandlesConversion) {
 #pragma clang diagnostic pop
 }
 
+TEST(IntTypeTest, CanConvertAllValues) {
+  EXPECT_TRUE(CanConvertAllValues(IntType::kI8, IntType::kI8));
+  EXPECT_TRUE(CanConvertAllValues(IntType::kI8, IntType::kI64));
+  EXPECT_TRUE(CanConvertAllValues(IntType::kU8, IntType::kU32));
+  EXPECT_TRUE(CanConvertAllValues(IntType::kU16, IntType::kI32));
+  EXPECT_TRUE(CanConvertAllValues(IntType::kU32, IntType::kI64));
+  EXPECT_FALSE(CanConvertAllValues(IntType::kI64, IntType::kI32));
+  EXPECT_FALSE(CanConvertAllValues(IntType::kU16, IntType::kU8));
+  EXPECT_FALSE(CanConvertAllValues(IntType::kU32, IntType::kI32));
+  EXPECT_FALSE(CanConvertAllValues(IntType::kI8, IntType::kU64));
+}
+
 TEST(IntTest, HandlesNegUnaryOp) {
   struct TestCase {
     int64_t num;
@@ -0,0 +1,151 @@
+//
+//  thread_pool.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "thread_pool.h"
+
+#include "src/common/logging/logging.h"
+
+namespace common::concurrency {
+
+using ::common::logging::fail;
+
+namespace {
+
+// Identifies the worker executing on the current thread, if any. Tasks submitted from a worker
+// get pushed to the queue of that worker.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local int64_t current_worker_index = -1;
+
+}  // namespace
+
+ThreadPool::ThreadPool(int64_t thread_count) {
+  if (thread_count < 0) {
+    fail("thread pool constructed with negative thread count");
+  } else if (thread_count == 0) {
+    thread_count = std::max(int64_t{std::thread::hardware_concurrency()}, int64_t{1});
+  }
+  thread_count_ = thread_count;
+  if (thread_count_ == 1) {
+    return;
+  }
+  workers_.reserve(thread_count_);
+  for (int64_t i = 0; i < thread_count_; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (int64_t i = 0; i < thread_count_; i++) {
+    workers_.at(i)->thread = std::thread(&ThreadPool::RunWorker, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  tasks_available_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  if (workers_.empty()) {
+    task();
+    return;
+  }
+  int64_t worker_index;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_pool == this) {
+      worker_index = current_worker_index;
+    } else {
+      worker_index = next_worker_index_;
+      next_worker_index_ = (next_worker_index_ + 1) % thread_count_;
+    }
+    queued_tasks_++;
+    pending_tasks_++;
+  }
+  Worker* worker = workers_.at(worker_index).get();
+  {
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    worker->tasks.push_back(std::move(task));
+  }
+  tasks_available_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  if (workers_.empty()) {
+    return;
+  } else if (current_pool == this) {
+    fail("thread pool waited on from one of its workers");
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  tasks_finished_.wait(lock, [this] { return pending_tasks_ == 0; });
+}
+
+void ThreadPool::RunWorker(int64_t worker_index) {
+  current_pool = this;
+  current_worker_index = worker_index;
+  while (true) {
+    if (std::optional<std::function<void()>> task = TakeTask(worker_index); task.has_value()) {
+      (*task)();
+      FinishTask();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    tasks_available_.wait(lock, [this] { return stopping_ || queued_tasks_ > 0; });
+    if (stopping_ && queued_tasks_ == 0) {
+      return;
+    }
+  }
+}
+
+std::optional<std::function<void()>> ThreadPool::TakeTask(int64_t worker_index) {
+  std::optional<std::function<void()>> task;
+  // Take the most recently pushed task from the own queue, otherwise steal the oldest task from
+  // another worker:
+  for (int64_t i = 0; i < thread_count_ && !task.has_value(); i++) {
+    Worker* worker = workers_.at((worker_index + i) % thread_count_).get();
+    std::unique_lock<std::mutex> lock(worker->mutex);
+    if (worker->tasks.empty()) {
+      continue;
+    } else if (i == 0) {
+      task = std::move(worker->tasks.back());
+      worker->tasks.pop_back();
+    } else {
+      task = std::move(worker->tasks.front());
+      worker->tasks.pop_front();
+    }
+  }
+  if (task.has_value()) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queued_tasks_--;
+  }
+  return task;
+}
+
+void ThreadPool::FinishTask() {
+  bool finished_all_tasks;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    pending_tasks_--;
+    finished_all_tasks = (pending_tasks_ == 0);
+  }
+  if (finished_all_tasks) {
+    tasks_finished_.notify_all();
+  }
+}
+
+void ParallelFor(ThreadPool& pool, int64_t count, std::function<void(int64_t)> f) {
+  for (int64_t i = 0; i < count; i++) {
+    pool.Submit([&f, i] { f(i); });
+  }
+  pool.Wait();
+}
+
+}  // namespace common::concurrency
@@ -0,0 +1,68 @@
+//
+//  thread_pool.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef common_concurrency_thread_pool_h
+#define common_concurrency_thread_pool_h
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace common::concurrency {
+
+// ThreadPool runs submitted tasks on a fixed set of worker threads. Each worker owns a task queue;
+// idle workers steal tasks from the queues of other workers. A pool with a single thread does not
+// start any workers and runs tasks on the submitting thread instead.
+class ThreadPool {
+ public:
+  // A thread count of zero selects one thread per hardware thread.
+  explicit ThreadPool(int64_t thread_count = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  int64_t thread_count() const { return thread_count_; }
+
+  void Submit(std::function<void()> task);
+  void Wait();
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    std::thread thread;
+  };
+
+  void RunWorker(int64_t worker_index);
+  std::optional<std::function<void()>> TakeTask(int64_t worker_index);
+  void FinishTask();
+
+  int64_t thread_count_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  int64_t next_worker_index_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable tasks_available_;
+  std::condition_variable tasks_finished_;
+  int64_t queued_tasks_ = 0;
+  int64_t pending_tasks_ = 0;
+  bool stopping_ = false;
+};
+
+// Calls f for every index in [0, count) on the given pool and returns once all calls completed.
+void ParallelFor(ThreadPool& pool, int64_t count, std::function<void(int64_t)> f);
+
+}  // namespace common::concurrency
+
+#endif /* common_concurrency_thread_pool_h */
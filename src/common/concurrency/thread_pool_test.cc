@@ -0,0 +1,92 @@
+//
+//  thread_pool_test.cc
+//  Katara-tests
+//
+//  Created by Arne Philipeit on 11/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/common/concurrency/thread_pool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace common::concurrency {
+
+TEST(ThreadPoolTest, SingleThreadPoolRunsTasksOnCallingThread) {
+  ThreadPool pool(/*thread_count=*/1);
+  EXPECT_EQ(pool.thread_count(), 1);
+
+  std::thread::id task_thread_id;
+  pool.Submit([&task_thread_id] { task_thread_id = std::this_thread::get_id(); });
+  pool.Wait();
+
+  EXPECT_EQ(task_thread_id, std::this_thread::get_id());
+}
+
+TEST(ThreadPoolTest, DefaultThreadCountIsPositive) {
+  ThreadPool pool;
+  EXPECT_GE(pool.thread_count(), 1);
+}
+
+TEST(ThreadPoolTest, RunsAllSubmittedTasks) {
+  ThreadPool pool(/*thread_count=*/4);
+  std::atomic<int64_t> sum = 0;
+  for (int64_t i = 1; i <= 1000; i++) {
+    pool.Submit([&sum, i] { sum += i; });
+  }
+  pool.Wait();
+
+  EXPECT_EQ(sum, 500500);
+}
+
+TEST(ThreadPoolTest, RunsTasksSubmittedFromTasks) {
+  ThreadPool pool(/*thread_count=*/4);
+  std::atomic<int64_t> count = 0;
+  for (int64_t i = 0; i < 10; i++) {
+    pool.Submit([&pool, &count] {
+      for (int64_t j = 0; j < 10; j++) {
+        pool.Submit([&count] { count++; });
+      }
+      count++;
+    });
+  }
+  pool.Wait();
+
+  EXPECT_EQ(count, 110);
+}
+
+TEST(ThreadPoolTest, CanBeReusedAfterWait) {
+  ThreadPool pool(/*thread_count=*/3);
+  std::atomic<int64_t> count = 0;
+  for (int64_t round = 0; round < 5; round++) {
+    for (int64_t i = 0; i < 20; i++) {
+      pool.Submit([&count] { count++; });
+    }
+    pool.Wait();
+    EXPECT_EQ(count, 20 * (round + 1));
+  }
+}
+
+TEST(ParallelForTest, CallsFunctionOnceForEachIndex) {
+  ThreadPool pool(/*thread_count=*/4);
+  std::vector<int64_t> calls(100, 0);
+  ParallelFor(pool, calls.size(), [&calls](int64_t i) { calls.at(i)++; });
+
+  for (int64_t call_count : calls) {
+    EXPECT_EQ(call_count, 1);
+  }
+}
+
+TEST(ParallelForTest, HandlesZeroCount) {
+  ThreadPool pool(/*thread_count=*/2);
+  bool called = false;
+  ParallelFor(pool, 0, [&called](int64_t) { called = true; });
+
+  EXPECT_FALSE(called);
+}
+
+}  // namespace common::concurrency
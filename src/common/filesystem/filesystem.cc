@@ -15,6 +15,17 @@ namespace common::filesystem {
 std::string Filesystem::ReadContentsOfFile(std::filesystem::path path) const {
   std::string contents;
   ReadFile(path, [&](std::istream* stream) {
+    // Read seekable streams with a single bulk read instead of character by character:
+    if (stream->seekg(0, std::ios::end)) {
+      std::streamoff size = stream->tellg();
+      if (size >= 0 && stream->seekg(0, std::ios::beg)) {
+        contents.resize(size);
+        stream->read(contents.data(), size);
+        contents.resize(stream->gcount());
+        return;
+      }
+    }
+    stream->clear();
     contents = std::string(std::istreambuf_iterator<char>(*stream), {});
   });
   return contents;
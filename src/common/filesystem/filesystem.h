@@ -36,6 +36,7 @@ class Filesystem {
   virtual void ReadFile(std::filesystem::path path,
                         std::function<void(std::istream*)> reader) const = 0;
   virtual void WriteFile(std::filesystem::path path, std::function<void(std::ostream*)> writer) = 0;
+  virtual void MakeExecutable(std::filesystem::path path) = 0;
 
   std::string ReadContentsOfFile(std::filesystem::path path) const;
   void WriteContentsOfFile(std::filesystem::path path, std::string contents);
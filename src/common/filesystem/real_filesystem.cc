@@ -117,6 +117,18 @@ void RealFilesystem::WriteFile(std::filesystem::path path,
   writer(&stream);
 }
 
+void RealFilesystem::MakeExecutable(std::filesystem::path path) {
+  std::error_code ec;
+  std::filesystem::permissions(path,
+                               std::filesystem::perms::owner_exec |
+                                   std::filesystem::perms::group_exec |
+                                   std::filesystem::perms::others_exec,
+                               std::filesystem::perm_options::add, ec);
+  if (ec) {
+    fail("could not make " + path.string() + " executable: " + ErrorCodeToString(ec));
+  }
+}
+
 void RealFilesystem::Remove(std::filesystem::path path) {
   std::error_code ec;
   std::filesystem::remove(path, ec);
@@ -36,6 +36,7 @@ class RealFilesystem : public Filesystem {
   void ReadFile(std::filesystem::path path,
                 std::function<void(std::istream*)> reader) const override;
   void WriteFile(std::filesystem::path path, std::function<void(std::ostream*)> writer) override;
+  void MakeExecutable(std::filesystem::path path) override;
 
   void Remove(std::filesystem::path path) override;
   void RemoveAll(std::filesystem::path path) override;
@@ -244,6 +244,11 @@ void TestFilesystem::WriteFile(std::filesystem::path path,
   file->contents = ss.str();
 }
 
+void TestFilesystem::MakeExecutable(std::filesystem::path path) {
+  // The test filesystem does not track permissions, the file only has to exist.
+  GetFile(path);
+}
+
 void TestFilesystem::Remove(std::filesystem::path path) {
   path = Absolute(path);
   Directory* parent = GetDirectory(path.parent_path());
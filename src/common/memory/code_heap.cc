@@ -0,0 +1,109 @@
+//
+//  code_heap.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "code_heap.h"
+
+#include <sys/mman.h>
+
+#include "src/common/logging/logging.h"
+
+namespace common::memory {
+
+using ::common::logging::fail;
+
+namespace {
+
+int64_t RoundUp(int64_t value, int64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+CodeHeap::CodeHeap(int64_t reserved_size, bool use_huge_pages) {
+  if (reserved_size <= 0) {
+    fail("CodeHeap constructed with non-positive size");
+  }
+  reserved_size_ = RoundUp(reserved_size, kSegmentSize);
+  // Over-reserve by one huge page, such that the heap can start at a huge page boundary.
+  mapping_size_ = reserved_size_ + (use_huge_pages ? kHugePageSize : 0);
+  void* mapping_base = mmap(/*addr=*/NULL, mapping_size_, PROT_NONE,
+                            /*flags=*/MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                            /*fildes=*/-1, /*offset=*/0);
+  if (mapping_base == (void*)-1) {
+    fail("mmap failed");
+  }
+  mapping_base_ = (uint8_t*)mapping_base;
+  base_ = mapping_base_;
+  if (use_huge_pages) {
+    base_ = (uint8_t*)RoundUp((int64_t)mapping_base_, kHugePageSize);
+#ifdef MADV_HUGEPAGE
+    // Transparent huge pages are only a hint, the heap works without them.
+    madvise(base_, reserved_size_, MADV_HUGEPAGE);
+#endif
+  }
+}
+
+CodeHeap::~CodeHeap() {
+  if (mapping_base_ != nullptr && munmap(mapping_base_, mapping_size_) != 0) {
+    fail("munmap failed");
+  }
+}
+
+data::DataView CodeHeap::BeginAllocation(int64_t max_size, int64_t alignment) {
+  if (!(permissions_ & kWrite)) {
+    fail("CodeHeap allocation requires write permissions");
+  } else if (allocation_start_ != -1) {
+    fail("CodeHeap allocation started before previous allocation ended");
+  } else if (max_size < 0) {
+    fail("CodeHeap allocation with negative size");
+  } else if (alignment <= 0 || (alignment & (alignment - 1)) != 0 || alignment > kPageSize) {
+    fail("CodeHeap allocation with invalid alignment");
+  }
+  int64_t start = RoundUp(used_size_, alignment);
+  Commit(start + max_size);
+  allocation_start_ = start;
+  allocation_max_size_ = max_size;
+  return data::DataView(base_ + start, max_size);
+}
+
+void CodeHeap::EndAllocation(int64_t used_size) {
+  if (allocation_start_ == -1) {
+    fail("CodeHeap allocation ended without being started");
+  } else if (used_size < 0 || used_size > allocation_max_size_) {
+    fail("CodeHeap allocation used more memory than requested");
+  }
+  used_size_ = allocation_start_ + used_size;
+  allocation_start_ = -1;
+  allocation_max_size_ = 0;
+}
+
+void CodeHeap::ChangePermissions(Permissions new_permissions) {
+  if ((new_permissions & kExecute) && new_permissions != kExecute) {
+    fail("Invalid permissions");
+  }
+  if (committed_size_ > 0 && mprotect(base_, committed_size_, new_permissions) != 0) {
+    fail("mprotect failed");
+  }
+  permissions_ = new_permissions;
+}
+
+void CodeHeap::Commit(int64_t required_size) {
+  if (required_size <= committed_size_) {
+    return;
+  }
+  int64_t new_committed_size = RoundUp(required_size, kSegmentSize);
+  if (new_committed_size > reserved_size_) {
+    fail("CodeHeap exhausted reserved memory");
+  }
+  if (mprotect(base_ + committed_size_, new_committed_size - committed_size_, permissions_) != 0) {
+    fail("mprotect failed");
+  }
+  committed_size_ = new_committed_size;
+}
+
+}  // namespace common::memory
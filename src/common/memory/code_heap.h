@@ -0,0 +1,69 @@
+//
+//  code_heap.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef common_code_heap_h
+#define common_code_heap_h
+
+#include <cstdint>
+
+#include "src/common/data/data_view.h"
+#include "src/common/memory/memory.h"
+
+namespace common::memory {
+
+constexpr int64_t kCacheLineSize = 64;
+constexpr int64_t kHugePageSize = 1 << 21;
+
+// Holds generated machine code. The heap reserves a large range of address space upfront and
+// commits it in segments as code gets added, so that the heap can grow without moving code that
+// was already emitted and all code stays within rel32 range of each other. Committed memory is
+// never writable and executable at the same time.
+class CodeHeap {
+ public:
+  static constexpr int64_t kDefaultReservedSize = int64_t{1} << 30;
+  static constexpr int64_t kSegmentSize = kHugePageSize;
+
+  // Reserves reserved_size bytes of address space. If use_huge_pages is set, the reserved range
+  // gets aligned to huge pages and the kernel gets advised to back it with transparent huge pages.
+  CodeHeap(int64_t reserved_size = kDefaultReservedSize, bool use_huge_pages = false);
+  CodeHeap(CodeHeap&) = delete;
+  CodeHeap& operator=(CodeHeap&) = delete;
+  ~CodeHeap();
+
+  // Returns all bytes allocated so far, including alignment padding.
+  data::DataView code() const { return data::DataView(base_, used_size_); }
+  int64_t committed_size() const { return committed_size_; }
+  Permissions permissions() const { return permissions_; }
+
+  // Starts an allocation of at most max_size bytes at the given alignment and returns the memory
+  // available to it. The heap has to be writable. EndAllocation has to be called with the number
+  // of bytes actually used before the next allocation starts.
+  data::DataView BeginAllocation(int64_t max_size, int64_t alignment = kCacheLineSize);
+  void EndAllocation(int64_t used_size);
+
+  // Changes the permissions of all committed segments. Segments committed later on inherit the
+  // permissions.
+  void ChangePermissions(Permissions new_permissions);
+
+ private:
+  void Commit(int64_t required_size);
+
+  uint8_t* mapping_base_ = nullptr;
+  int64_t mapping_size_ = 0;
+  uint8_t* base_ = nullptr;
+  int64_t reserved_size_ = 0;
+  int64_t committed_size_ = 0;
+  int64_t used_size_ = 0;
+  int64_t allocation_start_ = -1;
+  int64_t allocation_max_size_ = 0;
+  Permissions permissions_ = kWrite;
+};
+
+}  // namespace common::memory
+
+#endif /* common_code_heap_h */
@@ -0,0 +1,95 @@
+//
+//  code_heap_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/common/memory/code_heap.h"
+
+#include "gtest/gtest.h"
+
+namespace common::memory {
+
+TEST(CodeHeapTest, ConstructorCommitsNothing) {
+  CodeHeap heap;
+  EXPECT_NE(heap.code().base(), nullptr);
+  EXPECT_EQ(heap.code().size(), 0);
+  EXPECT_EQ(heap.committed_size(), 0);
+  EXPECT_EQ(heap.permissions(), Permissions::kWrite);
+}
+
+TEST(CodeHeapTest, AllocationsAreAligned) {
+  CodeHeap heap;
+  data::DataView a = heap.BeginAllocation(/*max_size=*/100);
+  EXPECT_EQ(a.size(), 100);
+  EXPECT_EQ((intptr_t)a.base() % kCacheLineSize, 0);
+  a[0] = 1;
+  a[12] = 2;
+  heap.EndAllocation(/*used_size=*/13);
+  EXPECT_EQ(heap.code().size(), 13);
+
+  data::DataView b = heap.BeginAllocation(/*max_size=*/100);
+  EXPECT_EQ(b.base(), a.base() + kCacheLineSize);
+  b[0] = 3;
+  heap.EndAllocation(/*used_size=*/1);
+  EXPECT_EQ(heap.code().size(), kCacheLineSize + 1);
+
+  data::DataView c = heap.BeginAllocation(/*max_size=*/8, /*alignment=*/1);
+  EXPECT_EQ(c.base(), b.base() + 1);
+  heap.EndAllocation(/*used_size=*/0);
+
+  EXPECT_EQ(heap.code()[0], 1);
+  EXPECT_EQ(heap.code()[1], 0);
+  EXPECT_EQ(heap.code()[12], 2);
+  EXPECT_EQ(heap.code()[kCacheLineSize], 3);
+  EXPECT_EQ(heap.committed_size(), CodeHeap::kSegmentSize);
+}
+
+TEST(CodeHeapTest, GrowsAcrossSegments) {
+  CodeHeap heap(/*reserved_size=*/CodeHeap::kSegmentSize * 4);
+  uint8_t* base = heap.code().base();
+  for (int i = 0; i < 5; i++) {
+    data::DataView code = heap.BeginAllocation(/*max_size=*/CodeHeap::kSegmentSize / 2 + 1);
+    code[0] = 42 + i;
+    code[code.size() - 1] = 42 + i;
+    heap.EndAllocation(code.size());
+  }
+  EXPECT_EQ(heap.code().base(), base);
+  EXPECT_EQ(heap.committed_size(), CodeHeap::kSegmentSize * 3);
+  heap.ChangePermissions(Permissions::kRead);
+  EXPECT_EQ(heap.code()[0], 42);
+  EXPECT_EQ(heap.code()[heap.code().size() - 1], 46);
+}
+
+TEST(CodeHeapTest, HugePageHeapStartsAtHugePageBoundary) {
+  CodeHeap heap(/*reserved_size=*/CodeHeap::kSegmentSize * 2, /*use_huge_pages=*/true);
+  EXPECT_EQ((intptr_t)heap.code().base() % kHugePageSize, 0);
+  data::DataView code = heap.BeginAllocation(/*max_size=*/kPageSize);
+  code[kPageSize - 1] = 7;
+  heap.EndAllocation(kPageSize);
+  heap.ChangePermissions(Permissions::kExecute);
+  heap.ChangePermissions(Permissions::kRead);
+  EXPECT_EQ(heap.code()[kPageSize - 1], 7);
+}
+
+TEST(CodeHeapDeathTest, RejectsWritableAndExecutablePermissions) {
+  CodeHeap heap;
+  EXPECT_DEATH(heap.ChangePermissions(Permissions(Permissions::kWrite | Permissions::kExecute)),
+               "Invalid permissions");
+}
+
+TEST(CodeHeapDeathTest, RejectsAllocationWhenExecutable) {
+  CodeHeap heap;
+  heap.ChangePermissions(Permissions::kExecute);
+  EXPECT_DEATH(heap.BeginAllocation(/*max_size=*/8), "requires write permissions");
+}
+
+TEST(CodeHeapDeathTest, RejectsAllocationBeyondReservedSize) {
+  CodeHeap heap(/*reserved_size=*/CodeHeap::kSegmentSize);
+  EXPECT_DEATH(heap.BeginAllocation(/*max_size=*/CodeHeap::kSegmentSize + 1),
+               "exhausted reserved memory");
+}
+
+}  // namespace common::memory
@@ -8,6 +8,9 @@
 
 #include "positions.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace common::positions {
 
 bool Position::IsValid() const { return line_ > 0; }
@@ -34,7 +37,7 @@ std::string Position::ToString() const {
 
 File::File(std::string name, pos_t start, std::string contents) {
   name_ = name;
-  contents_ = contents;
+  contents_ = std::move(contents);
   line_starts_.push_back(start);
 
   for (pos_t i = 0; i < int64_t(contents_.length()); i++) {
@@ -66,12 +69,8 @@ int64_t File::LineNumberFor(pos_t pos) const {
   if (pos < start() || pos > end()) {
     return 0;
   }
-  for (size_t i = 0; i < line_starts_.size() - 1; i++) {
-    if (line_starts_.at(i) <= pos && pos < line_starts_.at(i + 1)) {
-      return i + 1;
-    }
-  }
-  return line_starts_.size();
+  auto it = std::upper_bound(line_starts_.begin(), line_starts_.end(), pos);
+  return it - line_starts_.begin();
 }
 
 std::string File::LineFor(pos_t pos) const {
@@ -119,7 +118,7 @@ File* FileSet::AddFile(std::string name, std::string contents) {
     auto& last_file = files_.back();
     p = last_file->end() + 1;
   }
-  files_.push_back(std::unique_ptr<File>(new File(name, p, contents)));
+  files_.push_back(std::unique_ptr<File>(new File(name, p, std::move(contents))));
   return files_.back().get();
 }
 
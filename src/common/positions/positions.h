@@ -44,7 +44,7 @@ class File {
   std::string name() const { return name_; }
   pos_t start() const { return line_starts_.front(); }
   pos_t end() const { return line_starts_.front() + contents_.length(); }
-  std::string contents() const { return contents_; }
+  const std::string& contents() const { return contents_; }
   std::string contents(pos_t start, pos_t end) const;
   char at(pos_t pos) const;
 
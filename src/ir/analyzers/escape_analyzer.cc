@@ -0,0 +1,260 @@
+//
+//  escape_analyzer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "escape_analyzer.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/analyzers/func_call_graph_builder.h"
+#include "src/ir/analyzers/func_values_builder.h"
+#include "src/ir/info/func_call_graph.h"
+#include "src/ir/info/func_values.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_analyzers {
+namespace {
+
+using ::ir_info::EscapeKind;
+
+bool IsValue(const ir::Value* value, ir::value_num_t value_num) {
+  if (value->kind() == ir::Value::Kind::kInherited) {
+    value = static_cast<const ir::InheritedValue*>(value)->value().get();
+  }
+  return value->kind() == ir::Value::Kind::kComputed &&
+         static_cast<const ir::Computed*>(value)->number() == value_num;
+}
+
+// Returns if the value can only hold the root pointer itself, and not a pointer derived from it
+// or any other pointer.
+bool OnlyHoldsRoot(ir::value_num_t value_num, ir::value_num_t root_num,
+                   const ir_info::FuncValues& func_values,
+                   std::unordered_set<ir::value_num_t>& visited) {
+  if (value_num == root_num || !visited.insert(value_num).second) {
+    return true;
+  }
+  ir::Instr* defining_instr = func_values.GetInstrDefiningValue(value_num);
+  if (defining_instr == nullptr) {
+    return false;
+  }
+  if (defining_instr->instr_kind() != ir::InstrKind::kMov &&
+      defining_instr->instr_kind() != ir::InstrKind::kPhi) {
+    return false;
+  }
+  for (std::shared_ptr<ir::Value> origin : defining_instr->UsedValues()) {
+    if (origin->kind() == ir::Value::Kind::kInherited) {
+      origin = std::static_pointer_cast<ir::InheritedValue>(origin)->value();
+    }
+    if (origin->kind() != ir::Value::Kind::kComputed ||
+        !OnlyHoldsRoot(static_cast<ir::Computed*>(origin.get())->number(), root_num, func_values,
+                       visited)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class FuncEscapeAnalyzer {
+ public:
+  FuncEscapeAnalyzer(const ir::Func* func, const ir_info::FuncCallGraph& func_call_graph,
+                     const ir_info::EscapeInfo& escape_info)
+      : func_(func),
+        func_call_graph_(func_call_graph),
+        escape_info_(escape_info),
+        func_values_(FindValuesInFunc(func)) {}
+
+  // Root values are the allocations and pointer args of the func.
+  EscapeKind FindEscapeKindOfRoot(ir::value_num_t root_num, bool is_arg) const;
+
+ private:
+  EscapeKind FindEscapeKindOfUse(ir::Instr* instr, ir::value_num_t value_num,
+                                 ir::value_num_t root_num, bool is_arg,
+                                 std::vector<ir::value_num_t>& derived_values) const;
+  EscapeKind FindEscapeKindOfCallArg(ir::CallInstr* call_instr, std::size_t arg_index) const;
+
+  const ir::Func* func_;
+  const ir_info::FuncCallGraph& func_call_graph_;
+  const ir_info::EscapeInfo& escape_info_;
+  const ir_info::FuncValues func_values_;
+};
+
+EscapeKind FuncEscapeAnalyzer::FindEscapeKindOfRoot(ir::value_num_t root_num, bool is_arg) const {
+  EscapeKind kind = EscapeKind::kNoEscape;
+  std::unordered_set<ir::value_num_t> visited{root_num};
+  std::vector<ir::value_num_t> worklist{root_num};
+  while (!worklist.empty() && kind != EscapeKind::kGlobalEscape) {
+    ir::value_num_t value_num = worklist.back();
+    worklist.pop_back();
+
+    std::vector<ir::value_num_t> derived_values;
+    for (ir::Instr* instr : func_values_.GetInstrsUsingValue(value_num)) {
+      kind =
+          std::max(kind, FindEscapeKindOfUse(instr, value_num, root_num, is_arg, derived_values));
+    }
+    for (ir::value_num_t derived_value : derived_values) {
+      if (visited.insert(derived_value).second) {
+        worklist.push_back(derived_value);
+      }
+    }
+  }
+  return kind;
+}
+
+EscapeKind FuncEscapeAnalyzer::FindEscapeKindOfUse(
+    ir::Instr* instr, ir::value_num_t value_num, ir::value_num_t root_num, bool is_arg,
+    std::vector<ir::value_num_t>& derived_values) const {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov:
+    case ir::InstrKind::kPhi:
+      derived_values.push_back(static_cast<ir::Computation*>(instr)->result()->number());
+      return EscapeKind::kNoEscape;
+    case ir::InstrKind::kPointerOffset: {
+      auto pointer_offset_instr = static_cast<ir::PointerOffsetInstr*>(instr);
+      if (IsValue(pointer_offset_instr->pointer().get(), value_num)) {
+        derived_values.push_back(pointer_offset_instr->result()->number());
+      }
+      return EscapeKind::kNoEscape;
+    }
+    case ir::InstrKind::kNilTest:
+    case ir::InstrKind::kLoad:
+      return EscapeKind::kNoEscape;
+    case ir::InstrKind::kStore: {
+      auto store_instr = static_cast<ir::StoreInstr*>(instr);
+      return IsValue(store_instr->value().get(), value_num) ? EscapeKind::kGlobalEscape
+                                                            : EscapeKind::kNoEscape;
+    }
+    case ir::InstrKind::kFree: {
+      // Frees of allocations in their own func do not let them escape, as long as the freed value
+      // can only hold the allocation. Frees of args always count as escapes, since the memory
+      // does not outlive the call in that case, but the caller can not remove the free.
+      if (is_arg) {
+        return EscapeKind::kGlobalEscape;
+      }
+      std::unordered_set<ir::value_num_t> visited;
+      return OnlyHoldsRoot(value_num, root_num, func_values_, visited) ? EscapeKind::kNoEscape
+                                                                       : EscapeKind::kGlobalEscape;
+    }
+    case ir::InstrKind::kCall: {
+      auto call_instr = static_cast<ir::CallInstr*>(instr);
+      EscapeKind kind = EscapeKind::kNoEscape;
+      for (std::size_t i = 0; i < call_instr->args().size(); i++) {
+        if (IsValue(call_instr->args().at(i).get(), value_num)) {
+          kind = std::max(kind, FindEscapeKindOfCallArg(call_instr, i));
+        }
+      }
+      return kind;
+    }
+    default:
+      // Returns, syscalls, conversions, and all other uses might let the pointer escape:
+      return EscapeKind::kGlobalEscape;
+  }
+}
+
+EscapeKind FuncEscapeAnalyzer::FindEscapeKindOfCallArg(ir::CallInstr* call_instr,
+                                                        std::size_t arg_index) const {
+  ir_info::FuncCall* func_call = func_call_graph_.FuncCallAtInstr(call_instr);
+  if (func_call == nullptr || func_call->callees().empty()) {
+    return EscapeKind::kGlobalEscape;
+  }
+  for (ir::func_num_t callee_num : func_call->callees()) {
+    if (escape_info_.GetArgEscapeKind(callee_num, arg_index) == EscapeKind::kGlobalEscape) {
+      return EscapeKind::kGlobalEscape;
+    }
+  }
+  return EscapeKind::kArgEscape;
+}
+
+std::vector<EscapeKind> FindArgEscapeKinds(const ir::Func* func,
+                                           const ir_info::FuncCallGraph& func_call_graph,
+                                           const ir_info::EscapeInfo& escape_info) {
+  FuncEscapeAnalyzer analyzer(func, func_call_graph, escape_info);
+  std::vector<EscapeKind> kinds;
+  kinds.reserve(func->args().size());
+  for (const std::shared_ptr<ir::Computed>& arg : func->args()) {
+    if (arg->type() != ir::pointer_type()) {
+      kinds.push_back(EscapeKind::kNoEscape);
+      continue;
+    }
+    kinds.push_back(analyzer.FindEscapeKindOfRoot(arg->number(), /*is_arg=*/true));
+  }
+  return kinds;
+}
+
+void FindAllocationEscapeKinds(const ir::Func* func, const ir_info::FuncCallGraph& func_call_graph,
+                               ir_info::EscapeInfo& escape_info) {
+  FuncEscapeAnalyzer analyzer(func, func_call_graph, escape_info);
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() != ir::InstrKind::kMalloc) {
+        continue;
+      }
+      ir::value_num_t allocation = static_cast<ir::MallocInstr*>(instr.get())->result()->number();
+      escape_info.SetAllocationEscapeKind(
+          func->number(), allocation, analyzer.FindEscapeKindOfRoot(allocation, /*is_arg=*/false));
+    }
+  }
+}
+
+}  // namespace
+
+const ir_info::EscapeInfo FindEscapesInProgram(const ir::Program* program) {
+  const ir_info::FuncCallGraph func_call_graph = BuildFuncCallGraphForProgram(program);
+  ir_info::EscapeInfo escape_info;
+
+  // Args start out as not escaping and only get promoted to greater escape kinds, until a fixed
+  // point is reached. Processing callees before callers makes few iterations necessary.
+  std::deque<ir::func_num_t> worklist;
+  std::unordered_set<ir::func_num_t> queued;
+  for (ir_info::Component* component : func_call_graph.ComponentsInBottomUpOrder()) {
+    std::vector<ir::func_num_t> members(component->members().begin(),
+                                        component->members().end());
+    std::sort(members.begin(), members.end());
+    for (ir::func_num_t func_num : members) {
+      // Calls of funcs not defined in the program let all args escape.
+      const ir::Func* func = program->GetFunc(func_num);
+      if (func == nullptr) {
+        continue;
+      }
+      escape_info.SetArgEscapeKinds(
+          func_num, std::vector<EscapeKind>(func->args().size(), EscapeKind::kNoEscape));
+      worklist.push_back(func_num);
+      queued.insert(func_num);
+    }
+  }
+  while (!worklist.empty()) {
+    ir::func_num_t func_num = worklist.front();
+    worklist.pop_front();
+    queued.erase(func_num);
+
+    const ir::Func* func = program->GetFunc(func_num);
+    if (!escape_info.SetArgEscapeKinds(func_num,
+                                       FindArgEscapeKinds(func, func_call_graph, escape_info))) {
+      continue;
+    }
+    for (ir::func_num_t caller_num : func_call_graph.CallersOfFunc(func_num)) {
+      if (queued.insert(caller_num).second) {
+        worklist.push_back(caller_num);
+      }
+    }
+  }
+
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    FindAllocationEscapeKinds(func.get(), func_call_graph, escape_info);
+  }
+  return escape_info;
+}
+
+}  // namespace ir_analyzers
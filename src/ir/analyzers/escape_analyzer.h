@@ -0,0 +1,25 @@
+//
+//  escape_analyzer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_analyzers_escape_analyzer_h
+#define ir_analyzers_escape_analyzer_h
+
+#include "src/ir/info/escape_info.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_analyzers {
+
+// Classifies all allocation sites (malloc instrs) and pointer args in the program. The analysis
+// is flow insensitive and follows pointers through movs, phis, and pointer offsets. Args get
+// classified over the func call graph until a fixed point is reached, such that pointers passed to
+// called funcs get classified based on how the called funcs use them.
+const ir_info::EscapeInfo FindEscapesInProgram(const ir::Program* program);
+
+}  // namespace ir_analyzers
+
+#endif /* ir_analyzers_escape_analyzer_h */
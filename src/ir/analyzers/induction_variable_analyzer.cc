@@ -0,0 +1,104 @@
+//
+//  induction_variable_analyzer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "induction_variable_analyzer.h"
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+
+namespace ir_analyzers {
+namespace {
+
+using ::common::atomics::Int;
+
+// Returns the step from the phi result to the given value if the value gets computed from the phi
+// result by a chain of additions and subtractions of int constants.
+std::optional<Int> FindStep(
+    const ir::PhiInstr* phi_instr, std::shared_ptr<ir::Value> value,
+    const std::unordered_map<ir::value_num_t, const ir::IntBinaryInstr*>& int_binary_instrs) {
+  const ir::IntType* type = static_cast<const ir::IntType*>(phi_instr->result()->type());
+  Int step = Int(int64_t{0}).ConvertTo(type->int_type());
+  for (std::size_t i = 0; i <= int_binary_instrs.size(); i++) {
+    if (value->kind() != ir::Value::Kind::kComputed) {
+      return std::nullopt;
+    }
+    ir::value_num_t number = static_cast<ir::Computed*>(value.get())->number();
+    if (number == phi_instr->result()->number()) {
+      return step;
+    }
+    auto it = int_binary_instrs.find(number);
+    if (it == int_binary_instrs.end()) {
+      return std::nullopt;
+    }
+    const ir::IntBinaryInstr* instr = it->second;
+    std::shared_ptr<ir::Value> a = instr->operand_a();
+    std::shared_ptr<ir::Value> b = instr->operand_b();
+    if (instr->operation() == Int::BinaryOp::kAdd && a->kind() == ir::Value::Kind::kConstant) {
+      std::swap(a, b);
+    }
+    if (b->kind() != ir::Value::Kind::kConstant) {
+      return std::nullopt;
+    }
+    Int constant = static_cast<ir::IntConstant*>(b.get())->value();
+    switch (instr->operation()) {
+      case Int::BinaryOp::kAdd:
+      case Int::BinaryOp::kSub:
+        step = Int::Compute(step, instr->operation(), constant);
+        break;
+      default:
+        return std::nullopt;
+    }
+    value = a;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+std::vector<ir_info::InductionVariable> FindInductionVariablesInLoop(const ir::Func* func,
+                                                                     const ir_info::Loop* loop) {
+  if (loop->preheader() == ir::kNoBlockNum || loop->latches().size() != 1) {
+    return {};
+  }
+  ir::block_num_t latch = *loop->latches().begin();
+
+  std::unordered_map<ir::value_num_t, const ir::IntBinaryInstr*> int_binary_instrs;
+  for (ir::block_num_t bnum : loop->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : func->GetBlock(bnum)->instrs()) {
+      if (instr->instr_kind() == ir::InstrKind::kIntBinary) {
+        auto int_binary_instr = static_cast<const ir::IntBinaryInstr*>(instr.get());
+        int_binary_instrs.insert({int_binary_instr->result()->number(), int_binary_instr});
+      }
+    }
+  }
+
+  std::vector<ir_info::InductionVariable> induction_variables;
+  func->GetBlock(loop->header())->ForEachPhiInstr([&](ir::PhiInstr* phi_instr) {
+    if (phi_instr->result()->type()->type_kind() != ir::TypeKind::kInt) {
+      return;
+    }
+    std::shared_ptr<ir::Value> initial_value =
+        phi_instr->ValueInheritedFromBlock(loop->preheader());
+    std::shared_ptr<ir::Value> next_value = phi_instr->ValueInheritedFromBlock(latch);
+    std::optional<Int> step = FindStep(phi_instr, next_value, int_binary_instrs);
+    if (!step.has_value() || step->IsZero()) {
+      return;
+    }
+    induction_variables.push_back(
+        ir_info::InductionVariable(phi_instr, initial_value, next_value, *step));
+  });
+  return induction_variables;
+}
+
+}  // namespace ir_analyzers
@@ -0,0 +1,29 @@
+//
+//  induction_variable_analyzer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_analyzers_induction_variable_analyzer_h
+#define ir_analyzers_induction_variable_analyzer_h
+
+#include <vector>
+
+#include "src/ir/info/induction_variable.h"
+#include "src/ir/info/loop_info.h"
+#include "src/ir/representation/func.h"
+
+namespace ir_analyzers {
+
+// Finds the induction variables of a loop with a preheader and a single latch. The next value of
+// an induction variable has to be computed from its phi by a chain of additions and subtractions
+// of int constants inside the loop. Loops without preheader or with several latches do not have
+// induction variables.
+std::vector<ir_info::InductionVariable> FindInductionVariablesInLoop(const ir::Func* func,
+                                                                     const ir_info::Loop* loop);
+
+}  // namespace ir_analyzers
+
+#endif /* ir_analyzers_induction_variable_analyzer_h */
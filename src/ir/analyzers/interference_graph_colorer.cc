@@ -8,17 +8,32 @@
 
 #include "interference_graph_colorer.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace ir_analyzers {
 
 const ir_info::InterferenceGraphColors ColorInterferenceGraph(
     const ir_info::InterferenceGraph& graph,
-    const ir_info::InterferenceGraphColors& preferred_colors) {
+    const ir_info::InterferenceGraphColors& preferred_colors,
+    const std::unordered_map<ir::value_num_t, int64_t>& spill_costs) {
   // Idea: optimize to make as many movs no ops as possible
   // Idea: optimize to use least number of colors
   // Idea: optimize to satisfy as many preferred colors as possible
   ir_info::InterferenceGraphColors result_colors;
 
-  for (ir::value_num_t value : graph.values()) {
+  auto spill_cost = [&spill_costs](ir::value_num_t value) -> int64_t {
+    auto it = spill_costs.find(value);
+    return (it != spill_costs.end()) ? it->second : 0;
+  };
+  std::vector<ir::value_num_t> values(graph.values().begin(), graph.values().end());
+  std::sort(values.begin(), values.end(), [&](ir::value_num_t a, ir::value_num_t b) {
+    int64_t cost_a = spill_cost(a);
+    int64_t cost_b = spill_cost(b);
+    return (cost_a != cost_b) ? cost_a > cost_b : a < b;
+  });
+
+  for (ir::value_num_t value : values) {
     ir_info::color_t preferred_color = preferred_colors.GetColor(value);
     std::unordered_set<ir_info::color_t> neighbor_colors;
     for (ir::value_num_t neighbor : graph.GetNeighbors(value)) {
@@ -20,9 +20,12 @@
 
 namespace ir_analyzers {
 
+// Colors values in order of decreasing spill cost, such that values with higher spill costs are
+// more likely to receive low colors. Values without spill cost have a spill cost of zero.
 const ir_info::InterferenceGraphColors ColorInterferenceGraph(
     const ir_info::InterferenceGraph& graph,
-    const ir_info::InterferenceGraphColors& preferred_colors);
+    const ir_info::InterferenceGraphColors& preferred_colors,
+    const std::unordered_map<ir::value_num_t, int64_t>& spill_costs = {});
 
 }  // namespace ir_analyzers
 
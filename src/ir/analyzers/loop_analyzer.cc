@@ -0,0 +1,96 @@
+//
+//  loop_analyzer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "loop_analyzer.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/num_types.h"
+
+namespace ir_analyzers {
+
+const ir_info::LoopInfo FindLoopsInFunc(const ir::Func* func) {
+  std::vector<ir::block_num_t> reachable_blocks = func->GetBlocksInDominanceOrder();
+  std::unordered_set<ir::block_num_t> reachable(reachable_blocks.begin(), reachable_blocks.end());
+
+  std::map<ir::block_num_t, std::unordered_set<ir::block_num_t>> latches_by_header;
+  for (ir::block_num_t bnum : reachable_blocks) {
+    for (ir::block_num_t child : func->GetBlock(bnum)->children()) {
+      if (func->Dominates(child, bnum)) {
+        latches_by_header[child].insert(bnum);
+      }
+    }
+  }
+
+  struct LoopBlocks {
+    ir::block_num_t header;
+    std::unordered_set<ir::block_num_t> blocks;
+    std::unordered_set<ir::block_num_t> latches;
+  };
+  std::vector<LoopBlocks> loops;
+  loops.reserve(latches_by_header.size());
+  for (auto& [header, latches] : latches_by_header) {
+    // All blocks that reach a latch without passing through the header belong to the loop:
+    std::unordered_set<ir::block_num_t> blocks{header};
+    std::vector<ir::block_num_t> worklist(latches.begin(), latches.end());
+    while (!worklist.empty()) {
+      ir::block_num_t bnum = worklist.back();
+      worklist.pop_back();
+      if (!blocks.insert(bnum).second) {
+        continue;
+      }
+      for (ir::block_num_t parent : func->GetBlock(bnum)->parents()) {
+        if (reachable.contains(parent) && !blocks.contains(parent)) {
+          worklist.push_back(parent);
+        }
+      }
+    }
+    loops.push_back(LoopBlocks{.header = header, .blocks = blocks, .latches = latches});
+  }
+
+  // Loops nested in another loop have strictly fewer blocks than the outer loop:
+  std::stable_sort(loops.begin(), loops.end(), [](const LoopBlocks& a, const LoopBlocks& b) {
+    return a.blocks.size() > b.blocks.size();
+  });
+
+  ir_info::LoopInfo loop_info;
+  for (LoopBlocks& loop : loops) {
+    std::unordered_set<ir::block_num_t> exiting_blocks;
+    for (ir::block_num_t bnum : loop.blocks) {
+      for (ir::block_num_t child : func->GetBlock(bnum)->children()) {
+        if (!loop.blocks.contains(child)) {
+          exiting_blocks.insert(bnum);
+          break;
+        }
+      }
+    }
+
+    ir::block_num_t preheader = ir::kNoBlockNum;
+    for (ir::block_num_t parent : func->GetBlock(loop.header)->parents()) {
+      if (loop.blocks.contains(parent)) {
+        continue;
+      } else if (preheader != ir::kNoBlockNum) {
+        preheader = ir::kNoBlockNum;
+        break;
+      }
+      preheader = parent;
+    }
+    if (preheader != ir::kNoBlockNum && func->GetBlock(preheader)->children().size() != 1) {
+      preheader = ir::kNoBlockNum;
+    }
+
+    loop_info.AddLoop(loop.header, preheader, loop.blocks, loop.latches, exiting_blocks);
+  }
+  return loop_info;
+}
+
+}  // namespace ir_analyzers
@@ -0,0 +1,24 @@
+//
+//  loop_analyzer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_analyzers_loop_analyzer_h
+#define ir_analyzers_loop_analyzer_h
+
+#include "src/ir/info/loop_info.h"
+#include "src/ir/representation/func.h"
+
+namespace ir_analyzers {
+
+// Finds all natural loops in the func, identified by back edges to blocks dominating their
+// origin. Back edges to the same header get merged into a single loop. Irreducible cycles and
+// unreachable blocks are not part of any loop.
+const ir_info::LoopInfo FindLoopsInFunc(const ir::Func* func);
+
+}  // namespace ir_analyzers
+
+#endif /* ir_analyzers_loop_analyzer_h */
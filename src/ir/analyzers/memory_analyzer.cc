@@ -0,0 +1,58 @@
+//
+//  memory_analyzer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "memory_analyzer.h"
+
+#include <memory>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_analyzers {
+
+using ::common::atomics::Int;
+
+const ir_info::MemoryInfo FindMemoryLocationsInFunc(const ir::Func* func) {
+  ir_info::MemoryInfo memory_info;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kMalloc:
+          memory_info.AddAllocation(static_cast<ir::MallocInstr*>(instr.get())->result()->number(),
+                                    /*on_stack=*/false);
+          break;
+        case ir::InstrKind::kStackAlloc:
+          memory_info.AddAllocation(
+              static_cast<ir::StackAllocInstr*>(instr.get())->result()->number(),
+              /*on_stack=*/true);
+          break;
+        case ir::InstrKind::kPointerOffset: {
+          auto pointer_offset_instr = static_cast<ir::PointerOffsetInstr*>(instr.get());
+          if (pointer_offset_instr->offset()->kind() != ir::Value::Kind::kConstant) {
+            break;
+          }
+          Int offset = static_cast<ir::IntConstant*>(pointer_offset_instr->offset().get())->value();
+          if (!offset.IsRepresentableAsInt64()) {
+            break;
+          }
+          memory_info.AddPointerOffset(pointer_offset_instr->result()->number(),
+                                       pointer_offset_instr->pointer()->number(),
+                                       offset.AsInt64());
+          break;
+        }
+        default:
+          break;
+      }
+    }
+  }
+  return memory_info;
+}
+
+}  // namespace ir_analyzers
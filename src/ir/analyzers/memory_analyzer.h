@@ -0,0 +1,23 @@
+//
+//  memory_analyzer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_analyzers_memory_analyzer_h
+#define ir_analyzers_memory_analyzer_h
+
+#include "src/ir/info/memory_info.h"
+#include "src/ir/representation/func.h"
+
+namespace ir_analyzers {
+
+// Finds all allocation sites (malloc and salloc instrs) in the func and all pointer offsets with
+// constant offsets, such that memory accesses can be attributed to allocation sites and fields.
+const ir_info::MemoryInfo FindMemoryLocationsInFunc(const ir::Func* func);
+
+}  // namespace ir_analyzers
+
+#endif /* ir_analyzers_memory_analyzer_h */
@@ -0,0 +1,93 @@
+//
+//  speculation_analyzer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/23/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "speculation_analyzer.h"
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_analyzers {
+namespace {
+
+using ::common::atomics::CanConvertAllValues;
+using ::common::atomics::Int;
+using ::common::atomics::IntType;
+
+// Divisions fail for a zero divisor and overflow for a minus one divisor.
+bool CanTrap(const ir::IntBinaryInstr* instr) {
+  switch (instr->operation()) {
+    case Int::BinaryOp::kDiv:
+    case Int::BinaryOp::kRem:
+      break;
+    default:
+      return false;
+  }
+  if (instr->operand_b()->kind() != ir::Value::Kind::kConstant ||
+      instr->operand_b()->type()->type_kind() != ir::TypeKind::kInt) {
+    return true;
+  }
+  Int divisor = static_cast<ir::IntConstant*>(instr->operand_b().get())->value();
+  return divisor.IsZero() || divisor.IsMinusOne();
+}
+
+// Conversions to int types fail if the converted value does not fit the result type.
+bool CanTrap(const ir::Conversion* instr) {
+  const ir::Type* result_type = instr->result()->type();
+  if (result_type->type_kind() != ir::TypeKind::kInt) {
+    return false;
+  }
+  IntType result_int_type = static_cast<const ir::IntType*>(result_type)->int_type();
+  const ir::Value* operand = instr->operand().get();
+  switch (operand->type()->type_kind()) {
+    case ir::TypeKind::kBool:
+      return false;
+    case ir::TypeKind::kInt:
+      if (operand->kind() == ir::Value::Kind::kConstant) {
+        return !static_cast<const ir::IntConstant*>(operand)->value().CanConvertTo(result_int_type);
+      }
+      return !CanConvertAllValues(static_cast<const ir::IntType*>(operand->type())->int_type(),
+                                  result_int_type);
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+bool CanTrap(const ir::Instr* instr) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kConversion:
+      return CanTrap(static_cast<const ir::Conversion*>(instr));
+    case ir::InstrKind::kIntBinary:
+      return CanTrap(static_cast<const ir::IntBinaryInstr*>(instr));
+    default:
+      return false;
+  }
+}
+
+bool CanExecuteSpeculatively(const ir::Instr* instr) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov:
+    case ir::InstrKind::kBoolNot:
+    case ir::InstrKind::kBoolBinary:
+    case ir::InstrKind::kIntUnary:
+    case ir::InstrKind::kIntCompare:
+    case ir::InstrKind::kIntShift:
+    case ir::InstrKind::kPointerOffset:
+    case ir::InstrKind::kNilTest:
+      return true;
+    case ir::InstrKind::kConversion:
+    case ir::InstrKind::kIntBinary:
+      return !CanTrap(instr);
+    default:
+      return false;
+  }
+}
+
+}  // namespace ir_analyzers
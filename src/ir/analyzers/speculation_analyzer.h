@@ -0,0 +1,26 @@
+//
+//  speculation_analyzer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/23/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_analyzers_speculation_analyzer_h
+#define ir_analyzers_speculation_analyzer_h
+
+#include "src/ir/representation/instrs.h"
+
+namespace ir_analyzers {
+
+// Returns if the instr can fail at runtime, for example by dividing by zero or by converting a
+// value that does not fit the result type.
+bool CanTrap(const ir::Instr* instr);
+
+// Returns if the instr has no side effects and can not trap, such that it can get executed even
+// when the original program would not have executed it.
+bool CanExecuteSpeculatively(const ir::Instr* instr);
+
+}  // namespace ir_analyzers
+
+#endif /* ir_analyzers_speculation_analyzer_h */
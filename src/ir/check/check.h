@@ -9,16 +9,61 @@
 #ifndef ir_checker_check_h
 #define ir_checker_check_h
 
+#include <cstdint>
+#include <vector>
+
+#include "src/common/concurrency/thread_pool.h"
+#include "src/ir/check/check_cache.h"
 #include "src/ir/check/checker.h"
 #include "src/ir/issues/issues.h"
 #include "src/ir/representation/program.h"
 
 namespace ir_check {
 
+struct CheckOptions {
+  // If set, funcs get checked concurrently on the thread pool.
+  common::concurrency::ThreadPool* thread_pool = nullptr;
+  // If set, only funcs that changed since the last check with the cache get checked again.
+  CheckCache* cache = nullptr;
+};
+
+// Issues get added to the issue tracker in program order, regardless of the given options.
 template <typename Checker = Checker>
-void CheckProgram(const ir::Program* program, ir_issues::IssueTracker& issue_tracker) {
-  Checker checker(issue_tracker, program);
-  checker.CheckProgram();
+void CheckProgram(const ir::Program* program, ir_issues::IssueTracker& issue_tracker,
+                  CheckOptions options = {}) {
+  if (options.thread_pool == nullptr && options.cache == nullptr) {
+    Checker checker(issue_tracker, program);
+    checker.CheckProgram();
+    return;
+  }
+  std::size_t func_count = program->funcs().size();
+  std::vector<uint64_t> fingerprints(func_count);
+  std::vector<FuncCheckResults> results(func_count);
+  auto check_func = [&](std::size_t i) {
+    const ir::Func* func = program->funcs().at(i).get();
+    if (options.cache != nullptr) {
+      fingerprints.at(i) = FingerprintFunc(func, program);
+      if (const FuncCheckResults* cached = options.cache->Lookup(func, fingerprints.at(i))) {
+        results.at(i) = *cached;
+        return;
+      }
+    }
+    ir_issues::IssueTracker func_issue_tracker(/*file_set=*/nullptr);
+    Checker checker(func_issue_tracker, program);
+    results.at(i).defined_values = checker.CheckSingleFunc(func);
+    results.at(i).issues = func_issue_tracker.issues();
+  };
+  if (options.thread_pool != nullptr) {
+    common::concurrency::ParallelFor(*options.thread_pool, func_count, check_func);
+  } else {
+    for (std::size_t i = 0; i < func_count; i++) {
+      check_func(i);
+    }
+  }
+  AddIssuesForFuncs(program, results, issue_tracker);
+  if (options.cache != nullptr) {
+    options.cache->Update(program, fingerprints, results);
+  }
 }
 
 }  // namespace ir_check
@@ -0,0 +1,184 @@
+//
+//  check_cache.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/29/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "check_cache.h"
+
+#include <memory>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_check {
+namespace {
+
+class Hasher {
+ public:
+  void Add(uint64_t value) {
+    hash_ ^= value + 0x9e3779b97f4a7c15 + (hash_ << 6) + (hash_ >> 2);
+  }
+  void Add(const void* pointer) { Add(uint64_t(reinterpret_cast<uintptr_t>(pointer))); }
+
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 0;
+};
+
+// Block parents and children are unordered, therefore they get combined commutatively.
+uint64_t HashBlockNums(const std::unordered_set<ir::block_num_t>& block_nums) {
+  uint64_t hash = block_nums.size();
+  for (ir::block_num_t block_num : block_nums) {
+    Hasher hasher;
+    hasher.Add(uint64_t(block_num));
+    hash += hasher.hash();
+  }
+  return hash;
+}
+
+void AddValue(const ir::Value* value, Hasher& hasher) {
+  hasher.Add(value);
+  if (value == nullptr) {
+    return;
+  }
+  hasher.Add(value->type());
+  switch (value->kind()) {
+    case ir::Value::Kind::kComputed: {
+      auto computed = static_cast<const ir::Computed*>(value);
+      hasher.Add(uint64_t(computed->number()));
+      hasher.Add(uint64_t(computed->definition_start()));
+      return;
+    }
+    case ir::Value::Kind::kInherited: {
+      auto inherited = static_cast<const ir::InheritedValue*>(value);
+      hasher.Add(uint64_t(inherited->origin()));
+      hasher.Add(uint64_t(inherited->start()));
+      AddValue(inherited->value().get(), hasher);
+      return;
+    }
+    case ir::Value::Kind::kConstant:
+      return;
+  }
+}
+
+void AddCallee(const ir::CallInstr* call_instr, const ir::Program* program, Hasher& hasher) {
+  if (call_instr->func() == nullptr || call_instr->func()->kind() != ir::Value::Kind::kConstant ||
+      call_instr->func()->type() != ir::func_type()) {
+    return;
+  }
+  const ir::Func* callee =
+      program->GetFunc(static_cast<const ir::FuncConstant*>(call_instr->func().get())->value());
+  hasher.Add(callee);
+  if (callee == nullptr) {
+    return;
+  }
+  for (const std::shared_ptr<ir::Computed>& arg : callee->args()) {
+    hasher.Add(arg != nullptr ? arg->type() : nullptr);
+  }
+  for (const ir::Type* result_type : callee->result_types()) {
+    hasher.Add(result_type);
+  }
+}
+
+void AddInstr(const ir::Instr* instr, const ir::Program* program, Hasher& hasher) {
+  hasher.Add(instr);
+  hasher.Add(uint64_t(instr->instr_kind()));
+  hasher.Add(uint64_t(instr->start()));
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kBoolBinary:
+      hasher.Add(uint64_t(static_cast<const ir::BoolBinaryInstr*>(instr)->operation()));
+      break;
+    case ir::InstrKind::kIntUnary:
+      hasher.Add(uint64_t(static_cast<const ir::IntUnaryInstr*>(instr)->operation()));
+      break;
+    case ir::InstrKind::kIntCompare:
+      hasher.Add(uint64_t(static_cast<const ir::IntCompareInstr*>(instr)->operation()));
+      break;
+    case ir::InstrKind::kIntBinary:
+      hasher.Add(uint64_t(static_cast<const ir::IntBinaryInstr*>(instr)->operation()));
+      break;
+    case ir::InstrKind::kIntShift:
+      hasher.Add(uint64_t(static_cast<const ir::IntShiftInstr*>(instr)->operation()));
+      break;
+    case ir::InstrKind::kJump:
+      hasher.Add(uint64_t(static_cast<const ir::JumpInstr*>(instr)->destination()));
+      break;
+    case ir::InstrKind::kJumpCond: {
+      auto jump_cond_instr = static_cast<const ir::JumpCondInstr*>(instr);
+      hasher.Add(uint64_t(jump_cond_instr->destination_true()));
+      hasher.Add(uint64_t(jump_cond_instr->destination_false()));
+      break;
+    }
+    case ir::InstrKind::kCall:
+      AddCallee(static_cast<const ir::CallInstr*>(instr), program, hasher);
+      break;
+    default:
+      break;
+  }
+  for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+    AddValue(defined_value.get(), hasher);
+  }
+  for (const std::shared_ptr<ir::Value>& used_value : instr->UsedValues()) {
+    AddValue(used_value.get(), hasher);
+  }
+}
+
+}  // namespace
+
+const FuncCheckResults* CheckCache::Lookup(const ir::Func* func, uint64_t fingerprint) const {
+  auto it = entries_.find(func);
+  if (it == entries_.end() || it->second.fingerprint != fingerprint) {
+    return nullptr;
+  }
+  return &it->second.results;
+}
+
+void CheckCache::Update(const ir::Program* program, const std::vector<uint64_t>& fingerprints,
+                        const std::vector<FuncCheckResults>& results) {
+  entries_.clear();
+  entries_.reserve(program->funcs().size());
+  for (std::size_t i = 0; i < program->funcs().size(); i++) {
+    entries_.insert({program->funcs().at(i).get(), Entry{
+                                                       .fingerprint = fingerprints.at(i),
+                                                       .results = results.at(i),
+                                                   }});
+  }
+}
+
+uint64_t FingerprintFunc(const ir::Func* func, const ir::Program* program) {
+  Hasher hasher;
+  hasher.Add(func);
+  hasher.Add(uint64_t(func->number()));
+  hasher.Add(uint64_t(func->start()));
+  hasher.Add(uint64_t(func->entry_block_num()));
+  hasher.Add(uint64_t(func->args().size()));
+  for (const std::shared_ptr<ir::Computed>& arg : func->args()) {
+    AddValue(arg.get(), hasher);
+  }
+  hasher.Add(uint64_t(func->result_types().size()));
+  for (const ir::Type* result_type : func->result_types()) {
+    hasher.Add(result_type);
+  }
+  hasher.Add(uint64_t(func->blocks().size()));
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    hasher.Add(block.get());
+    hasher.Add(uint64_t(block->number()));
+    hasher.Add(uint64_t(block->start()));
+    hasher.Add(HashBlockNums(block->parents()));
+    hasher.Add(HashBlockNums(block->children()));
+    hasher.Add(uint64_t(block->instrs().size()));
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      AddInstr(instr.get(), program, hasher);
+    }
+  }
+  return hasher.hash();
+}
+
+}  // namespace ir_check
@@ -0,0 +1,51 @@
+//
+//  check_cache.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/29/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_checker_check_cache_h
+#define ir_checker_check_cache_h
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "src/ir/check/checker.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_check {
+
+// CheckCache remembers the results of checking funcs, such that funcs that did not change since
+// the last check do not need to get checked again. Changes get detected by comparing fingerprints
+// of the funcs (see FingerprintFunc). A cache should only get used with a single Checker type.
+class CheckCache {
+ public:
+  // Returns nullptr if there are no results for the func with the given fingerprint.
+  const FuncCheckResults* Lookup(const ir::Func* func, uint64_t fingerprint) const;
+
+  // Replaces the cached results with the given results for the funcs of the program. The
+  // fingerprints and results have to be given in the order of program->funcs().
+  void Update(const ir::Program* program, const std::vector<uint64_t>& fingerprints,
+              const std::vector<FuncCheckResults>& results);
+
+ private:
+  struct Entry {
+    uint64_t fingerprint;
+    FuncCheckResults results;
+  };
+
+  std::unordered_map<const ir::Func*, Entry> entries_;
+};
+
+// Hashes everything the checker inspects about the func: the identities, numbers, and types of
+// values, instrs and their operations, the block graph, positions, and the signatures of
+// statically called funcs.
+uint64_t FingerprintFunc(const ir::Func* func, const ir::Program* program);
+
+}  // namespace ir_check
+
+#endif /* ir_checker_check_cache_h */
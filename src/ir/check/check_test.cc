@@ -14,6 +14,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "src/common/atomics/atomics.h"
+#include "src/common/concurrency/thread_pool.h"
 #include "src/ir/issues/issues.h"
 #include "src/ir/representation/block.h"
 #include "src/ir/representation/func.h"
@@ -28,7 +29,10 @@ namespace {
 
 using ::common::atomics::Bool;
 using ::common::atomics::Int;
+using ::common::concurrency::ThreadPool;
 using ::common::positions::FileSet;
+using ::ir_check::CheckCache;
+using ::ir_check::CheckOptions;
 using ::ir_check::CheckProgram;
 using ::ir_issues::Issue;
 using ::ir_issues::IssueKind;
@@ -1818,4 +1822,83 @@ TEST(CheckerTest, FindsNoComputedValueDefinitionDoesNotDominateUseForCorrectInhe
   EXPECT_THAT(issue_tracker.issues(), IsEmpty());
 }
 
+// Adds funcs that alternate between being correct and missing an entry block, followed by two funcs
+// sharing an arg.
+void AddFuncsForConcurrentChecks(ir::Program& program) {
+  for (int i = 0; i < 16; i++) {
+    ir::Func* func = program.AddFunc();
+    ir::Block* block = func->AddBlock();
+    if (i % 2 == 0) {
+      func->set_entry_block_num(block->number());
+    }
+    block->instrs().push_back(std::make_unique<ir::ReturnInstr>());
+  }
+  auto arg = std::make_shared<ir::Computed>(ir::i8(), /*vnum=*/0);
+  for (int i = 0; i < 2; i++) {
+    ir::Func* func = program.AddFunc();
+    func->args().push_back(arg);
+    ir::Block* block = func->AddBlock();
+    func->set_entry_block_num(block->number());
+    block->instrs().push_back(std::make_unique<ir::ReturnInstr>());
+  }
+}
+
+TEST(CheckerTest, ReportsSameIssuesWhenCheckingConcurrently) {
+  ir::Program program;
+  AddFuncsForConcurrentChecks(program);
+
+  FileSet file_set;
+  ir_issues::IssueTracker serial_issue_tracker(&file_set);
+  CheckProgram(&program, serial_issue_tracker);
+
+  ThreadPool thread_pool(4);
+  ir_issues::IssueTracker concurrent_issue_tracker(&file_set);
+  CheckProgram(&program, concurrent_issue_tracker, CheckOptions{.thread_pool = &thread_pool});
+
+  ASSERT_THAT(concurrent_issue_tracker.issues(), SizeIs(serial_issue_tracker.issues().size()));
+  for (std::size_t i = 0; i < serial_issue_tracker.issues().size(); i++) {
+    const Issue& serial_issue = serial_issue_tracker.issues().at(i);
+    const Issue& concurrent_issue = concurrent_issue_tracker.issues().at(i);
+    EXPECT_EQ(concurrent_issue.kind(), serial_issue.kind());
+    EXPECT_EQ(concurrent_issue.positions(), serial_issue.positions());
+  }
+  EXPECT_EQ(concurrent_issue_tracker.issues().back().kind(),
+            IssueKind::kComputedValueUsedInMultipleFunctions);
+}
+
+TEST(CheckerTest, RechecksOnlyModifiedFuncsWithCache) {
+  ir::Program program;
+  AddFuncsForConcurrentChecks(program);
+
+  FileSet file_set;
+  ThreadPool thread_pool(4);
+  CheckCache cache;
+  CheckOptions options{.thread_pool = &thread_pool, .cache = &cache};
+  ir_issues::IssueTracker first_issue_tracker(&file_set);
+  CheckProgram(&program, first_issue_tracker, options);
+  EXPECT_THAT(first_issue_tracker.issues(), SizeIs(17));
+
+  ir_issues::IssueTracker second_issue_tracker(&file_set);
+  CheckProgram(&program, second_issue_tracker, options);
+  EXPECT_THAT(second_issue_tracker.issues(), SizeIs(17));
+
+  for (const std::unique_ptr<ir::Func>& func : program.funcs()) {
+    func->set_entry_block_num(func->blocks().front()->number());
+  }
+  ir::Func* last_func = program.funcs().back().get();
+  last_func->args().front() = std::make_shared<ir::Computed>(ir::i8(), /*vnum=*/0);
+  ir_issues::IssueTracker third_issue_tracker(&file_set);
+  CheckProgram(&program, third_issue_tracker, options);
+  EXPECT_THAT(third_issue_tracker.issues(), IsEmpty());
+
+  last_func->blocks().front()->instrs().clear();
+  last_func->blocks().front()->instrs().push_back(std::make_unique<ir::ReturnInstr>(
+      std::vector<std::shared_ptr<ir::Value>>{ir::I64Zero()}));
+  ir_issues::IssueTracker fourth_issue_tracker(&file_set);
+  CheckProgram(&program, fourth_issue_tracker, options);
+  EXPECT_THAT(fourth_issue_tracker.issues(),
+              ElementsAre(Property("kind", &Issue::kind,
+                                   IssueKind::kReturnInstrDoesNotMatchFuncSignature)));
+}
+
 }  // namespace
@@ -9,6 +9,7 @@
 #include "checker.h"
 
 #include <sstream>
+#include <utility>
 
 #include "src/common/logging/logging.h"
 
@@ -20,6 +21,13 @@ void Checker::CheckProgram() {
   }
 }
 
+std::vector<const ir::Computed*> Checker::CheckSingleFunc(const ir::Func* func) {
+  values_to_funcs_.clear();
+  defined_values_.clear();
+  CheckFunc(func);
+  return std::move(defined_values_);
+}
+
 void Checker::CheckFunc(const ir::Func* func) {
   CheckValuesInFunc(func);
   if (func->entry_block_num() == ir::kNoBlockNum) {
@@ -46,8 +54,8 @@ void Checker::AddValueInFunc(const ir::Computed* value, const ir::Func* func,
     issue_tracker().Add(ir_issues::IssueKind::kComputedValueUsedInMultipleFunctions,
                         {value->definition_start(), func->start(), it->second->start()},
                         "ir::Computed instance gets used in multiple functions");
-  } else {
-    values_to_funcs_.insert({value, func});
+  } else if (values_to_funcs_.insert({value, func}).second) {
+    defined_values_.push_back(value);
   }
 
   // Check and update value number association with ir::Computed instance:
@@ -295,6 +303,9 @@ void Checker::CheckInstr(const ir::Instr* instr, const ir::Block* block, const i
     case ir::InstrKind::kMalloc:
       CheckMallocInstr(static_cast<const ir::MallocInstr*>(instr));
       break;
+    case ir::InstrKind::kStackAlloc:
+      CheckStackAllocInstr(static_cast<const ir::StackAllocInstr*>(instr));
+      break;
     case ir::InstrKind::kLoad:
       CheckLoadInstr(static_cast<const ir::LoadInstr*>(instr));
       break;
@@ -549,6 +560,21 @@ void Checker::CheckMallocInstr(const ir::MallocInstr* malloc_instr) {
   }
 }
 
+void Checker::CheckStackAllocInstr(const ir::StackAllocInstr* stack_alloc_instr) {
+  const ir::Value* size = stack_alloc_instr->size().get();
+  if (size->type() != ir::i64() || size->kind() != ir::Value::Kind::kConstant ||
+      static_cast<const ir::IntConstant*>(size)->value().AsInt64() <= 0) {
+    issue_tracker().Add(ir_issues::IssueKind::kStackAllocInstrSizeIsNotPositiveI64Constant,
+                        stack_alloc_instr->start(),
+                        "ir::StackAllocInstr size is not a positive I64 constant");
+  }
+  if (stack_alloc_instr->result()->type() != ir::pointer_type()) {
+    issue_tracker().Add(ir_issues::IssueKind::kStackAllocInstrResultDoesNotHavePointerType,
+                        stack_alloc_instr->start(),
+                        "ir::StackAllocInstr result does not have pointer type");
+  }
+}
+
 void Checker::CheckLoadInstr(const ir::LoadInstr* load_instr) {
   if (load_instr->address()->type() != ir::pointer_type()) {
     issue_tracker().Add(ir_issues::IssueKind::kLoadInstrAddressDoesNotHavePointerType,
@@ -723,4 +749,24 @@ void Checker::CheckValue(const ir::Computed* value) {
   }
 }
 
+void AddIssuesForFuncs(const ir::Program* program, const std::vector<FuncCheckResults>& results,
+                       ir_issues::IssueTracker& issue_tracker) {
+  std::unordered_map<const ir::Computed*, const ir::Func*> values_to_funcs;
+  for (std::size_t i = 0; i < results.size(); i++) {
+    const ir::Func* func = program->funcs().at(i).get();
+    const FuncCheckResults& func_results = results.at(i);
+    for (const ir_issues::Issue& issue : func_results.issues) {
+      issue_tracker.Add(issue.kind(), issue.positions(), issue.message());
+    }
+    for (const ir::Computed* value : func_results.defined_values) {
+      auto [it, inserted] = values_to_funcs.insert({value, func});
+      if (!inserted) {
+        issue_tracker.Add(ir_issues::IssueKind::kComputedValueUsedInMultipleFunctions,
+                          {value->definition_start(), func->start(), it->second->start()},
+                          "ir::Computed instance gets used in multiple functions");
+      }
+    }
+  }
+}
+
 }  // namespace ir_check
@@ -27,6 +27,13 @@
 
 namespace ir_check {
 
+// Results of checking a single func, excluding the checks across funcs.
+struct FuncCheckResults {
+  std::vector<ir_issues::Issue> issues;
+  // The ir::Computed instances defined by the func (args and instr results) in order.
+  std::vector<const ir::Computed*> defined_values;
+};
+
 class Checker {
  public:
   Checker(ir_issues::IssueTracker& issue_tracker, const ir::Program* program)
@@ -35,6 +42,10 @@ class Checker {
 
   virtual void CheckProgram();
 
+  // Checks only the given func and returns the ir::Computed instances it defines. This leaves the
+  // checks across funcs to AddIssuesForFuncs, such that funcs can get checked independently.
+  std::vector<const ir::Computed*> CheckSingleFunc(const ir::Func* func);
+
  protected:
   const ir::Program* program() const { return program_; }
   ir_issues::IssueTracker& issue_tracker() { return issue_tracker_; }
@@ -82,6 +93,7 @@ class Checker {
   void CheckPointerOffsetInstr(const ir::PointerOffsetInstr* pointer_offset_instr);
   void CheckNilTestInstr(const ir::NilTestInstr* nil_test_instr);
   void CheckMallocInstr(const ir::MallocInstr* malloc_instr);
+  void CheckStackAllocInstr(const ir::StackAllocInstr* stack_alloc_instr);
   void CheckFreeInstr(const ir::FreeInstr* free_instr);
   void CheckJumpInstr(const ir::JumpInstr* jump_instr, const ir::Block* block);
   void CheckJumpCondInstr(const ir::JumpCondInstr* jump_cond_instr, const ir::Block* block);
@@ -93,8 +105,15 @@ class Checker {
   ir_issues::IssueTracker& issue_tracker_;
   const ir::Program* program_;
   std::unordered_map<const ir::Computed*, const ir::Func*> values_to_funcs_;
+  std::vector<const ir::Computed*> defined_values_;
 };
 
+// Adds the issues of independently checked funcs to the issue tracker in program order and checks
+// that no ir::Computed instance gets defined in multiple funcs. The results have to be given in the
+// order of program->funcs().
+void AddIssuesForFuncs(const ir::Program* program, const std::vector<FuncCheckResults>& results,
+                       ir_issues::IssueTracker& issue_tracker);
+
 }  // namespace ir_check
 
 #endif /* ir_checker_checker_h */
@@ -0,0 +1,96 @@
+//
+//  escape_info.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "escape_info.h"
+
+#include <algorithm>
+#include <sstream>
+#include <utility>
+
+namespace ir_info {
+
+std::string ToString(EscapeKind kind) {
+  switch (kind) {
+    case EscapeKind::kNoEscape:
+      return "no escape";
+    case EscapeKind::kArgEscape:
+      return "arg escape";
+    case EscapeKind::kGlobalEscape:
+      return "global escape";
+  }
+}
+
+EscapeKind EscapeInfo::GetAllocationEscapeKind(ir::func_num_t func_num,
+                                               ir::value_num_t allocation) const {
+  auto func_it = allocation_kinds_.find(func_num);
+  if (func_it == allocation_kinds_.end()) {
+    return EscapeKind::kGlobalEscape;
+  }
+  auto it = func_it->second.find(allocation);
+  if (it == func_it->second.end()) {
+    return EscapeKind::kGlobalEscape;
+  }
+  return it->second;
+}
+
+void EscapeInfo::SetAllocationEscapeKind(ir::func_num_t func_num, ir::value_num_t allocation,
+                                         EscapeKind kind) {
+  allocation_kinds_[func_num].insert_or_assign(allocation, kind);
+}
+
+EscapeKind EscapeInfo::GetArgEscapeKind(ir::func_num_t func_num, std::size_t arg_index) const {
+  auto it = arg_kinds_.find(func_num);
+  if (it == arg_kinds_.end() || arg_index >= it->second.size()) {
+    return EscapeKind::kGlobalEscape;
+  }
+  return it->second.at(arg_index);
+}
+
+bool EscapeInfo::SetArgEscapeKinds(ir::func_num_t func_num, std::vector<EscapeKind> kinds) {
+  auto it = arg_kinds_.find(func_num);
+  if (it != arg_kinds_.end() && it->second == kinds) {
+    return false;
+  }
+  arg_kinds_.insert_or_assign(func_num, std::move(kinds));
+  return true;
+}
+
+std::string EscapeInfo::ToString() const {
+  std::vector<ir::func_num_t> func_nums;
+  for (const auto& [func_num, kinds] : arg_kinds_) {
+    func_nums.push_back(func_num);
+  }
+  for (const auto& [func_num, kinds] : allocation_kinds_) {
+    if (!arg_kinds_.contains(func_num)) {
+      func_nums.push_back(func_num);
+    }
+  }
+  std::sort(func_nums.begin(), func_nums.end());
+
+  std::stringstream ss;
+  ss << "escape info:";
+  for (ir::func_num_t func_num : func_nums) {
+    ss << "\n@" << func_num << ":";
+    if (auto it = arg_kinds_.find(func_num); it != arg_kinds_.end()) {
+      for (std::size_t i = 0; i < it->second.size(); i++) {
+        ss << "\n  arg " << i << ": " << ir_info::ToString(it->second.at(i));
+      }
+    }
+    if (auto it = allocation_kinds_.find(func_num); it != allocation_kinds_.end()) {
+      std::vector<std::pair<ir::value_num_t, EscapeKind>> allocations(it->second.begin(),
+                                                                       it->second.end());
+      std::sort(allocations.begin(), allocations.end());
+      for (auto [allocation, kind] : allocations) {
+        ss << "\n  %" << allocation << ": " << ir_info::ToString(kind);
+      }
+    }
+  }
+  return ss.str();
+}
+
+}  // namespace ir_info
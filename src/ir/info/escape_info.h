@@ -0,0 +1,60 @@
+//
+//  escape_info.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_info_escape_info_h
+#define ir_info_escape_info_h
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "src/ir/representation/num_types.h"
+
+namespace ir_info {
+
+// EscapeKind classifies how far a pointer can get beyond the func it originates from. Greater
+// kinds subsume lesser kinds.
+enum class EscapeKind {
+  // The pointer and pointers derived from it only get used by the func itself.
+  kNoEscape,
+  // The pointer gets passed to called funcs, none of which lets it escape further. The pointed to
+  // memory can not outlive the func.
+  kArgEscape,
+  // The pointer might outlive the func, for example because it gets stored to memory, returned,
+  // passed to an unknown func, or freed by a called func.
+  kGlobalEscape,
+};
+
+std::string ToString(EscapeKind kind);
+
+class EscapeInfo {
+ public:
+  // Allocation sites get identified by their func and the result of their malloc instr. Returns
+  // kGlobalEscape for unknown allocation sites.
+  EscapeKind GetAllocationEscapeKind(ir::func_num_t func_num, ir::value_num_t allocation) const;
+  void SetAllocationEscapeKind(ir::func_num_t func_num, ir::value_num_t allocation,
+                               EscapeKind kind);
+
+  // Describes how a func treats pointers passed to it as the arg with the given index. Returns
+  // kGlobalEscape for unknown funcs and args.
+  EscapeKind GetArgEscapeKind(ir::func_num_t func_num, std::size_t arg_index) const;
+  // Returns if the escape kinds of the args of the func changed.
+  bool SetArgEscapeKinds(ir::func_num_t func_num, std::vector<EscapeKind> kinds);
+
+  std::string ToString() const;
+
+ private:
+  std::unordered_map<ir::func_num_t, std::unordered_map<ir::value_num_t, EscapeKind>>
+      allocation_kinds_;
+  std::unordered_map<ir::func_num_t, std::vector<EscapeKind>> arg_kinds_;
+};
+
+}  // namespace ir_info
+
+#endif /* ir_info_escape_info_h */
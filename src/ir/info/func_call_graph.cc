@@ -16,6 +16,7 @@ std::unordered_set<ir::func_num_t> FuncCallGraph::CalleesOfFunc(ir::func_num_t c
   std::unordered_set<ir::func_num_t> callees;
   for (const auto& func_call : func_calls_) {
     if (func_call->caller() == caller_num) {
+      callees.insert(func_call->callees().begin(), func_call->callees().end());
     }
   }
   return callees;
@@ -81,6 +82,16 @@ Component* FuncCallGraph::ComponentOfFunc(ir::func_num_t func_num) const {
   return nullptr;
 }
 
+std::vector<Component*> FuncCallGraph::ComponentsInBottomUpOrder() const {
+  // Tarjan's algorithm finds components after all components reachable from them:
+  std::vector<Component*> components;
+  components.reserve(Components().size());
+  for (const auto& component : Components()) {
+    components.push_back(component.get());
+  }
+  return components;
+}
+
 std::unordered_set<Component*> FuncCallGraph::ComponentsReachableFromComponent(
     Component* root_component) const {
   std::unordered_set<Component*> reachable_components{root_component};
@@ -121,7 +132,9 @@ void FuncCallGraph::GenerateComponents() const {
       .index = 0,
   };
   for (ir::func_num_t func : funcs_) {
-    GenerateComponent(func, state);
+    if (!state.func_annotations.contains(func)) {
+      GenerateComponent(func, state);
+    }
   }
   for (const auto& func_call : func_calls_) {
     Component* caller_component = ComponentOfFunc(func_call->caller());
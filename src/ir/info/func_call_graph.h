@@ -75,6 +75,8 @@ class FuncCallGraph {
   void AddFuncCall(std::unique_ptr<FuncCall> func_call);
 
   Component* ComponentOfFunc(ir::func_num_t func_num) const;
+  // Returns all components ordered such that callees precede their callers.
+  std::vector<Component*> ComponentsInBottomUpOrder() const;
   std::unordered_set<Component*> ComponentsReachableFromComponent(Component* root_component) const;
   std::unordered_set<ir::func_num_t> FuncsReachableFromComponent(Component* root_component) const;
 
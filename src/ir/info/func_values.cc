@@ -34,7 +34,11 @@ ir::Instr* FuncValues::GetInstrDefiningValue(ir::value_num_t value) const {
 }
 
 std::unordered_set<ir::Instr*> FuncValues::GetInstrsUsingValue(ir::value_num_t value) const {
-  return using_instrs_.at(value);
+  auto it = using_instrs_.find(value);
+  if (it == using_instrs_.end()) {
+    return {};
+  }
+  return it->second;
 }
 
 void FuncValues::AddValue(ir::Computed* value) {
@@ -0,0 +1,44 @@
+//
+//  induction_variable.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_info_induction_variable_h
+#define ir_info_induction_variable_h
+
+#include <memory>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_info {
+
+// InductionVariable represents a phi in a loop header that starts with an initial value inherited
+// from the loop preheader and gets incremented by a constant step on every iteration of the loop.
+// The next value is inherited from the loop latch.
+class InductionVariable {
+ public:
+  InductionVariable(ir::PhiInstr* phi, std::shared_ptr<ir::Value> initial_value,
+                    std::shared_ptr<ir::Value> next_value, common::atomics::Int step)
+      : phi_(phi), initial_value_(initial_value), next_value_(next_value), step_(step) {}
+
+  ir::PhiInstr* phi() const { return phi_; }
+  std::shared_ptr<ir::Computed> value() const { return phi_->result(); }
+  std::shared_ptr<ir::Value> initial_value() const { return initial_value_; }
+  std::shared_ptr<ir::Value> next_value() const { return next_value_; }
+  common::atomics::Int step() const { return step_; }
+
+ private:
+  ir::PhiInstr* phi_;
+  std::shared_ptr<ir::Value> initial_value_;
+  std::shared_ptr<ir::Value> next_value_;
+  common::atomics::Int step_;
+};
+
+}  // namespace ir_info
+
+#endif /* ir_info_induction_variable_h */
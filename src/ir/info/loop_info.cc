@@ -0,0 +1,102 @@
+//
+//  loop_info.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "loop_info.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "src/common/logging/logging.h"
+
+namespace ir_info {
+
+using ::common::logging::fail;
+
+std::vector<Loop*> LoopInfo::TopLevelLoops() const {
+  std::vector<Loop*> top_level_loops;
+  for (const std::unique_ptr<Loop>& loop : loops_) {
+    if (loop->parent() == nullptr) {
+      top_level_loops.push_back(loop.get());
+    }
+  }
+  return top_level_loops;
+}
+
+Loop* LoopInfo::GetLoopWithHeader(ir::block_num_t header) const {
+  auto it = loops_by_header_.find(header);
+  if (it == loops_by_header_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+Loop* LoopInfo::InnermostLoopOfBlock(ir::block_num_t bnum) const {
+  auto it = innermost_loops_.find(bnum);
+  if (it == innermost_loops_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+int64_t LoopInfo::LoopDepthOfBlock(ir::block_num_t bnum) const {
+  Loop* loop = InnermostLoopOfBlock(bnum);
+  if (loop == nullptr) {
+    return 0;
+  }
+  return loop->depth();
+}
+
+Loop* LoopInfo::AddLoop(ir::block_num_t header, ir::block_num_t preheader,
+                        std::unordered_set<ir::block_num_t> blocks,
+                        std::unordered_set<ir::block_num_t> latches,
+                        std::unordered_set<ir::block_num_t> exiting_blocks) {
+  if (loops_by_header_.contains(header)) {
+    fail("attempted to add second loop with the same header");
+  } else if (!blocks.contains(header)) {
+    fail("attempted to add loop not containing its header");
+  }
+  Loop* parent = InnermostLoopOfBlock(header);
+  if (parent != nullptr &&
+      !std::all_of(blocks.begin(), blocks.end(),
+                   [parent](ir::block_num_t bnum) { return parent->Contains(bnum); })) {
+    fail("attempted to add loop before the loop containing it");
+  }
+  auto loop = std::unique_ptr<Loop>(new Loop(header, preheader, blocks, latches, exiting_blocks));
+  if (parent != nullptr) {
+    loop->parent_ = parent;
+    loop->depth_ = parent->depth_ + 1;
+    parent->children_.push_back(loop.get());
+  }
+  for (ir::block_num_t bnum : loop->blocks()) {
+    innermost_loops_[bnum] = loop.get();
+  }
+  loops_by_header_.insert({header, loop.get()});
+  loops_.push_back(std::move(loop));
+  return loops_.back().get();
+}
+
+std::string LoopInfo::ToString() const {
+  std::stringstream ss;
+  ss << "loop info:";
+  for (const std::unique_ptr<Loop>& loop : loops_) {
+    std::vector<ir::block_num_t> blocks(loop->blocks().begin(), loop->blocks().end());
+    std::sort(blocks.begin(), blocks.end());
+    ss << "\n";
+    ss << std::string(2 * loop->depth(), ' ') << "{" << loop->header() << "}";
+    if (loop->preheader() != ir::kNoBlockNum) {
+      ss << " preheader: {" << loop->preheader() << "}";
+    }
+    ss << " blocks:";
+    for (ir::block_num_t bnum : blocks) {
+      ss << " {" << bnum << "}";
+    }
+  }
+  return ss.str();
+}
+
+}  // namespace ir_info
@@ -0,0 +1,95 @@
+//
+//  loop_info.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_info_loop_info_h
+#define ir_info_loop_info_h
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/representation/num_types.h"
+
+namespace ir_info {
+
+// Loop represents a natural loop: a header block that dominates all blocks of the loop and the
+// latches, the loop blocks with a back edge to the header. The blocks of a loop include the blocks
+// of all nested loops.
+class Loop {
+ public:
+  ir::block_num_t header() const { return header_; }
+  // The preheader is the only parent of the header outside the loop and has the header as its only
+  // child. It is kNoBlockNum if the header does not have such a parent.
+  ir::block_num_t preheader() const { return preheader_; }
+  const std::unordered_set<ir::block_num_t>& blocks() const { return blocks_; }
+  const std::unordered_set<ir::block_num_t>& latches() const { return latches_; }
+  // Exiting blocks are loop blocks with at least one child outside the loop.
+  const std::unordered_set<ir::block_num_t>& exiting_blocks() const { return exiting_blocks_; }
+
+  bool Contains(ir::block_num_t bnum) const { return blocks_.contains(bnum); }
+
+  Loop* parent() const { return parent_; }
+  const std::vector<Loop*>& children() const { return children_; }
+  // The depth of outermost loops is one.
+  int64_t depth() const { return depth_; }
+
+ private:
+  Loop(ir::block_num_t header, ir::block_num_t preheader,
+       std::unordered_set<ir::block_num_t> blocks, std::unordered_set<ir::block_num_t> latches,
+       std::unordered_set<ir::block_num_t> exiting_blocks)
+      : header_(header),
+        preheader_(preheader),
+        blocks_(blocks),
+        latches_(latches),
+        exiting_blocks_(exiting_blocks) {}
+
+  ir::block_num_t header_;
+  ir::block_num_t preheader_;
+  std::unordered_set<ir::block_num_t> blocks_;
+  std::unordered_set<ir::block_num_t> latches_;
+  std::unordered_set<ir::block_num_t> exiting_blocks_;
+
+  Loop* parent_ = nullptr;
+  std::vector<Loop*> children_;
+  int64_t depth_ = 1;
+
+  friend class LoopInfo;
+};
+
+class LoopInfo {
+ public:
+  // Returns all loops ordered such that outer loops precede the loops nested in them.
+  const std::vector<std::unique_ptr<Loop>>& loops() const { return loops_; }
+  std::vector<Loop*> TopLevelLoops() const;
+
+  Loop* GetLoopWithHeader(ir::block_num_t header) const;
+  // Returns the innermost loop containing the given block or nullptr if the block is not part of a
+  // loop.
+  Loop* InnermostLoopOfBlock(ir::block_num_t bnum) const;
+  // Returns the number of loops containing the given block.
+  int64_t LoopDepthOfBlock(ir::block_num_t bnum) const;
+
+  // Loops have to be added such that outer loops precede the loops nested in them.
+  Loop* AddLoop(ir::block_num_t header, ir::block_num_t preheader,
+                std::unordered_set<ir::block_num_t> blocks,
+                std::unordered_set<ir::block_num_t> latches,
+                std::unordered_set<ir::block_num_t> exiting_blocks);
+
+  std::string ToString() const;
+
+ private:
+  std::vector<std::unique_ptr<Loop>> loops_;
+  std::unordered_map<ir::block_num_t, Loop*> loops_by_header_;
+  std::unordered_map<ir::block_num_t, Loop*> innermost_loops_;
+};
+
+}  // namespace ir_info
+
+#endif /* ir_info_loop_info_h */
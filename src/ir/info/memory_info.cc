@@ -0,0 +1,65 @@
+//
+//  memory_info.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "memory_info.h"
+
+namespace ir_info {
+
+bool MemoryInfo::IsStackAllocation(ir::value_num_t pointer) const {
+  auto it = allocations_.find(pointer);
+  return it != allocations_.end() && it->second;
+}
+
+void MemoryInfo::AddAllocation(ir::value_num_t pointer, bool on_stack) {
+  allocations_.insert({pointer, on_stack});
+}
+
+void MemoryInfo::AddPointerOffset(ir::value_num_t result, ir::value_num_t pointer,
+                                  int64_t offset) {
+  pointer_offsets_.insert({result, PointerOffset{.pointer = pointer, .offset = offset}});
+}
+
+std::optional<MemoryLocation> MemoryInfo::LocationOf(const ir::Value* address,
+                                                     int64_t size) const {
+  if (address->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  MemoryLocation location{
+      .base = static_cast<const ir::Computed*>(address)->number(),
+      .offset = 0,
+      .size = size,
+  };
+  for (auto it = pointer_offsets_.find(location.base); it != pointer_offsets_.end();
+       it = pointer_offsets_.find(location.base)) {
+    location.base = it->second.pointer;
+    location.offset += it->second.offset;
+  }
+  return location;
+}
+
+bool MemoryInfo::MayAlias(const MemoryLocation& location_a,
+                          const MemoryLocation& location_b) const {
+  if (location_a.base == location_b.base) {
+    return location_a.offset < location_b.offset + location_b.size &&
+           location_b.offset < location_a.offset + location_a.size;
+  }
+  // Distinct allocations never overlap:
+  return !IsAllocation(location_a.base) || !IsAllocation(location_b.base);
+}
+
+bool MemoryInfo::MayAlias(const ir::Value* address_a, int64_t size_a, const ir::Value* address_b,
+                          int64_t size_b) const {
+  std::optional<MemoryLocation> location_a = LocationOf(address_a, size_a);
+  std::optional<MemoryLocation> location_b = LocationOf(address_b, size_b);
+  if (!location_a.has_value() || !location_b.has_value()) {
+    return true;
+  }
+  return MayAlias(*location_a, *location_b);
+}
+
+}  // namespace ir_info
@@ -0,0 +1,67 @@
+//
+//  memory_info.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_info_memory_info_h
+#define ir_info_memory_info_h
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_info {
+
+// A range of bytes, expressed as a base pointer and a constant byte offset from it.
+struct MemoryLocation {
+  ir::value_num_t base;
+  int64_t offset;
+  int64_t size;
+
+  // Returns if all bytes of the other location are part of this location.
+  bool Covers(const MemoryLocation& that) const {
+    return base == that.base && offset <= that.offset &&
+           that.offset + that.size <= offset + size;
+  }
+};
+
+// MemoryInfo records which pointers in a func are results of allocation instrs and which pointers
+// are constant offsets from other pointers. This allows distinguishing memory accesses to
+// different allocation sites and to different fields of the same allocation.
+class MemoryInfo {
+ public:
+  bool IsAllocation(ir::value_num_t pointer) const { return allocations_.contains(pointer); }
+  bool IsStackAllocation(ir::value_num_t pointer) const;
+  void AddAllocation(ir::value_num_t pointer, bool on_stack);
+
+  void AddPointerOffset(ir::value_num_t result, ir::value_num_t pointer, int64_t offset);
+
+  // Returns the location accessed with the given size through the address. Returns std::nullopt
+  // if the address is not a computed value.
+  std::optional<MemoryLocation> LocationOf(const ir::Value* address, int64_t size) const;
+
+  // Returns false only if the locations are known to not overlap: either because they have the
+  // same base and disjoint offsets or because their bases are distinct allocations.
+  bool MayAlias(const MemoryLocation& location_a, const MemoryLocation& location_b) const;
+  bool MayAlias(const ir::Value* address_a, int64_t size_a, const ir::Value* address_b,
+                int64_t size_b) const;
+
+ private:
+  struct PointerOffset {
+    ir::value_num_t pointer;
+    int64_t offset;
+  };
+
+  std::unordered_map<ir::value_num_t, bool> allocations_;
+  std::unordered_map<ir::value_num_t, PointerOffset> pointer_offsets_;
+};
+
+}  // namespace ir_info
+
+#endif /* ir_info_memory_info_h */
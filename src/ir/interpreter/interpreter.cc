@@ -56,6 +56,9 @@ void Interpreter::ExecuteStep() {
 void Interpreter::ExecuteFuncExit() {
   std::vector<std::shared_ptr<ir::Constant>> results =
       stack_.current_frame()->exec_point().results();
+  for (auto [instr, address] : stack_.current_frame()->stack_allocations()) {
+    heap_.Free(address);
+  }
   stack_.PopCurrentFrame();
 
   if (stack_.depth() == 0) {
@@ -103,6 +106,9 @@ void Interpreter::ExecuteInstr(ir::Instr* instr) {
     case ir::InstrKind::kMalloc:
       ExecuteMallocInstr(static_cast<ir::MallocInstr*>(instr));
       break;
+    case ir::InstrKind::kStackAlloc:
+      ExecuteStackAllocInstr(static_cast<ir::StackAllocInstr*>(instr));
+      break;
     case ir::InstrKind::kLoad:
       ExecuteLoadInstr(static_cast<ir::LoadInstr*>(instr));
       break;
@@ -180,6 +186,17 @@ void Interpreter::ExecuteConversion(ir::Conversion* instr) {
       stack_.current_frame()->computed_values().insert_or_assign(result_num,
                                                                  ir::ToIntConstant(result));
       return;
+
+    } else if (operand_type_kind == ir::TypeKind::kFunc) {
+      // Func values convert to their func number, such that equal funcs have equal ints:
+      Int operand(uint64_t(EvaluateFunc(instr->operand())));
+      if (!operand.CanConvertTo(result_int_type)) {
+        fail("can not handle conversion instr");
+      }
+      Int result = operand.ConvertTo(result_int_type);
+      stack_.current_frame()->computed_values().insert_or_assign(result_num,
+                                                                 ir::ToIntConstant(result));
+      return;
     }
   }
 
@@ -246,6 +263,18 @@ void Interpreter::ExecuteMallocInstr(ir::MallocInstr* instr) {
                                                              ir::ToPointerConstant(address));
 }
 
+void Interpreter::ExecuteStackAllocInstr(ir::StackAllocInstr* instr) {
+  // Like stack slots in compiled code, every execution of the instr in a frame yields the same
+  // address:
+  auto it = stack_.current_frame()->stack_allocations().find(instr);
+  if (it == stack_.current_frame()->stack_allocations().end()) {
+    int64_t size = EvaluateInt(instr->size()).AsInt64();
+    it = stack_.current_frame()->stack_allocations().insert({instr, heap_.Malloc(size)}).first;
+  }
+  stack_.current_frame()->computed_values().insert_or_assign(instr->result()->number(),
+                                                             ir::ToPointerConstant(it->second));
+}
+
 void Interpreter::ExecuteLoadInstr(ir::LoadInstr* instr) {
   int64_t address = EvaluatePointer(instr->address());
   const ir::Type* result_type = instr->result()->type();
@@ -63,6 +63,7 @@ class Interpreter {
   void ExecuteNilTestInstr(ir::NilTestInstr* instr);
 
   void ExecuteMallocInstr(ir::MallocInstr* instr);
+  void ExecuteStackAllocInstr(ir::StackAllocInstr* instr);
   void ExecuteLoadInstr(ir::LoadInstr* instr);
   void ExecuteStoreInstr(ir::StoreInstr* instr);
   void ExecuteFreeInstr(ir::FreeInstr* instr);
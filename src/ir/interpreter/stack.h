@@ -36,6 +36,11 @@ class StackFrame {
   std::unordered_map<ir::value_num_t, std::shared_ptr<ir::Constant>>& computed_values() {
     return computed_values_;
   }
+  // Maps stack alloc instrs executed in the frame to the addresses they allocated.
+  const std::unordered_map<const ir::Instr*, int64_t>& stack_allocations() const {
+    return stack_allocations_;
+  }
+  std::unordered_map<const ir::Instr*, int64_t>& stack_allocations() { return stack_allocations_; }
 
  private:
   StackFrame(StackFrame* parent, ir::Func* func)
@@ -46,6 +51,7 @@ class StackFrame {
 
   ExecutionPoint exec_point_;
   std::unordered_map<ir::value_num_t, std::shared_ptr<ir::Constant>> computed_values_;
+  std::unordered_map<const ir::Instr*, int64_t> stack_allocations_;
 
   friend class Stack;
 };
@@ -56,6 +56,7 @@ enum class IssueKind {
   kPointerOffsetInstrDoesNotHaveOneResult,
   kNilTestInstrDoesNotHaveOneResult,
   kMallocInstrDoesNotHaveOneResult,
+  kStackAllocInstrDoesNotHaveOneResult,
   kLoadInstrDoesNotHaveOneResult,
   kStoreInstrHasResults,
   kFreeInstrHasResults,
@@ -114,6 +115,8 @@ enum class IssueKind {
   kNilTestInstrResultDoesNotHaveBoolType,
   kMallocInstrSizeDoesNotHaveI64Type,
   kMallocInstrResultDoesNotHavePointerType,
+  kStackAllocInstrSizeIsNotPositiveI64Constant,
+  kStackAllocInstrResultDoesNotHavePointerType,
   kLoadInstrAddressDoesNotHavePointerType,
   kStoreInstrAddressDoesNotHavePointerType,
   kFreeInstrAddressDoesNotHavePointerType,
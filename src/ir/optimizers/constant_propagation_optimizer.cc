@@ -0,0 +1,518 @@
+//
+//  constant_propagation_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/12/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "constant_propagation_optimizer.h"
+
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/common/logging/logging.h"
+#include "src/ir/analyzers/func_values_builder.h"
+#include "src/ir/info/func_values.h"
+#include "src/ir/processors/value_replacer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::atomics::Bool;
+using ::common::atomics::Int;
+using ::common::atomics::IntType;
+using ::common::logging::fail;
+
+// Lattice element describing what is known about a computed value: either nothing yet (no
+// executable definition was evaluated), a constant, or that it is not a constant (overdefined).
+struct ValueState {
+  enum class Kind {
+    kUnknown,
+    kConstant,
+    kOverdefined,
+  };
+
+  static ValueState Unknown() {
+    return ValueState{.kind = Kind::kUnknown, .constant = nullptr};
+  }
+  static ValueState Constant(std::shared_ptr<ir::Constant> constant) {
+    return ValueState{.kind = Kind::kConstant, .constant = constant};
+  }
+  static ValueState Overdefined() {
+    return ValueState{.kind = Kind::kOverdefined, .constant = nullptr};
+  }
+
+  bool is_unknown() const { return kind == Kind::kUnknown; }
+  bool is_constant() const { return kind == Kind::kConstant; }
+  bool is_overdefined() const { return kind == Kind::kOverdefined; }
+
+  Int int_value() const { return static_cast<ir::IntConstant*>(constant.get())->value(); }
+  bool bool_value() const { return static_cast<ir::BoolConstant*>(constant.get())->value(); }
+
+  Kind kind;
+  std::shared_ptr<ir::Constant> constant;
+};
+
+ValueState Meet(const ValueState& a, const ValueState& b) {
+  if (a.is_unknown()) return b;
+  if (b.is_unknown()) return a;
+  if (a.is_overdefined() || b.is_overdefined()) return ValueState::Overdefined();
+  if (ir::IsEqual(a.constant.get(), b.constant.get())) return a;
+  return ValueState::Overdefined();
+}
+
+// Returns the state of an instr result if any of its operands is not a constant.
+ValueState NonConstantOperandsState(std::initializer_list<ValueState> operands) {
+  for (const ValueState& operand : operands) {
+    if (operand.is_unknown()) return ValueState::Unknown();
+  }
+  return ValueState::Overdefined();
+}
+
+bool AllConstant(std::initializer_list<ValueState> operands) {
+  for (const ValueState& operand : operands) {
+    if (!operand.is_constant()) return false;
+  }
+  return true;
+}
+
+class ConstantPropagator {
+ public:
+  ConstantPropagator(ir::Func* func)
+      : func_(func), func_values_(ir_analyzers::FindValuesInFunc(func)) {}
+
+  void PropagateConstants();
+
+ private:
+  void FindExecutableCode();
+  void MarkEdgeExecutable(ir::block_num_t parent_num, ir::block_num_t child_num);
+  void VisitInstr(ir::Instr* instr, ir::Block* block);
+  void VisitJumpCondInstr(ir::JumpCondInstr* instr, ir::Block* block);
+
+  ValueState StateOf(const std::shared_ptr<ir::Value>& value) const;
+  void SetState(const ir::Computed* value, ValueState state);
+
+  ValueState EvaluatePhiInstr(ir::PhiInstr* instr, ir::Block* block) const;
+  ValueState EvaluateConversion(ir::Conversion* instr) const;
+  ValueState EvaluateBoolNotInstr(ir::BoolNotInstr* instr) const;
+  ValueState EvaluateBoolBinaryInstr(ir::BoolBinaryInstr* instr) const;
+  ValueState EvaluateIntUnaryInstr(ir::IntUnaryInstr* instr) const;
+  ValueState EvaluateIntCompareInstr(ir::IntCompareInstr* instr) const;
+  ValueState EvaluateIntBinaryInstr(ir::IntBinaryInstr* instr) const;
+  ValueState EvaluateIntShiftInstr(ir::IntShiftInstr* instr) const;
+
+  void RemoveConstantJumpConds();
+  void RemoveUnexecutableBlocks();
+  void RemovePhiArgsFromBlock(ir::Block* block, ir::block_num_t origin);
+  void RemovePhisInBlocksWithSingleParent();
+  void RemoveConstantComputations();
+
+  ir::Func* func_;
+  const ir_info::FuncValues func_values_;
+  std::unordered_map<const ir::Instr*, ir::Block*> instr_blocks_;
+
+  std::unordered_map<ir::value_num_t, ValueState> states_;
+  std::unordered_set<ir::block_num_t> executable_blocks_;
+  std::set<std::pair<ir::block_num_t, ir::block_num_t>> executable_edges_;
+
+  std::vector<std::pair<ir::block_num_t, ir::block_num_t>> edge_worklist_;
+  std::vector<ir::Instr*> instr_worklist_;
+};
+
+void ConstantPropagator::PropagateConstants() {
+  FindExecutableCode();
+
+  ir_processors::ValueReplacements replacements;
+  for (const auto& [value_num, state] : states_) {
+    if (state.is_constant()) {
+      replacements.insert({value_num, state.constant});
+    }
+  }
+
+  RemoveConstantJumpConds();
+  RemoveUnexecutableBlocks();
+  ir_processors::ReplaceValuesInFunc(func_, replacements);
+  RemovePhisInBlocksWithSingleParent();
+  RemoveConstantComputations();
+}
+
+void ConstantPropagator::FindExecutableCode() {
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      instr_blocks_.insert({instr.get(), block.get()});
+    }
+  }
+  for (const std::shared_ptr<ir::Computed>& arg : func_->args()) {
+    states_.insert({arg->number(), ValueState::Overdefined()});
+  }
+
+  edge_worklist_.push_back({ir::kNoBlockNum, func_->entry_block_num()});
+  while (!edge_worklist_.empty() || !instr_worklist_.empty()) {
+    if (!edge_worklist_.empty()) {
+      auto [parent_num, child_num] = edge_worklist_.back();
+      edge_worklist_.pop_back();
+      if (!executable_edges_.insert({parent_num, child_num}).second) {
+        continue;
+      }
+      ir::Block* child = func_->GetBlock(child_num);
+      if (executable_blocks_.insert(child_num).second) {
+        for (const std::unique_ptr<ir::Instr>& instr : child->instrs()) {
+          VisitInstr(instr.get(), child);
+        }
+      } else {
+        child->ForEachPhiInstr([&](ir::PhiInstr* phi_instr) { VisitInstr(phi_instr, child); });
+      }
+
+    } else {
+      ir::Instr* instr = instr_worklist_.back();
+      instr_worklist_.pop_back();
+      ir::Block* block = instr_blocks_.at(instr);
+      if (executable_blocks_.contains(block->number())) {
+        VisitInstr(instr, block);
+      }
+    }
+  }
+}
+
+void ConstantPropagator::MarkEdgeExecutable(ir::block_num_t parent_num,
+                                            ir::block_num_t child_num) {
+  if (!executable_edges_.contains({parent_num, child_num})) {
+    edge_worklist_.push_back({parent_num, child_num});
+  }
+}
+
+void ConstantPropagator::VisitInstr(ir::Instr* instr, ir::Block* block) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov: {
+      auto mov_instr = static_cast<ir::MovInstr*>(instr);
+      SetState(mov_instr->result().get(), StateOf(mov_instr->origin()));
+      return;
+    }
+    case ir::InstrKind::kPhi: {
+      auto phi_instr = static_cast<ir::PhiInstr*>(instr);
+      SetState(phi_instr->result().get(), EvaluatePhiInstr(phi_instr, block));
+      return;
+    }
+    case ir::InstrKind::kConversion: {
+      auto conversion = static_cast<ir::Conversion*>(instr);
+      SetState(conversion->result().get(), EvaluateConversion(conversion));
+      return;
+    }
+    case ir::InstrKind::kBoolNot: {
+      auto bool_not_instr = static_cast<ir::BoolNotInstr*>(instr);
+      SetState(bool_not_instr->result().get(), EvaluateBoolNotInstr(bool_not_instr));
+      return;
+    }
+    case ir::InstrKind::kBoolBinary: {
+      auto bool_binary_instr = static_cast<ir::BoolBinaryInstr*>(instr);
+      SetState(bool_binary_instr->result().get(), EvaluateBoolBinaryInstr(bool_binary_instr));
+      return;
+    }
+    case ir::InstrKind::kIntUnary: {
+      auto int_unary_instr = static_cast<ir::IntUnaryInstr*>(instr);
+      SetState(int_unary_instr->result().get(), EvaluateIntUnaryInstr(int_unary_instr));
+      return;
+    }
+    case ir::InstrKind::kIntCompare: {
+      auto int_compare_instr = static_cast<ir::IntCompareInstr*>(instr);
+      SetState(int_compare_instr->result().get(), EvaluateIntCompareInstr(int_compare_instr));
+      return;
+    }
+    case ir::InstrKind::kIntBinary: {
+      auto int_binary_instr = static_cast<ir::IntBinaryInstr*>(instr);
+      SetState(int_binary_instr->result().get(), EvaluateIntBinaryInstr(int_binary_instr));
+      return;
+    }
+    case ir::InstrKind::kIntShift: {
+      auto int_shift_instr = static_cast<ir::IntShiftInstr*>(instr);
+      SetState(int_shift_instr->result().get(), EvaluateIntShiftInstr(int_shift_instr));
+      return;
+    }
+    case ir::InstrKind::kJump:
+      MarkEdgeExecutable(block->number(), static_cast<ir::JumpInstr*>(instr)->destination());
+      return;
+    case ir::InstrKind::kJumpCond:
+      VisitJumpCondInstr(static_cast<ir::JumpCondInstr*>(instr), block);
+      return;
+    default:
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        SetState(defined_value.get(), ValueState::Overdefined());
+      }
+      return;
+  }
+}
+
+void ConstantPropagator::VisitJumpCondInstr(ir::JumpCondInstr* instr, ir::Block* block) {
+  ValueState condition = StateOf(instr->condition());
+  if (condition.is_unknown()) {
+    return;
+  } else if (condition.is_constant()) {
+    MarkEdgeExecutable(block->number(), condition.bool_value() ? instr->destination_true()
+                                                               : instr->destination_false());
+  } else {
+    MarkEdgeExecutable(block->number(), instr->destination_true());
+    MarkEdgeExecutable(block->number(), instr->destination_false());
+  }
+}
+
+ValueState ConstantPropagator::StateOf(const std::shared_ptr<ir::Value>& value) const {
+  switch (value->kind()) {
+    case ir::Value::Kind::kConstant:
+      return ValueState::Constant(std::static_pointer_cast<ir::Constant>(value));
+    case ir::Value::Kind::kComputed: {
+      auto it = states_.find(static_cast<ir::Computed*>(value.get())->number());
+      return (it != states_.end()) ? it->second : ValueState::Unknown();
+    }
+    case ir::Value::Kind::kInherited:
+      return StateOf(static_cast<ir::InheritedValue*>(value.get())->value());
+    default:
+      fail("unexpected value kind");
+  }
+}
+
+void ConstantPropagator::SetState(const ir::Computed* value, ValueState state) {
+  ValueState& old_state = states_.try_emplace(value->number(), ValueState::Unknown()).first->second;
+  if (old_state.kind == state.kind &&
+      (!state.is_constant() || ir::IsEqual(old_state.constant.get(), state.constant.get()))) {
+    return;
+  } else if (old_state.is_overdefined()) {
+    return;
+  }
+  old_state = state;
+  for (ir::Instr* using_instr : func_values_.GetInstrsUsingValue(value->number())) {
+    instr_worklist_.push_back(using_instr);
+  }
+}
+
+ValueState ConstantPropagator::EvaluatePhiInstr(ir::PhiInstr* instr, ir::Block* block) const {
+  ValueState state = ValueState::Unknown();
+  for (const std::shared_ptr<ir::InheritedValue>& arg : instr->args()) {
+    if (executable_edges_.contains({arg->origin(), block->number()})) {
+      state = Meet(state, StateOf(arg->value()));
+    }
+  }
+  return state;
+}
+
+ValueState ConstantPropagator::EvaluateConversion(ir::Conversion* instr) const {
+  ValueState operand = StateOf(instr->operand());
+  if (!AllConstant({operand})) {
+    return NonConstantOperandsState({operand});
+  }
+  const ir::Type* result_type = instr->result()->type();
+  ir::TypeKind result_type_kind = result_type->type_kind();
+  ir::TypeKind operand_type_kind = instr->operand()->type()->type_kind();
+
+  if (result_type_kind == ir::TypeKind::kBool && operand_type_kind == ir::TypeKind::kInt) {
+    return ValueState::Constant(ir::ToBoolConstant(operand.int_value().ConvertToBool()));
+
+  } else if (result_type_kind == ir::TypeKind::kInt) {
+    IntType result_int_type = static_cast<const ir::IntType*>(result_type)->int_type();
+    if (operand_type_kind == ir::TypeKind::kBool) {
+      return ValueState::Constant(
+          ir::ToIntConstant(Bool::ConvertTo(result_int_type, operand.bool_value())));
+    } else if (operand_type_kind == ir::TypeKind::kInt &&
+               operand.int_value().CanConvertTo(result_int_type)) {
+      return ValueState::Constant(
+          ir::ToIntConstant(operand.int_value().ConvertTo(result_int_type)));
+    }
+  }
+  return ValueState::Overdefined();
+}
+
+ValueState ConstantPropagator::EvaluateBoolNotInstr(ir::BoolNotInstr* instr) const {
+  ValueState operand = StateOf(instr->operand());
+  if (!AllConstant({operand})) {
+    return NonConstantOperandsState({operand});
+  }
+  return ValueState::Constant(ir::ToBoolConstant(!operand.bool_value()));
+}
+
+ValueState ConstantPropagator::EvaluateBoolBinaryInstr(ir::BoolBinaryInstr* instr) const {
+  ValueState a = StateOf(instr->operand_a());
+  ValueState b = StateOf(instr->operand_b());
+  if (!AllConstant({a, b})) {
+    return NonConstantOperandsState({a, b});
+  }
+  return ValueState::Constant(
+      ir::ToBoolConstant(Bool::Compute(a.bool_value(), instr->operation(), b.bool_value())));
+}
+
+ValueState ConstantPropagator::EvaluateIntUnaryInstr(ir::IntUnaryInstr* instr) const {
+  ValueState operand = StateOf(instr->operand());
+  if (!AllConstant({operand})) {
+    return NonConstantOperandsState({operand});
+  } else if (!Int::CanCompute(instr->operation(), operand.int_value())) {
+    return ValueState::Overdefined();
+  }
+  return ValueState::Constant(
+      ir::ToIntConstant(Int::Compute(instr->operation(), operand.int_value())));
+}
+
+ValueState ConstantPropagator::EvaluateIntCompareInstr(ir::IntCompareInstr* instr) const {
+  ValueState a = StateOf(instr->operand_a());
+  ValueState b = StateOf(instr->operand_b());
+  if (!AllConstant({a, b})) {
+    return NonConstantOperandsState({a, b});
+  } else if (!Int::CanCompare(a.int_value(), b.int_value())) {
+    return ValueState::Overdefined();
+  }
+  return ValueState::Constant(
+      ir::ToBoolConstant(Int::Compare(a.int_value(), instr->operation(), b.int_value())));
+}
+
+ValueState ConstantPropagator::EvaluateIntBinaryInstr(ir::IntBinaryInstr* instr) const {
+  ValueState a = StateOf(instr->operand_a());
+  ValueState b = StateOf(instr->operand_b());
+  if (!AllConstant({a, b})) {
+    return NonConstantOperandsState({a, b});
+  } else if (!Int::CanCompute(a.int_value(), b.int_value())) {
+    return ValueState::Overdefined();
+  }
+  switch (instr->operation()) {
+    case Int::BinaryOp::kDiv:
+    case Int::BinaryOp::kRem:
+      // Leave traps and overflows to run time:
+      if (b.int_value().IsZero() || (a.int_value().IsMin() && b.int_value().IsMinusOne())) {
+        return ValueState::Overdefined();
+      }
+      break;
+    default:
+      break;
+  }
+  return ValueState::Constant(
+      ir::ToIntConstant(Int::Compute(a.int_value(), instr->operation(), b.int_value())));
+}
+
+ValueState ConstantPropagator::EvaluateIntShiftInstr(ir::IntShiftInstr* instr) const {
+  ValueState shifted = StateOf(instr->shifted());
+  ValueState offset = StateOf(instr->offset());
+  if (!AllConstant({shifted, offset})) {
+    return NonConstantOperandsState({shifted, offset});
+  }
+  Int offset_value = offset.int_value();
+  if (offset_value.IsLessThanZero() ||
+      offset_value.AsUint64() >= uint64_t(common::atomics::BitSizeOf(shifted.int_value().type()))) {
+    return ValueState::Overdefined();
+  }
+  return ValueState::Constant(
+      ir::ToIntConstant(Int::Shift(shifted.int_value(), instr->operation(), offset_value)));
+}
+
+void ConstantPropagator::RemoveConstantJumpConds() {
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    if (!executable_blocks_.contains(block->number()) ||
+        block->ControlFlowInstr()->instr_kind() != ir::InstrKind::kJumpCond) {
+      continue;
+    }
+    auto jump_cond_instr = static_cast<ir::JumpCondInstr*>(block->ControlFlowInstr());
+    ValueState condition = StateOf(jump_cond_instr->condition());
+    if (!condition.is_constant()) {
+      continue;
+    }
+    ir::block_num_t destination = condition.bool_value() ? jump_cond_instr->destination_true()
+                                                          : jump_cond_instr->destination_false();
+    ir::block_num_t skipped = condition.bool_value() ? jump_cond_instr->destination_false()
+                                                     : jump_cond_instr->destination_true();
+    block->instrs().back() = std::make_unique<ir::JumpInstr>(destination);
+    if (skipped != destination) {
+      func_->RemoveControlFlow(block->number(), skipped);
+      RemovePhiArgsFromBlock(func_->GetBlock(skipped), block->number());
+    }
+  }
+}
+
+void ConstantPropagator::RemoveUnexecutableBlocks() {
+  std::vector<ir::block_num_t> unexecutable_blocks;
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    if (!executable_blocks_.contains(block->number())) {
+      unexecutable_blocks.push_back(block->number());
+    }
+  }
+  for (ir::block_num_t block_num : unexecutable_blocks) {
+    ir::Block* block = func_->GetBlock(block_num);
+    for (ir::block_num_t child_num : block->children()) {
+      RemovePhiArgsFromBlock(func_->GetBlock(child_num), block_num);
+    }
+    func_->RemoveBlock(block_num);
+  }
+}
+
+void ConstantPropagator::RemovePhiArgsFromBlock(ir::Block* block, ir::block_num_t origin) {
+  block->ForEachPhiInstr([origin](ir::PhiInstr* phi_instr) {
+    std::erase_if(phi_instr->args(),
+                  [origin](const std::shared_ptr<ir::InheritedValue>& arg) {
+                    return arg->origin() == origin;
+                  });
+  });
+}
+
+void ConstantPropagator::RemovePhisInBlocksWithSingleParent() {
+  ir_processors::ValueReplacements replacements;
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    if (block->parents().size() != 1) {
+      continue;
+    }
+    std::erase_if(block->instrs(), [&](const std::unique_ptr<ir::Instr>& instr) {
+      if (instr->instr_kind() != ir::InstrKind::kPhi) {
+        return false;
+      }
+      auto phi_instr = static_cast<ir::PhiInstr*>(instr.get());
+      replacements.insert({phi_instr->result()->number(), phi_instr->args().front()->value()});
+      return true;
+    });
+  }
+  ir_processors::ReplaceValuesInFunc(func_, replacements);
+}
+
+void ConstantPropagator::RemoveConstantComputations() {
+  const ir_info::FuncValues func_values = ir_analyzers::FindValuesInFunc(func_);
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    std::erase_if(block->instrs(), [&](const std::unique_ptr<ir::Instr>& instr) {
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kMov:
+        case ir::InstrKind::kPhi:
+        case ir::InstrKind::kConversion:
+        case ir::InstrKind::kBoolNot:
+        case ir::InstrKind::kBoolBinary:
+        case ir::InstrKind::kIntUnary:
+        case ir::InstrKind::kIntCompare:
+        case ir::InstrKind::kIntBinary:
+        case ir::InstrKind::kIntShift:
+          break;
+        default:
+          return false;
+      }
+      ir::value_num_t result_num = static_cast<ir::Computation*>(instr.get())->result()->number();
+      auto it = states_.find(result_num);
+      return it != states_.end() && it->second.is_constant() &&
+             func_values.GetInstrsUsingValue(result_num).empty();
+    });
+  }
+}
+
+}  // namespace
+
+void PropagateConstantsInFunc(ir::Func* func) {
+  ConstantPropagator propagator(func);
+  propagator.PropagateConstants();
+}
+
+void PropagateConstantsInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    PropagateConstantsInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,25 @@
+//
+//  constant_propagation_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/12/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_constant_propagation_optimizer_h
+#define ir_optimizers_constant_propagation_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Performs sparse conditional constant propagation: values that are constant on all executable
+// paths get replaced with constants, conditional jumps with constant conditions become
+// unconditional jumps, and blocks that can never execute get removed.
+void PropagateConstantsInFunc(ir::Func* func);
+void PropagateConstantsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_constant_propagation_optimizer_h */
@@ -0,0 +1,226 @@
+//
+//  constant_propagation_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/12/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/constant_propagation_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+#include "src/lang/processors/ir/check/check_test_util.h"
+#include "src/lang/processors/ir/serialization/parse.h"
+
+class ConstantPropagationImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(ConstantPropagationImpossibleTestInstance,
+                         ConstantPropagationImpossibleTest, testing::Values(R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %0, %1
+    ret %2
+}
+)ir",
+                                                                            R"ir(
+@0 f() => (i64) {
+  {0}
+    %0:i64 = idiv #1:i64, #0:i64
+    ret %0
+}
+)ir",
+                                                                            R"ir(
+@0 f() => (i8) {
+  {0}
+    %0:i8 = irem #-128:i8, #-1:i8
+    ret %0
+}
+)ir",
+                                                                            R"ir(
+@0 f(%0:b) => (i64) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    jmp {2}
+  {2}
+    %1:i64 = phi #1:i64{0}, #2:i64{1}
+    ret %1
+}
+)ir"));
+
+TEST_P(ConstantPropagationImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::PropagateConstantsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(input_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class ConstantPropagationPossibleTest
+    : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(ConstantPropagationPossibleTestInstance, ConstantPropagationPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f() => (i32) {
+  {0}
+    %0:i64 = iadd #1:i64, #2:i64
+    %1:i64 = imul %0, #3:i64
+    %2:i64 = ishl %1, #2:u64
+    %3:i32 = conv %2
+    %4:i32 = ineg %3
+    ret %4
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f() => (i32) {
+  {0}
+    ret #-36:i32
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:b = ilss #1:i64, #2:i64
+    jcc %1, {1}, {2}
+  {1}
+    %2:i64 = iadd %0, #1:i64
+    jmp {3}
+  {2}
+    %3:i64 = isub %0, #1:i64
+    jmp {3}
+  {3}
+    %4:i64 = phi %2{1}, %3{2}
+    ret %4
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = iadd %0, #1:i64
+    jmp {3}
+  {3}
+    ret %2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #7:i64{0}, %2{2}
+    jcc %0, {2}, {3}
+  {2}
+    %2:i64 = iadd %1, #0:i64
+    jmp {1}
+  {3}
+    %3:i64 = imul %1, #6:i64
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    jcc %0, {2}, {3}
+  {2}
+    jmp {1}
+  {3}
+    ret #42:i64
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:b = ieq #3:i64, #4:i64
+    jcc %1, {1}, {2}
+  {1}
+    %2:i64 = idiv %0, #0:i64
+    jmp {2}
+  {2}
+    %3:i64 = phi %0{0}, %2{1}
+    %4:i64 = iadd %3, #1:i64
+    ret %4
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {2}
+  {2}
+    %4:i64 = iadd %0, #1:i64
+    ret %4
+}
+)ir",
+                             }));
+
+TEST_P(ConstantPropagationPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::PropagateConstantsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(ConstantPropagationTest, ReplacesConstantsUsedByLangInstrs) {
+  std::unique_ptr<ir::Program> optimized_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:lstr) => (i8, lstr) {
+  {0}
+    %1:i64 = iadd #1:i64, #2:i64
+    %2:i8 = str_index %0, %1
+    %3:lstr = mov "a"
+    %4:lstr = str_cat %0, %3
+    ret %2, %4
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:lstr) => (i8, lstr) {
+  {0}
+    %2:i8 = str_index %0, #3:i64
+    %4:lstr = str_cat %0, "a"
+    ret %2, %4
+}
+)ir");
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::PropagateConstantsInProgram(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
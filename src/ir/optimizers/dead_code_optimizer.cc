@@ -0,0 +1,97 @@
+//
+//  dead_code_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "dead_code_optimizer.h"
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+bool IsRemovable(const ir::Instr* instr) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov:
+    case ir::InstrKind::kPhi:
+    case ir::InstrKind::kConversion:
+    case ir::InstrKind::kBoolNot:
+    case ir::InstrKind::kBoolBinary:
+    case ir::InstrKind::kIntUnary:
+    case ir::InstrKind::kIntCompare:
+    case ir::InstrKind::kIntBinary:
+    case ir::InstrKind::kIntShift:
+    case ir::InstrKind::kPointerOffset:
+    case ir::InstrKind::kNilTest:
+    case ir::InstrKind::kMalloc:
+    case ir::InstrKind::kStackAlloc:
+    case ir::InstrKind::kLoad:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+void RemoveDeadCodeInFunc(ir::Func* func) {
+  std::unordered_map<ir::value_num_t, ir::Instr*> defining_instrs;
+  std::unordered_set<ir::Instr*> live_instrs;
+  std::vector<ir::Instr*> live_instrs_worklist;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        defining_instrs.insert({defined_value->number(), instr.get()});
+      }
+      if (!IsRemovable(instr.get())) {
+        live_instrs.insert(instr.get());
+        live_instrs_worklist.push_back(instr.get());
+      }
+    }
+  }
+
+  while (!live_instrs_worklist.empty()) {
+    ir::Instr* live_instr = live_instrs_worklist.back();
+    live_instrs_worklist.pop_back();
+    for (std::shared_ptr<ir::Value> used_value : live_instr->UsedValues()) {
+      if (used_value->kind() == ir::Value::Kind::kInherited) {
+        used_value = std::static_pointer_cast<ir::InheritedValue>(used_value)->value();
+      }
+      if (used_value->kind() != ir::Value::Kind::kComputed) {
+        continue;
+      }
+      auto it = defining_instrs.find(static_cast<ir::Computed*>(used_value.get())->number());
+      if (it == defining_instrs.end()) {
+        continue;  // func arg
+      }
+      if (live_instrs.insert(it->second).second) {
+        live_instrs_worklist.push_back(it->second);
+      }
+    }
+  }
+
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    std::erase_if(block->instrs(), [&live_instrs](const std::unique_ptr<ir::Instr>& instr) {
+      return !live_instrs.contains(instr.get());
+    });
+  }
+}
+
+void RemoveDeadCodeInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    RemoveDeadCodeInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
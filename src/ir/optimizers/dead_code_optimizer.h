@@ -0,0 +1,25 @@
+//
+//  dead_code_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_dead_code_optimizer_h
+#define ir_optimizers_dead_code_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Removes all computations without side effects whose results do not contribute to an instr with
+// side effects. Computations are assumed dead until proven live, which also removes cycles of
+// computations (such as phis in loops) that only use each other.
+void RemoveDeadCodeInFunc(ir::Func* func);
+void RemoveDeadCodeInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_dead_code_optimizer_h */
@@ -0,0 +1,114 @@
+//
+//  dead_code_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/dead_code_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+TEST(DeadCodeOptimizerTest, KeepsInstrsWithSideEffects) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %1, #1:i64
+    store %0, %2
+    %3:i64 = call @1
+    %4:i64 = imul %1, %1
+    ret %4
+}
+
+@1 g() => (i64) {
+  {0}
+    ret #0:i64
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(
+      ir_serialization::Print(program.get()));
+  ir_check::CheckProgramOrDie(program.get());
+
+  ir_optimizers::RemoveDeadCodeInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(program.get());
+}
+
+TEST(DeadCodeOptimizerTest, RemovesUnusedComputations) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:ptr = poff %0, #8:i64
+    %3:i64 = load %2
+    %4:i64 = iadd %3, %1
+    %5:ptr = malloc #8:i64
+    %6:b = ilss %1, #0:i64
+    ret %1
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    ret %1
+}
+)ir");
+  ir_check::CheckProgramOrDie(program.get());
+
+  ir_optimizers::RemoveDeadCodeInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(DeadCodeOptimizerTest, RemovesDeadPhiCycles) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %3{2}
+    %2:i64 = phi #0:i64{0}, %4{2}
+    %5:b = ilss %1, %0
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    %4:i64 = imul %2, #2:i64
+    jmp {1}
+  {3}
+    ret %1
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %3{2}
+    %5:b = ilss %1, %0
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %1
+}
+)ir");
+  ir_check::CheckProgramOrDie(program.get());
+
+  ir_optimizers::RemoveDeadCodeInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
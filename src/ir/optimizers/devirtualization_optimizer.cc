@@ -0,0 +1,381 @@
+//
+//  devirtualization_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "devirtualization_optimizer.h"
+
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/common/logging/logging.h"
+#include "src/ir/analyzers/func_call_graph_builder.h"
+#include "src/ir/info/func_call_graph.h"
+#include "src/ir/processors/block_splitter.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::atomics::Int;
+using ::common::logging::fail;
+
+// Func values that might refer to more funcs are treated as unknown.
+constexpr std::size_t kMaxTrackedFuncs = 8;
+// Calls with more possible callees remain indirect calls.
+constexpr std::size_t kMaxGuardedCallees = 3;
+
+// The funcs a func value might refer to. Unknown sets might refer to any func.
+struct FuncSet {
+  bool unknown = false;
+  std::set<ir::func_num_t> funcs;
+
+  static FuncSet Unknown() { return FuncSet{.unknown = true}; }
+
+  // Adds all funcs in the other set and returns if the set changed.
+  bool Join(const FuncSet& that) {
+    if (unknown) {
+      return false;
+    }
+    std::size_t old_size = funcs.size();
+    funcs.insert(that.funcs.begin(), that.funcs.end());
+    if (that.unknown || funcs.size() > kMaxTrackedFuncs) {
+      unknown = true;
+      funcs.clear();
+      return true;
+    }
+    return funcs.size() != old_size;
+  }
+};
+
+class FuncConstantPropagator {
+ public:
+  FuncConstantPropagator(ir::Program* program, const ir_info::FuncCallGraph& fcg)
+      : program_(program), fcg_(fcg) {}
+
+  void PropagateFuncConstants();
+
+  FuncSet FuncSetOfValue(const ir::Func* func, const ir::Value* value) const;
+
+ private:
+  bool VisitFunc(const ir::Func* func);
+  bool VisitCallInstr(const ir::Func* func, ir::CallInstr* instr);
+
+  bool JoinValue(const ir::Func* func, const ir::Computed* value, const FuncSet& set);
+  bool JoinArgs(ir::func_num_t callee_num, const ir::Func* caller,
+                const std::vector<std::shared_ptr<ir::Value>>& args);
+
+  ir::Program* program_;
+  const ir_info::FuncCallGraph& fcg_;
+  std::unordered_map<ir::func_num_t, std::unordered_map<ir::value_num_t, FuncSet>> value_sets_;
+  std::unordered_map<ir::func_num_t, std::vector<FuncSet>> arg_sets_;
+  std::unordered_map<ir::func_num_t, std::vector<FuncSet>> result_sets_;
+};
+
+void FuncConstantPropagator::PropagateFuncConstants() {
+  for (const std::unique_ptr<ir::Func>& func : program_->funcs()) {
+    arg_sets_[func->number()].resize(func->args().size());
+    result_sets_[func->number()].resize(func->result_types().size());
+  }
+  if (ir::Func* entry_func = program_->entry_func(); entry_func != nullptr) {
+    arg_sets_.at(entry_func->number()).assign(entry_func->args().size(), FuncSet::Unknown());
+  }
+
+  // Visit callers before callees, such that args propagate quickly:
+  std::vector<const ir::Func*> funcs;
+  std::vector<ir_info::Component*> components = fcg_.ComponentsInBottomUpOrder();
+  for (auto it = components.rbegin(); it != components.rend(); ++it) {
+    std::set<ir::func_num_t> members((*it)->members().begin(), (*it)->members().end());
+    for (ir::func_num_t member : members) {
+      if (program_->HasFunc(member)) {
+        funcs.push_back(program_->GetFunc(member));
+      }
+    }
+  }
+  for (bool changed = true; changed;) {
+    changed = false;
+    for (const ir::Func* func : funcs) {
+      changed |= VisitFunc(func);
+    }
+  }
+}
+
+FuncSet FuncConstantPropagator::FuncSetOfValue(const ir::Func* func,
+                                               const ir::Value* value) const {
+  switch (value->kind()) {
+    case ir::Value::Kind::kConstant:
+      return FuncSet{.funcs = {static_cast<const ir::FuncConstant*>(value)->value()}};
+    case ir::Value::Kind::kComputed: {
+      auto func_it = value_sets_.find(func->number());
+      if (func_it == value_sets_.end()) {
+        return FuncSet{};
+      }
+      auto value_it = func_it->second.find(static_cast<const ir::Computed*>(value)->number());
+      if (value_it == func_it->second.end()) {
+        return FuncSet{};
+      }
+      return value_it->second;
+    }
+    case ir::Value::Kind::kInherited:
+      return FuncSetOfValue(func, static_cast<const ir::InheritedValue*>(value)->value().get());
+    default:
+      fail("unexpected ir value kind");
+  }
+}
+
+bool FuncConstantPropagator::VisitFunc(const ir::Func* func) {
+  bool changed = false;
+  const std::vector<FuncSet>& arg_sets = arg_sets_.at(func->number());
+  for (std::size_t i = 0; i < func->args().size(); i++) {
+    changed |= JoinValue(func, func->args().at(i).get(), arg_sets.at(i));
+  }
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kMov: {
+          auto mov_instr = static_cast<ir::MovInstr*>(instr.get());
+          changed |= JoinValue(func, mov_instr->result().get(),
+                               FuncSetOfValue(func, mov_instr->origin().get()));
+          break;
+        }
+        case ir::InstrKind::kPhi: {
+          auto phi_instr = static_cast<ir::PhiInstr*>(instr.get());
+          for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+            changed |= JoinValue(func, phi_instr->result().get(), FuncSetOfValue(func, arg.get()));
+          }
+          break;
+        }
+        case ir::InstrKind::kCall:
+          changed |= VisitCallInstr(func, static_cast<ir::CallInstr*>(instr.get()));
+          break;
+        case ir::InstrKind::kReturn: {
+          auto return_instr = static_cast<ir::ReturnInstr*>(instr.get());
+          std::vector<FuncSet>& result_sets = result_sets_.at(func->number());
+          for (std::size_t i = 0; i < return_instr->args().size() && i < result_sets.size(); i++) {
+            if (return_instr->args().at(i)->type() == ir::func_type()) {
+              changed |= result_sets.at(i).Join(
+                  FuncSetOfValue(func, return_instr->args().at(i).get()));
+            }
+          }
+          break;
+        }
+        default:
+          // Func values loaded from memory or produced otherwise might refer to any func:
+          for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+            changed |= JoinValue(func, defined_value.get(), FuncSet::Unknown());
+          }
+          break;
+      }
+    }
+  }
+  return changed;
+}
+
+bool FuncConstantPropagator::VisitCallInstr(const ir::Func* func, ir::CallInstr* instr) {
+  bool changed = false;
+  FuncSet callees = FuncSetOfValue(func, instr->func().get());
+  if (callees.unknown) {
+    // The call graph contains all funcs that can get called indirectly:
+    for (ir::func_num_t callee_num : fcg_.FuncCallAtInstr(instr)->callees()) {
+      changed |= JoinArgs(callee_num, func, instr->args());
+    }
+    for (const std::shared_ptr<ir::Computed>& result : instr->results()) {
+      changed |= JoinValue(func, result.get(), FuncSet::Unknown());
+    }
+    return changed;
+  }
+  for (ir::func_num_t callee_num : callees.funcs) {
+    changed |= JoinArgs(callee_num, func, instr->args());
+    auto it = result_sets_.find(callee_num);
+    for (std::size_t i = 0; i < instr->results().size(); i++) {
+      if (it == result_sets_.end() || i >= it->second.size()) {
+        changed |= JoinValue(func, instr->results().at(i).get(), FuncSet::Unknown());
+      } else {
+        changed |= JoinValue(func, instr->results().at(i).get(), it->second.at(i));
+      }
+    }
+  }
+  return changed;
+}
+
+bool FuncConstantPropagator::JoinValue(const ir::Func* func, const ir::Computed* value,
+                                       const FuncSet& set) {
+  if (value->type() != ir::func_type()) {
+    return false;
+  }
+  return value_sets_[func->number()][value->number()].Join(set);
+}
+
+bool FuncConstantPropagator::JoinArgs(ir::func_num_t callee_num, const ir::Func* caller,
+                                      const std::vector<std::shared_ptr<ir::Value>>& args) {
+  auto it = arg_sets_.find(callee_num);
+  if (it == arg_sets_.end()) {
+    return false;
+  }
+  bool changed = false;
+  std::vector<FuncSet>& arg_sets = it->second;
+  for (std::size_t i = 0; i < args.size() && i < arg_sets.size(); i++) {
+    if (args.at(i)->type() == ir::func_type()) {
+      changed |= arg_sets.at(i).Join(FuncSetOfValue(caller, args.at(i).get()));
+    }
+  }
+  return changed;
+}
+
+class Devirtualizer {
+ public:
+  Devirtualizer(ir::Program* program, const FuncConstantPropagator& propagator)
+      : program_(program), propagator_(propagator) {}
+
+  void DevirtualizeCallsInFunc(ir::Func* func);
+
+ private:
+  std::vector<ir::func_num_t> CalleesOfCall(const ir::Func* func,
+                                            const ir::CallInstr* instr) const;
+  void GuardCall(ir::Func* func, ir::Block* block, std::size_t call_index,
+                 const std::vector<ir::func_num_t>& callees);
+
+  ir::Program* program_;
+  const FuncConstantPropagator& propagator_;
+};
+
+void Devirtualizer::DevirtualizeCallsInFunc(ir::Func* func) {
+  std::vector<std::pair<ir::Block*, ir::CallInstr*>> guarded_calls;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() != ir::InstrKind::kCall) {
+        continue;
+      }
+      auto call_instr = static_cast<ir::CallInstr*>(instr.get());
+      if (call_instr->func()->kind() != ir::Value::Kind::kComputed) {
+        continue;
+      }
+      std::vector<ir::func_num_t> callees = CalleesOfCall(func, call_instr);
+      if (callees.size() == 1) {
+        call_instr->set_func(ir::ToFuncConstant(callees.front()));
+      } else if (callees.size() > 1) {
+        guarded_calls.push_back({block.get(), call_instr});
+      }
+    }
+  }
+  // Guarding calls splits their blocks, so calls get processed from the back of each block:
+  for (auto it = guarded_calls.rbegin(); it != guarded_calls.rend(); ++it) {
+    auto [block, call_instr] = *it;
+    std::size_t call_index = 0;
+    while (block->instrs().at(call_index).get() != call_instr) {
+      call_index++;
+    }
+    GuardCall(func, block, call_index, CalleesOfCall(func, call_instr));
+  }
+}
+
+std::vector<ir::func_num_t> Devirtualizer::CalleesOfCall(const ir::Func* func,
+                                                         const ir::CallInstr* instr) const {
+  FuncSet callees = propagator_.FuncSetOfValue(func, instr->func().get());
+  if (callees.unknown || callees.funcs.size() > kMaxGuardedCallees) {
+    return {};
+  }
+  // All callees have to exist and match the signature of the call:
+  for (ir::func_num_t callee_num : callees.funcs) {
+    const ir::Func* callee = program_->GetFunc(callee_num);
+    if (callee == nullptr || callee->args().size() != instr->args().size() ||
+        callee->result_types().size() != instr->results().size()) {
+      return {};
+    }
+    for (std::size_t i = 0; i < instr->args().size(); i++) {
+      if (callee->args().at(i)->type() != instr->args().at(i)->type()) {
+        return {};
+      }
+    }
+    for (std::size_t i = 0; i < instr->results().size(); i++) {
+      if (callee->result_types().at(i) != instr->results().at(i)->type()) {
+        return {};
+      }
+    }
+  }
+  return std::vector<ir::func_num_t>(callees.funcs.begin(), callees.funcs.end());
+}
+
+void Devirtualizer::GuardCall(ir::Func* func, ir::Block* block, std::size_t call_index,
+                              const std::vector<ir::func_num_t>& callees) {
+  ir::Block* continuation_block = ir_processors::SplitBlockAfterInstr(func, block, call_index);
+  std::unique_ptr<ir::Instr> instr = std::move(block->instrs().back());
+  block->instrs().pop_back();
+  auto call_instr = static_cast<ir::CallInstr*>(instr.get());
+
+  auto func_value = std::make_shared<ir::Computed>(ir::u64(), func->next_computed_number());
+  block->instrs().push_back(std::make_unique<ir::Conversion>(func_value, call_instr->func()));
+
+  // Compare against all but the last callee, which gets called if no comparison succeeds:
+  std::vector<std::vector<std::shared_ptr<ir::InheritedValue>>> result_args(
+      call_instr->results().size());
+  ir::Block* guard_block = block;
+  for (std::size_t i = 0; i < callees.size(); i++) {
+    ir::Block* call_block = guard_block;
+    if (i + 1 < callees.size()) {
+      call_block = func->AddBlock();
+      ir::Block* next_guard_block = func->AddBlock();
+      auto callee_value = std::make_shared<ir::Computed>(ir::u64(), func->next_computed_number());
+      auto is_callee = std::make_shared<ir::Computed>(ir::bool_type(),
+                                                      func->next_computed_number());
+      guard_block->instrs().push_back(
+          std::make_unique<ir::Conversion>(callee_value, ir::ToFuncConstant(callees.at(i))));
+      guard_block->instrs().push_back(std::make_unique<ir::IntCompareInstr>(
+          is_callee, Int::CompareOp::kEq, func_value, callee_value));
+      guard_block->instrs().push_back(std::make_unique<ir::JumpCondInstr>(
+          is_callee, call_block->number(), next_guard_block->number()));
+      func->AddControlFlow(guard_block->number(), call_block->number());
+      func->AddControlFlow(guard_block->number(), next_guard_block->number());
+      guard_block = next_guard_block;
+    }
+
+    std::vector<std::shared_ptr<ir::Computed>> results;
+    results.reserve(call_instr->results().size());
+    for (std::size_t j = 0; j < call_instr->results().size(); j++) {
+      auto result = std::make_shared<ir::Computed>(call_instr->results().at(j)->type(),
+                                                   func->next_computed_number());
+      results.push_back(result);
+      result_args.at(j).push_back(
+          std::make_shared<ir::InheritedValue>(result, call_block->number()));
+    }
+    call_block->instrs().push_back(std::make_unique<ir::CallInstr>(
+        ir::ToFuncConstant(callees.at(i)), results, call_instr->args()));
+    call_block->instrs().push_back(std::make_unique<ir::JumpInstr>(continuation_block->number()));
+    func->AddControlFlow(call_block->number(), continuation_block->number());
+  }
+
+  auto& continuation_instrs = continuation_block->instrs();
+  for (std::size_t i = 0; i < call_instr->results().size(); i++) {
+    continuation_instrs.insert(
+        continuation_instrs.begin() + i,
+        std::make_unique<ir::PhiInstr>(call_instr->results().at(i), result_args.at(i)));
+  }
+}
+
+}  // namespace
+
+void DevirtualizeCallsInProgram(ir::Program* program) {
+  const ir_info::FuncCallGraph fcg = ir_analyzers::BuildFuncCallGraphForProgram(program);
+  FuncConstantPropagator propagator(program, fcg);
+  propagator.PropagateFuncConstants();
+
+  Devirtualizer devirtualizer(program, propagator);
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    devirtualizer.DevirtualizeCallsInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,26 @@
+//
+//  devirtualization_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_devirtualization_optimizer_h
+#define ir_optimizers_devirtualization_optimizer_h
+
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Replaces calls through computed func values with direct calls. The funcs each func value might
+// refer to get determined by a flow insensitive propagation of func constants through movs, phis,
+// args, and results of calls over the whole program. Func values loaded from memory might refer to
+// any func. Calls with a single possible callee call it directly. Calls with a few possible
+// callees compare the func value against all but the last callee and call the matching callee
+// directly.
+void DevirtualizeCallsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_devirtualization_optimizer_h */
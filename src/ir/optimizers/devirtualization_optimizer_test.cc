@@ -0,0 +1,269 @@
+//
+//  devirtualization_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/devirtualization_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+class DevirtualizationImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(DevirtualizationImpossibleTestInstance, DevirtualizationImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:ptr) => (i64) {
+  {0}
+    %1:func = load %0
+    %2:i64 = call %1, #1:i64
+    ret %2
+}
+
+@1 g(%0:i64) => (i64) {
+  {0}
+    ret %0
+}
+
+@2 h(%0:ptr) => () {
+  {0}
+    store %0, @1
+    ret
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:b = ilss %0, #2:i64
+    jcc %1, {1}, {2}
+  {1}
+    %2:b = ilss %0, #1:i64
+    jcc %2, {3}, {4}
+  {2}
+    %3:b = ilss %0, #3:i64
+    jcc %3, {5}, {6}
+  {3}
+    jmp {7}
+  {4}
+    jmp {7}
+  {5}
+    jmp {7}
+  {6}
+    jmp {7}
+  {7}
+    %4:func = phi @1{3}, @2{4}, @3{5}, @4{6}
+    %5:i64 = call %4, %0
+    ret %5
+}
+
+@1 g1(%0:i64) => (i64) {
+  {0}
+    ret #1:i64
+}
+
+@2 g2(%0:i64) => (i64) {
+  {0}
+    ret #2:i64
+}
+
+@3 g3(%0:i64) => (i64) {
+  {0}
+    ret #3:i64
+}
+
+@4 g4(%0:i64) => (i64) {
+  {0}
+    ret #4:i64
+}
+)ir"));
+
+TEST_P(DevirtualizationImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::DevirtualizeCallsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(input_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class DevirtualizationPossibleTest
+    : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(DevirtualizationPossibleTestInstance, DevirtualizationPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:func = mov @1
+    %1:i64 = call %0, #1:i64
+    ret %1
+}
+
+@1 f(%0:i64) => (i64) {
+  {0}
+    ret %0
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:func = mov @1
+    %1:i64 = call @1, #1:i64
+    ret %1
+}
+
+@1 f(%0:i64) => (i64) {
+  {0}
+    ret %0
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:func = call @3
+    %1:i64 = call @1, %0, #3:i64
+    ret %1
+}
+
+@1 apply(%0:func, %1:i64) => (i64) {
+  {0}
+    %2:i64 = call %0, %1
+    ret %2
+}
+
+@2 double(%0:i64) => (i64) {
+  {0}
+    %1:i64 = iadd %0, %0
+    ret %1
+}
+
+@3 get_double() => (func) {
+  {0}
+    ret @2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:func = call @3
+    %1:i64 = call @1, %0, #3:i64
+    ret %1
+}
+
+@1 apply(%0:func, %1:i64) => (i64) {
+  {0}
+    %2:i64 = call @2, %1
+    ret %2
+}
+
+@2 double(%0:i64) => (i64) {
+  {0}
+    %1:i64 = iadd %0, %0
+    ret %1
+}
+
+@3 get_double() => (func) {
+  {0}
+    ret @2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    %2:func = phi @1{1}, @2{2}
+    %3:i64 = call %2, %1
+    %4:i64 = iadd %3, #1:i64
+    ret %4
+}
+
+@1 g(%0:i64) => (i64) {
+  {0}
+    ret %0
+}
+
+@2 h(%0:i64) => (i64) {
+  {0}
+    %1:i64 = imul %0, #2:i64
+    ret %1
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    %2:func = phi @1{1}, @2{2}
+    %5:u64 = conv %2
+    %6:u64 = conv @1
+    %7:b = ieq %5, %6
+    jcc %7, {5}, {6}
+  {4}
+    %3:i64 = phi %8{5}, %9{6}
+    %4:i64 = iadd %3, #1:i64
+    ret %4
+  {5}
+    %8:i64 = call @1, %1
+    jmp {4}
+  {6}
+    %9:i64 = call @2, %1
+    jmp {4}
+}
+
+@1 g(%0:i64) => (i64) {
+  {0}
+    ret %0
+}
+
+@2 h(%0:i64) => (i64) {
+  {0}
+    %1:i64 = imul %0, #2:i64
+    ret %1
+}
+)ir",
+                             }));
+
+TEST_P(DevirtualizationPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::DevirtualizeCallsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
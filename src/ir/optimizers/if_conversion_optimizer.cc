@@ -0,0 +1,106 @@
+//
+//  if_conversion_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/22/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "if_conversion_optimizer.h"
+
+#include <memory>
+#include <vector>
+
+#include "src/ir/analyzers/speculation_analyzer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+// Branches with more computations are likely to cost more when executed unconditionally than a
+// mispredicted branch.
+constexpr std::size_t kMaxHoistedInstrsPerBranch = 2;
+
+// Returns the block the given branch of the branching block jumps to, if the branch can get
+// converted. Otherwise, returns ir::kNoBlockNum.
+ir::block_num_t JoinBlockOfBranch(const ir::Func* func, const ir::Block* branching_block,
+                                  ir::block_num_t branch_num) {
+  const ir::Block* branch = func->GetBlock(branch_num);
+  if (branch == branching_block || branch->parents().size() != 1 ||
+      branch->instrs().size() > kMaxHoistedInstrsPerBranch + 1) {
+    return ir::kNoBlockNum;
+  }
+  const ir::Instr* control_flow_instr = branch->instrs().back().get();
+  if (control_flow_instr->instr_kind() != ir::InstrKind::kJump) {
+    return ir::kNoBlockNum;
+  }
+  for (auto it = branch->instrs().begin(); it != branch->instrs().end() - 1; ++it) {
+    if (!ir_analyzers::CanExecuteSpeculatively(it->get())) {
+      return ir::kNoBlockNum;
+    }
+  }
+  ir::block_num_t join_block_num =
+      static_cast<const ir::JumpInstr*>(control_flow_instr)->destination();
+  if (join_block_num == branching_block->number() ||
+      func->GetBlock(join_block_num)->instrs().front()->instr_kind() != ir::InstrKind::kPhi) {
+    return ir::kNoBlockNum;
+  }
+  return join_block_num;
+}
+
+void HoistBranchInstrs(ir::Block* branch, ir::Block* branching_block) {
+  std::vector<std::unique_ptr<ir::Instr>>& branch_instrs = branch->instrs();
+  std::vector<std::unique_ptr<ir::Instr>>& branching_block_instrs = branching_block->instrs();
+  for (auto it = branch_instrs.begin(); it != branch_instrs.end() - 1; ++it) {
+    branching_block_instrs.insert(branching_block_instrs.end() - 1, std::move(*it));
+  }
+  branch_instrs.erase(branch_instrs.begin(), branch_instrs.end() - 1);
+}
+
+void ConvertIf(ir::Func* func, ir::Block* branching_block) {
+  if (branching_block->instrs().empty() ||
+      branching_block->instrs().back()->instr_kind() != ir::InstrKind::kJumpCond) {
+    return;
+  }
+  auto jump_cond_instr = static_cast<ir::JumpCondInstr*>(branching_block->instrs().back().get());
+  if (jump_cond_instr->condition()->kind() != ir::Value::Kind::kComputed) {
+    return;
+  }
+  ir::block_num_t true_num = jump_cond_instr->destination_true();
+  ir::block_num_t false_num = jump_cond_instr->destination_false();
+  if (true_num == false_num) {
+    return;
+  }
+  ir::block_num_t true_join_num = JoinBlockOfBranch(func, branching_block, true_num);
+  ir::block_num_t false_join_num = JoinBlockOfBranch(func, branching_block, false_num);
+  if (true_join_num != ir::kNoBlockNum && true_join_num == false_join_num) {
+    // Diamond:
+    HoistBranchInstrs(func->GetBlock(true_num), branching_block);
+    HoistBranchInstrs(func->GetBlock(false_num), branching_block);
+  } else if (true_join_num == false_num) {
+    // Triangle with the true destination as the branch:
+    HoistBranchInstrs(func->GetBlock(true_num), branching_block);
+  } else if (false_join_num == true_num) {
+    // Triangle with the false destination as the branch:
+    HoistBranchInstrs(func->GetBlock(false_num), branching_block);
+  }
+}
+
+}  // namespace
+
+void ConvertIfsInFunc(ir::Func* func) {
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    ConvertIf(func, block.get());
+  }
+}
+
+void ConvertIfsInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    ConvertIfsInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
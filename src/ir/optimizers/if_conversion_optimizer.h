@@ -0,0 +1,27 @@
+//
+//  if_conversion_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/22/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_if_conversion_optimizer_h
+#define ir_optimizers_if_conversion_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Hoists the computations of small branches of diamonds and triangles into the block branching to
+// them, such that the branches only pass values computed in the branching block to phis in the
+// join block. Backends can then select the phi values with conditional moves instead of branches.
+// Only computations that can not trap get hoisted and only if all computations in the branch can
+// be hoisted.
+void ConvertIfsInFunc(ir::Func* func);
+void ConvertIfsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_if_conversion_optimizer_h */
@@ -0,0 +1,222 @@
+//
+//  if_conversion_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/22/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/if_conversion_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+class IfConversionImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(IfConversionImpossibleTestInstance, IfConversionImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = ilss %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    %3:i64 = idiv %0, %1
+    jmp {2}
+  {2}
+    %4:i64 = phi %0{0}, %3{1}
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:b = ilss %1, #0:i64
+    jcc %2, {1}, {2}
+  {1}
+    %3:i64 = load %0
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    %4:i64 = phi %3{1}, %1{2}
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = ilss %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    %3:i64 = imul %0, %1
+    %4:i64 = iadd %3, %0
+    %5:i64 = isub %4, %1
+    jmp {2}
+  {2}
+    %6:i64 = phi %0{0}, %5{1}
+    ret %6
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = ilss %0, %1
+    jcc %2, {1}, {3}
+  {1}
+    %3:i64 = ineg %0
+    jmp {2}
+  {2}
+    ret %3
+  {3}
+    ret %1
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i32) {
+  {0}
+    %1:b = ilss %0, #128:i64
+    jcc %1, {1}, {2}
+  {1}
+    %2:i32 = conv %0
+    jmp {2}
+  {2}
+    %3:i32 = phi #0:i32{0}, %2{1}
+    ret %3
+}
+)ir"));
+
+TEST_P(IfConversionImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ConvertIfsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class IfConversionPossibleTest : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(IfConversionPossibleTestInstance, IfConversionPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 abs(%0:i64) => (i64) {
+  {0}
+    %1:b = ilss %0, #0:i64
+    jcc %1, {1}, {2}
+  {1}
+    %2:i64 = ineg %0
+    jmp {2}
+  {2}
+    %3:i64 = phi %0{0}, %2{1}
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 abs(%0:i64) => (i64) {
+  {0}
+    %1:b = ilss %0, #0:i64
+    %2:i64 = ineg %0
+    jcc %1, {1}, {2}
+  {1}
+    jmp {2}
+  {2}
+    %3:i64 = phi %0{0}, %2{1}
+    ret %3
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64, i64) {
+  {0}
+    %2:b = ilss %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    %3:i64 = isub %1, %0
+    jmp {3}
+  {2}
+    %4:i64 = isub %0, %1
+    %5:i64 = idiv %4, #2:i64
+    jmp {3}
+  {3}
+    %6:i64 = phi %3{1}, %5{2}
+    %7:i64 = phi %0{1}, %1{2}
+    ret %6, %7
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64, i64) {
+  {0}
+    %2:b = ilss %0, %1
+    %3:i64 = isub %1, %0
+    %4:i64 = isub %0, %1
+    %5:i64 = idiv %4, #2:i64
+    jcc %2, {1}, {2}
+  {1}
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    %6:i64 = phi %3{1}, %5{2}
+    %7:i64 = phi %0{1}, %1{2}
+    ret %6, %7
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i32) => (i64) {
+  {0}
+    %1:b = ilss %0, #0:i32
+    jcc %1, {1}, {2}
+  {1}
+    %2:i64 = conv %0
+    jmp {2}
+  {2}
+    %3:i64 = phi #0:i64{0}, %2{1}
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i32) => (i64) {
+  {0}
+    %1:b = ilss %0, #0:i32
+    %2:i64 = conv %0
+    jcc %1, {1}, {2}
+  {1}
+    jmp {2}
+  {2}
+    %3:i64 = phi #0:i64{0}, %2{1}
+    ret %3
+}
+)ir",
+                             }));
+
+TEST_P(IfConversionPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ConvertIfsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
@@ -0,0 +1,261 @@
+//
+//  inlining_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/19/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "inlining_optimizer.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/ir/analyzers/func_call_graph_builder.h"
+#include "src/ir/info/func_call_graph.h"
+#include "src/ir/processors/block_splitter.h"
+#include "src/ir/processors/instr_cloner.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+int64_t SizeOfFunc(const ir::Func* func) {
+  int64_t size = 0;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    size += block->instrs().size();
+  }
+  return size;
+}
+
+const ir::CallInstr* CallInstrWithFuncConstant(const ir::Instr* instr) {
+  if (instr->instr_kind() != ir::InstrKind::kCall) {
+    return nullptr;
+  }
+  auto call_instr = static_cast<const ir::CallInstr*>(instr);
+  if (call_instr->func()->kind() != ir::Value::Kind::kConstant ||
+      call_instr->func()->type() != ir::func_type()) {
+    return nullptr;
+  }
+  return call_instr;
+}
+
+ir::func_num_t CalleeOfCallInstr(const ir::CallInstr* call_instr) {
+  return static_cast<ir::FuncConstant*>(call_instr->func().get())->value();
+}
+
+class Inliner {
+ public:
+  Inliner(ir::Program* program, InliningBudget budget) : program_(program), budget_(budget) {}
+
+  void InlineFuncCalls();
+
+ private:
+  bool CanInlineFunc(const ir::Func* callee) const;
+  bool ShouldInlineCall(const ir::Func* caller, const ir_info::Component* caller_component,
+                        const ir::CallInstr* call_instr) const;
+  void InlineFuncCallsInFunc(ir::Func* caller, const ir_info::Component* caller_component);
+  void InlineCall(ir::Func* caller, ir::Block* call_block, std::size_t call_index,
+                  const ir::Func* callee);
+  void UpdateCallSiteCounts(const ir::Func* func, int64_t delta);
+
+  ir::Program* program_;
+  InliningBudget budget_;
+  int64_t remaining_program_growth_;
+  std::unordered_map<ir::func_num_t, int64_t> func_sizes_;
+  std::unordered_map<ir::func_num_t, int64_t> call_site_counts_;
+};
+
+void Inliner::InlineFuncCalls() {
+  int64_t program_size = 0;
+  for (const std::unique_ptr<ir::Func>& func : program_->funcs()) {
+    int64_t func_size = SizeOfFunc(func.get());
+    func_sizes_.insert({func->number(), func_size});
+    program_size += func_size;
+    UpdateCallSiteCounts(func.get(), +1);
+  }
+  remaining_program_growth_ = std::max(program_size * budget_.max_program_growth_percent / 100,
+                                       budget_.min_program_growth);
+
+  const ir_info::FuncCallGraph fcg = ir_analyzers::BuildFuncCallGraphForProgram(program_);
+  for (const ir_info::Component* component : fcg.ComponentsInBottomUpOrder()) {
+    std::vector<ir::func_num_t> members(component->members().begin(),
+                                        component->members().end());
+    std::sort(members.begin(), members.end());
+    for (ir::func_num_t member : members) {
+      if (program_->HasFunc(member)) {
+        InlineFuncCallsInFunc(program_->GetFunc(member), component);
+      }
+    }
+  }
+}
+
+bool Inliner::CanInlineFunc(const ir::Func* callee) const {
+  if (!callee->entry_block()->parents().empty()) {
+    return false;
+  }
+  bool has_return = false;
+  for (const std::unique_ptr<ir::Block>& block : callee->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() >= ir::InstrKind::kLangPanic) {
+        return false;
+      } else if (instr->instr_kind() == ir::InstrKind::kReturn) {
+        has_return = true;
+      }
+    }
+  }
+  return has_return;
+}
+
+bool Inliner::ShouldInlineCall(const ir::Func* caller, const ir_info::Component* caller_component,
+                               const ir::CallInstr* call_instr) const {
+  ir::func_num_t callee_num = CalleeOfCallInstr(call_instr);
+  if (caller_component->members().contains(callee_num) || !program_->HasFunc(callee_num)) {
+    return false;
+  }
+  const ir::Func* callee = program_->GetFunc(callee_num);
+  if (callee->args().size() != call_instr->args().size() ||
+      callee->result_types().size() != call_instr->results().size() || !CanInlineFunc(callee)) {
+    return false;
+  }
+  int64_t callee_size = func_sizes_.at(callee_num);
+  if (callee_size > remaining_program_growth_ ||
+      func_sizes_.at(caller->number()) + callee_size > budget_.max_caller_size) {
+    return false;
+  } else if (callee_size <= budget_.max_callee_size) {
+    return true;
+  }
+  return call_site_counts_.at(callee_num) == 1 && callee_num != program_->entry_func_num() &&
+         callee_size <= budget_.max_single_call_site_callee_size;
+}
+
+void Inliner::InlineFuncCallsInFunc(ir::Func* caller, const ir_info::Component* caller_component) {
+  // Blocks created by inlining get appended and visited afterwards, which handles calls copied
+  // from callees and the instrs following inlined calls.
+  for (std::size_t block_index = 0; block_index < caller->blocks().size(); block_index++) {
+    ir::Block* block = caller->blocks().at(block_index).get();
+    for (std::size_t instr_index = 0; instr_index < block->instrs().size(); instr_index++) {
+      const ir::CallInstr* call_instr =
+          CallInstrWithFuncConstant(block->instrs().at(instr_index).get());
+      if (call_instr == nullptr || !ShouldInlineCall(caller, caller_component, call_instr)) {
+        continue;
+      }
+      InlineCall(caller, block, instr_index, program_->GetFunc(CalleeOfCallInstr(call_instr)));
+      break;
+    }
+  }
+}
+
+void Inliner::InlineCall(ir::Func* caller, ir::Block* call_block, std::size_t call_index,
+                         const ir::Func* callee) {
+  std::unique_ptr<ir::Instr> call_instr_owner = std::move(call_block->instrs().at(call_index));
+  auto call_instr = static_cast<ir::CallInstr*>(call_instr_owner.get());
+  ir::Block* continuation_block =
+      ir_processors::SplitBlockAfterInstr(caller, call_block, call_index);
+  call_block->instrs().pop_back();
+
+  ir_processors::CloningMaps maps;
+  for (std::size_t i = 0; i < callee->args().size(); i++) {
+    std::shared_ptr<ir::Computed> callee_arg = callee->args().at(i);
+    std::shared_ptr<ir::Value> caller_arg = call_instr->args().at(i);
+    // Pointer offsets require computed pointers:
+    if (callee_arg->type()->type_kind() == ir::TypeKind::kPointer &&
+        caller_arg->kind() != ir::Value::Kind::kComputed) {
+      auto computed_arg =
+          std::make_shared<ir::Computed>(callee_arg->type(), caller->next_computed_number());
+      call_block->instrs().push_back(std::make_unique<ir::MovInstr>(computed_arg, caller_arg));
+      caller_arg = computed_arg;
+    }
+    maps.values.insert({callee_arg->number(), caller_arg});
+  }
+  for (const std::unique_ptr<ir::Block>& callee_block : callee->blocks()) {
+    maps.blocks.insert({callee_block->number(), caller->AddBlock()->number()});
+    for (const std::unique_ptr<ir::Instr>& callee_instr : callee_block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& callee_value : callee_instr->DefinedValues()) {
+        maps.values.insert({callee_value->number(),
+                            std::make_shared<ir::Computed>(callee_value->type(),
+                                                           caller->next_computed_number())});
+      }
+    }
+  }
+
+  // Copy the callee body and redirect returns to the continuation block:
+  std::vector<std::pair<ir::block_num_t, std::vector<std::shared_ptr<ir::Value>>>> returns;
+  for (const std::unique_ptr<ir::Block>& callee_block : callee->blocks()) {
+    ir::Block* block = caller->GetBlock(maps.blocks.at(callee_block->number()));
+    for (const std::unique_ptr<ir::Instr>& callee_instr : callee_block->instrs()) {
+      if (callee_instr->instr_kind() != ir::InstrKind::kReturn) {
+        block->instrs().push_back(ir_processors::CloneInstr(callee_instr.get(), maps));
+        continue;
+      }
+      auto return_instr = static_cast<ir::ReturnInstr*>(callee_instr.get());
+      returns.push_back({block->number(), maps.MapValues(return_instr->args())});
+      block->instrs().push_back(std::make_unique<ir::JumpInstr>(continuation_block->number()));
+    }
+  }
+  for (const std::unique_ptr<ir::Block>& callee_block : callee->blocks()) {
+    for (ir::block_num_t callee_child : callee_block->children()) {
+      caller->AddControlFlow(maps.blocks.at(callee_block->number()), maps.blocks.at(callee_child));
+    }
+  }
+  for (auto& [return_block_num, return_values] : returns) {
+    caller->AddControlFlow(return_block_num, continuation_block->number());
+  }
+  ir::block_num_t callee_entry_num = maps.blocks.at(callee->entry_block_num());
+  call_block->instrs().push_back(std::make_unique<ir::JumpInstr>(callee_entry_num));
+  caller->AddControlFlow(call_block->number(), callee_entry_num);
+
+  // Define the call results from the returned values:
+  for (std::size_t i = 0; i < call_instr->results().size(); i++) {
+    std::shared_ptr<ir::Computed> result = call_instr->results().at(i);
+    if (returns.size() == 1) {
+      auto& [return_block_num, return_values] = returns.front();
+      auto& return_block_instrs = caller->GetBlock(return_block_num)->instrs();
+      return_block_instrs.insert(return_block_instrs.end() - 1,
+                                 std::make_unique<ir::MovInstr>(result, return_values.at(i)));
+      continue;
+    }
+    std::vector<std::shared_ptr<ir::InheritedValue>> args;
+    args.reserve(returns.size());
+    for (auto& [return_block_num, return_values] : returns) {
+      args.push_back(std::make_shared<ir::InheritedValue>(return_values.at(i), return_block_num));
+    }
+    auto& continuation_instrs = continuation_block->instrs();
+    continuation_instrs.insert(continuation_instrs.begin() + i,
+                               std::make_unique<ir::PhiInstr>(result, args));
+  }
+
+  int64_t callee_size = func_sizes_.at(callee->number());
+  func_sizes_.at(caller->number()) += callee_size;
+  remaining_program_growth_ -= callee_size;
+  call_site_counts_.at(callee->number())--;
+  UpdateCallSiteCounts(callee, +1);
+}
+
+void Inliner::UpdateCallSiteCounts(const ir::Func* func, int64_t delta) {
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (const ir::CallInstr* call_instr = CallInstrWithFuncConstant(instr.get());
+          call_instr != nullptr) {
+        call_site_counts_[CalleeOfCallInstr(call_instr)] += delta;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void InlineFuncCallsInProgram(ir::Program* program, InliningBudget budget) {
+  Inliner inliner(program, budget);
+  inliner.InlineFuncCalls();
+}
+
+}  // namespace ir_optimizers
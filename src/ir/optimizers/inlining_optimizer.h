@@ -0,0 +1,38 @@
+//
+//  inlining_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/19/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_inlining_optimizer_h
+#define ir_optimizers_inlining_optimizer_h
+
+#include <cstdint>
+
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+struct InliningBudget {
+  // Callees with at most this many instrs get inlined at all call sites.
+  int64_t max_callee_size = 32;
+  // Callees with a single call site get inlined if they have at most this many instrs.
+  int64_t max_single_call_site_callee_size = 256;
+  // Callers do not grow beyond this many instrs through inlining.
+  int64_t max_caller_size = 2048;
+  // Inlining stops once the program grew by this percentage of its initial number of instrs, or
+  // by the minimum growth for small programs.
+  int64_t max_program_growth_percent = 50;
+  int64_t min_program_growth = 128;
+};
+
+// Replaces calls to small funcs with copies of the called func bodies. Components of the func call
+// graph get processed bottom-up, such that callees already contain all calls inlined into them
+// when they get inlined themselves. Calls within a component (recursion) do not get inlined.
+void InlineFuncCallsInProgram(ir::Program* program, InliningBudget budget = InliningBudget{});
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_inlining_optimizer_h */
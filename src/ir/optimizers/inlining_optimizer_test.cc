@@ -0,0 +1,200 @@
+//
+//  inlining_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/19/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/inlining_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+TEST(InliningOptimizerTest, InlinesFuncWithSingleReturn) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:i64 = call @1, #1:i64, #2:i64
+    %1:i64 = imul %0, #3:i64
+    ret %1
+}
+
+@1 add(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %0, %1
+    ret %2
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 main() => (i64) {
+  {0}
+    jmp {2}
+  {1}
+    %1:i64 = imul %0, #3:i64
+    ret %1
+  {2}
+    %2:i64 = iadd #1:i64, #2:i64
+    %0:i64 = mov %2
+    jmp {1}
+}
+
+@1 add(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %0, %1
+    ret %2
+}
+)ir");
+  ir_check::CheckProgramOrDie(program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::InlineFuncCallsInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(InliningOptimizerTest, InlinesFuncWithMultipleReturns) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 main(%0:i64) => (i64) {
+  {0}
+    %1:i64 = call @1, %0, #5:i64
+    ret %1
+}
+
+@1 max(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = igtr %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    ret %0
+  {2}
+    ret %1
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 main(%0:i64) => (i64) {
+  {0}
+    jmp {2}
+  {1}
+    %1:i64 = phi %0{3}, #5:i64{4}
+    ret %1
+  {2}
+    %2:b = igtr %0, #5:i64
+    jcc %2, {3}, {4}
+  {3}
+    jmp {1}
+  {4}
+    jmp {1}
+}
+
+@1 max(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = igtr %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    ret %0
+  {2}
+    ret %1
+}
+)ir");
+  ir_check::CheckProgramOrDie(program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::InlineFuncCallsInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(InliningOptimizerTest, InlinesCalleesBottomUp) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:i64 = call @1, #1:i64
+    ret %0
+}
+
+@1 f(%0:i64) => (i64) {
+  {0}
+    %1:i64 = call @2, %0
+    %2:i64 = iadd %1, #1:i64
+    ret %2
+}
+
+@2 g(%0:i64) => (i64) {
+  {0}
+    %1:i64 = imul %0, #2:i64
+    ret %1
+}
+)ir");
+  ir_check::CheckProgramOrDie(program.get());
+
+  ir_optimizers::InlineFuncCallsInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+      for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+        EXPECT_NE(instr->instr_kind(), ir::InstrKind::kCall)
+            << "Expected all calls to be inlined, got:\n"
+            << ir_serialization::Print(program.get());
+      }
+    }
+  }
+}
+
+TEST(InliningOptimizerTest, DoesNotInlineRecursiveCalls) {
+  std::string program_text = R"ir(
+@0 main(%0:i64) => (i64) {
+  {0}
+    %1:i64 = call @1, %0
+    ret %1
+}
+
+@1 f(%0:i64) => (i64) {
+  {0}
+    %1:b = ieq %0, #0:i64
+    jcc %1, {1}, {2}
+  {1}
+    ret #0:i64
+  {2}
+    %2:i64 = isub %0, #1:i64
+    %3:i64 = call @2, %2
+    ret %3
+}
+
+@2 g(%0:i64) => (i64) {
+  {0}
+    %1:i64 = call @1, %0
+    ret %1
+}
+)ir";
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(program_text);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(program_text);
+  ir_check::CheckProgramOrDie(program.get());
+
+  ir_optimizers::InlineFuncCallsInProgram(program.get(), ir_optimizers::InliningBudget{
+                                                             .max_callee_size = 0,
+                                                             .max_single_call_site_callee_size = 0,
+                                                         });
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(program.get());
+
+  ir_optimizers::InlineFuncCallsInProgram(program.get());
+  ir_check::CheckProgramOrDie(program.get());
+  EXPECT_TRUE(ir::IsEqual(program->GetFunc(1), expected_program->GetFunc(1)) &&
+              ir::IsEqual(program->GetFunc(2), expected_program->GetFunc(2)))
+      << "Expected calls within component to stay, got:\n"
+      << ir_serialization::Print(program.get());
+}
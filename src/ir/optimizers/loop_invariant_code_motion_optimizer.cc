@@ -0,0 +1,264 @@
+//
+//  loop_invariant_code_motion_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "loop_invariant_code_motion_optimizer.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "src/common/logging/logging.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/analyzers/speculation_analyzer.h"
+#include "src/ir/info/loop_info.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::logging::fail;
+
+bool MightWriteMemory(const ir::Instr* instr) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov:
+    case ir::InstrKind::kPhi:
+    case ir::InstrKind::kConversion:
+    case ir::InstrKind::kBoolNot:
+    case ir::InstrKind::kBoolBinary:
+    case ir::InstrKind::kIntUnary:
+    case ir::InstrKind::kIntCompare:
+    case ir::InstrKind::kIntBinary:
+    case ir::InstrKind::kIntShift:
+    case ir::InstrKind::kPointerOffset:
+    case ir::InstrKind::kNilTest:
+    case ir::InstrKind::kMalloc:
+    case ir::InstrKind::kStackAlloc:
+    case ir::InstrKind::kLoad:
+    case ir::InstrKind::kJump:
+    case ir::InstrKind::kJumpCond:
+    case ir::InstrKind::kReturn:
+      return false;
+    default:
+      return true;
+  }
+}
+
+void ReplaceDestination(ir::Block* block, ir::block_num_t old_destination,
+                        ir::block_num_t new_destination) {
+  ir::Instr* instr = block->ControlFlowInstr();
+  if (instr == nullptr) {
+    fail("block with children has no control flow instr");
+  }
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kJump:
+      static_cast<ir::JumpInstr*>(instr)->set_destination(new_destination);
+      return;
+    case ir::InstrKind::kJumpCond: {
+      auto jump_cond_instr = static_cast<ir::JumpCondInstr*>(instr);
+      if (jump_cond_instr->destination_true() == old_destination) {
+        jump_cond_instr->set_destination_true(new_destination);
+      }
+      if (jump_cond_instr->destination_false() == old_destination) {
+        jump_cond_instr->set_destination_false(new_destination);
+      }
+      return;
+    }
+    default:
+      fail("unexpected control flow instr");
+  }
+}
+
+// Inserts a new block between the header of the loop and its parents outside the loop. Header phi
+// args inherited from outside the loop get merged by phis in the new block.
+void InsertPreheader(ir::Func* func, const ir_info::Loop* loop) {
+  ir::Block* header = func->GetBlock(loop->header());
+  std::vector<ir::block_num_t> outside_parents;
+  for (ir::block_num_t parent : header->parents()) {
+    if (!loop->Contains(parent)) {
+      outside_parents.push_back(parent);
+    }
+  }
+  std::sort(outside_parents.begin(), outside_parents.end());
+  if (outside_parents.empty() && header->number() != func->entry_block_num()) {
+    return;  // unreachable loop
+  }
+
+  ir::Block* preheader = func->AddBlock();
+  std::vector<std::unique_ptr<ir::Instr>> preheader_phis;
+  header->ForEachPhiInstr([&](ir::PhiInstr* phi_instr) {
+    std::vector<std::shared_ptr<ir::InheritedValue>> inside_args;
+    std::vector<std::shared_ptr<ir::InheritedValue>> outside_args;
+    for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+      if (loop->Contains(arg->origin())) {
+        inside_args.push_back(arg);
+      } else {
+        outside_args.push_back(arg);
+      }
+    }
+    std::shared_ptr<ir::Value> outside_value;
+    if (outside_args.size() == 1) {
+      outside_value = outside_args.front()->value();
+    } else {
+      auto merged_value = std::make_shared<ir::Computed>(phi_instr->result()->type(),
+                                                         func->next_computed_number());
+      preheader_phis.push_back(std::make_unique<ir::PhiInstr>(merged_value, outside_args));
+      outside_value = merged_value;
+    }
+    inside_args.push_back(std::make_shared<ir::InheritedValue>(outside_value, preheader->number()));
+    phi_instr->args() = inside_args;
+  });
+  preheader->instrs() = std::move(preheader_phis);
+  preheader->instrs().push_back(std::make_unique<ir::JumpInstr>(header->number()));
+
+  if (outside_parents.empty()) {
+    func->set_entry_block_num(preheader->number());
+  }
+  for (ir::block_num_t parent : outside_parents) {
+    ReplaceDestination(func->GetBlock(parent), header->number(), preheader->number());
+    func->AddControlFlow(parent, preheader->number());
+  }
+  func->AddControlFlow(preheader->number(), header->number());
+  for (ir::block_num_t parent : outside_parents) {
+    func->RemoveControlFlow(parent, header->number());
+  }
+}
+
+void InsertMissingPreheaders(ir::Func* func) {
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func);
+  for (const std::unique_ptr<ir_info::Loop>& loop : loop_info.loops()) {
+    if (loop->preheader() == ir::kNoBlockNum) {
+      InsertPreheader(func, loop.get());
+    }
+  }
+}
+
+class LoopInvariantCodeMover {
+ public:
+  LoopInvariantCodeMover(ir::Func* func, const ir_info::LoopInfo& loop_info)
+      : func_(func), loop_info_(loop_info) {}
+
+  void HoistLoopInvariantCode();
+
+ private:
+  void HoistLoopInvariantCodeInLoop(const ir_info::Loop* loop);
+  bool IsInvariant(const ir_info::Loop* loop, const ir::Instr* instr) const;
+  bool CanHoistTrappingInstrs(const ir_info::Loop* loop, const ir::Block* block) const;
+
+  ir::Func* func_;
+  const ir_info::LoopInfo& loop_info_;
+  std::unordered_map<ir::value_num_t, ir::block_num_t> defining_blocks_;
+};
+
+void LoopInvariantCodeMover::HoistLoopInvariantCode() {
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        defining_blocks_.insert({defined_value->number(), block->number()});
+      }
+    }
+  }
+  // Process inner loops first, such that the outer loops can hoist code further:
+  for (auto it = loop_info_.loops().rbegin(); it != loop_info_.loops().rend(); ++it) {
+    HoistLoopInvariantCodeInLoop(it->get());
+  }
+}
+
+void LoopInvariantCodeMover::HoistLoopInvariantCodeInLoop(const ir_info::Loop* loop) {
+  if (loop->preheader() == ir::kNoBlockNum) {
+    return;
+  }
+  bool loop_might_write_memory = false;
+  for (ir::block_num_t bnum : loop->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : func_->GetBlock(bnum)->instrs()) {
+      loop_might_write_memory |= MightWriteMemory(instr.get());
+    }
+  }
+
+  ir::Block* preheader = func_->GetBlock(loop->preheader());
+  std::vector<std::unique_ptr<ir::Instr>> hoisted_instrs;
+  // Visiting blocks in dominance order ensures that values get hoisted before their uses:
+  for (ir::block_num_t bnum : func_->GetBlocksInDominanceOrder()) {
+    if (!loop->Contains(bnum)) {
+      continue;
+    }
+    ir::Block* block = func_->GetBlock(bnum);
+    bool can_hoist_trapping_instrs = CanHoistTrappingInstrs(loop, block);
+    bool can_hoist_loads = !loop_might_write_memory && can_hoist_trapping_instrs;
+    std::vector<std::unique_ptr<ir::Instr>> remaining_instrs;
+    remaining_instrs.reserve(block->instrs().size());
+    for (std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      bool hoistable =
+          ir_analyzers::CanExecuteSpeculatively(instr.get()) ||
+          (can_hoist_trapping_instrs && instr->instr_kind() == ir::InstrKind::kConversion) ||
+          (can_hoist_loads && instr->instr_kind() == ir::InstrKind::kLoad);
+      if (!hoistable || !IsInvariant(loop, instr.get())) {
+        remaining_instrs.push_back(std::move(instr));
+        continue;
+      }
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        defining_blocks_.at(defined_value->number()) = preheader->number();
+      }
+      hoisted_instrs.push_back(std::move(instr));
+    }
+    block->instrs() = std::move(remaining_instrs);
+  }
+
+  auto& preheader_instrs = preheader->instrs();
+  preheader_instrs.insert(preheader_instrs.end() - 1,
+                          std::make_move_iterator(hoisted_instrs.begin()),
+                          std::make_move_iterator(hoisted_instrs.end()));
+}
+
+bool LoopInvariantCodeMover::IsInvariant(const ir_info::Loop* loop,
+                                         const ir::Instr* instr) const {
+  for (const std::shared_ptr<ir::Value>& used_value : instr->UsedValues()) {
+    if (used_value->kind() != ir::Value::Kind::kComputed) {
+      continue;
+    }
+    auto it = defining_blocks_.find(static_cast<ir::Computed*>(used_value.get())->number());
+    if (it != defining_blocks_.end() && loop->Contains(it->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LoopInvariantCodeMover::CanHoistTrappingInstrs(const ir_info::Loop* loop,
+                                                    const ir::Block* block) const {
+  // Hoisting a load or conversion that might not get executed could introduce a trap:
+  if (loop->exiting_blocks().empty()) {
+    return false;
+  }
+  for (ir::block_num_t exiting_block : loop->exiting_blocks()) {
+    if (!func_->Dominates(block->number(), exiting_block)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void HoistLoopInvariantCodeInFunc(ir::Func* func) {
+  InsertMissingPreheaders(func);
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func);
+  LoopInvariantCodeMover mover(func, loop_info);
+  mover.HoistLoopInvariantCode();
+}
+
+void HoistLoopInvariantCodeInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    HoistLoopInvariantCodeInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,28 @@
+//
+//  loop_invariant_code_motion_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_loop_invariant_code_motion_optimizer_h
+#define ir_optimizers_loop_invariant_code_motion_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Hoists computations whose operands do not change inside a loop into the preheader of the loop,
+// inserting preheaders where needed. Divisions only get hoisted if they can not trap with their
+// operands. Conversions that might not fit their result type only get hoisted if they get executed
+// whenever the loop gets left. Loads only get hoisted out of loops without instrs that might write
+// memory and under the same condition. Inner loops get processed before outer loops, such that
+// computations can move out of several loops at once.
+void HoistLoopInvariantCodeInFunc(ir::Func* func);
+void HoistLoopInvariantCodeInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_loop_invariant_code_motion_optimizer_h */
@@ -0,0 +1,365 @@
+//
+//  loop_invariant_code_motion_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/loop_invariant_code_motion_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+class LoopInvariantCodeMotionImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(LoopInvariantCodeMotionImpossibleTestInstance,
+                         LoopInvariantCodeMotionImpossibleTest, testing::Values(R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{2}
+    %3:b = ilss %2, %0
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = imul %2, %1
+    %5:i64 = iadd %4, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                                                                R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{2}
+    %3:b = ilss %2, %0
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = idiv %0, %1
+    %5:i64 = iadd %2, %4
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                                                                R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %4:i64{1}
+    %3:i64 = load %0
+    %4:i64 = iadd %2, %3
+    store %0, %4
+    %5:b = ilss %4, %1
+    jcc %5, {1}, {2}
+  {2}
+    ret %4
+}
+)ir",
+                                                                                R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{2}
+    %3:b = ilss %2, %1
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = load %0
+    %5:i64 = iadd %2, %4
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                                                                R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %6:i64{2}
+    %3:b = ilss %2, %1
+    jcc %3, {2}, {3}
+  {2}
+    %4:i32 = conv %0
+    %5:i64 = conv %4
+    %6:i64 = iadd %2, %5
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir"));
+
+TEST_P(LoopInvariantCodeMotionImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::HoistLoopInvariantCodeInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class LoopInvariantCodeMotionPossibleTest
+    : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(LoopInvariantCodeMotionPossibleTestInstance,
+                         LoopInvariantCodeMotionPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %6:i64{2}
+    %3:i64 = phi #0:i64{0}, %7:i64{2}
+    %4:b = ilss %2, %0
+    jcc %4, {2}, {3}
+  {2}
+    %5:i64 = imul %0, %1
+    %8:i64 = iadd %5, #3:i64
+    %6:i64 = iadd %2, #1:i64
+    %7:i64 = iadd %3, %8
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %5:i64 = imul %0, %1
+    %8:i64 = iadd %5, #3:i64
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %6:i64{2}
+    %3:i64 = phi #0:i64{0}, %7:i64{2}
+    %4:b = ilss %2, %0
+    jcc %4, {2}, {3}
+  {2}
+    %6:i64 = iadd %2, #1:i64
+    %7:i64 = iadd %3, %8
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b, %1:ptr, %2:i64) => (ptr) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    %3:i64 = phi #0:i64{1}, #1:i64{2}, %5:i64{3}
+    %4:ptr = poff %1, %2
+    %5:i64 = iadd %3, #1:i64
+    %6:b = ilss %5, #10:i64
+    jcc %6, {3}, {4}
+  {4}
+    ret %4
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b, %1:ptr, %2:i64) => (ptr) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    jmp {5}
+  {2}
+    jmp {5}
+  {3}
+    %3:i64 = phi %5:i64{3}, %7:i64{5}
+    %5:i64 = iadd %3, #1:i64
+    %6:b = ilss %5, #10:i64
+    jcc %6, {3}, {4}
+  {4}
+    ret %4:ptr
+  {5}
+    %7:i64 = phi #0:i64{1}, #1:i64{2}
+    %4:ptr = poff %1, %2
+    jmp {3}
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %4:i64{1}
+    %3:i64 = load %0
+    %4:i64 = iadd %2, %3
+    %5:b = ilss %4, %1
+    jcc %5, {1}, {2}
+  {2}
+    ret %4
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %3:i64 = load %0
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %4:i64{1}
+    %4:i64 = iadd %2, %3
+    %5:b = ilss %4, %1
+    jcc %5, {1}, {2}
+  {2}
+    ret %4
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{4}
+    %3:b = ilss %2, %0
+    jcc %3, {2}, {5}
+  {2}
+    jmp {3}
+  {3}
+    %4:i64 = phi %2{2}, %7:i64{3}
+    %6:i64 = ishl %1, #2:u64
+    %7:i64 = iadd %4, %6
+    %8:b = ilss %7, %1
+    jcc %8, {3}, {4}
+  {4}
+    %5:i64 = iadd %7, #1:i64
+    jmp {1}
+  {5}
+    ret %2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %6:i64 = ishl %1, #2:u64
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{4}
+    %3:b = ilss %2, %0
+    jcc %3, {2}, {5}
+  {2}
+    jmp {3}
+  {3}
+    %4:i64 = phi %2{2}, %7:i64{3}
+    %7:i64 = iadd %4, %6
+    %8:b = ilss %7, %1
+    jcc %8, {3}, {4}
+  {4}
+    %5:i64 = iadd %7, #1:i64
+    jmp {1}
+  {5}
+    ret %2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i32, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %4:i64{2}
+    %3:b = ilss %2, %1
+    jcc %3, {2}, {3}
+  {2}
+    %5:i64 = conv %0
+    %4:i64 = iadd %2, %5
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i32, %1:i64) => (i64) {
+  {0}
+    %5:i64 = conv %0
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %4:i64{2}
+    %3:b = ilss %2, %1
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = iadd %2, %5
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{1}
+    %3:i32 = conv %0
+    %4:i64 = conv %3
+    %5:i64 = iadd %2, %4
+    %6:b = ilss %5, %1
+    jcc %6, {1}, {2}
+  {2}
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %3:i32 = conv %0
+    %4:i64 = conv %3
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{1}
+    %5:i64 = iadd %2, %4
+    %6:b = ilss %5, %1
+    jcc %6, {1}, {2}
+  {2}
+    ret %5
+}
+)ir",
+                             }));
+
+TEST_P(LoopInvariantCodeMotionPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::HoistLoopInvariantCodeInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
@@ -0,0 +1,388 @@
+//
+//  loop_unrolling_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "loop_unrolling_optimizer.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/analyzers/induction_variable_analyzer.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/info/induction_variable.h"
+#include "src/ir/info/loop_info.h"
+#include "src/ir/processors/instr_cloner.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::atomics::Int;
+
+bool IsComputedValue(const ir::Value* value, ir::value_num_t number) {
+  return value->kind() == ir::Value::Kind::kComputed &&
+         static_cast<const ir::Computed*>(value)->number() == number;
+}
+
+struct CountedLoop {
+  const ir_info::Loop* loop;
+  ir::block_num_t latch;
+  ir::block_num_t body_entry;
+  std::vector<ir::block_num_t> body;
+  const ir::IntCompareInstr* condition;
+  std::shared_ptr<ir::Value> bound;
+  // The amount the induction variable increases by during all but the last body copy:
+  Int offset;
+};
+
+class LoopUnroller {
+ public:
+  LoopUnroller(ir::Func* func, LoopUnrollingOptions options) : func_(func), options_(options) {}
+
+  void UnrollLoops();
+
+ private:
+  std::optional<CountedLoop> FindCountedLoop(const ir_info::Loop* loop) const;
+  bool CanCloneBody(const std::vector<ir::block_num_t>& body) const;
+  bool IsDefinedOutsideLoop(const ir_info::Loop* loop, const ir::Value* value) const;
+  int64_t CountUses(ir::value_num_t value) const;
+
+  void UnrollLoop(const CountedLoop& counted_loop);
+  std::shared_ptr<ir::Value> AddLimitCheckToPreheader(const CountedLoop& counted_loop,
+                                                      ir::block_num_t unrolled_header);
+
+  ir::Func* func_;
+  LoopUnrollingOptions options_;
+  std::unordered_map<ir::value_num_t, ir::block_num_t> defining_blocks_;
+};
+
+void LoopUnroller::UnrollLoops() {
+  if (options_.unroll_factor < 2) {
+    return;
+  }
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        defining_blocks_.insert({defined_value->number(), block->number()});
+      }
+    }
+  }
+  // Innermost loops do not share any blocks, such that unrolling one of them does not affect the
+  // others:
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func_);
+  for (const std::unique_ptr<ir_info::Loop>& loop : loop_info.loops()) {
+    if (std::optional<CountedLoop> counted_loop = FindCountedLoop(loop.get());
+        counted_loop.has_value()) {
+      UnrollLoop(*counted_loop);
+    }
+  }
+}
+
+std::optional<CountedLoop> LoopUnroller::FindCountedLoop(const ir_info::Loop* loop) const {
+  if (!loop->children().empty() || loop->preheader() == ir::kNoBlockNum ||
+      loop->latches().size() != 1 || loop->exiting_blocks().size() != 1 ||
+      !loop->exiting_blocks().contains(loop->header())) {
+    return std::nullopt;
+  }
+  ir::block_num_t latch = *loop->latches().begin();
+  ir::Block* header = func_->GetBlock(loop->header());
+  if (latch == header->number() ||
+      func_->GetBlock(latch)->instrs().back()->instr_kind() != ir::InstrKind::kJump) {
+    return std::nullopt;
+  }
+
+  // The header may only contain phis followed by the loop condition and the conditional jump:
+  std::vector<ir::Instr*> non_phi_instrs;
+  header->ForEachNonPhiInstr([&](ir::Instr* instr) { non_phi_instrs.push_back(instr); });
+  if (non_phi_instrs.size() != 2 ||
+      non_phi_instrs.at(0)->instr_kind() != ir::InstrKind::kIntCompare ||
+      non_phi_instrs.at(1)->instr_kind() != ir::InstrKind::kJumpCond) {
+    return std::nullopt;
+  }
+  auto condition = static_cast<ir::IntCompareInstr*>(non_phi_instrs.at(0));
+  auto jump_cond_instr = static_cast<ir::JumpCondInstr*>(non_phi_instrs.at(1));
+  if ((condition->operation() != Int::CompareOp::kLss &&
+       condition->operation() != Int::CompareOp::kLeq) ||
+      !IsComputedValue(jump_cond_instr->condition().get(), condition->result()->number()) ||
+      CountUses(condition->result()->number()) != 1 ||
+      !loop->Contains(jump_cond_instr->destination_true()) ||
+      !IsDefinedOutsideLoop(loop, condition->operand_b().get())) {
+    return std::nullopt;
+  }
+  ir::block_num_t body_entry = jump_cond_instr->destination_true();
+  if (func_->GetBlock(body_entry)->parents().size() != 1) {
+    return std::nullopt;
+  }
+
+  std::optional<Int> step;
+  std::shared_ptr<ir::Value> initial_value;
+  for (const ir_info::InductionVariable& iv :
+       ir_analyzers::FindInductionVariablesInLoop(func_, loop)) {
+    if (IsComputedValue(condition->operand_a().get(), iv.value()->number())) {
+      step = iv.step();
+      initial_value = iv.initial_value();
+    }
+  }
+  if (!step.has_value() || !step->IsGreaterThanZero() || !step->IsRepresentableAsInt64() ||
+      step->AsInt64() > std::numeric_limits<int64_t>::max() / (options_.unroll_factor - 1)) {
+    return std::nullopt;
+  }
+  Int offset(step->AsInt64() * (options_.unroll_factor - 1));
+  if (!offset.CanConvertTo(step->type())) {
+    return std::nullopt;
+  }
+  offset = offset.ConvertTo(step->type());
+  if (condition->operand_b()->kind() == ir::Value::Kind::kConstant) {
+    // The unrolled loop would never execute if computing the limit wraps around:
+    Int bound = static_cast<ir::IntConstant*>(condition->operand_b().get())->value();
+    Int limit = Int::Compute(bound, Int::BinaryOp::kSub, offset);
+    if (!Int::Compare(limit, Int::CompareOp::kLss, bound)) {
+      return std::nullopt;
+    }
+    // Unrolling does not pay off if the loop executes fewer iterations than the unroll factor:
+    if (initial_value->kind() == ir::Value::Kind::kConstant &&
+        !Int::Compare(static_cast<ir::IntConstant*>(initial_value.get())->value(),
+                      condition->operation(), limit)) {
+      return std::nullopt;
+    }
+  }
+
+  std::vector<ir::block_num_t> body;
+  for (ir::block_num_t bnum : loop->blocks()) {
+    if (bnum != loop->header()) {
+      body.push_back(bnum);
+    }
+  }
+  std::sort(body.begin(), body.end());
+  if (!CanCloneBody(body)) {
+    return std::nullopt;
+  }
+  return CountedLoop{
+      .loop = loop,
+      .latch = latch,
+      .body_entry = body_entry,
+      .body = body,
+      .condition = condition,
+      .bound = condition->operand_b(),
+      .offset = offset,
+  };
+}
+
+bool LoopUnroller::CanCloneBody(const std::vector<ir::block_num_t>& body) const {
+  int64_t body_size = 0;
+  for (ir::block_num_t bnum : body) {
+    for (const std::unique_ptr<ir::Instr>& instr : func_->GetBlock(bnum)->instrs()) {
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kReturn:
+        case ir::InstrKind::kLangPanic:
+        case ir::InstrKind::kLangMakeSharedPointer:
+        case ir::InstrKind::kLangCopySharedPointer:
+        case ir::InstrKind::kLangDeleteSharedPointer:
+        case ir::InstrKind::kLangMakeUniquePointer:
+        case ir::InstrKind::kLangDeleteUniquePointer:
+        case ir::InstrKind::kLangStringIndex:
+        case ir::InstrKind::kLangStringConcat:
+          return false;
+        default:
+          body_size++;
+      }
+    }
+  }
+  return body_size * options_.unroll_factor <= options_.max_unrolled_body_size;
+}
+
+bool LoopUnroller::IsDefinedOutsideLoop(const ir_info::Loop* loop, const ir::Value* value) const {
+  if (value->kind() != ir::Value::Kind::kComputed) {
+    return true;
+  }
+  auto it = defining_blocks_.find(static_cast<const ir::Computed*>(value)->number());
+  return it == defining_blocks_.end() || !loop->Contains(it->second);
+}
+
+int64_t LoopUnroller::CountUses(ir::value_num_t value) const {
+  int64_t uses = 0;
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (std::shared_ptr<ir::Value> used_value : instr->UsedValues()) {
+        if (used_value->kind() == ir::Value::Kind::kInherited) {
+          used_value = std::static_pointer_cast<ir::InheritedValue>(used_value)->value();
+        }
+        if (used_value->kind() == ir::Value::Kind::kComputed &&
+            static_cast<ir::Computed*>(used_value.get())->number() == value) {
+          uses++;
+        }
+      }
+    }
+  }
+  return uses;
+}
+
+void LoopUnroller::UnrollLoop(const CountedLoop& counted_loop) {
+  const ir_info::Loop* loop = counted_loop.loop;
+  ir::Block* header = func_->GetBlock(loop->header());
+  ir::Block* unrolled_header = func_->AddBlock();
+
+  std::vector<ir::PhiInstr*> header_phis;
+  header->ForEachPhiInstr([&](ir::PhiInstr* phi_instr) { header_phis.push_back(phi_instr); });
+  std::vector<std::shared_ptr<ir::Computed>> unrolled_phi_results;
+  unrolled_phi_results.reserve(header_phis.size());
+  for (ir::PhiInstr* phi_instr : header_phis) {
+    unrolled_phi_results.push_back(std::make_shared<ir::Computed>(phi_instr->result()->type(),
+                                                                  func_->next_computed_number()));
+  }
+
+  // Copy the loop body, such that each copy continues with the values computed by the previous
+  // copy. The body entry of the first copy follows the unrolled header.
+  std::vector<std::shared_ptr<ir::Computed>> current_values = unrolled_phi_results;
+  std::vector<std::shared_ptr<ir::Value>> next_values(current_values.begin(),
+                                                      current_values.end());
+  std::vector<ir::block_num_t> body_entry_copies;
+  std::vector<ir::block_num_t> latch_copies;
+  ir::block_num_t previous_block = unrolled_header->number();
+  for (int64_t i = 0; i < options_.unroll_factor; i++) {
+    ir_processors::CloningMaps maps;
+    maps.blocks.insert({header->number(), previous_block});
+    for (ir::block_num_t bnum : counted_loop.body) {
+      maps.blocks.insert({bnum, func_->AddBlock()->number()});
+    }
+    for (std::size_t j = 0; j < header_phis.size(); j++) {
+      maps.values.insert({header_phis.at(j)->result()->number(), next_values.at(j)});
+    }
+    for (ir::block_num_t bnum : counted_loop.body) {
+      for (const std::unique_ptr<ir::Instr>& instr : func_->GetBlock(bnum)->instrs()) {
+        for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+          maps.values.insert({defined_value->number(),
+                              std::make_shared<ir::Computed>(defined_value->type(),
+                                                             func_->next_computed_number())});
+        }
+      }
+    }
+    for (ir::block_num_t bnum : counted_loop.body) {
+      ir::Block* copy = func_->GetBlock(maps.MapBlock(bnum));
+      for (const std::unique_ptr<ir::Instr>& instr : func_->GetBlock(bnum)->instrs()) {
+        copy->instrs().push_back(ir_processors::CloneInstr(instr.get(), maps));
+      }
+      for (ir::block_num_t child : func_->GetBlock(bnum)->children()) {
+        if (child != header->number()) {
+          func_->AddControlFlow(copy->number(), maps.MapBlock(child));
+        }
+      }
+    }
+    for (std::size_t j = 0; j < header_phis.size(); j++) {
+      next_values.at(j) =
+          maps.MapValue(header_phis.at(j)->ValueInheritedFromBlock(counted_loop.latch));
+    }
+    body_entry_copies.push_back(maps.MapBlock(counted_loop.body_entry));
+    latch_copies.push_back(maps.MapBlock(counted_loop.latch));
+    previous_block = latch_copies.back();
+  }
+  for (int64_t i = 0; i < options_.unroll_factor; i++) {
+    ir::block_num_t destination = (i + 1 < options_.unroll_factor)
+                                      ? body_entry_copies.at(i + 1)
+                                      : unrolled_header->number();
+    ir::Block* latch_copy = func_->GetBlock(latch_copies.at(i));
+    static_cast<ir::JumpInstr*>(latch_copy->instrs().back().get())->set_destination(destination);
+    func_->AddControlFlow(latch_copy->number(), destination);
+  }
+
+  // The unrolled header continues with the unrolled loop while all body copies can execute:
+  ir::block_num_t preheader = loop->preheader();
+  std::shared_ptr<ir::Value> limit = AddLimitCheckToPreheader(counted_loop,
+                                                              unrolled_header->number());
+  std::shared_ptr<ir::Computed> unrolled_iv;
+  for (std::size_t j = 0; j < header_phis.size(); j++) {
+    ir::PhiInstr* phi_instr = header_phis.at(j);
+    if (IsComputedValue(counted_loop.condition->operand_a().get(),
+                        phi_instr->result()->number())) {
+      unrolled_iv = unrolled_phi_results.at(j);
+    }
+    unrolled_header->instrs().push_back(std::make_unique<ir::PhiInstr>(
+        unrolled_phi_results.at(j),
+        std::vector<std::shared_ptr<ir::InheritedValue>>{
+            std::make_shared<ir::InheritedValue>(phi_instr->ValueInheritedFromBlock(preheader),
+                                                 preheader),
+            std::make_shared<ir::InheritedValue>(next_values.at(j), latch_copies.back())}));
+  }
+  auto unrolled_condition =
+      std::make_shared<ir::Computed>(ir::bool_type(), func_->next_computed_number());
+  unrolled_header->instrs().push_back(std::make_unique<ir::IntCompareInstr>(
+      unrolled_condition, counted_loop.condition->operation(), unrolled_iv, limit));
+  unrolled_header->instrs().push_back(std::make_unique<ir::JumpCondInstr>(
+      unrolled_condition, body_entry_copies.front(), header->number()));
+  func_->AddControlFlow(unrolled_header->number(), body_entry_copies.front());
+  func_->AddControlFlow(unrolled_header->number(), header->number());
+
+  // The original loop executes the remaining iterations:
+  bool preheader_reaches_header =
+      func_->GetBlock(preheader)->children().contains(header->number());
+  for (std::size_t j = 0; j < header_phis.size(); j++) {
+    std::vector<std::shared_ptr<ir::InheritedValue>>& args = header_phis.at(j)->args();
+    if (!preheader_reaches_header) {
+      args.erase(std::remove_if(args.begin(), args.end(),
+                                [preheader](const std::shared_ptr<ir::InheritedValue>& arg) {
+                                  return arg->origin() == preheader;
+                                }),
+                 args.end());
+    }
+    args.push_back(std::make_shared<ir::InheritedValue>(unrolled_phi_results.at(j),
+                                                        unrolled_header->number()));
+  }
+}
+
+std::shared_ptr<ir::Value> LoopUnroller::AddLimitCheckToPreheader(
+    const CountedLoop& counted_loop, ir::block_num_t unrolled_header) {
+  ir::block_num_t header = counted_loop.loop->header();
+  ir::Block* preheader = func_->GetBlock(counted_loop.loop->preheader());
+  std::vector<std::unique_ptr<ir::Instr>>& instrs = preheader->instrs();
+  std::shared_ptr<ir::Value> offset = ir::ToIntConstant(counted_loop.offset);
+
+  if (counted_loop.bound->kind() == ir::Value::Kind::kConstant) {
+    // The limit was checked to not wrap around, so the unrolled loop always gets entered:
+    Int bound = static_cast<ir::IntConstant*>(counted_loop.bound.get())->value();
+    static_cast<ir::JumpInstr*>(instrs.back().get())->set_destination(unrolled_header);
+    func_->AddControlFlow(preheader->number(), unrolled_header);
+    func_->RemoveControlFlow(preheader->number(), header);
+    return ir::ToIntConstant(Int::Compute(bound, Int::BinaryOp::kSub, counted_loop.offset));
+  }
+
+  // If computing the limit wraps around, the unrolled loop gets skipped:
+  auto limit =
+      std::make_shared<ir::Computed>(counted_loop.bound->type(), func_->next_computed_number());
+  auto limit_ok = std::make_shared<ir::Computed>(ir::bool_type(), func_->next_computed_number());
+  instrs.pop_back();
+  instrs.push_back(std::make_unique<ir::IntBinaryInstr>(limit, Int::BinaryOp::kSub,
+                                                        counted_loop.bound, offset));
+  instrs.push_back(std::make_unique<ir::IntCompareInstr>(limit_ok, Int::CompareOp::kLss, limit,
+                                                         counted_loop.bound));
+  instrs.push_back(std::make_unique<ir::JumpCondInstr>(limit_ok, unrolled_header, header));
+  func_->AddControlFlow(preheader->number(), unrolled_header);
+  return limit;
+}
+
+}  // namespace
+
+void UnrollLoopsInFunc(ir::Func* func, LoopUnrollingOptions options) {
+  LoopUnroller unroller(func, options);
+  unroller.UnrollLoops();
+}
+
+void UnrollLoopsInProgram(ir::Program* program, LoopUnrollingOptions options) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    UnrollLoopsInFunc(func.get(), options);
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,38 @@
+//
+//  loop_unrolling_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_loop_unrolling_optimizer_h
+#define ir_optimizers_loop_unrolling_optimizer_h
+
+#include <cstdint>
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+struct LoopUnrollingOptions {
+  // The number of copies of the loop body executed per iteration of an unrolled loop. Factors
+  // below two disable unrolling.
+  int64_t unroll_factor = 4;
+  // Loops only get unrolled if all copies of their body contain at most this many instrs.
+  int64_t max_unrolled_body_size = 64;
+};
+
+// Unrolls small counted loops: innermost loops with a preheader and a single latch, whose header
+// only checks if an induction variable with positive step is less than (or equal to) a loop
+// invariant bound. The unrolled loop gets inserted before the original loop and executes the loop
+// body several times per iteration, while all copies of the body can execute. The original loop
+// serves as the remainder loop and executes the remaining iterations.
+void UnrollLoopsInFunc(ir::Func* func, LoopUnrollingOptions options = LoopUnrollingOptions{});
+void UnrollLoopsInProgram(ir::Program* program,
+                          LoopUnrollingOptions options = LoopUnrollingOptions{});
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_loop_unrolling_optimizer_h */
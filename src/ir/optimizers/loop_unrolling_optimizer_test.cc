@@ -0,0 +1,233 @@
+//
+//  loop_unrolling_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/loop_unrolling_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+namespace {
+
+constexpr ir_optimizers::LoopUnrollingOptions kTestOptions{
+    .unroll_factor = 2,
+    .max_unrolled_body_size = 8,
+};
+
+}  // namespace
+
+class LoopUnrollingImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(LoopUnrollingImpossibleTestInstance, LoopUnrollingImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %3:i64{2}
+    %2:b = ilss %1, %0
+    jcc %2, {2}, {3}
+  {2}
+    %3:i64 = imul %1, #2:i64
+    jmp {1}
+  {3}
+    ret %1
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %3:i64{2}
+    %2:b = ilss %1, %0
+    jcc %2, {2}, {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    %4:b = ieq %3, #5:i64
+    jcc %4, {3}, {1}
+  {3}
+    ret %1
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %3:i64{2}
+    %2:b = ilss %1, #1:i64
+    jcc %2, {2}, {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %1
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %7:i64{2}
+    %2:b = ilss %1, %0
+    jcc %2, {2}, {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    %4:i64 = iadd %3, #1:i64
+    %5:i64 = iadd %4, #1:i64
+    %6:i64 = iadd %5, #1:i64
+    %7:i64 = iadd %6, #1:i64
+    jmp {1}
+  {3}
+    ret %1
+}
+)ir"));
+
+TEST_P(LoopUnrollingImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::UnrollLoopsInProgram(input_program.get(), kTestOptions);
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class LoopUnrollingPossibleTest : public testing::TestWithParam<PossibleOptimizationTestParams> {
+};
+
+INSTANTIATE_TEST_SUITE_P(LoopUnrollingPossibleTestInstance, LoopUnrollingPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f() => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %4:i64{2}
+    %2:i64 = phi #0:i64{0}, %3:i64{2}
+    %5:b = ilss %1, #10:i64
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %2, %1
+    %4:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f() => (i64) {
+  {0}
+    jmp {4}
+  {1}
+    %1:i64 = phi %4:i64{2}, %6:i64{4}
+    %2:i64 = phi %3:i64{2}, %7:i64{4}
+    %5:b = ilss %1, #10:i64
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %2, %1
+    %4:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+  {4}
+    %6:i64 = phi #0:i64{0}, %11:i64{6}
+    %7:i64 = phi #0:i64{0}, %10:i64{6}
+    %12:b = ilss %6, #9:i64
+    jcc %12, {5}, {1}
+  {5}
+    %8:i64 = iadd %7, %6
+    %9:i64 = iadd %6, #1:i64
+    jmp {6}
+  {6}
+    %10:i64 = iadd %8, %9
+    %11:i64 = iadd %9, #1:i64
+    jmp {4}
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %4:i64{2}
+    %2:i64 = phi #0:i64{0}, %3:i64{2}
+    %5:b = ilss %1, %0
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %2, %1
+    %4:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %12:i64 = isub %0, #1:i64
+    %13:b = ilss %12, %0
+    jcc %13, {4}, {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %4:i64{2}, %6:i64{4}
+    %2:i64 = phi #0:i64{0}, %3:i64{2}, %7:i64{4}
+    %5:b = ilss %1, %0
+    jcc %5, {2}, {3}
+  {2}
+    %3:i64 = iadd %2, %1
+    %4:i64 = iadd %1, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+  {4}
+    %6:i64 = phi #0:i64{0}, %11:i64{6}
+    %7:i64 = phi #0:i64{0}, %10:i64{6}
+    %14:b = ilss %6, %12
+    jcc %14, {5}, {1}
+  {5}
+    %8:i64 = iadd %7, %6
+    %9:i64 = iadd %6, #1:i64
+    jmp {6}
+  {6}
+    %10:i64 = iadd %8, %9
+    %11:i64 = iadd %9, #1:i64
+    jmp {4}
+}
+)ir",
+                             }));
+
+TEST_P(LoopUnrollingPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::UnrollLoopsInProgram(optimized_program.get(), kTestOptions);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
@@ -0,0 +1,266 @@
+//
+//  memory_access_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "memory_access_optimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/analyzers/memory_analyzer.h"
+#include "src/ir/info/memory_info.h"
+#include "src/ir/processors/value_replacer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+// A memory location known to hold a value, because the value got stored to or loaded from it.
+struct KnownValue {
+  ir_info::MemoryLocation location;
+  std::shared_ptr<ir::Value> value;
+};
+typedef std::vector<KnownValue> KnownValues;
+
+class MemoryAccessOptimizer {
+ public:
+  MemoryAccessOptimizer(ir::Func* func)
+      : func_(func), memory_info_(ir_analyzers::FindMemoryLocationsInFunc(func)) {}
+
+  void RemoveRedundantMemoryAccesses();
+
+ private:
+  void ForwardValuesInBlock(ir::Block* block);
+  void ForwardValueToLoad(ir::LoadInstr* instr, KnownValues& known_values);
+  void RememberStoredValue(ir::StoreInstr* instr, KnownValues& known_values);
+
+  void RemoveDeadStoresInBlock(ir::Block* block);
+
+  ir::Func* func_;
+  const ir_info::MemoryInfo memory_info_;
+  std::unordered_map<ir::block_num_t, KnownValues> known_values_at_block_ends_;
+
+  ir_processors::ValueReplacements replacements_;
+  std::unordered_set<ir::Instr*> removed_instrs_;
+};
+
+void MemoryAccessOptimizer::RemoveRedundantMemoryAccesses() {
+  func_->ForBlocksInDominanceOrder([this](ir::Block* block) { ForwardValuesInBlock(block); });
+  if (!removed_instrs_.empty()) {
+    ir_processors::ReplaceValuesInFunc(func_, replacements_);
+  }
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    RemoveDeadStoresInBlock(block.get());
+  }
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    std::erase_if(block->instrs(), [this](const std::unique_ptr<ir::Instr>& instr) {
+      return removed_instrs_.contains(instr.get());
+    });
+  }
+}
+
+void MemoryAccessOptimizer::ForwardValuesInBlock(ir::Block* block) {
+  // Values remain known if the block can only be entered from its dominator:
+  KnownValues known_values;
+  if (block->parents().size() == 1) {
+    ir::block_num_t parent_num = *block->parents().begin();
+    auto it = known_values_at_block_ends_.find(parent_num);
+    if (it != known_values_at_block_ends_.end()) {
+      known_values = it->second;
+    }
+  }
+  for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+    ir_processors::ReplaceValuesInInstr(instr.get(), replacements_);
+    switch (instr->instr_kind()) {
+      case ir::InstrKind::kLoad:
+        ForwardValueToLoad(static_cast<ir::LoadInstr*>(instr.get()), known_values);
+        break;
+      case ir::InstrKind::kStore:
+        RememberStoredValue(static_cast<ir::StoreInstr*>(instr.get()), known_values);
+        break;
+      case ir::InstrKind::kMov:
+      case ir::InstrKind::kPhi:
+      case ir::InstrKind::kConversion:
+      case ir::InstrKind::kBoolNot:
+      case ir::InstrKind::kBoolBinary:
+      case ir::InstrKind::kIntUnary:
+      case ir::InstrKind::kIntCompare:
+      case ir::InstrKind::kIntBinary:
+      case ir::InstrKind::kIntShift:
+      case ir::InstrKind::kPointerOffset:
+      case ir::InstrKind::kNilTest:
+      case ir::InstrKind::kMalloc:
+      case ir::InstrKind::kStackAlloc:
+      case ir::InstrKind::kJump:
+      case ir::InstrKind::kJumpCond:
+      case ir::InstrKind::kReturn:
+        break;
+      default:
+        // Calls, syscalls, frees, and lang instrs might modify any memory:
+        known_values.clear();
+        break;
+    }
+  }
+  known_values_at_block_ends_.insert({block->number(), std::move(known_values)});
+}
+
+void MemoryAccessOptimizer::ForwardValueToLoad(ir::LoadInstr* instr, KnownValues& known_values) {
+  std::shared_ptr<ir::Computed> result = instr->result();
+  std::optional<ir_info::MemoryLocation> location =
+      memory_info_.LocationOf(instr->address().get(), result->type()->size());
+  if (!location.has_value()) {
+    return;
+  }
+  for (const KnownValue& known_value : known_values) {
+    if (known_value.location.base != location->base ||
+        known_value.location.offset != location->offset ||
+        known_value.value->type() != result->type()) {
+      continue;
+    }
+    // Pointer offsets require a computed pointer, other uses can not be replaced with constants:
+    if (known_value.value->kind() != ir::Value::Kind::kComputed &&
+        result->type()->type_kind() == ir::TypeKind::kPointer) {
+      break;
+    }
+    replacements_.insert({result->number(), known_value.value});
+    removed_instrs_.insert(instr);
+    return;
+  }
+  known_values.push_back(KnownValue{.location = *location, .value = result});
+}
+
+void MemoryAccessOptimizer::RememberStoredValue(ir::StoreInstr* instr, KnownValues& known_values) {
+  int64_t store_size = instr->value()->type()->size();
+  std::optional<ir_info::MemoryLocation> location =
+      memory_info_.LocationOf(instr->address().get(), store_size);
+  if (!location.has_value()) {
+    known_values.clear();
+    return;
+  }
+  std::erase_if(known_values, [&](const KnownValue& known_value) {
+    return memory_info_.MayAlias(known_value.location, *location);
+  });
+  known_values.push_back(KnownValue{.location = *location, .value = instr->value()});
+}
+
+void MemoryAccessOptimizer::RemoveDeadStoresInBlock(ir::Block* block) {
+  // Walks the block backwards, tracking locations that get written to and allocations that get
+  // freed before any instr might read them:
+  std::vector<ir_info::MemoryLocation> overwritten_locations;
+  std::unordered_set<ir::value_num_t> freed_allocations;
+  bool stack_allocations_dead = false;
+  for (auto it = block->instrs().rbegin(); it != block->instrs().rend(); ++it) {
+    ir::Instr* instr = it->get();
+    if (removed_instrs_.contains(instr)) {
+      continue;
+    }
+    switch (instr->instr_kind()) {
+      case ir::InstrKind::kStore: {
+        auto store_instr = static_cast<ir::StoreInstr*>(instr);
+        std::optional<ir_info::MemoryLocation> location = memory_info_.LocationOf(
+            store_instr->address().get(), store_instr->value()->type()->size());
+        if (!location.has_value()) {
+          break;
+        }
+        if (freed_allocations.contains(location->base) ||
+            (stack_allocations_dead && memory_info_.IsStackAllocation(location->base)) ||
+            std::any_of(overwritten_locations.begin(), overwritten_locations.end(),
+                        [&](const ir_info::MemoryLocation& overwritten_location) {
+                          return overwritten_location.Covers(*location);
+                        })) {
+          removed_instrs_.insert(instr);
+        } else {
+          overwritten_locations.push_back(*location);
+        }
+        break;
+      }
+      case ir::InstrKind::kLoad: {
+        auto load_instr = static_cast<ir::LoadInstr*>(instr);
+        std::optional<ir_info::MemoryLocation> location = memory_info_.LocationOf(
+            load_instr->address().get(), load_instr->result()->type()->size());
+        if (!location.has_value()) {
+          overwritten_locations.clear();
+          freed_allocations.clear();
+          stack_allocations_dead = false;
+          break;
+        }
+        std::erase_if(overwritten_locations,
+                      [&](const ir_info::MemoryLocation& overwritten_location) {
+                        return memory_info_.MayAlias(overwritten_location, *location);
+                      });
+        if (memory_info_.IsAllocation(location->base)) {
+          freed_allocations.erase(location->base);
+        } else {
+          // The address might point into any allocation:
+          freed_allocations.clear();
+          stack_allocations_dead = false;
+        }
+        break;
+      }
+      case ir::InstrKind::kFree: {
+        auto free_instr = static_cast<ir::FreeInstr*>(instr);
+        std::optional<ir_info::MemoryLocation> location =
+            memory_info_.LocationOf(free_instr->address().get(), 0);
+        if (location.has_value() && location->offset == 0 &&
+            memory_info_.IsAllocation(location->base)) {
+          freed_allocations.insert(location->base);
+        }
+        break;
+      }
+      case ir::InstrKind::kReturn:
+        // Stack allocations can not be reachable after their func returns:
+        stack_allocations_dead = true;
+        break;
+      case ir::InstrKind::kMov:
+      case ir::InstrKind::kPhi:
+      case ir::InstrKind::kConversion:
+      case ir::InstrKind::kBoolNot:
+      case ir::InstrKind::kBoolBinary:
+      case ir::InstrKind::kIntUnary:
+      case ir::InstrKind::kIntCompare:
+      case ir::InstrKind::kIntBinary:
+      case ir::InstrKind::kIntShift:
+      case ir::InstrKind::kPointerOffset:
+      case ir::InstrKind::kNilTest:
+      case ir::InstrKind::kMalloc:
+      case ir::InstrKind::kStackAlloc:
+      case ir::InstrKind::kJump:
+      case ir::InstrKind::kJumpCond:
+        break;
+      default:
+        // Calls, syscalls, and lang instrs might read any memory:
+        overwritten_locations.clear();
+        freed_allocations.clear();
+        stack_allocations_dead = false;
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+void RemoveRedundantMemoryAccessesInFunc(ir::Func* func) {
+  MemoryAccessOptimizer optimizer(func);
+  optimizer.RemoveRedundantMemoryAccesses();
+}
+
+void RemoveRedundantMemoryAccessesInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    RemoveRedundantMemoryAccessesInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,26 @@
+//
+//  memory_access_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_memory_access_optimizer_h
+#define ir_optimizers_memory_access_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Removes loads and stores that are redundant under the alias model of memory_info.h. Stored and
+// loaded values get forwarded to later loads of the same location in the same extended basic
+// block. Stores get removed if the location gets overwritten or freed later in the same block
+// before it might get read, or if the location is a stack allocation and the block returns.
+void RemoveRedundantMemoryAccessesInFunc(ir::Func* func);
+void RemoveRedundantMemoryAccessesInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_memory_access_optimizer_h */
@@ -0,0 +1,269 @@
+//
+//  memory_access_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/3/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/memory_access_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+#include "src/lang/processors/ir/check/check_test_util.h"
+#include "src/lang/processors/ir/serialization/parse.h"
+
+class MemoryAccessImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(MemoryAccessImpossibleTestInstance, MemoryAccessImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:ptr, %1:ptr, %2:i64) => (i64) {
+  {0}
+    store %0, %2
+    store %1, #0:i64
+    %3:i64 = load %0
+    ret %3
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => () {
+  {0}
+    %1:ptr = malloc #8:i64
+    store %1, %0
+    call @1, %1
+    store %1, #0:i64
+    call @1, %1
+    free %1
+    ret
+}
+
+@1 g(%0:ptr) => () {
+  {0}
+    ret
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr) => (ptr) {
+  {0}
+    store %0, 0x0
+    %1:ptr = load %0
+    %2:ptr = poff %1, #8:i64
+    ret %2
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:b) => (i64) {
+  {0}
+    jcc %1, {1}, {2}
+  {1}
+    store %0, #1:i64
+    jmp {3}
+  {2}
+    store %0, #2:i64
+    jmp {3}
+  {3}
+    %2:i64 = load %0
+    ret %2
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:i64) => (i8) {
+  {0}
+    store %0, %1
+    %2:i8 = load %0
+    %3:ptr = poff %0, #4:i64
+    store %3, #0:i32
+    ret %2
+}
+)ir"));
+
+TEST_P(MemoryAccessImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantMemoryAccessesInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(input_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class MemoryAccessPossibleTest : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(MemoryAccessPossibleTestInstance, MemoryAccessPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:ptr, %1:i64) => () {
+  {0}
+    store %0, #0:i64
+    %2:ptr = poff %0, #8:i64
+    store %2, #0:i64
+    %3:ptr = poff %0, #0:i64
+    store %3, %1
+    %4:ptr = poff %0, #8:i64
+    store %4, #42:i64
+    ret
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:ptr, %1:i64) => () {
+  {0}
+    %2:ptr = poff %0, #8:i64
+    %3:ptr = poff %0, #0:i64
+    store %3, %1
+    %4:ptr = poff %0, #8:i64
+    store %4, #42:i64
+    ret
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:ptr = malloc #16:i64
+    store %1, %0
+    %2:ptr = poff %1, #8:i64
+    store %2, #1:i64
+    %3:i64 = load %1
+    %4:i64 = load %2
+    %5:i64 = iadd %3, %4
+    free %1
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:ptr = malloc #16:i64
+    %2:ptr = poff %1, #8:i64
+    %5:i64 = iadd %0, #1:i64
+    free %1
+    ret %5
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => () {
+  {0}
+    %1:ptr = salloc #8:i64
+    store %1, %0
+    call @1, %1
+    store %1, #0:i64
+    ret
+}
+
+@1 g(%0:ptr) => () {
+  {0}
+    ret
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => () {
+  {0}
+    %1:ptr = salloc #8:i64
+    store %1, %0
+    call @1, %1
+    ret
+}
+
+@1 g(%0:ptr) => () {
+  {0}
+    ret
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:ptr, %1:b) => (i64) {
+  {0}
+    %2:ptr = malloc #8:i64
+    %3:ptr = malloc #8:i64
+    store %2, #7:i64
+    %4:i64 = load %0
+    store %3, %4
+    jcc %1, {1}, {2}
+  {1}
+    %5:i64 = load %2
+    %6:i64 = load %3
+    %7:i64 = iadd %5, %6
+    ret %7
+  {2}
+    ret #0:i64
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:ptr, %1:b) => (i64) {
+  {0}
+    %2:ptr = malloc #8:i64
+    %3:ptr = malloc #8:i64
+    store %2, #7:i64
+    %4:i64 = load %0
+    store %3, %4
+    jcc %1, {1}, {2}
+  {1}
+    %7:i64 = iadd #7:i64, %4
+    ret %7
+  {2}
+    ret #0:i64
+}
+)ir",
+                             }));
+
+TEST_P(MemoryAccessPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantMemoryAccessesInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(MemoryAccessTest, ForwardsStoredValuesToLangInstrs) {
+  std::unique_ptr<ir::Program> optimized_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:ptr, %1:lstr, %2:i64) => (i8) {
+  {0}
+    store %0, %2
+    %3:i64 = load %0
+    %4:i8 = str_index %1, %3
+    ret %4
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:ptr, %1:lstr, %2:i64) => (i8) {
+  {0}
+    store %0, %2
+    %4:i8 = str_index %1, %2
+    ret %4
+}
+)ir");
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantMemoryAccessesInProgram(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
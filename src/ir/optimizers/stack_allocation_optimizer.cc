@@ -0,0 +1,425 @@
+//
+//  stack_allocation_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "stack_allocation_optimizer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/analyzers/escape_analyzer.h"
+#include "src/ir/analyzers/func_values_builder.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/info/escape_info.h"
+#include "src/ir/info/func_values.h"
+#include "src/ir/info/loop_info.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+// Larger allocations stay on the heap to keep stack frames small.
+constexpr int64_t kMaxStackAllocationSize = 1024;
+
+std::optional<int64_t> ConstantSize(const ir::Value* value) {
+  if (value->kind() != ir::Value::Kind::kConstant || value->type() != ir::i64()) {
+    return std::nullopt;
+  }
+  return static_cast<const ir::IntConstant*>(value)->value().AsInt64();
+}
+
+bool IsAlias(const ir::Value* value, const std::unordered_set<ir::value_num_t>& aliases) {
+  return value->kind() == ir::Value::Kind::kComputed &&
+         aliases.contains(static_cast<const ir::Computed*>(value)->number());
+}
+
+// Describes an allocation and all values pointing into it.
+struct Allocation {
+  ir::MallocInstr* malloc_instr;
+  int64_t size;
+  std::unordered_set<ir::value_num_t> aliases;
+  bool has_phi_alias = false;
+  std::vector<ir::Instr*> uses;
+};
+
+Allocation FindAllocation(ir::MallocInstr* malloc_instr, int64_t size,
+                          const ir_info::FuncValues& func_values) {
+  Allocation allocation{.malloc_instr = malloc_instr, .size = size};
+  std::vector<ir::value_num_t> worklist{malloc_instr->result()->number()};
+  allocation.aliases.insert(malloc_instr->result()->number());
+  std::unordered_set<ir::Instr*> uses;
+  while (!worklist.empty()) {
+    ir::value_num_t value_num = worklist.back();
+    worklist.pop_back();
+    for (ir::Instr* instr : func_values.GetInstrsUsingValue(value_num)) {
+      if (uses.insert(instr).second) {
+        allocation.uses.push_back(instr);
+      }
+      ir::value_num_t derived_value;
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kMov:
+          derived_value = static_cast<ir::MovInstr*>(instr)->result()->number();
+          break;
+        case ir::InstrKind::kPhi:
+          derived_value = static_cast<ir::PhiInstr*>(instr)->result()->number();
+          allocation.has_phi_alias = true;
+          break;
+        case ir::InstrKind::kPointerOffset: {
+          auto pointer_offset_instr = static_cast<ir::PointerOffsetInstr*>(instr);
+          if (pointer_offset_instr->pointer()->number() != value_num) {
+            continue;
+          }
+          derived_value = pointer_offset_instr->result()->number();
+          break;
+        }
+        default:
+          continue;
+      }
+      if (allocation.aliases.insert(derived_value).second) {
+        worklist.push_back(derived_value);
+      }
+    }
+  }
+  return allocation;
+}
+
+std::shared_ptr<ir::Value> ZeroValueWithType(const ir::Type* type) {
+  switch (type->type_kind()) {
+    case ir::TypeKind::kBool:
+      return ir::False();
+    case ir::TypeKind::kInt:
+      return ir::ZeroWithType(static_cast<const ir::IntType*>(type)->int_type());
+    case ir::TypeKind::kPointer:
+      return ir::NilPointer();
+    case ir::TypeKind::kFunc:
+      return ir::NilFunc();
+    default:
+      return nullptr;
+  }
+}
+
+// Replaces an allocation, whose aliases are all at constant offsets from the allocation, with
+// separate SSA values for each accessed field. Stores to fields become definitions, loads from
+// fields become movs of the reaching definition, and phis get inserted where definitions from
+// different blocks meet.
+class ScalarReplacer {
+ public:
+  ScalarReplacer(ir::Func* func, const Allocation& allocation)
+      : func_(func), allocation_(allocation) {}
+
+  bool FindFields();
+  void ReplaceAllocation();
+
+ private:
+  struct Field {
+    const ir::Type* type;
+    std::unordered_map<ir::block_num_t, std::shared_ptr<ir::Value>> end_values;
+    std::unordered_map<ir::block_num_t, std::shared_ptr<ir::Value>> entry_values;
+  };
+
+  std::optional<int64_t> FieldOffset(const ir::Value* address) const;
+  bool AddFieldAccess(int64_t offset, const ir::Type* type);
+
+  std::shared_ptr<ir::Value> ReadEntryValue(int64_t offset, ir::block_num_t bnum);
+  std::shared_ptr<ir::Value> ReadEndValue(int64_t offset, ir::block_num_t bnum);
+
+  ir::Func* func_;
+  const Allocation& allocation_;
+  std::unordered_map<ir::value_num_t, int64_t> alias_offsets_;
+  std::map<int64_t, Field> fields_;
+  std::unordered_map<ir::block_num_t, std::vector<std::unique_ptr<ir::Instr>>> phis_;
+};
+
+std::optional<int64_t> ScalarReplacer::FieldOffset(const ir::Value* address) const {
+  if (address->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  auto it = alias_offsets_.find(static_cast<const ir::Computed*>(address)->number());
+  if (it == alias_offsets_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+bool ScalarReplacer::AddFieldAccess(int64_t offset, const ir::Type* type) {
+  if (ZeroValueWithType(type) == nullptr || offset < 0 ||
+      offset + type->size() > allocation_.size) {
+    return false;
+  }
+  auto [it, inserted] = fields_.insert({offset, Field{.type = type}});
+  return inserted || it->second.type == type;
+}
+
+bool ScalarReplacer::FindFields() {
+  ir::value_num_t root = allocation_.malloc_instr->result()->number();
+  alias_offsets_.insert({root, 0});
+  // Uses are ordered such that pointer offsets get visited before any uses of their results.
+  for (ir::Instr* instr : allocation_.uses) {
+    switch (instr->instr_kind()) {
+      case ir::InstrKind::kPointerOffset: {
+        auto pointer_offset_instr = static_cast<ir::PointerOffsetInstr*>(instr);
+        std::optional<int64_t> pointer_offset = FieldOffset(pointer_offset_instr->pointer().get());
+        std::optional<int64_t> offset = ConstantSize(pointer_offset_instr->offset().get());
+        if (!pointer_offset.has_value() || !offset.has_value()) {
+          return false;
+        }
+        alias_offsets_.insert(
+            {pointer_offset_instr->result()->number(), *pointer_offset + *offset});
+        break;
+      }
+      case ir::InstrKind::kLoad: {
+        auto load_instr = static_cast<ir::LoadInstr*>(instr);
+        std::optional<int64_t> offset = FieldOffset(load_instr->address().get());
+        if (!offset.has_value() || !AddFieldAccess(*offset, load_instr->result()->type())) {
+          return false;
+        }
+        break;
+      }
+      case ir::InstrKind::kStore: {
+        auto store_instr = static_cast<ir::StoreInstr*>(instr);
+        std::optional<int64_t> offset = FieldOffset(store_instr->address().get());
+        if (!offset.has_value() || !AddFieldAccess(*offset, store_instr->value()->type())) {
+          return false;
+        }
+        break;
+      }
+      case ir::InstrKind::kFree: {
+        std::optional<int64_t> offset =
+            FieldOffset(static_cast<ir::FreeInstr*>(instr)->address().get());
+        if (offset != 0) {
+          return false;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  // Fields must not overlap, such that every load reads exactly one stored value:
+  int64_t end = 0;
+  for (auto& [offset, field] : fields_) {
+    if (offset < end) {
+      return false;
+    }
+    end = offset + field.type->size();
+  }
+
+  for (auto& [offset, field] : fields_) {
+    for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+      for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+        if (instr.get() == allocation_.malloc_instr) {
+          field.end_values.insert_or_assign(block->number(), ZeroValueWithType(field.type));
+        } else if (instr->instr_kind() == ir::InstrKind::kStore) {
+          auto store_instr = static_cast<ir::StoreInstr*>(instr.get());
+          if (FieldOffset(store_instr->address().get()) == offset) {
+            field.end_values.insert_or_assign(block->number(), store_instr->value());
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<ir::Value> ScalarReplacer::ReadEndValue(int64_t offset, ir::block_num_t bnum) {
+  Field& field = fields_.at(offset);
+  auto it = field.end_values.find(bnum);
+  if (it != field.end_values.end()) {
+    return it->second;
+  }
+  return ReadEntryValue(offset, bnum);
+}
+
+std::shared_ptr<ir::Value> ScalarReplacer::ReadEntryValue(int64_t offset, ir::block_num_t bnum) {
+  Field& field = fields_.at(offset);
+  auto it = field.entry_values.find(bnum);
+  if (it != field.entry_values.end()) {
+    return it->second;
+  }
+  const std::unordered_set<ir::block_num_t>& parents = func_->GetBlock(bnum)->parents();
+  if (parents.empty()) {
+    // Only reachable on paths not executing the allocation, where the value is irrelevant.
+    std::shared_ptr<ir::Value> value = ZeroValueWithType(field.type);
+    field.entry_values.insert({bnum, value});
+    return value;
+  } else if (parents.size() == 1) {
+    std::shared_ptr<ir::Value> value = ReadEndValue(offset, *parents.begin());
+    field.entry_values.insert({bnum, value});
+    return value;
+  }
+  // The phi gets registered before its args get determined to terminate on loops.
+  auto phi_result = std::make_shared<ir::Computed>(field.type, func_->next_computed_number());
+  field.entry_values.insert({bnum, phi_result});
+  std::vector<ir::block_num_t> sorted_parents(parents.begin(), parents.end());
+  std::sort(sorted_parents.begin(), sorted_parents.end());
+  std::vector<std::shared_ptr<ir::InheritedValue>> phi_args;
+  phi_args.reserve(sorted_parents.size());
+  for (ir::block_num_t parent : sorted_parents) {
+    phi_args.push_back(
+        std::make_shared<ir::InheritedValue>(ReadEndValue(offset, parent), parent));
+  }
+  phis_[bnum].push_back(std::make_unique<ir::PhiInstr>(phi_result, phi_args));
+  return phi_result;
+}
+
+void ScalarReplacer::ReplaceAllocation() {
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    std::unordered_map<int64_t, std::shared_ptr<ir::Value>> values;
+    auto read_value = [&](int64_t offset) {
+      auto it = values.find(offset);
+      if (it != values.end()) {
+        return it->second;
+      }
+      return ReadEntryValue(offset, block->number());
+    };
+
+    std::vector<std::unique_ptr<ir::Instr>>& instrs = block->instrs();
+    for (auto it = instrs.begin(); it != instrs.end();) {
+      ir::Instr* instr = it->get();
+      if (instr == allocation_.malloc_instr) {
+        for (auto& [offset, field] : fields_) {
+          values.insert_or_assign(offset, ZeroValueWithType(field.type));
+        }
+        it = instrs.erase(it);
+        continue;
+      }
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kLoad: {
+          auto load_instr = static_cast<ir::LoadInstr*>(instr);
+          std::optional<int64_t> offset = FieldOffset(load_instr->address().get());
+          if (offset.has_value()) {
+            *it = std::make_unique<ir::MovInstr>(load_instr->result(), read_value(*offset));
+          }
+          break;
+        }
+        case ir::InstrKind::kStore: {
+          auto store_instr = static_cast<ir::StoreInstr*>(instr);
+          std::optional<int64_t> offset = FieldOffset(store_instr->address().get());
+          if (offset.has_value()) {
+            values.insert_or_assign(*offset, store_instr->value());
+            it = instrs.erase(it);
+            continue;
+          }
+          break;
+        }
+        case ir::InstrKind::kPointerOffset:
+          if (FieldOffset(static_cast<ir::PointerOffsetInstr*>(instr)->result().get())) {
+            it = instrs.erase(it);
+            continue;
+          }
+          break;
+        case ir::InstrKind::kFree:
+          if (FieldOffset(static_cast<ir::FreeInstr*>(instr)->address().get())) {
+            it = instrs.erase(it);
+            continue;
+          }
+          break;
+        default:
+          break;
+      }
+      ++it;
+    }
+  }
+  for (auto& [bnum, phis] : phis_) {
+    std::vector<std::unique_ptr<ir::Instr>>& instrs = func_->GetBlock(bnum)->instrs();
+    instrs.insert(instrs.begin(), std::make_move_iterator(phis.begin()),
+                  std::make_move_iterator(phis.end()));
+  }
+}
+
+void ReplaceWithStackAllocation(ir::Func* func, const Allocation& allocation) {
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    std::vector<std::unique_ptr<ir::Instr>>& instrs = block->instrs();
+    for (auto it = instrs.begin(); it != instrs.end();) {
+      ir::Instr* instr = it->get();
+      if (instr == allocation.malloc_instr) {
+        *it = std::make_unique<ir::StackAllocInstr>(allocation.malloc_instr->result(),
+                                                    allocation.malloc_instr->size());
+      } else if (instr->instr_kind() == ir::InstrKind::kFree &&
+                 IsAlias(static_cast<ir::FreeInstr*>(instr)->address().get(), allocation.aliases)) {
+        it = instrs.erase(it);
+        continue;
+      }
+      ++it;
+    }
+  }
+}
+
+void ReplaceNonEscapingAllocationsInFunc(ir::Func* func, const ir_info::EscapeInfo& escape_info) {
+  struct Candidate {
+    ir::block_num_t bnum;
+    ir::MallocInstr* malloc_instr;
+    int64_t size;
+  };
+  std::vector<Candidate> candidates;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() != ir::InstrKind::kMalloc) {
+        continue;
+      }
+      auto malloc_instr = static_cast<ir::MallocInstr*>(instr.get());
+      std::optional<int64_t> size = ConstantSize(malloc_instr->size().get());
+      if (!size.has_value() || *size <= 0 || *size > kMaxStackAllocationSize ||
+          escape_info.GetAllocationEscapeKind(func->number(), malloc_instr->result()->number()) ==
+              ir_info::EscapeKind::kGlobalEscape) {
+        continue;
+      }
+      candidates.push_back(
+          Candidate{.bnum = block->number(), .malloc_instr = malloc_instr, .size = *size});
+    }
+  }
+  if (candidates.empty()) {
+    return;
+  }
+
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func);
+  for (auto [bnum, malloc_instr, size] : candidates) {
+    Allocation allocation =
+        FindAllocation(malloc_instr, size, ir_analyzers::FindValuesInFunc(func));
+    if (escape_info.GetAllocationEscapeKind(func->number(), malloc_instr->result()->number()) ==
+            ir_info::EscapeKind::kNoEscape &&
+        !allocation.has_phi_alias) {
+      ScalarReplacer replacer(func, allocation);
+      if (replacer.FindFields()) {
+        replacer.ReplaceAllocation();
+        continue;
+      }
+    }
+
+    // Stack allocations yield the same address every time they get executed in a frame. In loops,
+    // the allocation from one iteration must therefore not be reachable in the next iteration,
+    // which is only possible through phis.
+    if (allocation.has_phi_alias && loop_info.InnermostLoopOfBlock(bnum) != nullptr) {
+      continue;
+    }
+    ReplaceWithStackAllocation(func, allocation);
+  }
+}
+
+}  // namespace
+
+void ReplaceNonEscapingAllocationsInProgram(ir::Program* program) {
+  const ir_info::EscapeInfo escape_info = ir_analyzers::FindEscapesInProgram(program);
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    ReplaceNonEscapingAllocationsInFunc(func.get(), escape_info);
+  }
+}
+
+}  // namespace ir_optimizers
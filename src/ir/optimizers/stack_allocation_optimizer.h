@@ -0,0 +1,25 @@
+//
+//  stack_allocation_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_stack_allocation_optimizer_h
+#define ir_optimizers_stack_allocation_optimizer_h
+
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Replaces heap allocations of constant size that do not escape their func (see
+// escape_analyzer.h). Allocations only accessed with loads and stores at constant offsets get
+// replaced by scalar values for each field. All other non-escaping allocations, including those
+// only passed to funcs that do not let them escape, get replaced by stack allocations. Frees of
+// replaced allocations get removed.
+void ReplaceNonEscapingAllocationsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_stack_allocation_optimizer_h */
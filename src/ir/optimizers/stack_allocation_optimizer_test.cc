@@ -0,0 +1,164 @@
+//
+//  stack_allocation_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/30/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/stack_allocation_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+class StackAllocationImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(StackAllocationImpossibleTestInstance, StackAllocationImpossibleTest,
+                         testing::Values(R"ir(
+@0 f() => (ptr) {
+  {0}
+    %0:ptr = malloc #8:i64
+    store %0, #1:i64
+    ret %0
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr) => () {
+  {0}
+    %1:ptr = malloc #8:i64
+    store %0, %1
+    ret
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:ptr = malloc %0
+    store %1, #1:i64
+    %2:i64 = load %1
+    free %1
+    ret %2
+}
+)ir",
+                                         R"ir(
+@0 f() => (i64) {
+  {0}
+    %0:ptr = malloc #8:i64
+    %1:i64 = call @1, %0
+    ret %1
+}
+
+@1 g(%0:ptr) => (i64) {
+  {0}
+    free %0
+    ret #0:i64
+}
+)ir"));
+
+TEST_P(StackAllocationImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ReplaceNonEscapingAllocationsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class StackAllocationPossibleTest
+    : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(StackAllocationPossibleTestInstance, StackAllocationPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %2:ptr = malloc #16:i64
+    %3:ptr = poff %2, #8:i64
+    store %2, %1
+    %4:i64 = load %2
+    jcc %0, {1}, {2}
+  {1}
+    store %3, %4
+    jmp {2}
+  {2}
+    %5:i64 = load %3
+    free %2
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %4:i64 = mov %1
+    jcc %0, {1}, {2}
+  {1}
+    jmp {2}
+  {2}
+    %6:i64 = phi #0:i64{0}, %4:i64{1}
+    %5:i64 = mov %6
+    ret %5
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:ptr = malloc #8:i64
+    store %0, #42:i64
+    %1:i64 = call @1, %0
+    free %0
+    ret %1
+}
+
+@1 get(%0:ptr) => (i64) {
+  {0}
+    %1:i64 = load %0
+    ret %1
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 main() => (i64) {
+  {0}
+    %0:ptr = salloc #8:i64
+    store %0, #42:i64
+    %1:i64 = call @1, %0
+    ret %1
+}
+
+@1 get(%0:ptr) => (i64) {
+  {0}
+    %1:i64 = load %0
+    ret %1
+}
+)ir",
+                             }));
+
+TEST_P(StackAllocationPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ReplaceNonEscapingAllocationsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
@@ -0,0 +1,316 @@
+//
+//  strength_reduction_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "strength_reduction_optimizer.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/analyzers/induction_variable_analyzer.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/info/induction_variable.h"
+#include "src/ir/info/loop_info.h"
+#include "src/ir/processors/value_replacer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::atomics::Int;
+
+// Describes a basic induction variable found by the analyzer or one created by the optimizer.
+struct InductionValue {
+  std::shared_ptr<ir::Computed> value;
+  std::shared_ptr<ir::Value> initial_value;
+  Int step;
+};
+
+class StrengthReducer {
+ public:
+  StrengthReducer(ir::Func* func) : func_(func) {}
+
+  void ReduceStrength();
+
+ private:
+  void ReduceStrengthInLoop(const ir_info::Loop* loop);
+  void ReduceMultiplications(const ir_info::Loop* loop, std::vector<InductionValue>& ivs);
+  void ReducePointerOffsets(const ir_info::Loop* loop, const std::vector<InductionValue>& ivs);
+
+  // Adds a phi to the loop header that starts with the initial value and gets updated by the
+  // increment instr, added to the end of the loop latch. The increment function receives the
+  // result of the increment and the phi result.
+  std::shared_ptr<ir::Computed> AddInductionPhi(
+      const ir_info::Loop* loop, const ir::Type* type, std::shared_ptr<ir::Value> initial_value,
+      std::function<std::unique_ptr<ir::Instr>(std::shared_ptr<ir::Computed>,
+                                               std::shared_ptr<ir::Computed>)>
+          make_increment);
+  void AddToPreheader(const ir_info::Loop* loop, std::unique_ptr<ir::Instr> instr);
+
+  void FindValueBlocks();
+  bool IsDefinedOutsideLoop(const ir_info::Loop* loop, const ir::Value* value) const;
+  bool IsOnlyUsedInLoop(const ir_info::Loop* loop, const ir::Computed* value) const;
+  // Returns the instrs of the given kind in the loop. The returned list stays valid while the
+  // optimizer inserts new instrs into the loop blocks.
+  std::vector<ir::Instr*> InstrsInLoop(const ir_info::Loop* loop, ir::InstrKind kind) const;
+  std::optional<InductionValue> FindInductionValue(const std::vector<InductionValue>& ivs,
+                                                   const ir::Value* value) const;
+
+  ir::Func* func_;
+  std::unordered_map<ir::value_num_t, ir::block_num_t> defining_blocks_;
+  std::unordered_map<ir::value_num_t, std::unordered_set<ir::block_num_t>> using_blocks_;
+  ir_processors::ValueReplacements replacements_;
+  std::unordered_set<ir::Instr*> removed_instrs_;
+};
+
+void StrengthReducer::ReduceStrength() {
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func_);
+  // Process inner loops first, such that the outer loops can reduce the initial values of
+  // induction variables of inner loops:
+  for (auto it = loop_info.loops().rbegin(); it != loop_info.loops().rend(); ++it) {
+    ReduceStrengthInLoop(it->get());
+  }
+}
+
+void StrengthReducer::ReduceStrengthInLoop(const ir_info::Loop* loop) {
+  std::vector<ir_info::InductionVariable> basic_ivs =
+      ir_analyzers::FindInductionVariablesInLoop(func_, loop);
+  if (basic_ivs.empty()) {
+    return;
+  }
+  std::vector<InductionValue> ivs;
+  ivs.reserve(basic_ivs.size());
+  for (const ir_info::InductionVariable& iv : basic_ivs) {
+    ivs.push_back(InductionValue{
+        .value = iv.value(), .initial_value = iv.initial_value(), .step = iv.step()});
+  }
+
+  FindValueBlocks();
+  replacements_.clear();
+  removed_instrs_.clear();
+
+  ReduceMultiplications(loop, ivs);
+  ReducePointerOffsets(loop, ivs);
+
+  if (removed_instrs_.empty()) {
+    return;
+  }
+  for (ir::block_num_t bnum : loop->blocks()) {
+    std::vector<std::unique_ptr<ir::Instr>>& instrs = func_->GetBlock(bnum)->instrs();
+    instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                [this](const std::unique_ptr<ir::Instr>& instr) {
+                                  return removed_instrs_.contains(instr.get());
+                                }),
+                 instrs.end());
+  }
+  ir_processors::ReplaceValuesInFunc(func_, replacements_);
+}
+
+void StrengthReducer::ReduceMultiplications(const ir_info::Loop* loop,
+                                            std::vector<InductionValue>& ivs) {
+  for (ir::Instr* instr : InstrsInLoop(loop, ir::InstrKind::kIntBinary)) {
+    auto mul_instr = static_cast<ir::IntBinaryInstr*>(instr);
+    std::shared_ptr<ir::Value> a = mul_instr->operand_a();
+    std::shared_ptr<ir::Value> b = mul_instr->operand_b();
+    if (a->kind() == ir::Value::Kind::kConstant) {
+      std::swap(a, b);
+    }
+    if (mul_instr->operation() != Int::BinaryOp::kMul ||
+        b->kind() != ir::Value::Kind::kConstant ||
+        !IsOnlyUsedInLoop(loop, mul_instr->result().get())) {
+      continue;
+    }
+    std::optional<InductionValue> iv = FindInductionValue(ivs, a.get());
+    if (!iv.has_value()) {
+      continue;
+    }
+    Int factor = static_cast<ir::IntConstant*>(b.get())->value();
+    Int step = Int::Compute(iv->step, Int::BinaryOp::kMul, factor);
+
+    std::shared_ptr<ir::Value> initial_value;
+    if (iv->initial_value->kind() == ir::Value::Kind::kConstant) {
+      Int initial = static_cast<ir::IntConstant*>(iv->initial_value.get())->value();
+      initial_value = ir::ToIntConstant(Int::Compute(initial, Int::BinaryOp::kMul, factor));
+    } else {
+      auto initial_result = std::make_shared<ir::Computed>(mul_instr->result()->type(),
+                                                           func_->next_computed_number());
+      AddToPreheader(loop, std::make_unique<ir::IntBinaryInstr>(
+                               initial_result, Int::BinaryOp::kMul, iv->initial_value, b));
+      initial_value = initial_result;
+    }
+    std::shared_ptr<ir::Computed> reduced_value = AddInductionPhi(
+        loop, mul_instr->result()->type(), initial_value,
+        [step](std::shared_ptr<ir::Computed> next, std::shared_ptr<ir::Computed> current) {
+          return std::make_unique<ir::IntBinaryInstr>(next, Int::BinaryOp::kAdd, current,
+                                                      ir::ToIntConstant(step));
+        });
+
+    replacements_.insert({mul_instr->result()->number(), reduced_value});
+    removed_instrs_.insert(mul_instr);
+    ivs.push_back(InductionValue{.value = mul_instr->result(),
+                                 .initial_value = initial_value,
+                                 .step = step});
+  }
+}
+
+void StrengthReducer::ReducePointerOffsets(const ir_info::Loop* loop,
+                                           const std::vector<InductionValue>& ivs) {
+  for (ir::Instr* instr : InstrsInLoop(loop, ir::InstrKind::kPointerOffset)) {
+    auto pointer_offset_instr = static_cast<ir::PointerOffsetInstr*>(instr);
+    std::shared_ptr<ir::Computed> pointer = pointer_offset_instr->pointer();
+    if (!IsDefinedOutsideLoop(loop, pointer.get()) ||
+        !IsOnlyUsedInLoop(loop, pointer_offset_instr->result().get())) {
+      continue;
+    }
+    std::optional<InductionValue> iv =
+        FindInductionValue(ivs, pointer_offset_instr->offset().get());
+    if (!iv.has_value() || iv->step.type() != common::atomics::IntType::kI64) {
+      continue;
+    }
+
+    auto initial_pointer =
+        std::make_shared<ir::Computed>(ir::pointer_type(), func_->next_computed_number());
+    AddToPreheader(loop, std::make_unique<ir::PointerOffsetInstr>(initial_pointer, pointer,
+                                                                  iv->initial_value));
+    Int step = iv->step;
+    std::shared_ptr<ir::Computed> reduced_pointer = AddInductionPhi(
+        loop, ir::pointer_type(), initial_pointer,
+        [step](std::shared_ptr<ir::Computed> next, std::shared_ptr<ir::Computed> current) {
+          return std::make_unique<ir::PointerOffsetInstr>(next, current,
+                                                          ir::ToIntConstant(step));
+        });
+
+    replacements_.insert({pointer_offset_instr->result()->number(), reduced_pointer});
+    removed_instrs_.insert(pointer_offset_instr);
+  }
+}
+
+std::shared_ptr<ir::Computed> StrengthReducer::AddInductionPhi(
+    const ir_info::Loop* loop, const ir::Type* type, std::shared_ptr<ir::Value> initial_value,
+    std::function<std::unique_ptr<ir::Instr>(std::shared_ptr<ir::Computed>,
+                                             std::shared_ptr<ir::Computed>)>
+        make_increment) {
+  ir::block_num_t latch = *loop->latches().begin();
+  auto current = std::make_shared<ir::Computed>(type, func_->next_computed_number());
+  auto next = std::make_shared<ir::Computed>(type, func_->next_computed_number());
+
+  std::vector<std::unique_ptr<ir::Instr>>& header_instrs =
+      func_->GetBlock(loop->header())->instrs();
+  auto first_non_phi = std::find_if(
+      header_instrs.begin(), header_instrs.end(), [](const std::unique_ptr<ir::Instr>& instr) {
+        return instr->instr_kind() != ir::InstrKind::kPhi;
+      });
+  header_instrs.insert(first_non_phi,
+                       std::make_unique<ir::PhiInstr>(
+                           current, std::vector<std::shared_ptr<ir::InheritedValue>>{
+                                        std::make_shared<ir::InheritedValue>(initial_value,
+                                                                             loop->preheader()),
+                                        std::make_shared<ir::InheritedValue>(next, latch)}));
+
+  std::vector<std::unique_ptr<ir::Instr>>& latch_instrs = func_->GetBlock(latch)->instrs();
+  latch_instrs.insert(latch_instrs.end() - 1, make_increment(next, current));
+  return current;
+}
+
+void StrengthReducer::AddToPreheader(const ir_info::Loop* loop, std::unique_ptr<ir::Instr> instr) {
+  std::vector<std::unique_ptr<ir::Instr>>& instrs = func_->GetBlock(loop->preheader())->instrs();
+  instrs.insert(instrs.end() - 1, std::move(instr));
+}
+
+void StrengthReducer::FindValueBlocks() {
+  defining_blocks_.clear();
+  using_blocks_.clear();
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        defining_blocks_.insert({defined_value->number(), block->number()});
+      }
+      for (std::shared_ptr<ir::Value> used_value : instr->UsedValues()) {
+        if (used_value->kind() == ir::Value::Kind::kInherited) {
+          used_value = std::static_pointer_cast<ir::InheritedValue>(used_value)->value();
+        }
+        if (used_value->kind() == ir::Value::Kind::kComputed) {
+          using_blocks_[static_cast<ir::Computed*>(used_value.get())->number()].insert(
+              block->number());
+        }
+      }
+    }
+  }
+}
+
+bool StrengthReducer::IsDefinedOutsideLoop(const ir_info::Loop* loop,
+                                           const ir::Value* value) const {
+  if (value->kind() != ir::Value::Kind::kComputed) {
+    return true;
+  }
+  auto it = defining_blocks_.find(static_cast<const ir::Computed*>(value)->number());
+  return it == defining_blocks_.end() || !loop->Contains(it->second);
+}
+
+bool StrengthReducer::IsOnlyUsedInLoop(const ir_info::Loop* loop,
+                                       const ir::Computed* value) const {
+  auto it = using_blocks_.find(value->number());
+  if (it == using_blocks_.end()) {
+    return true;
+  }
+  return std::all_of(it->second.begin(), it->second.end(),
+                     [loop](ir::block_num_t bnum) { return loop->Contains(bnum); });
+}
+
+std::vector<ir::Instr*> StrengthReducer::InstrsInLoop(const ir_info::Loop* loop,
+                                                      ir::InstrKind kind) const {
+  std::vector<ir::block_num_t> blocks(loop->blocks().begin(), loop->blocks().end());
+  std::sort(blocks.begin(), blocks.end());
+  std::vector<ir::Instr*> instrs;
+  for (ir::block_num_t bnum : blocks) {
+    for (const std::unique_ptr<ir::Instr>& instr : func_->GetBlock(bnum)->instrs()) {
+      if (instr->instr_kind() == kind) {
+        instrs.push_back(instr.get());
+      }
+    }
+  }
+  return instrs;
+}
+
+std::optional<InductionValue> StrengthReducer::FindInductionValue(
+    const std::vector<InductionValue>& ivs, const ir::Value* value) const {
+  if (value->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  ir::value_num_t number = static_cast<const ir::Computed*>(value)->number();
+  for (const InductionValue& iv : ivs) {
+    if (iv.value->number() == number) {
+      return iv;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+void ReduceStrengthInFunc(ir::Func* func) {
+  StrengthReducer reducer(func);
+  reducer.ReduceStrength();
+}
+
+void ReduceStrengthInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    ReduceStrengthInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,28 @@
+//
+//  strength_reduction_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_strength_reduction_optimizer_h
+#define ir_optimizers_strength_reduction_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Replaces multiplications of loop induction variables with int constants by new induction
+// variables that get incremented by the product of the step and the constant (and can get
+// multiplied again). Afterwards, pointer offsets from loop invariant pointers by induction
+// variables get replaced by pointer induction variables that get offset by the step on every
+// iteration. Only results without uses outside the loop get replaced. Loops without preheader or
+// with several latches remain unchanged.
+void ReduceStrengthInFunc(ir::Func* func);
+void ReduceStrengthInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_strength_reduction_optimizer_h */
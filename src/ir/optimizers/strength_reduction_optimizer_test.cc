@@ -0,0 +1,237 @@
+//
+//  strength_reduction_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/strength_reduction_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+class StrengthReductionImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(StrengthReductionImpossibleTestInstance, StrengthReductionImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{2}
+    %3:b = ilss %2, %0
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = imul %2, %1
+    %5:i64 = iadd %2, %4
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %5:i64{2}
+    %3:i64 = phi #0:i64{0}, %4:i64{2}
+    %4:i64 = imul %2, #3:i64
+    %6:b = ilss %2, %0
+    jcc %6, {2}, {3}
+  {2}
+    %5:i64 = iadd %2, #1:i64
+    jmp {1}
+  {3}
+    %7:i64 = iadd %3, %4
+    ret %7
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #1:i64{0}, %5:i64{2}
+    %3:i64 = phi #0:i64{0}, %6:i64{2}
+    %7:b = ilss %2, %0
+    jcc %7, {2}, {3}
+  {2}
+    %4:i64 = imul %2, #3:i64
+    %5:i64 = imul %2, #2:i64
+    %6:i64 = iadd %3, %4
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir"));
+
+TEST_P(StrengthReductionImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ReduceStrengthInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class StrengthReductionPossibleTest
+    : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(StrengthReductionPossibleTestInstance, StrengthReductionPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %5:i64{2}
+    %2:i64 = phi #0:i64{0}, %4:i64{2}
+    %3:b = ilss %1, %0
+    jcc %3, {2}, {3}
+  {2}
+    %6:i64 = imul %1, #3:i64
+    %4:i64 = iadd %2, %6
+    %7:i64 = iadd %1, #3:i64
+    %5:i64 = isub %7, #1:i64
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %1:i64 = phi #0:i64{0}, %5:i64{2}
+    %2:i64 = phi #0:i64{0}, %4:i64{2}
+    %8:i64 = phi #0:i64{0}, %9:i64{2}
+    %3:b = ilss %1, %0
+    jcc %3, {2}, {3}
+  {2}
+    %4:i64 = iadd %2, %8
+    %7:i64 = iadd %1, #3:i64
+    %5:i64 = isub %7, #1:i64
+    %9:i64 = iadd %8, #6:i64
+    jmp {1}
+  {3}
+    ret %2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi %1{0}, %5:i64{2}
+    %3:i64 = phi #0:i64{0}, %4:i64{2}
+    %6:b = ilss %2, %0
+    jcc %6, {2}, {3}
+  {2}
+    %7:i64 = imul #4:i64, %2
+    %4:i64 = iadd %3, %7
+    %5:i64 = iadd %2, #1:i64
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %8:i64 = imul %1, #4:i64
+    jmp {1}
+  {1}
+    %2:i64 = phi %1{0}, %5:i64{2}
+    %3:i64 = phi #0:i64{0}, %4:i64{2}
+    %9:i64 = phi %8{0}, %10:i64{2}
+    %6:b = ilss %2, %0
+    jcc %6, {2}, {3}
+  {2}
+    %4:i64 = iadd %3, %9
+    %5:i64 = iadd %2, #1:i64
+    %10:i64 = iadd %9, #4:i64
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %8:i64{2}
+    %3:i64 = phi #0:i64{0}, %7:i64{2}
+    %4:b = ilss %2, %1
+    jcc %4, {2}, {3}
+  {2}
+    %5:i64 = imul %2, #8:i64
+    %6:ptr = poff %0, %5
+    %9:i64 = load %6
+    %7:i64 = iadd %3, %9
+    %8:i64 = iadd %2, #1:i64
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %12:ptr = poff %0, #0:i64
+    jmp {1}
+  {1}
+    %2:i64 = phi #0:i64{0}, %8:i64{2}
+    %3:i64 = phi #0:i64{0}, %7:i64{2}
+    %10:i64 = phi #0:i64{0}, %11:i64{2}
+    %13:ptr = phi %12{0}, %14:ptr{2}
+    %4:b = ilss %2, %1
+    jcc %4, {2}, {3}
+  {2}
+    %9:i64 = load %13
+    %7:i64 = iadd %3, %9
+    %8:i64 = iadd %2, #1:i64
+    %11:i64 = iadd %10, #8:i64
+    %14:ptr = poff %13, #8:i64
+    jmp {1}
+  {3}
+    ret %3
+}
+)ir",
+                             }));
+
+TEST_P(StrengthReductionPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::ReduceStrengthInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
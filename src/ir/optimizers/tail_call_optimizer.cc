@@ -0,0 +1,115 @@
+//
+//  tail_call_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/26/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "tail_call_optimizer.h"
+
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "src/ir/processors/value_replacer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+bool IsSelfTailCall(const ir::Func* func, const ir::Block* block) {
+  const std::vector<std::unique_ptr<ir::Instr>>& instrs = block->instrs();
+  if (instrs.size() < 2 || instrs.back()->instr_kind() != ir::InstrKind::kReturn ||
+      instrs.at(instrs.size() - 2)->instr_kind() != ir::InstrKind::kCall) {
+    return false;
+  }
+  auto call_instr = static_cast<const ir::CallInstr*>(instrs.at(instrs.size() - 2).get());
+  auto return_instr = static_cast<const ir::ReturnInstr*>(instrs.back().get());
+  if (call_instr->func()->kind() != ir::Value::Kind::kConstant ||
+      call_instr->func()->type() != ir::func_type() ||
+      static_cast<ir::FuncConstant*>(call_instr->func().get())->value() != func->number() ||
+      call_instr->args().size() != func->args().size() ||
+      call_instr->results().size() != return_instr->args().size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < return_instr->args().size(); i++) {
+    const ir::Value* returned_value = return_instr->args().at(i).get();
+    if (returned_value->kind() != ir::Value::Kind::kComputed ||
+        static_cast<const ir::Computed*>(returned_value)->number() !=
+            call_instr->results().at(i)->number()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+void EliminateSelfTailCallsInFunc(ir::Func* func) {
+  std::vector<ir::Block*> tail_call_blocks;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    if (IsSelfTailCall(func, block.get())) {
+      tail_call_blocks.push_back(block.get());
+    }
+  }
+  if (tail_call_blocks.empty()) {
+    return;
+  }
+
+  // The entry block can not have parents, therefore the loop starts at the former entry block and
+  // a new entry block jumps to it:
+  ir::Block* loop_header = func->entry_block();
+  ir::Block* entry_block = func->AddBlock();
+  entry_block->instrs().push_back(std::make_unique<ir::JumpInstr>(loop_header->number()));
+  func->set_entry_block_num(entry_block->number());
+  func->AddControlFlow(entry_block->number(), loop_header->number());
+
+  ir_processors::ValueReplacements replacements;
+  std::vector<std::shared_ptr<ir::Computed>> loop_args;
+  loop_args.reserve(func->args().size());
+  for (const std::shared_ptr<ir::Computed>& arg : func->args()) {
+    auto loop_arg = std::make_shared<ir::Computed>(arg->type(), func->next_computed_number());
+    replacements.insert({arg->number(), loop_arg});
+    loop_args.push_back(loop_arg);
+  }
+  ir_processors::ReplaceValuesInFunc(func, replacements);
+
+  std::vector<std::vector<std::shared_ptr<ir::InheritedValue>>> phi_args(func->args().size());
+  for (std::size_t i = 0; i < func->args().size(); i++) {
+    phi_args.at(i).push_back(
+        std::make_shared<ir::InheritedValue>(func->args().at(i), entry_block->number()));
+  }
+  for (ir::Block* block : tail_call_blocks) {
+    std::vector<std::unique_ptr<ir::Instr>>& instrs = block->instrs();
+    auto call_instr = static_cast<ir::CallInstr*>(instrs.at(instrs.size() - 2).get());
+    for (std::size_t i = 0; i < func->args().size(); i++) {
+      phi_args.at(i).push_back(
+          std::make_shared<ir::InheritedValue>(call_instr->args().at(i), block->number()));
+    }
+    instrs.pop_back();
+    instrs.pop_back();
+    instrs.push_back(std::make_unique<ir::JumpInstr>(loop_header->number()));
+    func->AddControlFlow(block->number(), loop_header->number());
+  }
+
+  std::vector<std::unique_ptr<ir::Instr>> phis;
+  phis.reserve(func->args().size());
+  for (std::size_t i = 0; i < func->args().size(); i++) {
+    phis.push_back(std::make_unique<ir::PhiInstr>(loop_args.at(i), phi_args.at(i)));
+  }
+  loop_header->instrs().insert(loop_header->instrs().begin(), std::make_move_iterator(phis.begin()),
+                               std::make_move_iterator(phis.end()));
+}
+
+void EliminateSelfTailCallsInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    EliminateSelfTailCallsInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
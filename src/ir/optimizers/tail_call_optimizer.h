@@ -0,0 +1,26 @@
+//
+//  tail_call_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/26/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_tail_call_optimizer_h
+#define ir_optimizers_tail_call_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Replaces self tail calls (calls of the func itself, directly followed by a return of exactly the
+// call results) with jumps back to the start of the func. The func args get replaced by phis in
+// the former entry block, which merge the original args from a new entry block with the args of
+// all tail calls. Recursive funcs of this form then execute as loops in constant stack space.
+void EliminateSelfTailCallsInFunc(ir::Func* func);
+void EliminateSelfTailCallsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_tail_call_optimizer_h */
@@ -0,0 +1,236 @@
+//
+//  tail_call_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/26/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/tail_call_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+#include "src/lang/processors/ir/check/check_test_util.h"
+#include "src/lang/processors/ir/serialization/parse.h"
+
+class TailCallImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(TailCallImpossibleTestInstance, TailCallImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:i64 = call @1, %0
+    ret %1
+}
+
+@1 g(%0:i64) => (i64) {
+  {0}
+    %1:i64 = iadd %0, #1:i64
+    ret %1
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64) => (i64) {
+  {0}
+    %1:b = ilss %0, #2:i64
+    jcc %1, {1}, {2}
+  {1}
+    ret #1:i64
+  {2}
+    %2:i64 = isub %0, #1:i64
+    %3:i64 = call @0, %2
+    %4:i64 = imul %0, %3
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:i64, %1:i64) => (i64, i64) {
+  {0}
+    %2:b = ilss %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    ret %0, %1
+  {2}
+    %3:i64, %4:i64 = call @0, %1, %0
+    ret %4, %3
+}
+)ir"));
+
+TEST_P(TailCallImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::EliminateSelfTailCallsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected unchanged program, got:\n"
+      << ir_serialization::Print(input_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class TailCallPossibleTest : public testing::TestWithParam<PossibleOptimizationTestParams> {};
+
+INSTANTIATE_TEST_SUITE_P(TailCallPossibleTestInstance, TailCallPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 sum(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = ieq %0, #0:i64
+    jcc %2, {1}, {2}
+  {1}
+    ret %1
+  {2}
+    %3:i64 = isub %0, #1:i64
+    %4:i64 = iadd %1, %0
+    %5:i64 = call @0, %3, %4
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 sum(%0:i64, %1:i64) => (i64) {
+  {3}
+    jmp {0}
+  {0}
+    %6:i64 = phi %0{3}, %3:i64{2}
+    %7:i64 = phi %1{3}, %4:i64{2}
+    %2:b = ieq %6, #0:i64
+    jcc %2, {1}, {2}
+  {1}
+    ret %7
+  {2}
+    %3:i64 = isub %6, #1:i64
+    %4:i64 = iadd %7, %6
+    jmp {0}
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 gcd(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:b = ieq %0, %1
+    jcc %2, {1}, {2}
+  {1}
+    ret %0
+  {2}
+    %3:b = ilss %0, %1
+    jcc %3, {3}, {4}
+  {3}
+    %4:i64 = isub %1, %0
+    %5:i64 = call @0, %0, %4
+    ret %5
+  {4}
+    %6:i64 = isub %0, %1
+    %7:i64 = call @0, %6, %1
+    ret %7
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 gcd(%0:i64, %1:i64) => (i64) {
+  {5}
+    jmp {0}
+  {0}
+    %8:i64 = phi %0{5}, %8:i64{3}, %6:i64{4}
+    %9:i64 = phi %1{5}, %4:i64{3}, %9:i64{4}
+    %2:b = ieq %8, %9
+    jcc %2, {1}, {2}
+  {1}
+    ret %8
+  {2}
+    %3:b = ilss %8, %9
+    jcc %3, {3}, {4}
+  {3}
+    %4:i64 = isub %9, %8
+    jmp {0}
+  {4}
+    %6:i64 = isub %8, %9
+    jmp {0}
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f() => () {
+  {0}
+    call @0
+    ret
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f() => () {
+  {1}
+    jmp {0}
+  {0}
+    jmp {0}
+}
+)ir",
+                             }));
+
+TEST_P(TailCallPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::EliminateSelfTailCallsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(TailCallTest, EliminatesSelfTailCallsWithArgsUsedByLangInstrs) {
+  std::unique_ptr<ir::Program> optimized_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 repeat(%0:lstr, %1:i64) => (lstr) {
+  {0}
+    %2:b = ieq %1, #0:i64
+    jcc %2, {1}, {2}
+  {1}
+    ret %0
+  {2}
+    %3:lstr = str_cat %0, "a"
+    %4:i64 = isub %1, #1:i64
+    %5:lstr = call @0, %3, %4
+    ret %5
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 repeat(%0:lstr, %1:i64) => (lstr) {
+  {3}
+    jmp {0}
+  {0}
+    %6:lstr = phi %0{3}, %3:lstr{2}
+    %7:i64 = phi %1{3}, %4:i64{2}
+    %2:b = ieq %7, #0:i64
+    jcc %2, {1}, {2}
+  {1}
+    ret %6
+  {2}
+    %3:lstr = str_cat %6, "a"
+    %4:i64 = isub %7, #1:i64
+    jmp {0}
+}
+)ir");
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::EliminateSelfTailCallsInProgram(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
@@ -0,0 +1,360 @@
+//
+//  value_numbering_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "value_numbering_optimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/ir/analyzers/memory_analyzer.h"
+#include "src/ir/info/memory_info.h"
+#include "src/ir/processors/value_replacer.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_optimizers {
+namespace {
+
+using ::common::atomics::Bool;
+using ::common::atomics::Int;
+
+// Describes the computation performed by a pure instr. Two instrs with equal expressions compute
+// the same result.
+struct Expression {
+  ir::InstrKind instr_kind;
+  int64_t operation;  // operation of the instr or block number for phis
+  const ir::Type* result_type;
+  std::vector<std::shared_ptr<ir::Value>> operands;
+
+  bool operator==(const Expression& that) const {
+    if (instr_kind != that.instr_kind || operation != that.operation ||
+        result_type != that.result_type || operands.size() != that.operands.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < operands.size(); i++) {
+      if (!ir::IsEqual(operands.at(i).get(), that.operands.at(i).get())) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+std::size_t HashValue(const ir::Value* value) {
+  switch (value->kind()) {
+    case ir::Value::Kind::kComputed:
+      return std::hash<ir::value_num_t>{}(static_cast<const ir::Computed*>(value)->number());
+    case ir::Value::Kind::kInherited: {
+      auto inherited_value = static_cast<const ir::InheritedValue*>(value);
+      return HashValue(inherited_value->value().get()) * 31 +
+             std::hash<ir::block_num_t>{}(inherited_value->origin());
+    }
+    default:
+      return std::hash<const ir::Type*>{}(value->type());
+  }
+}
+
+struct ExpressionHash {
+  std::size_t operator()(const Expression& expr) const {
+    std::size_t hash = std::hash<int64_t>{}(int64_t(expr.instr_kind)) * 31 +
+                       std::hash<int64_t>{}(expr.operation);
+    for (const std::shared_ptr<ir::Value>& operand : expr.operands) {
+      hash = hash * 31 + HashValue(operand.get());
+    }
+    return hash;
+  }
+};
+
+// The result of a computation and the block it is defined in.
+typedef std::pair<ir::block_num_t, std::shared_ptr<ir::Computed>> DefinedComputation;
+
+// Memory locations known to hold the results of earlier loads.
+struct AvailableLoad {
+  std::shared_ptr<ir::Value> address;
+  std::shared_ptr<ir::Computed> result;
+};
+typedef std::vector<AvailableLoad> AvailableLoads;
+
+class ValueNumberer {
+ public:
+  ValueNumberer(ir::Func* func)
+      : func_(func), memory_info_(ir_analyzers::FindMemoryLocationsInFunc(func)) {}
+
+  void RemoveRedundantComputations();
+
+ private:
+  void VisitBlock(ir::Block* block);
+  void VisitInstr(ir::Instr* instr, ir::block_num_t block_num, AvailableLoads& available_loads);
+  void VisitLoadInstr(ir::LoadInstr* instr, AvailableLoads& available_loads);
+  void VisitStoreInstr(ir::StoreInstr* instr, AvailableLoads& available_loads);
+
+  std::optional<Expression> ExpressionForInstr(ir::Instr* instr, ir::block_num_t block_num) const;
+  std::optional<std::shared_ptr<ir::Value>> TrivialPhiValue(ir::PhiInstr* instr) const;
+  std::shared_ptr<ir::Computed> FindDominatingComputation(const Expression& expr,
+                                                          ir::block_num_t block_num) const;
+
+  void Replace(ir::Instr* instr, ir::Computed* result, std::shared_ptr<ir::Value> replacement);
+
+  ir::Func* func_;
+  const ir_info::MemoryInfo memory_info_;
+  std::unordered_map<Expression, std::vector<DefinedComputation>, ExpressionHash> computations_;
+  std::unordered_map<ir::block_num_t, AvailableLoads> available_loads_at_block_ends_;
+
+  ir_processors::ValueReplacements replacements_;
+  std::unordered_set<ir::Instr*> removed_instrs_;
+};
+
+void ValueNumberer::RemoveRedundantComputations() {
+  func_->ForBlocksInDominanceOrder([this](ir::Block* block) { VisitBlock(block); });
+  if (removed_instrs_.empty()) {
+    return;
+  }
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    std::erase_if(block->instrs(), [this](const std::unique_ptr<ir::Instr>& instr) {
+      return removed_instrs_.contains(instr.get());
+    });
+  }
+  ir_processors::ReplaceValuesInFunc(func_, replacements_);
+}
+
+void ValueNumberer::VisitBlock(ir::Block* block) {
+  // Loads remain available if the block can only be entered from its dominator:
+  AvailableLoads available_loads;
+  if (block->parents().size() == 1) {
+    ir::block_num_t parent_num = *block->parents().begin();
+    auto it = available_loads_at_block_ends_.find(parent_num);
+    if (it != available_loads_at_block_ends_.end()) {
+      available_loads = it->second;
+    }
+  }
+  for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+    VisitInstr(instr.get(), block->number(), available_loads);
+  }
+  available_loads_at_block_ends_.insert({block->number(), std::move(available_loads)});
+}
+
+void ValueNumberer::VisitInstr(ir::Instr* instr, ir::block_num_t block_num,
+                               AvailableLoads& available_loads) {
+  ir_processors::ReplaceValuesInInstr(instr, replacements_);
+
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov: {
+      auto mov_instr = static_cast<ir::MovInstr*>(instr);
+      if (mov_instr->origin()->kind() == ir::Value::Kind::kComputed) {
+        Replace(instr, mov_instr->result().get(), mov_instr->origin());
+        return;
+      }
+      break;
+    }
+    case ir::InstrKind::kPhi: {
+      auto phi_instr = static_cast<ir::PhiInstr*>(instr);
+      if (std::optional<std::shared_ptr<ir::Value>> value = TrivialPhiValue(phi_instr);
+          value.has_value()) {
+        Replace(instr, phi_instr->result().get(), *value);
+        return;
+      }
+      break;
+    }
+    case ir::InstrKind::kConversion:
+    case ir::InstrKind::kBoolNot:
+    case ir::InstrKind::kBoolBinary:
+    case ir::InstrKind::kIntUnary:
+    case ir::InstrKind::kIntCompare:
+    case ir::InstrKind::kIntBinary:
+    case ir::InstrKind::kIntShift:
+    case ir::InstrKind::kPointerOffset:
+    case ir::InstrKind::kNilTest:
+      break;
+    case ir::InstrKind::kLoad:
+      VisitLoadInstr(static_cast<ir::LoadInstr*>(instr), available_loads);
+      return;
+    case ir::InstrKind::kStore:
+      VisitStoreInstr(static_cast<ir::StoreInstr*>(instr), available_loads);
+      return;
+    case ir::InstrKind::kMalloc:
+    case ir::InstrKind::kStackAlloc:
+    case ir::InstrKind::kJump:
+    case ir::InstrKind::kJumpCond:
+    case ir::InstrKind::kReturn:
+      return;
+    default:
+      // Calls, syscalls, frees, and lang instrs might modify any memory:
+      available_loads.clear();
+      return;
+  }
+
+  std::optional<Expression> expr = ExpressionForInstr(instr, block_num);
+  if (!expr.has_value()) {
+    return;
+  }
+  auto computation = static_cast<ir::Computation*>(instr);
+  if (std::shared_ptr<ir::Computed> equal_computation = FindDominatingComputation(*expr, block_num);
+      equal_computation != nullptr) {
+    Replace(instr, computation->result().get(), equal_computation);
+    return;
+  }
+  computations_[*expr].push_back({block_num, computation->result()});
+}
+
+void ValueNumberer::VisitLoadInstr(ir::LoadInstr* instr, AvailableLoads& available_loads) {
+  for (const AvailableLoad& available_load : available_loads) {
+    if (available_load.result->type() == instr->result()->type() &&
+        ir::IsEqual(available_load.address.get(), instr->address().get())) {
+      Replace(instr, instr->result().get(), available_load.result);
+      return;
+    }
+  }
+  available_loads.push_back(AvailableLoad{
+      .address = instr->address(),
+      .result = instr->result(),
+  });
+}
+
+void ValueNumberer::VisitStoreInstr(ir::StoreInstr* instr, AvailableLoads& available_loads) {
+  int64_t store_size = instr->value()->type()->size();
+  std::erase_if(available_loads, [&](const AvailableLoad& available_load) {
+    return memory_info_.MayAlias(available_load.address.get(),
+                                 available_load.result->type()->size(), instr->address().get(),
+                                 store_size);
+  });
+}
+
+std::optional<Expression> ValueNumberer::ExpressionForInstr(ir::Instr* instr,
+                                                            ir::block_num_t block_num) const {
+  Expression expr{
+      .instr_kind = instr->instr_kind(),
+      .operation = 0,
+      .result_type = static_cast<ir::Computation*>(instr)->result()->type(),
+      .operands = instr->UsedValues(),
+  };
+  bool commutative = false;
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kPhi: {
+      auto phi_instr = static_cast<ir::PhiInstr*>(instr);
+      expr.operation = block_num;
+      expr.operands.clear();
+      for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+        expr.operands.push_back(arg);
+      }
+      std::sort(expr.operands.begin(), expr.operands.end(),
+                [](const std::shared_ptr<ir::Value>& a, const std::shared_ptr<ir::Value>& b) {
+                  return static_cast<ir::InheritedValue*>(a.get())->origin() <
+                         static_cast<ir::InheritedValue*>(b.get())->origin();
+                });
+      break;
+    }
+    case ir::InstrKind::kBoolBinary:
+      expr.operation = int64_t(static_cast<ir::BoolBinaryInstr*>(instr)->operation());
+      commutative = true;
+      break;
+    case ir::InstrKind::kIntUnary:
+      expr.operation = int64_t(static_cast<ir::IntUnaryInstr*>(instr)->operation());
+      break;
+    case ir::InstrKind::kIntCompare: {
+      Int::CompareOp op = static_cast<ir::IntCompareInstr*>(instr)->operation();
+      expr.operation = int64_t(op);
+      commutative = (op == Int::CompareOp::kEq || op == Int::CompareOp::kNeq);
+      break;
+    }
+    case ir::InstrKind::kIntBinary: {
+      Int::BinaryOp op = static_cast<ir::IntBinaryInstr*>(instr)->operation();
+      expr.operation = int64_t(op);
+      commutative = (op == Int::BinaryOp::kAdd || op == Int::BinaryOp::kMul ||
+                     op == Int::BinaryOp::kAnd || op == Int::BinaryOp::kOr ||
+                     op == Int::BinaryOp::kXor);
+      break;
+    }
+    case ir::InstrKind::kIntShift:
+      expr.operation = int64_t(static_cast<ir::IntShiftInstr*>(instr)->operation());
+      break;
+    default:
+      break;
+  }
+  // Order operands of commutative operations canonically: computed values by number, before
+  // constants.
+  if (commutative && expr.operands.size() == 2) {
+    const ir::Value* a = expr.operands.at(0).get();
+    const ir::Value* b = expr.operands.at(1).get();
+    if (a->kind() != ir::Value::Kind::kComputed && b->kind() == ir::Value::Kind::kComputed) {
+      std::swap(expr.operands.at(0), expr.operands.at(1));
+    } else if (a->kind() == ir::Value::Kind::kComputed && b->kind() == ir::Value::Kind::kComputed &&
+               static_cast<const ir::Computed*>(b)->number() <
+                   static_cast<const ir::Computed*>(a)->number()) {
+      std::swap(expr.operands.at(0), expr.operands.at(1));
+    }
+  }
+  return expr;
+}
+
+std::optional<std::shared_ptr<ir::Value>> ValueNumberer::TrivialPhiValue(
+    ir::PhiInstr* instr) const {
+  std::shared_ptr<ir::Value> value;
+  for (const std::shared_ptr<ir::InheritedValue>& arg : instr->args()) {
+    if (ir::IsEqual(arg->value().get(), instr->result().get())) {
+      continue;
+    } else if (value == nullptr) {
+      value = arg->value();
+    } else if (!ir::IsEqual(arg->value().get(), value.get())) {
+      return std::nullopt;
+    }
+  }
+  if (value == nullptr) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::shared_ptr<ir::Computed> ValueNumberer::FindDominatingComputation(
+    const Expression& expr, ir::block_num_t block_num) const {
+  auto it = computations_.find(expr);
+  if (it == computations_.end()) {
+    return nullptr;
+  }
+  for (const auto& [computation_block_num, computation_result] : it->second) {
+    if (func_->Dominates(computation_block_num, block_num)) {
+      return computation_result;
+    }
+  }
+  return nullptr;
+}
+
+void ValueNumberer::Replace(ir::Instr* instr, ir::Computed* result,
+                            std::shared_ptr<ir::Value> replacement) {
+  // Pointer offsets require a computed pointer, other uses can not be replaced with constants:
+  if (replacement->kind() != ir::Value::Kind::kComputed &&
+      result->type()->type_kind() == ir::TypeKind::kPointer) {
+    return;
+  }
+  replacements_.insert({result->number(), replacement});
+  removed_instrs_.insert(instr);
+}
+
+}  // namespace
+
+void RemoveRedundantComputationsInFunc(ir::Func* func) {
+  ValueNumberer value_numberer(func);
+  value_numberer.RemoveRedundantComputations();
+}
+
+void RemoveRedundantComputationsInProgram(ir::Program* program) {
+  for (const std::unique_ptr<ir::Func>& func : program->funcs()) {
+    RemoveRedundantComputationsInFunc(func.get());
+  }
+}
+
+}  // namespace ir_optimizers
@@ -0,0 +1,26 @@
+//
+//  value_numbering_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_optimizers_value_numbering_optimizer_h
+#define ir_optimizers_value_numbering_optimizer_h
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_optimizers {
+
+// Performs dominator based global value numbering: computations that are equal to a computation
+// in a dominating position get removed and their uses replaced. Loads get removed if an equal load
+// precedes them in the same extended basic block without any possibly aliasing store, call, or
+// other instr with side effects in between.
+void RemoveRedundantComputationsInFunc(ir::Func* func);
+void RemoveRedundantComputationsInProgram(ir::Program* program);
+
+}  // namespace ir_optimizers
+
+#endif /* ir_optimizers_value_numbering_optimizer_h */
@@ -0,0 +1,272 @@
+//
+//  value_numbering_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/13/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/optimizers/value_numbering_optimizer.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+#include "src/lang/processors/ir/check/check_test_util.h"
+#include "src/lang/processors/ir/serialization/parse.h"
+
+class ValueNumberingImpossibleTest : public testing::TestWithParam<std::string> {};
+
+INSTANTIATE_TEST_SUITE_P(ValueNumberingImpossibleTestInstance, ValueNumberingImpossibleTest,
+                         testing::Values(R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = isub %0, %1
+    %3:i64 = isub %1, %0
+    %4:i64 = iadd %2, %3
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    jcc %0, {1}, {2}
+  {1}
+    %2:i64 = iadd %1, #1:i64
+    jmp {3}
+  {2}
+    %3:i64 = iadd %1, #1:i64
+    jmp {3}
+  {3}
+    %4:i64 = phi %2{1}, %3{2}
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:i64 = load %0
+    store %0, %1
+    %3:i64 = load %0
+    %4:i64 = iadd %2, %3
+    ret %4
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:ptr, %2:i64) => (i64) {
+  {0}
+    %3:i64 = load %0
+    store %1, %2
+    %4:i64 = load %0
+    %5:i64 = iadd %3, %4
+    ret %5
+}
+)ir",
+                                         R"ir(
+@0 f(%0:ptr, %1:b) => (i64) {
+  {0}
+    %2:i64 = load %0
+    jcc %1, {1}, {2}
+  {1}
+    call @1
+    jmp {2}
+  {2}
+    %3:i64 = load %0
+    %4:i64 = iadd %2, %3
+    ret %4
+}
+
+@1 g() => () {
+  {0}
+    ret
+}
+)ir"));
+
+TEST_P(ValueNumberingImpossibleTest, DoesNotOptimizeProgram) {
+  std::unique_ptr<ir::Program> input_program = ir_serialization::ParseProgramOrDie(GetParam());
+  std::unique_ptr<ir::Program> expected_program = ir_serialization::ParseProgramOrDie(GetParam());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantComputationsInProgram(input_program.get());
+  ir_check::CheckProgramOrDie(input_program.get());
+  EXPECT_TRUE(ir::IsEqual(input_program.get(), expected_program.get()))
+      << "Expected program to stay unoptimized, got:\n"
+      << ir_serialization::Print(input_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+struct PossibleOptimizationTestParams {
+  std::string input_program;
+  std::string expected_program;
+};
+
+class ValueNumberingPossibleTest : public testing::TestWithParam<PossibleOptimizationTestParams> {
+};
+
+INSTANTIATE_TEST_SUITE_P(ValueNumberingPossibleTestInstance, ValueNumberingPossibleTest,
+                         testing::Values(
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %0, %1
+    %3:i64 = iadd %1, %0
+    %4:i64 = mov %3
+    %5:i64 = imul %2, %4
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:i64, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %0, %1
+    %5:i64 = imul %2, %2
+    ret %5
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %1, #1:i64
+    jcc %0, {1}, {2}
+  {1}
+    %3:i64 = iadd %1, #1:i64
+    jmp {3}
+  {2}
+    %4:i64 = iadd %1, #1:i64
+    jmp {3}
+  {3}
+    %5:i64 = phi %3{1}, %4{2}
+    ret %5
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %2:i64 = iadd %1, #1:i64
+    jcc %0, {1}, {2}
+  {1}
+    jmp {3}
+  {2}
+    jmp {3}
+  {3}
+    ret %2
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:ptr = poff %0, #8:i64
+    %3:i64 = load %2
+    %4:ptr = poff %0, #16:i64
+    store %4, %1
+    %5:ptr = poff %0, #8:i64
+    %6:i64 = load %5
+    %7:i64 = iadd %3, %6
+    ret %7
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:ptr, %1:i64) => (i64) {
+  {0}
+    %2:ptr = poff %0, #8:i64
+    %3:i64 = load %2
+    %4:ptr = poff %0, #16:i64
+    store %4, %1
+    %7:i64 = iadd %3, %3
+    ret %7
+}
+)ir",
+                             },
+                             PossibleOptimizationTestParams{
+                                 .input_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %2:ptr = malloc #8:i64
+    %3:ptr = malloc #8:i64
+    store %2, %1
+    %4:i64 = load %2
+    jcc %0, {1}, {2}
+  {1}
+    store %3, #0:i64
+    %5:i64 = load %2
+    jmp {2}
+  {2}
+    %6:i64 = phi %4{0}, %5{1}
+    free %2
+    free %3
+    ret %6
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f(%0:b, %1:i64) => (i64) {
+  {0}
+    %2:ptr = malloc #8:i64
+    %3:ptr = malloc #8:i64
+    store %2, %1
+    %4:i64 = load %2
+    jcc %0, {1}, {2}
+  {1}
+    store %3, #0:i64
+    jmp {2}
+  {2}
+    free %2
+    free %3
+    ret %4
+}
+)ir",
+                             }));
+
+TEST_P(ValueNumberingPossibleTest, OptimizesProgram) {
+  std::unique_ptr<ir::Program> optimized_program =
+      ir_serialization::ParseProgramOrDie(GetParam().input_program);
+  std::unique_ptr<ir::Program> expected_program =
+      ir_serialization::ParseProgramOrDie(GetParam().expected_program);
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantComputationsInProgram(optimized_program.get());
+  ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
+
+TEST(ValueNumberingTest, ReplacesRedundantValuesUsedByLangInstrs) {
+  std::unique_ptr<ir::Program> optimized_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:lstr, %1:i64) => (i8, lstr) {
+  {0}
+    %2:i64 = iadd %1, #1:i64
+    %3:i64 = iadd %1, #1:i64
+    %4:i8 = str_index %0, %3
+    %5:lstr = mov %0
+    %6:lstr = str_cat %0, %5
+    ret %4, %6
+}
+)ir");
+  std::unique_ptr<ir::Program> expected_program = lang::ir_serialization::ParseProgramOrDie(R"ir(
+@0 f(%0:lstr, %1:i64) => (i8, lstr) {
+  {0}
+    %2:i64 = iadd %1, #1:i64
+    %4:i8 = str_index %0, %2
+    %6:lstr = str_cat %0, %0
+    ret %4, %6
+}
+)ir");
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(expected_program.get());
+
+  ir_optimizers::RemoveRedundantComputationsInProgram(optimized_program.get());
+  lang::ir_check::CheckProgramOrDie(optimized_program.get());
+  EXPECT_TRUE(ir::IsEqual(optimized_program.get(), expected_program.get()))
+      << "Expected different optimized program, got:\n"
+      << ir_serialization::Print(optimized_program.get()) << "\nexpected:\n"
+      << ir_serialization::Print(expected_program.get());
+}
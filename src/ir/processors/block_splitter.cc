@@ -0,0 +1,45 @@
+//
+//  block_splitter.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "block_splitter.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_processors {
+
+ir::Block* SplitBlockAfterInstr(ir::Func* func, ir::Block* block, std::size_t instr_index) {
+  ir::Block* continuation_block = func->AddBlock();
+  auto& instrs = block->instrs();
+  std::move(instrs.begin() + instr_index + 1, instrs.end(),
+            std::back_inserter(continuation_block->instrs()));
+  instrs.resize(instr_index + 1);
+
+  std::vector<ir::block_num_t> children(block->children().begin(), block->children().end());
+  std::sort(children.begin(), children.end());
+  for (ir::block_num_t child_num : children) {
+    func->AddControlFlow(continuation_block->number(), child_num);
+    func->RemoveControlFlow(block->number(), child_num);
+    func->GetBlock(child_num)->ForEachPhiInstr([&](ir::PhiInstr* phi_instr) {
+      for (std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+        if (arg->origin() == block->number()) {
+          arg = std::make_shared<ir::InheritedValue>(arg->value(), continuation_block->number());
+        }
+      }
+    });
+  }
+  return continuation_block;
+}
+
+}  // namespace ir_processors
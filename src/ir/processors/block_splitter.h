@@ -0,0 +1,26 @@
+//
+//  block_splitter.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/4/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_proc_block_splitter_h
+#define ir_proc_block_splitter_h
+
+#include <cstddef>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+
+namespace ir_processors {
+
+// Moves all instrs after the instr at the given index into a new block, which takes over the
+// children of the split block. Phis in the children get updated to inherit from the new block.
+// The split block is left without a terminating instr and without children.
+ir::Block* SplitBlockAfterInstr(ir::Func* func, ir::Block* block, std::size_t instr_index);
+
+}  // namespace ir_processors
+
+#endif /* ir_proc_block_splitter_h */
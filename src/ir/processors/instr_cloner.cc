@@ -0,0 +1,186 @@
+//
+//  instr_cloner.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "instr_cloner.h"
+
+#include "src/common/logging/logging.h"
+
+namespace ir_processors {
+
+using ::common::logging::fail;
+
+std::shared_ptr<ir::Value> CloningMaps::MapValue(const std::shared_ptr<ir::Value>& value) const {
+  switch (value->kind()) {
+    case ir::Value::Kind::kConstant:
+      return value;
+    case ir::Value::Kind::kComputed: {
+      auto it = values.find(static_cast<ir::Computed*>(value.get())->number());
+      return (it != values.end()) ? it->second : value;
+    }
+    case ir::Value::Kind::kInherited:
+      return MapInheritedValue(static_cast<ir::InheritedValue*>(value.get()));
+    default:
+      fail("unexpected value kind");
+  }
+}
+
+std::shared_ptr<ir::Computed> CloningMaps::MapComputed(
+    const std::shared_ptr<ir::Computed>& value) const {
+  auto it = values.find(value->number());
+  return (it != values.end()) ? std::static_pointer_cast<ir::Computed>(it->second) : value;
+}
+
+std::shared_ptr<ir::InheritedValue> CloningMaps::MapInheritedValue(
+    const ir::InheritedValue* inherited_value) const {
+  return std::make_shared<ir::InheritedValue>(MapValue(inherited_value->value()),
+                                              MapBlock(inherited_value->origin()));
+}
+
+std::vector<std::shared_ptr<ir::Value>> CloningMaps::MapValues(
+    const std::vector<std::shared_ptr<ir::Value>>& values_to_map) const {
+  std::vector<std::shared_ptr<ir::Value>> mapped_values;
+  mapped_values.reserve(values_to_map.size());
+  for (const std::shared_ptr<ir::Value>& value : values_to_map) {
+    mapped_values.push_back(MapValue(value));
+  }
+  return mapped_values;
+}
+
+ir::block_num_t CloningMaps::MapBlock(ir::block_num_t block) const {
+  auto it = blocks.find(block);
+  return (it != blocks.end()) ? it->second : block;
+}
+
+std::unique_ptr<ir::Instr> CloneInstr(const ir::Instr* instr, const CloningMaps& maps) {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov: {
+      auto mov_instr = static_cast<const ir::MovInstr*>(instr);
+      return std::make_unique<ir::MovInstr>(maps.MapComputed(mov_instr->result()),
+                                            maps.MapValue(mov_instr->origin()));
+    }
+    case ir::InstrKind::kPhi: {
+      auto phi_instr = static_cast<const ir::PhiInstr*>(instr);
+      std::vector<std::shared_ptr<ir::InheritedValue>> args;
+      args.reserve(phi_instr->args().size());
+      for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+        args.push_back(maps.MapInheritedValue(arg.get()));
+      }
+      return std::make_unique<ir::PhiInstr>(maps.MapComputed(phi_instr->result()), args);
+    }
+    case ir::InstrKind::kConversion: {
+      auto conversion = static_cast<const ir::Conversion*>(instr);
+      return std::make_unique<ir::Conversion>(maps.MapComputed(conversion->result()),
+                                              maps.MapValue(conversion->operand()));
+    }
+    case ir::InstrKind::kBoolNot: {
+      auto bool_not_instr = static_cast<const ir::BoolNotInstr*>(instr);
+      return std::make_unique<ir::BoolNotInstr>(maps.MapComputed(bool_not_instr->result()),
+                                                maps.MapValue(bool_not_instr->operand()));
+    }
+    case ir::InstrKind::kBoolBinary: {
+      auto bool_binary_instr = static_cast<const ir::BoolBinaryInstr*>(instr);
+      return std::make_unique<ir::BoolBinaryInstr>(
+          maps.MapComputed(bool_binary_instr->result()), bool_binary_instr->operation(),
+          maps.MapValue(bool_binary_instr->operand_a()),
+          maps.MapValue(bool_binary_instr->operand_b()));
+    }
+    case ir::InstrKind::kIntUnary: {
+      auto int_unary_instr = static_cast<const ir::IntUnaryInstr*>(instr);
+      return std::make_unique<ir::IntUnaryInstr>(maps.MapComputed(int_unary_instr->result()),
+                                                 int_unary_instr->operation(),
+                                                 maps.MapValue(int_unary_instr->operand()));
+    }
+    case ir::InstrKind::kIntCompare: {
+      auto int_compare_instr = static_cast<const ir::IntCompareInstr*>(instr);
+      return std::make_unique<ir::IntCompareInstr>(
+          maps.MapComputed(int_compare_instr->result()), int_compare_instr->operation(),
+          maps.MapValue(int_compare_instr->operand_a()),
+          maps.MapValue(int_compare_instr->operand_b()));
+    }
+    case ir::InstrKind::kIntBinary: {
+      auto int_binary_instr = static_cast<const ir::IntBinaryInstr*>(instr);
+      return std::make_unique<ir::IntBinaryInstr>(
+          maps.MapComputed(int_binary_instr->result()), int_binary_instr->operation(),
+          maps.MapValue(int_binary_instr->operand_a()),
+          maps.MapValue(int_binary_instr->operand_b()));
+    }
+    case ir::InstrKind::kIntShift: {
+      auto int_shift_instr = static_cast<const ir::IntShiftInstr*>(instr);
+      return std::make_unique<ir::IntShiftInstr>(
+          maps.MapComputed(int_shift_instr->result()), int_shift_instr->operation(),
+          maps.MapValue(int_shift_instr->shifted()), maps.MapValue(int_shift_instr->offset()));
+    }
+    case ir::InstrKind::kPointerOffset: {
+      auto pointer_offset_instr = static_cast<const ir::PointerOffsetInstr*>(instr);
+      return std::make_unique<ir::PointerOffsetInstr>(
+          maps.MapComputed(pointer_offset_instr->result()),
+          maps.MapComputed(pointer_offset_instr->pointer()),
+          maps.MapValue(pointer_offset_instr->offset()));
+    }
+    case ir::InstrKind::kNilTest: {
+      auto nil_test_instr = static_cast<const ir::NilTestInstr*>(instr);
+      return std::make_unique<ir::NilTestInstr>(maps.MapComputed(nil_test_instr->result()),
+                                                maps.MapValue(nil_test_instr->tested()));
+    }
+    case ir::InstrKind::kMalloc: {
+      auto malloc_instr = static_cast<const ir::MallocInstr*>(instr);
+      return std::make_unique<ir::MallocInstr>(maps.MapComputed(malloc_instr->result()),
+                                               maps.MapValue(malloc_instr->size()));
+    }
+    case ir::InstrKind::kStackAlloc: {
+      auto stack_alloc_instr = static_cast<const ir::StackAllocInstr*>(instr);
+      return std::make_unique<ir::StackAllocInstr>(maps.MapComputed(stack_alloc_instr->result()),
+                                                   maps.MapValue(stack_alloc_instr->size()));
+    }
+    case ir::InstrKind::kLoad: {
+      auto load_instr = static_cast<const ir::LoadInstr*>(instr);
+      return std::make_unique<ir::LoadInstr>(maps.MapComputed(load_instr->result()),
+                                             maps.MapValue(load_instr->address()));
+    }
+    case ir::InstrKind::kStore: {
+      auto store_instr = static_cast<const ir::StoreInstr*>(instr);
+      return std::make_unique<ir::StoreInstr>(maps.MapValue(store_instr->address()),
+                                              maps.MapValue(store_instr->value()));
+    }
+    case ir::InstrKind::kFree: {
+      auto free_instr = static_cast<const ir::FreeInstr*>(instr);
+      return std::make_unique<ir::FreeInstr>(maps.MapValue(free_instr->address()));
+    }
+    case ir::InstrKind::kJump: {
+      auto jump_instr = static_cast<const ir::JumpInstr*>(instr);
+      return std::make_unique<ir::JumpInstr>(maps.MapBlock(jump_instr->destination()));
+    }
+    case ir::InstrKind::kJumpCond: {
+      auto jump_cond_instr = static_cast<const ir::JumpCondInstr*>(instr);
+      return std::make_unique<ir::JumpCondInstr>(
+          maps.MapValue(jump_cond_instr->condition()),
+          maps.MapBlock(jump_cond_instr->destination_true()),
+          maps.MapBlock(jump_cond_instr->destination_false()));
+    }
+    case ir::InstrKind::kSyscall: {
+      auto syscall_instr = static_cast<const ir::SyscallInstr*>(instr);
+      return std::make_unique<ir::SyscallInstr>(maps.MapComputed(syscall_instr->result()),
+                                                maps.MapValue(syscall_instr->syscall_num()),
+                                                maps.MapValues(syscall_instr->args()));
+    }
+    case ir::InstrKind::kCall: {
+      auto call_instr = static_cast<const ir::CallInstr*>(instr);
+      std::vector<std::shared_ptr<ir::Computed>> results;
+      results.reserve(call_instr->results().size());
+      for (const std::shared_ptr<ir::Computed>& result : call_instr->results()) {
+        results.push_back(maps.MapComputed(result));
+      }
+      return std::make_unique<ir::CallInstr>(maps.MapValue(call_instr->func()), results,
+                                             maps.MapValues(call_instr->args()));
+    }
+    default:
+      fail("can not clone instr: " + instr->RefString());
+  }
+}
+
+}  // namespace ir_processors
@@ -0,0 +1,41 @@
+//
+//  instr_cloner.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/20/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_proc_instr_cloner_h
+#define ir_proc_instr_cloner_h
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_processors {
+
+// Maps values and blocks to their copies. Values and blocks without an entry map to themselves.
+struct CloningMaps {
+  std::unordered_map<ir::value_num_t, std::shared_ptr<ir::Value>> values;
+  std::unordered_map<ir::block_num_t, ir::block_num_t> blocks;
+
+  std::shared_ptr<ir::Value> MapValue(const std::shared_ptr<ir::Value>& value) const;
+  std::shared_ptr<ir::Computed> MapComputed(const std::shared_ptr<ir::Computed>& value) const;
+  std::shared_ptr<ir::InheritedValue> MapInheritedValue(
+      const ir::InheritedValue* inherited_value) const;
+  std::vector<std::shared_ptr<ir::Value>> MapValues(
+      const std::vector<std::shared_ptr<ir::Value>>& values_to_map) const;
+  ir::block_num_t MapBlock(ir::block_num_t block) const;
+};
+
+// Returns a copy of the instr with all defined values, used values and referenced blocks mapped.
+std::unique_ptr<ir::Instr> CloneInstr(const ir::Instr* instr, const CloningMaps& maps);
+
+}  // namespace ir_processors
+
+#endif /* ir_proc_instr_cloner_h */
@@ -0,0 +1,189 @@
+//
+//  value_replacer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/12/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "value_replacer.h"
+
+#include "src/ir/representation/block.h"
+
+namespace ir_processors {
+namespace {
+
+std::shared_ptr<ir::Value> Replace(std::shared_ptr<ir::Value> value,
+                                   const ValueReplacements& replacements) {
+  while (value->kind() == ir::Value::Kind::kComputed) {
+    auto it = replacements.find(static_cast<ir::Computed*>(value.get())->number());
+    if (it == replacements.end()) {
+      break;
+    }
+    value = it->second;
+  }
+  return value;
+}
+
+bool UsesReplacedValue(ir::Instr* instr, const ValueReplacements& replacements) {
+  for (const std::shared_ptr<ir::Value>& used_value : instr->UsedValues()) {
+    if (used_value->kind() == ir::Value::Kind::kComputed &&
+        replacements.contains(static_cast<ir::Computed*>(used_value.get())->number())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ReplaceValues(std::vector<std::shared_ptr<ir::Value>>& values,
+                   const ValueReplacements& replacements) {
+  for (std::shared_ptr<ir::Value>& value : values) {
+    value = Replace(value, replacements);
+  }
+}
+
+void ReplaceValuesInPhiInstr(ir::PhiInstr* phi_instr, const ValueReplacements& replacements) {
+  for (std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+    std::shared_ptr<ir::Value> value = Replace(arg->value(), replacements);
+    if (value != arg->value()) {
+      arg = std::make_shared<ir::InheritedValue>(value, arg->origin());
+    }
+  }
+}
+
+void ReplaceValuesInPointerOffsetInstr(ir::PointerOffsetInstr* pointer_offset_instr,
+                                       const ValueReplacements& replacements) {
+  std::shared_ptr<ir::Value> pointer = Replace(pointer_offset_instr->pointer(), replacements);
+  if (pointer->kind() == ir::Value::Kind::kComputed) {
+    pointer_offset_instr->set_pointer(std::static_pointer_cast<ir::Computed>(pointer));
+  }
+  pointer_offset_instr->set_offset(Replace(pointer_offset_instr->offset(), replacements));
+}
+
+}  // namespace
+
+void ReplaceValuesInInstr(ir::Instr* instr, const ValueReplacements& replacements) {
+  if (!UsesReplacedValue(instr, replacements)) {
+    return;
+  }
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov: {
+      auto mov_instr = static_cast<ir::MovInstr*>(instr);
+      mov_instr->set_origin(Replace(mov_instr->origin(), replacements));
+      return;
+    }
+    case ir::InstrKind::kPhi:
+      ReplaceValuesInPhiInstr(static_cast<ir::PhiInstr*>(instr), replacements);
+      return;
+    case ir::InstrKind::kConversion: {
+      auto conversion = static_cast<ir::Conversion*>(instr);
+      conversion->set_operand(Replace(conversion->operand(), replacements));
+      return;
+    }
+    case ir::InstrKind::kBoolNot: {
+      auto bool_not_instr = static_cast<ir::BoolNotInstr*>(instr);
+      bool_not_instr->set_operand(Replace(bool_not_instr->operand(), replacements));
+      return;
+    }
+    case ir::InstrKind::kBoolBinary: {
+      auto bool_binary_instr = static_cast<ir::BoolBinaryInstr*>(instr);
+      bool_binary_instr->set_operand_a(Replace(bool_binary_instr->operand_a(), replacements));
+      bool_binary_instr->set_operand_b(Replace(bool_binary_instr->operand_b(), replacements));
+      return;
+    }
+    case ir::InstrKind::kIntUnary: {
+      auto int_unary_instr = static_cast<ir::IntUnaryInstr*>(instr);
+      int_unary_instr->set_operand(Replace(int_unary_instr->operand(), replacements));
+      return;
+    }
+    case ir::InstrKind::kIntCompare: {
+      auto int_compare_instr = static_cast<ir::IntCompareInstr*>(instr);
+      int_compare_instr->set_operand_a(Replace(int_compare_instr->operand_a(), replacements));
+      int_compare_instr->set_operand_b(Replace(int_compare_instr->operand_b(), replacements));
+      return;
+    }
+    case ir::InstrKind::kIntBinary: {
+      auto int_binary_instr = static_cast<ir::IntBinaryInstr*>(instr);
+      int_binary_instr->set_operand_a(Replace(int_binary_instr->operand_a(), replacements));
+      int_binary_instr->set_operand_b(Replace(int_binary_instr->operand_b(), replacements));
+      return;
+    }
+    case ir::InstrKind::kIntShift: {
+      auto int_shift_instr = static_cast<ir::IntShiftInstr*>(instr);
+      int_shift_instr->set_shifted(Replace(int_shift_instr->shifted(), replacements));
+      int_shift_instr->set_offset(Replace(int_shift_instr->offset(), replacements));
+      return;
+    }
+    case ir::InstrKind::kPointerOffset:
+      ReplaceValuesInPointerOffsetInstr(static_cast<ir::PointerOffsetInstr*>(instr), replacements);
+      return;
+    case ir::InstrKind::kNilTest: {
+      auto nil_test_instr = static_cast<ir::NilTestInstr*>(instr);
+      nil_test_instr->set_tested(Replace(nil_test_instr->tested(), replacements));
+      return;
+    }
+    case ir::InstrKind::kMalloc: {
+      auto malloc_instr = static_cast<ir::MallocInstr*>(instr);
+      malloc_instr->set_size(Replace(malloc_instr->size(), replacements));
+      return;
+    }
+    case ir::InstrKind::kStackAlloc: {
+      auto stack_alloc_instr = static_cast<ir::StackAllocInstr*>(instr);
+      stack_alloc_instr->set_size(Replace(stack_alloc_instr->size(), replacements));
+      return;
+    }
+    case ir::InstrKind::kLoad: {
+      auto load_instr = static_cast<ir::LoadInstr*>(instr);
+      load_instr->set_address(Replace(load_instr->address(), replacements));
+      return;
+    }
+    case ir::InstrKind::kStore: {
+      auto store_instr = static_cast<ir::StoreInstr*>(instr);
+      store_instr->set_address(Replace(store_instr->address(), replacements));
+      store_instr->set_value(Replace(store_instr->value(), replacements));
+      return;
+    }
+    case ir::InstrKind::kFree: {
+      auto free_instr = static_cast<ir::FreeInstr*>(instr);
+      free_instr->set_address(Replace(free_instr->address(), replacements));
+      return;
+    }
+    case ir::InstrKind::kJumpCond: {
+      auto jump_cond_instr = static_cast<ir::JumpCondInstr*>(instr);
+      jump_cond_instr->set_condition(Replace(jump_cond_instr->condition(), replacements));
+      return;
+    }
+    case ir::InstrKind::kSyscall: {
+      auto syscall_instr = static_cast<ir::SyscallInstr*>(instr);
+      syscall_instr->set_syscall_num(Replace(syscall_instr->syscall_num(), replacements));
+      ReplaceValues(syscall_instr->args(), replacements);
+      return;
+    }
+    case ir::InstrKind::kCall: {
+      auto call_instr = static_cast<ir::CallInstr*>(instr);
+      call_instr->set_func(Replace(call_instr->func(), replacements));
+      ReplaceValues(call_instr->args(), replacements);
+      return;
+    }
+    case ir::InstrKind::kReturn:
+      ReplaceValues(static_cast<ir::ReturnInstr*>(instr)->args(), replacements);
+      return;
+    default:
+      instr->ReplaceUsedValues([&replacements](std::shared_ptr<ir::Value> value) {
+        return Replace(value, replacements);
+      });
+  }
+}
+
+void ReplaceValuesInFunc(ir::Func* func, const ValueReplacements& replacements) {
+  if (replacements.empty()) {
+    return;
+  }
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      ReplaceValuesInInstr(instr.get(), replacements);
+    }
+  }
+}
+
+}  // namespace ir_processors
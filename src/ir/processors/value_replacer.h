@@ -0,0 +1,34 @@
+//
+//  value_replacer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/12/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_proc_value_replacer_h
+#define ir_proc_value_replacer_h
+
+#include <memory>
+#include <unordered_map>
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/values.h"
+
+namespace ir_processors {
+
+// Maps the numbers of computed values to the values that should replace all their uses. Chains of
+// replacements get followed, i.e. the replacement of a replacement gets used.
+typedef std::unordered_map<ir::value_num_t, std::shared_ptr<ir::Value>> ValueReplacements;
+
+// Replaces all values used by the instr according to the given replacements. Uses that require a
+// computed value (the pointer of ir::PointerOffsetInstr) do not get replaced with constants. Instrs
+// outside the core IR get their values replaced through ir::Instr::ReplaceUsedValues.
+void ReplaceValuesInInstr(ir::Instr* instr, const ValueReplacements& replacements);
+void ReplaceValuesInFunc(ir::Func* func, const ValueReplacements& replacements);
+
+}  // namespace ir_processors
+
+#endif /* ir_proc_value_replacer_h */
@@ -8,7 +8,10 @@
 
 #include "func.h"
 
+#include <algorithm>
+#include <queue>
 #include <sstream>
+#include <utility>
 
 #include "src/common/logging/logging.h"
 
@@ -18,9 +21,10 @@ using ::common::logging::fail;
 using ::common::positions::pos_t;
 
 Block* Func::GetBlock(block_num_t bnum) const {
-  auto it = std::find_if(blocks_.begin(), blocks_.end(),
-                         [=](auto& block) { return block->number() == bnum; });
-  return (it != blocks_.end()) ? it->get() : nullptr;
+  if (bnum < 0 || bnum >= int64_t(blocks_by_num_.size())) {
+    return nullptr;
+  }
+  return blocks_by_num_.at(bnum);
 }
 
 Block* Func::AddBlock(block_num_t bnum) {
@@ -32,7 +36,15 @@ Block* Func::AddBlock(block_num_t bnum) {
     block_count_ = std::max(block_count_, bnum + 1);
   }
   auto& block = blocks_.emplace_back(new Block(bnum));
-  dominator_tree_ok_ = false;
+  blocks_by_num_.resize(block_count_, nullptr);
+  blocks_by_num_.at(bnum) = block.get();
+  if (dominator_tree_ok_) {
+    // The new block is unreachable and does not affect the dominator tree:
+    dominators_.resize(block_count_, kNoBlockNum);
+    dominees_.resize(block_count_);
+    dominator_tree_depths_.resize(block_count_, -1);
+    dominator_tree_nums_.resize(block_count_, -1);
+  }
   return block.get();
 }
 
@@ -50,8 +62,12 @@ void Func::RemoveBlock(block_num_t bnum) {
     Block* child = GetBlock(child_num);
     child->parents_.erase(bnum);
   }
+  if (dominator_tree_ok_ && IsReachable(bnum)) {
+    // Removing a reachable block can make other blocks unreachable:
+    dominator_tree_ok_ = false;
+  }
+  blocks_by_num_.at(bnum) = nullptr;
   blocks_.erase(it);
-  dominator_tree_ok_ = false;
 }
 
 void Func::AddControlFlow(block_num_t parent_num, block_num_t child_num) {
@@ -59,9 +75,13 @@ void Func::AddControlFlow(block_num_t parent_num, block_num_t child_num) {
   Block* child = GetBlock(child_num);
   if (parent == nullptr) fail("tried to add control flow to unknown block");
   if (child == nullptr) fail("tried to add control flow to unknown block");
-  parent->children_.insert(child_num);
+  if (!parent->children_.insert(child_num).second) {
+    return;
+  }
   child->parents_.insert(parent_num);
-  dominator_tree_ok_ = false;
+  if (dominator_tree_ok_) {
+    UpdateDominatorTreeForAddedControlFlow(parent_num, child_num);
+  }
 }
 
 void Func::RemoveControlFlow(block_num_t parent_num, block_num_t child_num) {
@@ -69,9 +89,13 @@ void Func::RemoveControlFlow(block_num_t parent_num, block_num_t child_num) {
   Block* child = GetBlock(child_num);
   if (parent == nullptr) fail("tried to remove control flow from nullptr block");
   if (child == nullptr) fail("tried to remove control flow from nullptr block");
-  parent->children_.erase(child_num);
+  if (parent->children_.erase(child_num) == 0) {
+    return;
+  }
   child->parents_.erase(parent_num);
-  dominator_tree_ok_ = false;
+  if (dominator_tree_ok_) {
+    UpdateDominatorTreeForRemovedControlFlow(parent_num, child_num);
+  }
 }
 
 block_num_t Func::DominatorOf(block_num_t dominee_num) const {
@@ -81,13 +105,27 @@ block_num_t Func::DominatorOf(block_num_t dominee_num) const {
   return dominators_.at(dominee_num);
 }
 
-std::unordered_set<block_num_t> Func::DomineesOf(block_num_t dominator_num) const {
+const std::vector<block_num_t>& Func::DomineesOf(block_num_t dominator_num) const {
   if (!dominator_tree_ok_) {
     UpdateDominatorTree();
   }
   return dominees_.at(dominator_num);
 }
 
+bool Func::Dominates(block_num_t dominator_num, block_num_t dominee_num) const {
+  if (!dominator_tree_ok_) {
+    UpdateDominatorTree();
+  }
+  if (!IsReachable(dominator_num) || !IsReachable(dominee_num)) {
+    return false;
+  }
+  int64_t dominator_depth = dominator_tree_depths_.at(dominator_num);
+  while (dominator_tree_depths_.at(dominee_num) > dominator_depth) {
+    dominee_num = dominators_.at(dominee_num);
+  }
+  return dominee_num == dominator_num;
+}
+
 std::vector<block_num_t> Func::GetBlocksInDominanceOrder() const {
   if (!dominator_tree_ok_) {
     UpdateDominatorTree();
@@ -97,9 +135,10 @@ std::vector<block_num_t> Func::GetBlocksInDominanceOrder() const {
   ordered_blocks.push_back(entry_block_num_);
   for (std::size_t i = 0; i < ordered_blocks.size(); i++) {
     block_num_t current = ordered_blocks.at(i);
-    for (block_num_t dominee : dominees_.at(current)) {
-      ordered_blocks.push_back(dominee);
-    }
+    const std::vector<block_num_t>& dominees = dominees_.at(current);
+    // Visit siblings by block number to be independent of the order of dominator tree updates:
+    ordered_blocks.insert(ordered_blocks.end(), dominees.begin(), dominees.end());
+    std::sort(ordered_blocks.end() - dominees.size(), ordered_blocks.end());
   }
   return ordered_blocks;
 }
@@ -169,147 +208,243 @@ bool Func::operator==(const Func& that) const {
     const Type* result_b = that.result_types().at(i);
     if (!IsEqual(result_a, result_b)) return false;
   }
-  for (std::size_t i = 0; i < blocks().size(); i++) {
-    const Block* block_a = blocks().at(i).get();
-    const Block* block_b = that.blocks().at(i).get();
-    if (!IsEqual(block_a, block_b)) return false;
+  for (const std::unique_ptr<Block>& block_a : blocks()) {
+    const Block* block_b = that.GetBlock(block_a->number());
+    if (!IsEqual(block_a.get(), block_b)) return false;
   }
   return true;
 }
 
-Func::DomTreeContext::DomTreeContext(int64_t block_count) {
-  tree_order_ = std::vector<block_num_t>();
-  tree_order_.reserve(block_count);
-  tree_parent_ = std::vector<block_num_t>(block_count, -1);
-  sdom_ = std::vector<tree_num_t>(block_count, -1);
-  idom_ = std::vector<block_num_t>(block_count, -1);
-  bucket_ =
-      std::vector<std::unordered_set<block_num_t>>(block_count, std::unordered_set<block_num_t>());
-  ancestor_ = std::vector<block_num_t>(block_count, -1);
-  label_ = std::vector<block_num_t>(block_count, -1);
-}
-
 void Func::UpdateDominatorTree() const {
   if (dominator_tree_ok_) return;
   if (entry_block_num_ == kNoBlockNum) {
     fail("can not determine dominator tree without entry block");
   }
 
-  DomTreeContext ctx(block_count_);
-  FindDFSTree(ctx);
-  FindImplicitIDoms(ctx);
-  FindExplicitIDoms(ctx);
+  dominators_.assign(block_count_, kNoBlockNum);
+  dominees_.assign(block_count_, std::vector<block_num_t>{});
+  dominator_tree_depths_.assign(block_count_, -1);
+  dominator_tree_nums_.assign(block_count_, -1);
+  dominator_tree_depths_.at(entry_block_num_) = 0;
 
-  dominators_.clear();
-  dominees_.clear();
-  dominators_.reserve(blocks_.size());
-  dominees_.reserve(blocks_.size());
-  for (auto& block : blocks_) {
-    dominators_.insert({block->number(), kNoBlockNum});
-    dominees_.insert({block->number(), std::unordered_set<block_num_t>{}});
+  UpdateDominatorSubtree(entry_block_num_, /*restrict_to_current_subtree=*/false);
+
+  dominator_tree_ok_ = true;
+}
+
+// Recomputes the immediate dominators of all blocks reachable from the given root with the
+// Semi-NCA algorithm. If restrict_to_current_subtree is set, only blocks currently dominated by the
+// root get visited. The root keeps its own dominator and depth.
+void Func::UpdateDominatorSubtree(block_num_t root_num, bool restrict_to_current_subtree) const {
+  DomTreeContext ctx;
+  FindDFSTree(ctx, root_num, restrict_to_current_subtree);
+  FindIDoms(ctx);
+
+  for (block_num_t bnum : ctx.tree_order_) {
+    dominees_.at(bnum).clear();
+    dominator_tree_nums_.at(bnum) = -1;
   }
-  for (size_t i = 1; i < ctx.tree_order_.size(); i++) {
+  for (tree_num_t i = 1; i < tree_num_t(ctx.tree_order_.size()); i++) {
     block_num_t dominee_num = ctx.tree_order_.at(i);
-    block_num_t dominator_num = ctx.idom_.at(dominee_num);
+    block_num_t dominator_num = ctx.tree_order_.at(ctx.idom_.at(i));
 
-    dominators_.insert_or_assign(dominee_num, dominator_num);
-    dominees_.at(dominator_num).insert(dominee_num);
+    dominators_.at(dominee_num) = dominator_num;
+    dominees_.at(dominator_num).push_back(dominee_num);
+    // Dominators precede their dominees in the DFS tree order:
+    dominator_tree_depths_.at(dominee_num) = dominator_tree_depths_.at(dominator_num) + 1;
   }
-
-  dominator_tree_ok_ = true;
 }
 
-void Func::FindDFSTree(DomTreeContext& ctx) const {
-  std::vector<block_num_t> stack;
-  std::unordered_set<block_num_t> seen;
-
-  stack.push_back(entry_block_num_);
-  seen.insert(entry_block_num_);
+void Func::FindDFSTree(DomTreeContext& ctx, block_num_t root_num,
+                       bool restrict_to_current_subtree) const {
+  int64_t root_depth = dominator_tree_depths_.at(root_num);
+  std::vector<std::pair<block_num_t, tree_num_t>> stack;  // block_num_t, parent tree_num_t
+  stack.push_back({root_num, -1});
 
   while (!stack.empty()) {
-    int64_t v = stack.back();
+    auto [v, parent] = stack.back();
     stack.pop_back();
+    if (dominator_tree_nums_.at(v) != -1) continue;
 
+    tree_num_t n = ctx.tree_order_.size();
+    dominator_tree_nums_.at(v) = n;
     ctx.tree_order_.push_back(v);
-    ctx.sdom_[v] = ctx.tree_order_.size() - 1;
-    ctx.label_[v] = v;
-
-    Block* block = GetBlock(v);
-
-    for (block_num_t w : block->children_) {
-      if (seen.count(w) > 0) continue;
+    ctx.tree_parent_.push_back(parent);
+    ctx.ancestor_.push_back(parent);
+    ctx.label_.push_back(n);
+    ctx.sdom_.push_back(n);
 
-      stack.push_back(w);
-      seen.insert(w);
+    for (block_num_t w : GetBlock(v)->children_) {
+      if (dominator_tree_nums_.at(w) != -1) continue;
+      if (restrict_to_current_subtree && dominator_tree_depths_.at(w) <= root_depth) continue;
 
-      ctx.tree_parent_[w] = v;
+      stack.push_back({w, n});
     }
   }
 }
 
-void Func::Compress(DomTreeContext& ctx, block_num_t v) const {
-  if (ctx.ancestor_.at(ctx.ancestor_.at(v)) == -1) {
-    return;
+// Returns the vertex with the minimal semi-dominator on the path from v to the root of its tree in
+// the forest of linked vertices (all vertices with a tree number of at least last_linked).
+tree_num_t Func::Eval(DomTreeContext& ctx, tree_num_t v, tree_num_t last_linked) const {
+  if (ctx.ancestor_.at(v) < last_linked) {
+    return ctx.label_.at(v);
   }
 
-  Compress(ctx, ctx.ancestor_[v]);
+  std::vector<tree_num_t>& stack = ctx.eval_stack_;
+  do {
+    stack.push_back(v);
+    v = ctx.ancestor_.at(v);
+  } while (ctx.ancestor_.at(v) >= last_linked);
+
+  // Path compression:
+  tree_num_t p = v;
+  tree_num_t p_label = ctx.label_.at(p);
+  do {
+    v = stack.back();
+    stack.pop_back();
 
-  if (ctx.sdom_.at(ctx.label_.at(ctx.ancestor_.at(v))) < ctx.sdom_.at(ctx.label_.at(v))) {
-    ctx.label_[v] = ctx.label_.at(ctx.ancestor_.at(v));
-  }
+    ctx.ancestor_.at(v) = ctx.ancestor_.at(p);
+    if (ctx.sdom_.at(p_label) < ctx.sdom_.at(ctx.label_.at(v))) {
+      ctx.label_.at(v) = p_label;
+    } else {
+      p_label = ctx.label_.at(v);
+    }
+    p = v;
+  } while (!stack.empty());
 
-  ctx.ancestor_[v] = ctx.ancestor_.at(ctx.ancestor_.at(v));
+  return ctx.label_.at(v);
 }
 
-block_num_t Func::Eval(DomTreeContext& ctx, block_num_t v) const {
-  if (ctx.ancestor_.at(v) == -1) {
-    return v;
-  }
+void Func::FindIDoms(DomTreeContext& ctx) const {
+  tree_num_t n = ctx.tree_order_.size();
+  ctx.idom_ = ctx.tree_parent_;
 
-  Compress(ctx, v);
+  // Semi-dominators:
+  for (tree_num_t w = n - 1; w > 0; w--) {
+    ctx.sdom_.at(w) = ctx.tree_parent_.at(w);
+    for (block_num_t v_num : GetBlock(ctx.tree_order_.at(w))->parents_) {
+      tree_num_t v = dominator_tree_nums_.at(v_num);
+      if (v == -1) continue;  // unreachable or outside of the recomputed subtree
 
-  return ctx.label_.at(v);
-}
+      tree_num_t u = Eval(ctx, v, w + 1);
+      ctx.sdom_.at(w) = std::min(ctx.sdom_.at(w), ctx.sdom_.at(u));
+    }
+  }
 
-void Func::FindImplicitIDoms(DomTreeContext& ctx) const {
-  for (tree_num_t i = (tree_num_t)ctx.tree_order_.size() - 1; i > 0; i--) {
-    block_num_t w = ctx.tree_order_.at(i);
-    Block* block = GetBlock(w);
+  // Immediate dominators are the nearest common ancestors of semi-dominators and tree parents:
+  for (tree_num_t w = 1; w < n; w++) {
+    tree_num_t idom = ctx.idom_.at(w);
+    while (idom > ctx.sdom_.at(w)) {
+      idom = ctx.idom_.at(idom);
+    }
+    ctx.idom_.at(w) = idom;
+  }
+}
 
-    // Step 2:
-    for (block_num_t v : block->parents_) {
-      int64_t u = Eval(ctx, v);
+// Incremental insertion as described by Georgiadis et al. in "An Experimental Study of Dynamic
+// Dominators": after adding the edge (x, y), exactly the blocks w that are reachable from y via
+// blocks at least as deep as w, and deeper than nca(x, y) + 1, get nca(x, y) as new dominator.
+void Func::UpdateDominatorTreeForAddedControlFlow(block_num_t parent_num, block_num_t child_num) {
+  if (!IsReachable(parent_num)) {
+    return;
+  } else if (!IsReachable(child_num)) {
+    dominator_tree_ok_ = false;
+    return;
+  }
+  block_num_t nca_num = NearestCommonDominator(parent_num, child_num);
+  int64_t nca_depth = dominator_tree_depths_.at(nca_num);
+  if (dominator_tree_depths_.at(child_num) <= nca_depth + 1) {
+    return;
+  }
 
-      if (ctx.sdom_.at(w) > ctx.sdom_.at(u)) {
-        ctx.sdom_[w] = ctx.sdom_.at(u);
+  std::priority_queue<std::pair<int64_t, block_num_t>> candidates;
+  std::unordered_set<block_num_t> visited{child_num};
+  std::vector<block_num_t> affected;
+  candidates.push({dominator_tree_depths_.at(child_num), child_num});
+  while (!candidates.empty()) {
+    auto [depth, affected_num] = candidates.top();
+    candidates.pop();
+    affected.push_back(affected_num);
+
+    std::vector<block_num_t> stack{affected_num};
+    while (!stack.empty()) {
+      block_num_t v = stack.back();
+      stack.pop_back();
+      for (block_num_t w : GetBlock(v)->children_) {
+        int64_t w_depth = dominator_tree_depths_.at(w);
+        if (w_depth <= nca_depth + 1 || !visited.insert(w).second) continue;
+        if (w_depth > depth) {
+          stack.push_back(w);
+        } else {
+          candidates.push({w_depth, w});
+        }
       }
     }
+  }
 
-    ctx.bucket_.at(ctx.tree_order_.at(ctx.sdom_.at(w))).insert(w);
-
-    Link(ctx, ctx.tree_parent_.at(w), w);
+  for (block_num_t affected_num : affected) {
+    SetDominator(affected_num, nca_num);
+  }
+  for (block_num_t affected_num : affected) {
+    UpdateDominatorTreeDepths(affected_num);
+  }
+}
 
-    // Step 3:
-    for (block_num_t v : ctx.bucket_.at(ctx.tree_parent_.at(w))) {
-      block_num_t u = Eval(ctx, v);
+// Deleting the edge (x, y) only affects blocks dominated by nca(x, y) if y remains reachable
+// (Lemma 2.6 in "An Experimental Study of Dynamic Dominators"). That subtree gets recomputed.
+void Func::UpdateDominatorTreeForRemovedControlFlow(block_num_t parent_num,
+                                                    block_num_t child_num) {
+  if (!IsReachable(parent_num)) {
+    return;
+  }
+  block_num_t nca_num = NearestCommonDominator(parent_num, child_num);
+  if (nca_num == child_num) {
+    return;
+  } else if (dominators_.at(child_num) == parent_num && !HasParentNotDominatedBy(child_num)) {
+    // The child block and all blocks it dominates became unreachable:
+    dominator_tree_ok_ = false;
+    return;
+  }
+  UpdateDominatorSubtree(nca_num, /*restrict_to_current_subtree=*/true);
+}
 
-      if (ctx.sdom_.at(u) < ctx.sdom_.at(v)) {
-        ctx.idom_[v] = u;
-      } else {
-        ctx.idom_[v] = ctx.tree_parent_.at(w);
-      }
+block_num_t Func::NearestCommonDominator(block_num_t bnum_a, block_num_t bnum_b) const {
+  while (bnum_a != bnum_b) {
+    if (dominator_tree_depths_.at(bnum_a) < dominator_tree_depths_.at(bnum_b)) {
+      bnum_b = dominators_.at(bnum_b);
+    } else {
+      bnum_a = dominators_.at(bnum_a);
     }
+  }
+  return bnum_a;
+}
 
-    ctx.bucket_.at(ctx.tree_parent_.at(w)).clear();
+bool Func::HasParentNotDominatedBy(block_num_t bnum) const {
+  for (block_num_t parent_num : GetBlock(bnum)->parents_) {
+    if (IsReachable(parent_num) && NearestCommonDominator(parent_num, bnum) != bnum) {
+      return true;
+    }
   }
+  return false;
 }
 
-void Func::FindExplicitIDoms(DomTreeContext& ctx) const {
-  for (tree_num_t i = 1; i < (tree_num_t)ctx.tree_order_.size(); i++) {
-    block_num_t w = ctx.tree_order_.at(i);
+void Func::SetDominator(block_num_t dominee_num, block_num_t dominator_num) {
+  std::vector<block_num_t>& old_siblings = dominees_.at(dominators_.at(dominee_num));
+  old_siblings.erase(std::find(old_siblings.begin(), old_siblings.end(), dominee_num));
+  dominees_.at(dominator_num).push_back(dominee_num);
+  dominators_.at(dominee_num) = dominator_num;
+}
 
-    if (ctx.idom_.at(w) != ctx.tree_order_.at(ctx.sdom_.at(w))) {
-      ctx.idom_[w] = ctx.idom_.at(ctx.idom_.at(w));
+void Func::UpdateDominatorTreeDepths(block_num_t root_num) const {
+  std::vector<block_num_t> stack{root_num};
+  dominator_tree_depths_.at(root_num) =
+      dominator_tree_depths_.at(dominators_.at(root_num)) + 1;
+  while (!stack.empty()) {
+    block_num_t v = stack.back();
+    stack.pop_back();
+    for (block_num_t w : dominees_.at(v)) {
+      dominator_tree_depths_.at(w) = dominator_tree_depths_.at(v) + 1;
+      stack.push_back(w);
     }
   }
 }
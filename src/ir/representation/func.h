@@ -43,7 +43,10 @@ class Func : public Object {
 
   Block* entry_block() const { return GetBlock(entry_block_num_); }
   block_num_t entry_block_num() const { return entry_block_num_; }
-  void set_entry_block_num(block_num_t entry_block_num) { entry_block_num_ = entry_block_num; }
+  void set_entry_block_num(block_num_t entry_block_num) {
+    entry_block_num_ = entry_block_num;
+    dominator_tree_ok_ = false;
+  }
 
   bool HasBlock(block_num_t bnum) const { return GetBlock(bnum) != nullptr; }
   Block* GetBlock(block_num_t bnum) const;
@@ -53,8 +56,12 @@ class Func : public Object {
   void AddControlFlow(block_num_t parent, block_num_t child);
   void RemoveControlFlow(block_num_t parent, block_num_t child);
 
+  // The dominator tree gets computed lazily on the first query. Afterwards, it gets updated
+  // incrementally when control flow gets added or removed. Changes that alter which blocks are
+  // reachable from the entry block cause a full recomputation on the next query.
   block_num_t DominatorOf(block_num_t dominee_num) const;
-  std::unordered_set<block_num_t> DomineesOf(block_num_t dominator_num) const;
+  const std::vector<block_num_t>& DomineesOf(block_num_t dominator_num) const;
+  bool Dominates(block_num_t dominator_num, block_num_t dominee_num) const;
   std::vector<block_num_t> GetBlocksInDominanceOrder() const;
   void ForBlocksInDominanceOrder(std::function<void(Block*)> f) const;
 
@@ -78,25 +85,29 @@ class Func : public Object {
 
  private:
   struct DomTreeContext {
-    DomTreeContext(int64_t block_count);
-
-    std::vector<block_num_t> tree_order_;   // tree_num_t -> block_num_t
-    std::vector<block_num_t> tree_parent_;  // block_num_t -> block_num_t
-    std::vector<tree_num_t> sdom_;          // block_num_t -> tree_num_t
-    std::vector<block_num_t> idom_;         // block_num_t -> block_num_t
-    std::vector<std::unordered_set<block_num_t>>
-        bucket_;                         // block_num_t -> std::unordered_set<block_num_t>
-    std::vector<block_num_t> ancestor_;  // block_num_t -> block_num_t
-    std::vector<block_num_t> label_;     // block_num_t -> block_num_t
+    std::vector<block_num_t> tree_order_;  // tree_num_t -> block_num_t
+    std::vector<tree_num_t> tree_parent_;  // tree_num_t -> tree_num_t
+    std::vector<tree_num_t> ancestor_;     // tree_num_t -> tree_num_t
+    std::vector<tree_num_t> label_;        // tree_num_t -> tree_num_t
+    std::vector<tree_num_t> sdom_;         // tree_num_t -> tree_num_t
+    std::vector<tree_num_t> idom_;         // tree_num_t -> tree_num_t
+    std::vector<tree_num_t> eval_stack_;
   };
 
   void UpdateDominatorTree() const;
-  void FindDFSTree(DomTreeContext& ctx) const;
-  void Link(DomTreeContext& ctx, block_num_t v, block_num_t w) const { ctx.ancestor_[w] = v; }
-  void Compress(DomTreeContext& ctx, block_num_t v) const;
-  block_num_t Eval(DomTreeContext& ctx, block_num_t v) const;
-  void FindImplicitIDoms(DomTreeContext& ctx) const;
-  void FindExplicitIDoms(DomTreeContext& ctx) const;
+  void UpdateDominatorSubtree(block_num_t root_num, bool restrict_to_current_subtree) const;
+  void FindDFSTree(DomTreeContext& ctx, block_num_t root_num,
+                   bool restrict_to_current_subtree) const;
+  tree_num_t Eval(DomTreeContext& ctx, tree_num_t v, tree_num_t last_linked) const;
+  void FindIDoms(DomTreeContext& ctx) const;
+
+  void UpdateDominatorTreeForAddedControlFlow(block_num_t parent_num, block_num_t child_num);
+  void UpdateDominatorTreeForRemovedControlFlow(block_num_t parent_num, block_num_t child_num);
+  bool IsReachable(block_num_t bnum) const { return dominator_tree_depths_.at(bnum) != -1; }
+  block_num_t NearestCommonDominator(block_num_t bnum_a, block_num_t bnum_b) const;
+  bool HasParentNotDominatedBy(block_num_t bnum) const;
+  void SetDominator(block_num_t dominee_num, block_num_t dominator_num);
+  void UpdateDominatorTreeDepths(block_num_t root_num) const;
 
   func_num_t number_;
   std::string name_;
@@ -106,12 +117,15 @@ class Func : public Object {
 
   int64_t block_count_ = 0;
   std::vector<std::unique_ptr<Block>> blocks_;
+  std::vector<Block*> blocks_by_num_;  // block_num_t -> Block*
 
   block_num_t entry_block_num_ = kNoBlockNum;
 
   mutable bool dominator_tree_ok_ = false;
-  mutable std::unordered_map<block_num_t, block_num_t> dominators_;
-  mutable std::unordered_map<block_num_t, std::unordered_set<block_num_t>> dominees_;
+  mutable std::vector<block_num_t> dominators_;             // block_num_t -> block_num_t
+  mutable std::vector<std::vector<block_num_t>> dominees_;  // block_num_t -> block_num_ts
+  mutable std::vector<int64_t> dominator_tree_depths_;      // block_num_t -> depth or -1
+  mutable std::vector<tree_num_t> dominator_tree_nums_;     // block_num_t -> tree_num_t or -1
 
   int64_t computed_count_ = 0;
 
@@ -8,6 +8,10 @@
 
 #include "src/ir/representation/func.h"
 
+#include <random>
+#include <utility>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "src/ir/representation/block.h"
@@ -20,6 +24,7 @@ using ::testing::ElementsAre;
 using ::testing::IsEmpty;
 using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
+using ::testing::UnorderedElementsAreArray;
 
 TEST(FuncTest, CreatesDominatorTreeForSingleBlock) {
   ir::Func func(/*fnum=*/0);
@@ -187,4 +192,134 @@ TEST(FuncTest, CreatesDominatorTreeForLoopWithForkContinueAndBreak) {
   EXPECT_THAT(dom_order.at(2), AnyOf(block_c->number(), block_i->number()));
 }
 
+TEST(FuncTest, UpdatesDominatorTreeForAddedControlFlow) {
+  ir::Func func(/*fnum=*/0);
+  ir::Block* block_a = func.AddBlock();
+  ir::Block* block_b = func.AddBlock();
+  ir::Block* block_c = func.AddBlock();
+  ir::Block* block_d = func.AddBlock();
+  func.set_entry_block_num(block_a->number());
+  func.AddControlFlow(block_a->number(), block_b->number());
+  func.AddControlFlow(block_b->number(), block_c->number());
+  func.AddControlFlow(block_c->number(), block_d->number());
+
+  EXPECT_EQ(func.DominatorOf(block_d->number()), block_c->number());
+  EXPECT_TRUE(func.Dominates(block_b->number(), block_d->number()));
+
+  func.AddControlFlow(block_a->number(), block_c->number());
+
+  EXPECT_EQ(func.DominatorOf(block_b->number()), block_a->number());
+  EXPECT_EQ(func.DominatorOf(block_c->number()), block_a->number());
+  EXPECT_EQ(func.DominatorOf(block_d->number()), block_c->number());
+  EXPECT_THAT(func.DomineesOf(block_a->number()),
+              UnorderedElementsAre(block_b->number(), block_c->number()));
+  EXPECT_THAT(func.DomineesOf(block_b->number()), IsEmpty());
+  EXPECT_FALSE(func.Dominates(block_b->number(), block_d->number()));
+  EXPECT_TRUE(func.Dominates(block_a->number(), block_d->number()));
+}
+
+TEST(FuncTest, UpdatesDominatorTreeForRemovedControlFlow) {
+  ir::Func func(/*fnum=*/0);
+  ir::Block* block_a = func.AddBlock();
+  ir::Block* block_b = func.AddBlock();
+  ir::Block* block_c = func.AddBlock();
+  ir::Block* block_d = func.AddBlock();
+  func.set_entry_block_num(block_a->number());
+  func.AddControlFlow(block_a->number(), block_b->number());
+  func.AddControlFlow(block_a->number(), block_c->number());
+  func.AddControlFlow(block_b->number(), block_c->number());
+  func.AddControlFlow(block_c->number(), block_d->number());
+
+  EXPECT_EQ(func.DominatorOf(block_c->number()), block_a->number());
+
+  func.RemoveControlFlow(block_a->number(), block_c->number());
+
+  EXPECT_EQ(func.DominatorOf(block_b->number()), block_a->number());
+  EXPECT_EQ(func.DominatorOf(block_c->number()), block_b->number());
+  EXPECT_EQ(func.DominatorOf(block_d->number()), block_c->number());
+  EXPECT_THAT(func.DomineesOf(block_a->number()), ElementsAre(block_b->number()));
+  EXPECT_THAT(func.DomineesOf(block_b->number()), ElementsAre(block_c->number()));
+  EXPECT_TRUE(func.Dominates(block_b->number(), block_d->number()));
+}
+
+TEST(FuncTest, UpdatesDominatorTreeForUnreachableBlocks) {
+  ir::Func func(/*fnum=*/0);
+  ir::Block* block_a = func.AddBlock();
+  ir::Block* block_b = func.AddBlock();
+  ir::Block* block_c = func.AddBlock();
+  func.set_entry_block_num(block_a->number());
+  func.AddControlFlow(block_a->number(), block_b->number());
+  func.AddControlFlow(block_b->number(), block_c->number());
+
+  EXPECT_EQ(func.DominatorOf(block_c->number()), block_b->number());
+
+  func.RemoveControlFlow(block_a->number(), block_b->number());
+
+  EXPECT_EQ(func.DominatorOf(block_b->number()), ir::kNoBlockNum);
+  EXPECT_EQ(func.DominatorOf(block_c->number()), ir::kNoBlockNum);
+  EXPECT_THAT(func.DomineesOf(block_a->number()), IsEmpty());
+  EXPECT_THAT(func.GetBlocksInDominanceOrder(), ElementsAre(block_a->number()));
+
+  ir::Block* block_d = func.AddBlock();
+  func.AddControlFlow(block_a->number(), block_d->number());
+  func.AddControlFlow(block_d->number(), block_c->number());
+
+  EXPECT_EQ(func.DominatorOf(block_b->number()), ir::kNoBlockNum);
+  EXPECT_EQ(func.DominatorOf(block_c->number()), block_d->number());
+  EXPECT_EQ(func.DominatorOf(block_d->number()), block_a->number());
+  EXPECT_FALSE(func.Dominates(block_a->number(), block_b->number()));
+}
+
+TEST(FuncTest, IncrementalDominatorTreeMatchesRecomputedDominatorTree) {
+  constexpr int64_t kBlockCount = 24;
+  std::mt19937 rng(/*seed=*/42);
+  std::uniform_int_distribution<ir::block_num_t> block_dist(0, kBlockCount - 1);
+
+  ir::Func func(/*fnum=*/0);
+  for (int64_t i = 0; i < kBlockCount; i++) {
+    func.AddBlock();
+  }
+  func.set_entry_block_num(0);
+  for (ir::block_num_t bnum = 1; bnum < kBlockCount; bnum++) {
+    func.AddControlFlow(bnum - 1, bnum);
+  }
+  std::vector<std::pair<ir::block_num_t, ir::block_num_t>> edges;
+  for (ir::block_num_t bnum = 1; bnum < kBlockCount; bnum++) {
+    edges.push_back({bnum - 1, bnum});
+  }
+  func.GetBlocksInDominanceOrder();
+
+  for (int64_t step = 0; step < 2000; step++) {
+    if (edges.empty() || rng() % 2 == 0) {
+      ir::block_num_t parent = block_dist(rng);
+      ir::block_num_t child = block_dist(rng);
+      if (child == func.entry_block_num() || func.GetBlock(parent)->children().contains(child)) {
+        continue;
+      }
+      func.AddControlFlow(parent, child);
+      edges.push_back({parent, child});
+    } else {
+      std::size_t index = rng() % edges.size();
+      auto [parent, child] = edges.at(index);
+      edges.erase(edges.begin() + index);
+      func.RemoveControlFlow(parent, child);
+    }
+
+    ir::Func expected_func(/*fnum=*/0);
+    for (int64_t i = 0; i < kBlockCount; i++) {
+      expected_func.AddBlock();
+    }
+    expected_func.set_entry_block_num(0);
+    for (auto [parent, child] : edges) {
+      expected_func.AddControlFlow(parent, child);
+    }
+    for (ir::block_num_t bnum = 0; bnum < kBlockCount; bnum++) {
+      ASSERT_EQ(func.DominatorOf(bnum), expected_func.DominatorOf(bnum))
+          << "block " << bnum << " in step " << step;
+      EXPECT_THAT(func.DomineesOf(bnum),
+                  UnorderedElementsAreArray(expected_func.DomineesOf(bnum)));
+    }
+  }
+}
+
 }  // namespace
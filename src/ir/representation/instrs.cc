@@ -35,6 +35,10 @@ void Instr::SetPositions(pos_t start, pos_t end) {
   end_ = end;
 }
 
+void Instr::ReplaceUsedValues(const UsedValueReplacer&) {
+  fail("can not replace values used by instr: " + RefString());
+}
+
 void Instr::WriteRefString(std::ostream& os) const {
   bool wrote_first_defined_value = false;
   for (std::shared_ptr<Computed>& defined_value : DefinedValues()) {
@@ -202,6 +206,14 @@ bool MallocInstr::operator==(const Instr& that_instr) const {
   return true;
 }
 
+bool StackAllocInstr::operator==(const Instr& that_instr) const {
+  if (that_instr.instr_kind() != InstrKind::kStackAlloc) return false;
+  auto that = static_cast<const StackAllocInstr&>(that_instr);
+  if (!IsEqual(result().get(), that.result().get())) return false;
+  if (!IsEqual(size().get(), that.size().get())) return false;
+  return true;
+}
+
 bool LoadInstr::operator==(const Instr& that_instr) const {
   if (that_instr.instr_kind() != InstrKind::kLoad) return false;
   auto that = static_cast<const LoadInstr&>(that_instr);
@@ -9,6 +9,7 @@
 #ifndef ir_instrs_h
 #define ir_instrs_h
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -35,6 +36,7 @@ enum class InstrKind {
   kNilTest,
 
   kMalloc,
+  kStackAlloc,
   kLoad,
   kStore,
   kFree,
@@ -62,6 +64,13 @@ class Instr : public Object {
   virtual std::vector<std::shared_ptr<Computed>> DefinedValues() const = 0;
   virtual std::vector<std::shared_ptr<Value>> UsedValues() const = 0;
 
+  // Replaces the used values of instrs defined outside the core IR (e.g. by language extensions)
+  // with the values returned by the given function. Uses that require a computed value keep their
+  // value if the replacement is not computed. Values used by core IR instrs get replaced by
+  // ir_processors::ReplaceValuesInInstr instead.
+  typedef std::function<std::shared_ptr<Value>(std::shared_ptr<Value>)> UsedValueReplacer;
+  virtual void ReplaceUsedValues(const UsedValueReplacer& replacer);
+
   constexpr Object::Kind object_kind() const final { return Object::Kind::kInstr; }
   constexpr virtual InstrKind instr_kind() const = 0;
   bool IsControlFlowInstr() const;
@@ -388,6 +397,29 @@ class MallocInstr : public Computation {
   std::shared_ptr<Value> size_;
 };
 
+// StackAllocInstr allocates memory in the stack frame of the func. The memory must not get freed
+// and remains valid until the func returns. Repeated executions of the instr during the same func
+// call may yield the same address, therefore the allocated memory must not be used beyond the next
+// execution of the instr.
+class StackAllocInstr : public Computation {
+ public:
+  StackAllocInstr(std::shared_ptr<Computed> result, std::shared_ptr<Value> size)
+      : Computation(result), size_(size) {}
+
+  std::shared_ptr<Value> size() const { return size_; }
+  void set_size(std::shared_ptr<Value> size) { size_ = size; }
+
+  std::vector<std::shared_ptr<Value>> UsedValues() const override { return {size_}; }
+
+  InstrKind instr_kind() const override { return InstrKind::kStackAlloc; }
+  std::string OperationString() const override { return "salloc"; }
+
+  bool operator==(const Instr& that) const override;
+
+ private:
+  std::shared_ptr<Value> size_;
+};
+
 class LoadInstr : public Computation {
  public:
   LoadInstr(std::shared_ptr<Computed> result, std::shared_ptr<Value> address)
@@ -17,14 +17,15 @@ namespace ir {
 using ::common::logging::fail;
 
 Func* Program::GetFunc(func_num_t fnum) const {
-  auto it = std::find_if(funcs_.begin(), funcs_.end(),
-                         [=](auto& func) { return func->number() == fnum; });
-  return (it != funcs_.end()) ? it->get() : nullptr;
+  auto it = funcs_by_num_.find(fnum);
+  return (it != funcs_by_num_.end()) ? it->second : nullptr;
 }
 
 Func* Program::AddFunc(func_num_t fnum) {
   if (fnum == kNoFuncNum) {
     fnum = func_count_++;
+  } else if (fnum < 0) {
+    fail("tried to add function with negative function number");
   } else if (fnum < func_count_ && HasFunc(fnum)) {
     fail("tried to add function with used function number");
   } else {
@@ -33,6 +34,7 @@ Func* Program::AddFunc(func_num_t fnum) {
   auto func = std::make_unique<Func>(fnum);
   auto func_ptr = func.get();
   funcs_.push_back(std::move(func));
+  funcs_by_num_.insert({fnum, func_ptr});
   return func_ptr;
 }
 
@@ -41,16 +43,16 @@ void Program::RemoveFunc(func_num_t fnum) {
                          [=](auto& func) { return func->number() == fnum; });
   if (it == funcs_.end()) fail("tried to remove func not owned by program");
   if (entry_func_num_ == fnum) entry_func_num_ = kNoFuncNum;
+  funcs_by_num_.erase(fnum);
   funcs_.erase(it);
 }
 
 bool Program::operator==(const Program& that) const {
   if (entry_func_num() != that.entry_func_num()) return false;
   if (funcs().size() != that.funcs().size()) return false;
-  for (std::size_t i = 0; i < funcs().size(); i++) {
-    const Func* func_a = funcs().at(i).get();
-    const Func* func_b = that.funcs().at(i).get();
-    if (!IsEqual(func_a, func_b)) return false;
+  for (const std::unique_ptr<Func>& func_a : funcs()) {
+    const Func* func_b = that.GetFunc(func_a->number());
+    if (!IsEqual(func_a.get(), func_b)) return false;
   }
   return true;
 }
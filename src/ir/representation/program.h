@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "src/common/graph/graph.h"
@@ -47,6 +48,7 @@ class Program : public Object {
  private:
   int64_t func_count_;
   std::vector<std::unique_ptr<Func>> funcs_;
+  std::unordered_map<func_num_t, Func*> funcs_by_num_;
 
   func_num_t entry_func_num_ = kNoFuncNum;
 
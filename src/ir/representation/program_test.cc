@@ -0,0 +1,43 @@
+//
+//  program_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/23/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/representation/program.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/num_types.h"
+
+namespace {
+
+using ::testing::SizeIs;
+
+TEST(ProgramTest, HandlesNonContiguousFuncNumbers) {
+  ir::Program program;
+  ir::Func* func_a = program.AddFunc(/*fnum=*/4000000000);
+  ir::Func* func_b = program.AddFunc(/*fnum=*/7);
+  ir::Func* func_c = program.AddFunc();
+
+  EXPECT_EQ(func_c->number(), 4000000001);
+  EXPECT_EQ(program.GetFunc(4000000000), func_a);
+  EXPECT_EQ(program.GetFunc(7), func_b);
+  EXPECT_EQ(program.GetFunc(4000000001), func_c);
+  EXPECT_FALSE(program.HasFunc(0));
+  EXPECT_FALSE(program.HasFunc(8));
+  EXPECT_FALSE(program.HasFunc(ir::kNoFuncNum));
+
+  program.RemoveFunc(7);
+  EXPECT_FALSE(program.HasFunc(7));
+  EXPECT_EQ(program.GetFunc(4000000000), func_a);
+  EXPECT_THAT(program.funcs(), SizeIs(2));
+
+  ir::Func* func_d = program.AddFunc(/*fnum=*/7);
+  EXPECT_EQ(program.GetFunc(7), func_d);
+}
+
+}  // namespace
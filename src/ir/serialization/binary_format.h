@@ -0,0 +1,84 @@
+//
+//  binary_format.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_serialization_binary_format_h
+#define ir_serialization_binary_format_h
+
+#include <cstdint>
+
+namespace ir_serialization {
+namespace binary_format {
+
+// Layout of a binary IR file (all fixed width integers are little endian):
+//
+//   Header (kHeaderSize bytes):
+//      0: magic ("KIRB")
+//      4: u32 version
+//      8: u64 offset of string table
+//     16: u64 offset of func table
+//     24: u32 number of strings
+//     28: u32 number of funcs
+//     32: i64 entry func number
+//     40: u64 file size
+//   String table:
+//     (number of strings + 1) x u32 offsets of strings relative to the end of the offsets,
+//     followed by the string contents
+//   Func table (kFuncTableEntrySize bytes per func):
+//      0: i64 func number
+//      8: u32 index of func name in string table
+//     12: u32 reserved
+//     16: u64 offset of func body
+//     24: u64 size of func body
+//   Func bodies:
+//     Dense encoding of blocks, instrs, and values using LEB128 varints (see binary_writer.cc).
+//
+// Func bodies do not reference each other, such that each func can get decoded independently
+// when it gets used for the first time.
+
+constexpr uint8_t kMagic[4] = {'K', 'I', 'R', 'B'};
+constexpr uint32_t kVersion = 2;
+
+constexpr int64_t kHeaderSize = 48;
+constexpr int64_t kVersionOffset = 4;
+constexpr int64_t kStringTableOffsetOffset = 8;
+constexpr int64_t kFuncTableOffsetOffset = 16;
+constexpr int64_t kStringCountOffset = 24;
+constexpr int64_t kFuncCountOffset = 28;
+constexpr int64_t kEntryFuncNumOffset = 32;
+constexpr int64_t kFileSizeOffset = 40;
+
+constexpr int64_t kFuncTableEntrySize = 32;
+constexpr int64_t kFuncNumOffset = 0;
+constexpr int64_t kFuncNameOffset = 8;
+constexpr int64_t kFuncBodyOffsetOffset = 16;
+constexpr int64_t kFuncBodySizeOffset = 24;
+
+// Encodes types in a single byte. Int types get encoded as kIntTypeBase plus the value of
+// common::atomics::IntType.
+enum class TypeCode : uint8_t {
+  kBool = 1,
+  kPointer = 2,
+  kFunc = 3,
+  kIntTypeBase = 16,
+};
+
+// Precedes every encoded value.
+enum class ValueTag : uint8_t {
+  kComputed = 0,    // followed by value number and type code
+  kFalse = 1,       // no payload
+  kTrue = 2,        // no payload
+  kInt = 3,         // followed by type code and value (zig-zag encoded for signed types)
+  kPointer = 4,     // followed by zig-zag encoded value
+  kFunc = 5,        // followed by zig-zag encoded func number
+  kInherited = 6,   // followed by inherited value and origin block number
+};
+
+}  // namespace binary_format
+}  // namespace ir_serialization
+
+#endif /* ir_serialization_binary_format_h */
@@ -0,0 +1,530 @@
+//
+//  binary_reader.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "binary_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include "src/common/atomics/atomics.h"
+#include "src/common/logging/logging.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+#include "src/ir/serialization/binary_format.h"
+
+namespace ir_serialization {
+namespace {
+
+using ::common::logging::fail;
+using ::ir_serialization::binary_format::TypeCode;
+using ::ir_serialization::binary_format::ValueTag;
+
+uint64_t ReadFixed(std::string_view data, uint64_t offset, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= uint64_t(uint8_t(data.at(offset + i))) << (8 * i);
+  }
+  return value;
+}
+
+class Decoder {
+ public:
+  Decoder(std::string_view data) : data_(data), pos_(0) {}
+
+  bool AtEnd() const { return pos_ == data_.size(); }
+
+  uint8_t U8() {
+    if (pos_ >= data_.size()) {
+      fail("malformed binary IR: unexpected end of func body");
+    }
+    return uint8_t(data_[pos_++]);
+  }
+
+  uint64_t UVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t byte = U8();
+      value |= uint64_t(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    fail("malformed binary IR: varint too long");
+  }
+  int64_t SVarint() {
+    uint64_t value = UVarint();
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+  }
+
+ private:
+  std::string_view data_;
+  std::size_t pos_;
+};
+
+class FuncDecoder {
+ public:
+  FuncDecoder(std::string_view body, std::function<std::string_view(uint32_t)> strings,
+              ir::Func* func)
+      : decoder_(body), strings_(strings), func_(func) {}
+
+  void DecodeFunc();
+
+ private:
+  void DecodeBlock();
+  std::unique_ptr<ir::Instr> DecodeInstr();
+  std::vector<std::shared_ptr<ir::Value>> DecodeValues();
+  std::shared_ptr<ir::Value> DecodeValue();
+  std::shared_ptr<ir::InheritedValue> DecodeInheritedValue();
+  std::vector<std::shared_ptr<ir::Computed>> DecodeComputeds();
+  std::shared_ptr<ir::Computed> DecodeComputed();
+  const ir::Type* DecodeType();
+
+  void ConnectBlocks();
+
+  Decoder decoder_;
+  std::function<std::string_view(uint32_t)> strings_;
+  ir::Func* func_;
+  std::unordered_map<ir::value_num_t, std::shared_ptr<ir::Computed>> computeds_;
+};
+
+void FuncDecoder::DecodeFunc() {
+  int64_t computed_count = int64_t(decoder_.UVarint());
+  func_->args() = DecodeComputeds();
+  uint64_t result_count = decoder_.UVarint();
+  for (uint64_t i = 0; i < result_count; i++) {
+    func_->result_types().push_back(DecodeType());
+  }
+  ir::block_num_t entry_block_num = decoder_.SVarint();
+  uint64_t block_count = decoder_.UVarint();
+  for (uint64_t i = 0; i < block_count; i++) {
+    DecodeBlock();
+  }
+  if (!decoder_.AtEnd()) {
+    fail("malformed binary IR: unexpected data after func body");
+  }
+  if (!func_->HasBlock(entry_block_num)) {
+    fail("malformed binary IR: entry block does not exist");
+  }
+  func_->set_entry_block_num(entry_block_num);
+  if (computed_count > 0) {
+    func_->register_computed_number(computed_count - 1);
+  }
+  ConnectBlocks();
+}
+
+void FuncDecoder::DecodeBlock() {
+  ir::block_num_t block_num = decoder_.UVarint();
+  if (func_->HasBlock(block_num)) {
+    fail("malformed binary IR: duplicate block number");
+  }
+  ir::Block* block = func_->AddBlock(block_num);
+  block->set_name(std::string(strings_(uint32_t(decoder_.UVarint()))));
+  uint64_t instr_count = decoder_.UVarint();
+  block->instrs().reserve(instr_count);
+  for (uint64_t i = 0; i < instr_count; i++) {
+    block->instrs().push_back(DecodeInstr());
+  }
+}
+
+std::unique_ptr<ir::Instr> FuncDecoder::DecodeInstr() {
+  uint8_t instr_kind = decoder_.U8();
+  switch (ir::InstrKind(instr_kind)) {
+    case ir::InstrKind::kMov: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> origin = DecodeValue();
+      return std::make_unique<ir::MovInstr>(result, origin);
+    }
+    case ir::InstrKind::kPhi: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      uint64_t arg_count = decoder_.UVarint();
+      std::vector<std::shared_ptr<ir::InheritedValue>> args;
+      args.reserve(arg_count);
+      for (uint64_t i = 0; i < arg_count; i++) {
+        args.push_back(DecodeInheritedValue());
+      }
+      return std::make_unique<ir::PhiInstr>(result, args);
+    }
+    case ir::InstrKind::kConversion: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand = DecodeValue();
+      return std::make_unique<ir::Conversion>(result, operand);
+    }
+    case ir::InstrKind::kBoolNot: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand = DecodeValue();
+      return std::make_unique<ir::BoolNotInstr>(result, operand);
+    }
+    case ir::InstrKind::kBoolBinary: {
+      auto op = common::atomics::Bool::BinaryOp(decoder_.U8());
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand_a = DecodeValue();
+      std::shared_ptr<ir::Value> operand_b = DecodeValue();
+      return std::make_unique<ir::BoolBinaryInstr>(result, op, operand_a, operand_b);
+    }
+    case ir::InstrKind::kIntUnary: {
+      auto op = common::atomics::Int::UnaryOp(decoder_.U8());
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand = DecodeValue();
+      return std::make_unique<ir::IntUnaryInstr>(result, op, operand);
+    }
+    case ir::InstrKind::kIntCompare: {
+      auto op = common::atomics::Int::CompareOp(decoder_.U8());
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand_a = DecodeValue();
+      std::shared_ptr<ir::Value> operand_b = DecodeValue();
+      return std::make_unique<ir::IntCompareInstr>(result, op, operand_a, operand_b);
+    }
+    case ir::InstrKind::kIntBinary: {
+      auto op = common::atomics::Int::BinaryOp(decoder_.U8());
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> operand_a = DecodeValue();
+      std::shared_ptr<ir::Value> operand_b = DecodeValue();
+      return std::make_unique<ir::IntBinaryInstr>(result, op, operand_a, operand_b);
+    }
+    case ir::InstrKind::kIntShift: {
+      auto op = common::atomics::Int::ShiftOp(decoder_.U8());
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> shifted = DecodeValue();
+      std::shared_ptr<ir::Value> offset = DecodeValue();
+      return std::make_unique<ir::IntShiftInstr>(result, op, shifted, offset);
+    }
+    case ir::InstrKind::kPointerOffset: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Computed> pointer = DecodeComputed();
+      std::shared_ptr<ir::Value> offset = DecodeValue();
+      return std::make_unique<ir::PointerOffsetInstr>(result, pointer, offset);
+    }
+    case ir::InstrKind::kNilTest: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> tested = DecodeValue();
+      return std::make_unique<ir::NilTestInstr>(result, tested);
+    }
+    case ir::InstrKind::kMalloc: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> size = DecodeValue();
+      return std::make_unique<ir::MallocInstr>(result, size);
+    }
+    case ir::InstrKind::kStackAlloc: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> size = DecodeValue();
+      return std::make_unique<ir::StackAllocInstr>(result, size);
+    }
+    case ir::InstrKind::kLoad: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> address = DecodeValue();
+      return std::make_unique<ir::LoadInstr>(result, address);
+    }
+    case ir::InstrKind::kStore: {
+      std::shared_ptr<ir::Value> address = DecodeValue();
+      std::shared_ptr<ir::Value> value = DecodeValue();
+      return std::make_unique<ir::StoreInstr>(address, value);
+    }
+    case ir::InstrKind::kFree: {
+      std::shared_ptr<ir::Value> address = DecodeValue();
+      return std::make_unique<ir::FreeInstr>(address);
+    }
+    case ir::InstrKind::kJump: {
+      ir::block_num_t destination = decoder_.UVarint();
+      return std::make_unique<ir::JumpInstr>(destination);
+    }
+    case ir::InstrKind::kJumpCond: {
+      std::shared_ptr<ir::Value> condition = DecodeValue();
+      ir::block_num_t destination_true = decoder_.UVarint();
+      ir::block_num_t destination_false = decoder_.UVarint();
+      return std::make_unique<ir::JumpCondInstr>(condition, destination_true, destination_false);
+    }
+    case ir::InstrKind::kSyscall: {
+      std::shared_ptr<ir::Computed> result = DecodeComputed();
+      std::shared_ptr<ir::Value> syscall_num = DecodeValue();
+      std::vector<std::shared_ptr<ir::Value>> args = DecodeValues();
+      return std::make_unique<ir::SyscallInstr>(result, syscall_num, args);
+    }
+    case ir::InstrKind::kCall: {
+      std::shared_ptr<ir::Value> func = DecodeValue();
+      std::vector<std::shared_ptr<ir::Computed>> results = DecodeComputeds();
+      std::vector<std::shared_ptr<ir::Value>> args = DecodeValues();
+      return std::make_unique<ir::CallInstr>(func, results, args);
+    }
+    case ir::InstrKind::kReturn: {
+      std::vector<std::shared_ptr<ir::Value>> args = DecodeValues();
+      return std::make_unique<ir::ReturnInstr>(args);
+    }
+    default:
+      fail("malformed binary IR: unexpected instr kind");
+  }
+}
+
+std::vector<std::shared_ptr<ir::Value>> FuncDecoder::DecodeValues() {
+  uint64_t count = decoder_.UVarint();
+  std::vector<std::shared_ptr<ir::Value>> values;
+  values.reserve(count);
+  for (uint64_t i = 0; i < count; i++) {
+    values.push_back(DecodeValue());
+  }
+  return values;
+}
+
+std::shared_ptr<ir::Value> FuncDecoder::DecodeValue() {
+  switch (ValueTag(decoder_.U8())) {
+    case ValueTag::kComputed:
+      return DecodeComputed();
+    case ValueTag::kFalse:
+      return ir::False();
+    case ValueTag::kTrue:
+      return ir::True();
+    case ValueTag::kInt: {
+      const ir::Type* type = DecodeType();
+      if (type->type_kind() != ir::TypeKind::kInt) {
+        fail("malformed binary IR: int constant without int type");
+      }
+      common::atomics::IntType int_type = static_cast<const ir::IntType*>(type)->int_type();
+      common::atomics::Int value = common::atomics::IsSigned(int_type)
+                                       ? common::atomics::Int(decoder_.SVarint())
+                                       : common::atomics::Int(decoder_.UVarint());
+      return ir::ToIntConstant(value.ConvertTo(int_type));
+    }
+    case ValueTag::kPointer:
+      return ir::ToPointerConstant(decoder_.SVarint());
+    case ValueTag::kFunc:
+      return ir::ToFuncConstant(decoder_.SVarint());
+    case ValueTag::kInherited: {
+      std::shared_ptr<ir::Value> value = DecodeValue();
+      ir::block_num_t origin = decoder_.UVarint();
+      return std::make_shared<ir::InheritedValue>(value, origin);
+    }
+    default:
+      fail("malformed binary IR: unexpected value tag");
+  }
+}
+
+std::shared_ptr<ir::InheritedValue> FuncDecoder::DecodeInheritedValue() {
+  std::shared_ptr<ir::Value> value = DecodeValue();
+  if (value->kind() != ir::Value::Kind::kInherited) {
+    fail("malformed binary IR: expected inherited value");
+  }
+  return std::static_pointer_cast<ir::InheritedValue>(value);
+}
+
+std::vector<std::shared_ptr<ir::Computed>> FuncDecoder::DecodeComputeds() {
+  uint64_t count = decoder_.UVarint();
+  std::vector<std::shared_ptr<ir::Computed>> computeds;
+  computeds.reserve(count);
+  for (uint64_t i = 0; i < count; i++) {
+    computeds.push_back(DecodeComputed());
+  }
+  return computeds;
+}
+
+// Definitions and uses of a computed value share the same object, like in parsed funcs.
+std::shared_ptr<ir::Computed> FuncDecoder::DecodeComputed() {
+  ir::value_num_t number = decoder_.UVarint();
+  const ir::Type* type = DecodeType();
+  auto it = computeds_.find(number);
+  if (it != computeds_.end()) {
+    if (!ir::IsEqual(it->second->type(), type)) {
+      fail("malformed binary IR: computed value with inconsistent types");
+    }
+    return it->second;
+  }
+  auto computed = std::make_shared<ir::Computed>(type, number);
+  computeds_.insert({number, computed});
+  return computed;
+}
+
+const ir::Type* FuncDecoder::DecodeType() {
+  uint8_t type_code = decoder_.U8();
+  switch (TypeCode(type_code)) {
+    case TypeCode::kBool:
+      return ir::bool_type();
+    case TypeCode::kPointer:
+      return ir::pointer_type();
+    case TypeCode::kFunc:
+      return ir::func_type();
+    default:
+      break;
+  }
+  uint8_t int_type = type_code - uint8_t(TypeCode::kIntTypeBase);
+  if (type_code < uint8_t(TypeCode::kIntTypeBase) ||
+      int_type > uint8_t(common::atomics::IntType::kU64)) {
+    fail("malformed binary IR: unexpected type code");
+  }
+  return ir::IntTypeFor(common::atomics::IntType(int_type));
+}
+
+void FuncDecoder::ConnectBlocks() {
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    if (block->instrs().empty()) {
+      continue;
+    }
+    ir::Instr* last_instr = block->instrs().back().get();
+    std::vector<ir::block_num_t> children;
+    if (last_instr->instr_kind() == ir::InstrKind::kJump) {
+      children.push_back(static_cast<ir::JumpInstr*>(last_instr)->destination());
+    } else if (last_instr->instr_kind() == ir::InstrKind::kJumpCond) {
+      auto jump_cond = static_cast<ir::JumpCondInstr*>(last_instr);
+      children.push_back(jump_cond->destination_true());
+      children.push_back(jump_cond->destination_false());
+    }
+    for (ir::block_num_t child : children) {
+      if (!func_->HasBlock(child)) {
+        fail("malformed binary IR: jump destination does not exist");
+      }
+      func_->AddControlFlow(block->number(), child);
+    }
+  }
+}
+
+}  // namespace
+
+bool BinaryProgramReader::HasBinaryFormat(std::string_view data) {
+  return data.size() >= sizeof(binary_format::kMagic) &&
+         std::memcmp(data.data(), binary_format::kMagic, sizeof(binary_format::kMagic)) == 0;
+}
+
+std::unique_ptr<BinaryProgramReader> BinaryProgramReader::FromData(std::string data) {
+  auto reader = std::unique_ptr<BinaryProgramReader>(new BinaryProgramReader(""));
+  reader->owned_data_ = std::move(data);
+  reader->data_ = reader->owned_data_;
+  if (!reader->ReadHeader()) {
+    return nullptr;
+  }
+  return reader;
+}
+
+std::unique_ptr<BinaryProgramReader> BinaryProgramReader::FromFile(std::filesystem::path path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < binary_format::kHeaderSize) {
+    close(fd);
+    return nullptr;
+  }
+  std::size_t size = std::size_t(file_stat.st_size);
+  void* mapped_data = mmap(/*addr=*/NULL, size, PROT_READ, MAP_PRIVATE, fd, /*offset=*/0);
+  close(fd);
+  if (mapped_data == MAP_FAILED) {
+    return nullptr;
+  }
+  auto reader = std::unique_ptr<BinaryProgramReader>(
+      new BinaryProgramReader(std::string_view(static_cast<const char*>(mapped_data), size)));
+  reader->mapped_data_ = mapped_data;
+  reader->mapped_size_ = size;
+  if (!reader->ReadHeader()) {
+    return nullptr;
+  }
+  return reader;
+}
+
+BinaryProgramReader::~BinaryProgramReader() {
+  if (mapped_data_ != nullptr) {
+    munmap(mapped_data_, mapped_size_);
+  }
+}
+
+bool BinaryProgramReader::ReadHeader() {
+  if (data_.size() < uint64_t(binary_format::kHeaderSize) || !HasBinaryFormat(data_) ||
+      ReadFixed(data_, binary_format::kVersionOffset, 4) != binary_format::kVersion ||
+      ReadFixed(data_, binary_format::kFileSizeOffset, 8) != data_.size()) {
+    return false;
+  }
+  string_table_offset_ = ReadFixed(data_, binary_format::kStringTableOffsetOffset, 8);
+  string_count_ = uint32_t(ReadFixed(data_, binary_format::kStringCountOffset, 4));
+  uint64_t string_data_offset = string_table_offset_ + 4 * (uint64_t(string_count_) + 1);
+  if (string_table_offset_ > data_.size() || string_data_offset > data_.size() ||
+      string_data_offset + ReadFixed(data_, string_data_offset - 4, 4) > data_.size()) {
+    return false;
+  }
+
+  uint64_t func_table_offset = ReadFixed(data_, binary_format::kFuncTableOffsetOffset, 8);
+  uint64_t func_count = ReadFixed(data_, binary_format::kFuncCountOffset, 4);
+  if (func_table_offset > data_.size() ||
+      func_count > (data_.size() - func_table_offset) / binary_format::kFuncTableEntrySize) {
+    return false;
+  }
+  func_nums_.reserve(func_count);
+  for (uint64_t i = 0; i < func_count; i++) {
+    uint64_t entry_offset = func_table_offset + i * binary_format::kFuncTableEntrySize;
+    ir::func_num_t func_num =
+        ir::func_num_t(ReadFixed(data_, entry_offset + binary_format::kFuncNumOffset, 8));
+    FuncEntry entry{
+        .name_index =
+            uint32_t(ReadFixed(data_, entry_offset + binary_format::kFuncNameOffset, 4)),
+        .body_offset = ReadFixed(data_, entry_offset + binary_format::kFuncBodyOffsetOffset, 8),
+        .body_size = ReadFixed(data_, entry_offset + binary_format::kFuncBodySizeOffset, 8),
+    };
+    if (func_num < 0 || entry.name_index >= string_count_ || entry.body_offset > data_.size() ||
+        entry.body_size > data_.size() - entry.body_offset ||
+        !func_entries_.insert({func_num, entry}).second) {
+      return false;
+    }
+    func_nums_.push_back(func_num);
+  }
+  entry_func_num_ = ir::func_num_t(ReadFixed(data_, binary_format::kEntryFuncNumOffset, 8));
+  return true;
+}
+
+std::string_view BinaryProgramReader::String(uint32_t index) const {
+  if (index >= string_count_) {
+    fail("malformed binary IR: string index out of bounds");
+  }
+  uint64_t string_data_offset = string_table_offset_ + 4 * (uint64_t(string_count_) + 1);
+  uint64_t start = ReadFixed(data_, string_table_offset_ + 4 * uint64_t(index), 4);
+  uint64_t end = ReadFixed(data_, string_table_offset_ + 4 * (uint64_t(index) + 1), 4);
+  if (start > end || string_data_offset + end > data_.size()) {
+    fail("malformed binary IR: string out of bounds");
+  }
+  return data_.substr(string_data_offset + start, end - start);
+}
+
+std::string_view BinaryProgramReader::FuncName(ir::func_num_t func_num) const {
+  auto it = func_entries_.find(func_num);
+  if (it == func_entries_.end()) {
+    fail("func does not exist in binary IR");
+  }
+  return String(it->second.name_index);
+}
+
+ir::Func* BinaryProgramReader::GetFunc(ir::func_num_t func_num) {
+  if (ir::Func* func = program_->GetFunc(func_num); func != nullptr) {
+    return func;
+  }
+  auto it = func_entries_.find(func_num);
+  if (it == func_entries_.end()) {
+    return nullptr;
+  }
+  const FuncEntry& entry = it->second;
+  ir::Func* func = program_->AddFunc(func_num);
+  func->set_name(std::string(String(entry.name_index)));
+  FuncDecoder func_decoder(data_.substr(entry.body_offset, entry.body_size),
+                           [this](uint32_t index) { return String(index); }, func);
+  func_decoder.DecodeFunc();
+  return func;
+}
+
+std::unique_ptr<ir::Program> BinaryProgramReader::ReadProgram() {
+  for (ir::func_num_t func_num : func_nums_) {
+    GetFunc(func_num);
+  }
+  program_->set_entry_func_num(entry_func_num_);
+  std::unique_ptr<ir::Program> program = std::move(program_);
+  program_ = std::make_unique<ir::Program>();
+  return program;
+}
+
+}  // namespace ir_serialization
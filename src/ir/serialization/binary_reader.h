@@ -0,0 +1,79 @@
+//
+//  binary_reader.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_serialization_binary_reader_h
+#define ir_serialization_binary_reader_h
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/program.h"
+
+namespace ir_serialization {
+
+// Reads programs in the binary IR format (see binary_format.h). Only the header and func table
+// get validated upfront, func bodies get decoded when a func gets requested for the first time.
+class BinaryProgramReader {
+ public:
+  static bool HasBinaryFormat(std::string_view data);
+
+  // Returns nullptr if the data does not have a valid header.
+  static std::unique_ptr<BinaryProgramReader> FromData(std::string data);
+  // Maps the file into memory. Returns nullptr if the file can not be mapped or does not have a
+  // valid header.
+  static std::unique_ptr<BinaryProgramReader> FromFile(std::filesystem::path path);
+
+  ~BinaryProgramReader();
+
+  ir::func_num_t entry_func_num() const { return entry_func_num_; }
+  const std::vector<ir::func_num_t>& func_nums() const { return func_nums_; }
+  std::string_view FuncName(ir::func_num_t func_num) const;
+
+  // Decodes the func on the first request and returns the same func for later requests. Returns
+  // nullptr if the program does not contain a func with the given number.
+  ir::Func* GetFunc(ir::func_num_t func_num);
+
+  // Decodes all remaining funcs and transfers ownership of the program.
+  std::unique_ptr<ir::Program> ReadProgram();
+
+ private:
+  struct FuncEntry {
+    uint32_t name_index;
+    uint64_t body_offset;
+    uint64_t body_size;
+  };
+
+  BinaryProgramReader(std::string_view data) : data_(data) {}
+
+  bool ReadHeader();
+  std::string_view String(uint32_t index) const;
+
+  std::string owned_data_;
+  void* mapped_data_ = nullptr;
+  std::size_t mapped_size_ = 0;
+  std::string_view data_;
+
+  uint32_t string_count_;
+  uint64_t string_table_offset_;
+  ir::func_num_t entry_func_num_;
+  std::vector<ir::func_num_t> func_nums_;
+  std::unordered_map<ir::func_num_t, FuncEntry> func_entries_;
+
+  std::unique_ptr<ir::Program> program_ = std::make_unique<ir::Program>();
+};
+
+}  // namespace ir_serialization
+
+#endif /* ir_serialization_binary_reader_h */
@@ -0,0 +1,131 @@
+//
+//  binary_reader_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/ir/serialization/binary_reader.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/check/check_test_util.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/binary_writer.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/print.h"
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsNull;
+using ::testing::NotNull;
+using ::testing::SizeIs;
+
+constexpr std::string_view kProgram = R"ir(
+@0 main () => (i64) {
+{0}
+  %0:i64 = call @1, #10:i64
+  %1:u8 = conv %0
+  %2:b = ilss %0, #-3:i64
+  jcc %2, {1}, {2}
+{1}
+  %3:ptr = malloc #8:i64
+  store %3, #255:u8
+  %4:u8 = load %3
+  %5:ptr = poff %3, #1:i64
+  %6:b = niltest %5
+  free %3
+  jmp {2}
+{2}
+  %7:u8 = phi %1{0}, %4:u8{1}
+  %8:u8 = ishl %7, #2:u64
+  %9:b = bnot %2
+  %10:b = band %9, #t
+  %11:func = mov @1
+  %12:i64 = call %11, #0:i64
+  %13:i64 = syscall #60:i64, %12
+  ret %13
+}
+
+@1 fib (%0:i64) => (i64) {
+{0}
+  %1:b = ileq %0, #1:i64
+  jcc %1, {1}, {2}
+{1}
+  ret %0
+{2}
+  %2:i64 = isub %0, #1:i64
+  %3:i64 = call @1, %2
+  %4:i64 = isub %0, #2:i64
+  %5:i64 = call @1, %4
+  %6:i64 = iadd %3, %5
+  ret %6
+}
+)ir";
+
+TEST(BinaryReaderTest, RoundTripsProgram) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(std::string(kProgram));
+  ir_check::CheckProgramOrDie(program.get());
+
+  std::string data = ir_serialization::WriteBinary(program.get());
+  ASSERT_TRUE(ir_serialization::BinaryProgramReader::HasBinaryFormat(data));
+  std::unique_ptr<ir_serialization::BinaryProgramReader> reader =
+      ir_serialization::BinaryProgramReader::FromData(data);
+  ASSERT_THAT(reader, NotNull());
+  std::unique_ptr<ir::Program> read_program = reader->ReadProgram();
+  ir_check::CheckProgramOrDie(read_program.get());
+
+  EXPECT_TRUE(ir::IsEqual(read_program.get(), program.get()))
+      << "Expected program:\n"
+      << ir_serialization::Print(program.get()) << "\n"
+      << "Read program:\n"
+      << ir_serialization::Print(read_program.get());
+}
+
+TEST(BinaryReaderTest, DecodesFuncsLazily) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(std::string(kProgram));
+  std::unique_ptr<ir_serialization::BinaryProgramReader> reader =
+      ir_serialization::BinaryProgramReader::FromData(
+          ir_serialization::WriteBinary(program.get()));
+  ASSERT_THAT(reader, NotNull());
+
+  EXPECT_EQ(reader->entry_func_num(), 0);
+  EXPECT_THAT(reader->func_nums(), ElementsAre(0, 1));
+  EXPECT_EQ(reader->FuncName(1), "fib");
+  EXPECT_THAT(reader->GetFunc(2), IsNull());
+
+  ir::Func* fib = reader->GetFunc(1);
+  ASSERT_THAT(fib, NotNull());
+  EXPECT_EQ(reader->GetFunc(1), fib);
+  EXPECT_TRUE(ir::IsEqual(fib, program->GetFunc(1)));
+  EXPECT_EQ(fib->computed_count(), 7);
+  EXPECT_THAT(fib->blocks(), SizeIs(3));
+  EXPECT_THAT(fib->entry_block()->children(), SizeIs(2));
+
+  std::unique_ptr<ir::Program> read_program = reader->ReadProgram();
+  EXPECT_EQ(read_program->GetFunc(1), fib);
+  EXPECT_TRUE(ir::IsEqual(read_program.get(), program.get()));
+}
+
+TEST(BinaryReaderTest, RejectsInvalidHeaders) {
+  std::unique_ptr<ir::Program> program = ir_serialization::ParseProgramOrDie(std::string(kProgram));
+  std::string data = ir_serialization::WriteBinary(program.get());
+
+  EXPECT_FALSE(ir_serialization::BinaryProgramReader::HasBinaryFormat("@0 main () => () {"));
+  EXPECT_THAT(ir_serialization::BinaryProgramReader::FromData("@0 main () => () {"), IsNull());
+
+  std::string truncated_data = data.substr(0, data.size() - 1);
+  EXPECT_THAT(ir_serialization::BinaryProgramReader::FromData(truncated_data), IsNull());
+
+  std::string wrong_version_data = data;
+  wrong_version_data[4] = 42;
+  EXPECT_THAT(ir_serialization::BinaryProgramReader::FromData(wrong_version_data), IsNull());
+}
+
+}  // namespace
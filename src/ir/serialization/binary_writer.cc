@@ -0,0 +1,442 @@
+//
+//  binary_writer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "binary_writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "src/common/atomics/atomics.h"
+#include "src/common/logging/logging.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+#include "src/ir/serialization/binary_format.h"
+
+namespace ir_serialization {
+namespace {
+
+using ::common::logging::fail;
+using ::ir_serialization::binary_format::TypeCode;
+using ::ir_serialization::binary_format::ValueTag;
+
+class Encoder {
+ public:
+  Encoder(std::string& out) : out_(out) {}
+
+  void U8(uint8_t value) { out_.push_back(char(value)); }
+  void U32(uint32_t value) { Fixed(value, 4); }
+  void U64(uint64_t value) { Fixed(value, 8); }
+  void I64(int64_t value) { Fixed(uint64_t(value), 8); }
+
+  void UVarint(uint64_t value) {
+    while (value >= 0x80) {
+      U8(uint8_t(value) | 0x80);
+      value >>= 7;
+    }
+    U8(uint8_t(value));
+  }
+  void SVarint(int64_t value) { UVarint((uint64_t(value) << 1) ^ uint64_t(value >> 63)); }
+
+ private:
+  void Fixed(uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+      U8(uint8_t(value >> (8 * i)));
+    }
+  }
+
+  std::string& out_;
+};
+
+class BinaryWriter {
+ public:
+  BinaryWriter(const ir::Program* program) : program_(program) {}
+
+  std::string Write();
+
+ private:
+  uint32_t InternString(const std::string& str);
+
+  void WriteFuncBody(const ir::Func* func, Encoder& encoder);
+  void WriteBlock(const ir::Block* block, Encoder& encoder);
+  void WriteInstr(const ir::Instr* instr, Encoder& encoder);
+  void WriteValues(const std::vector<std::shared_ptr<ir::Value>>& values, Encoder& encoder);
+  void WriteValue(const ir::Value* value, Encoder& encoder);
+  void WriteComputeds(const std::vector<std::shared_ptr<ir::Computed>>& computeds,
+                      Encoder& encoder);
+  void WriteComputed(const ir::Computed* computed, Encoder& encoder);
+  void WriteType(const ir::Type* type, Encoder& encoder);
+
+  const ir::Program* program_;
+  std::vector<std::string> strings_;
+  std::unordered_map<std::string, uint32_t> string_indices_;
+};
+
+std::string BinaryWriter::Write() {
+  std::vector<const ir::Func*> funcs;
+  funcs.reserve(program_->funcs().size());
+  for (const std::unique_ptr<ir::Func>& func : program_->funcs()) {
+    funcs.push_back(func.get());
+  }
+  std::sort(funcs.begin(), funcs.end(), [](const ir::Func* a, const ir::Func* b) {
+    return a->number() < b->number();
+  });
+
+  std::string bodies;
+  Encoder bodies_encoder(bodies);
+  std::vector<uint32_t> name_indices;
+  std::vector<uint64_t> body_offsets;
+  name_indices.reserve(funcs.size());
+  body_offsets.reserve(funcs.size() + 1);
+  for (const ir::Func* func : funcs) {
+    name_indices.push_back(InternString(func->name()));
+    body_offsets.push_back(bodies.size());
+    WriteFuncBody(func, bodies_encoder);
+  }
+  body_offsets.push_back(bodies.size());
+
+  std::string string_table;
+  Encoder string_table_encoder(string_table);
+  uint32_t string_offset = 0;
+  for (const std::string& str : strings_) {
+    string_table_encoder.U32(string_offset);
+    string_offset += str.size();
+  }
+  string_table_encoder.U32(string_offset);
+  for (const std::string& str : strings_) {
+    string_table += str;
+  }
+  // Keep the func table aligned:
+  string_table.resize((string_table.size() + 7) / 8 * 8, '\0');
+
+  const uint64_t string_table_offset = binary_format::kHeaderSize;
+  const uint64_t func_table_offset = string_table_offset + string_table.size();
+  const uint64_t bodies_offset =
+      func_table_offset + funcs.size() * binary_format::kFuncTableEntrySize;
+  const uint64_t file_size = bodies_offset + bodies.size();
+
+  std::string out;
+  out.reserve(file_size);
+  Encoder encoder(out);
+  for (uint8_t c : binary_format::kMagic) {
+    encoder.U8(c);
+  }
+  encoder.U32(binary_format::kVersion);
+  encoder.U64(string_table_offset);
+  encoder.U64(func_table_offset);
+  encoder.U32(uint32_t(strings_.size()));
+  encoder.U32(uint32_t(funcs.size()));
+  encoder.I64(program_->entry_func_num());
+  encoder.U64(file_size);
+  out += string_table;
+  for (std::size_t i = 0; i < funcs.size(); i++) {
+    encoder.I64(funcs.at(i)->number());
+    encoder.U32(name_indices.at(i));
+    encoder.U32(0);
+    encoder.U64(bodies_offset + body_offsets.at(i));
+    encoder.U64(body_offsets.at(i + 1) - body_offsets.at(i));
+  }
+  out += bodies;
+  return out;
+}
+
+uint32_t BinaryWriter::InternString(const std::string& str) {
+  auto it = string_indices_.find(str);
+  if (it != string_indices_.end()) {
+    return it->second;
+  }
+  uint32_t index = uint32_t(strings_.size());
+  strings_.push_back(str);
+  string_indices_.insert({str, index});
+  return index;
+}
+
+// FuncBody ::= ComputedCount Args ResultTypes EntryBlock BlockCount Block*
+void BinaryWriter::WriteFuncBody(const ir::Func* func, Encoder& encoder) {
+  encoder.UVarint(func->computed_count());
+  WriteComputeds(func->args(), encoder);
+  encoder.UVarint(func->result_types().size());
+  for (const ir::Type* result_type : func->result_types()) {
+    WriteType(result_type, encoder);
+  }
+  encoder.SVarint(func->entry_block_num());
+
+  std::vector<const ir::Block*> blocks;
+  blocks.reserve(func->blocks().size());
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    blocks.push_back(block.get());
+  }
+  std::sort(blocks.begin(), blocks.end(), [](const ir::Block* a, const ir::Block* b) {
+    return a->number() < b->number();
+  });
+  encoder.UVarint(blocks.size());
+  for (const ir::Block* block : blocks) {
+    WriteBlock(block, encoder);
+  }
+}
+
+// Block ::= Number Name InstrCount Instr*
+void BinaryWriter::WriteBlock(const ir::Block* block, Encoder& encoder) {
+  encoder.UVarint(block->number());
+  encoder.UVarint(InternString(block->name()));
+  encoder.UVarint(block->instrs().size());
+  for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+    WriteInstr(instr.get(), encoder);
+  }
+}
+
+// Instr ::= InstrKind Operation? Operands
+void BinaryWriter::WriteInstr(const ir::Instr* instr, Encoder& encoder) {
+  encoder.U8(uint8_t(instr->instr_kind()));
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kMov: {
+      auto mov_instr = static_cast<const ir::MovInstr*>(instr);
+      WriteComputed(mov_instr->result().get(), encoder);
+      WriteValue(mov_instr->origin().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kPhi: {
+      auto phi_instr = static_cast<const ir::PhiInstr*>(instr);
+      WriteComputed(phi_instr->result().get(), encoder);
+      encoder.UVarint(phi_instr->args().size());
+      for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+        WriteValue(arg.get(), encoder);
+      }
+      return;
+    }
+    case ir::InstrKind::kConversion: {
+      auto conversion = static_cast<const ir::Conversion*>(instr);
+      WriteComputed(conversion->result().get(), encoder);
+      WriteValue(conversion->operand().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kBoolNot: {
+      auto bool_not_instr = static_cast<const ir::BoolNotInstr*>(instr);
+      WriteComputed(bool_not_instr->result().get(), encoder);
+      WriteValue(bool_not_instr->operand().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kBoolBinary: {
+      auto bool_binary_instr = static_cast<const ir::BoolBinaryInstr*>(instr);
+      encoder.U8(uint8_t(bool_binary_instr->operation()));
+      WriteComputed(bool_binary_instr->result().get(), encoder);
+      WriteValue(bool_binary_instr->operand_a().get(), encoder);
+      WriteValue(bool_binary_instr->operand_b().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kIntUnary: {
+      auto int_unary_instr = static_cast<const ir::IntUnaryInstr*>(instr);
+      encoder.U8(uint8_t(int_unary_instr->operation()));
+      WriteComputed(int_unary_instr->result().get(), encoder);
+      WriteValue(int_unary_instr->operand().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kIntCompare: {
+      auto int_compare_instr = static_cast<const ir::IntCompareInstr*>(instr);
+      encoder.U8(uint8_t(int_compare_instr->operation()));
+      WriteComputed(int_compare_instr->result().get(), encoder);
+      WriteValue(int_compare_instr->operand_a().get(), encoder);
+      WriteValue(int_compare_instr->operand_b().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kIntBinary: {
+      auto int_binary_instr = static_cast<const ir::IntBinaryInstr*>(instr);
+      encoder.U8(uint8_t(int_binary_instr->operation()));
+      WriteComputed(int_binary_instr->result().get(), encoder);
+      WriteValue(int_binary_instr->operand_a().get(), encoder);
+      WriteValue(int_binary_instr->operand_b().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kIntShift: {
+      auto int_shift_instr = static_cast<const ir::IntShiftInstr*>(instr);
+      encoder.U8(uint8_t(int_shift_instr->operation()));
+      WriteComputed(int_shift_instr->result().get(), encoder);
+      WriteValue(int_shift_instr->shifted().get(), encoder);
+      WriteValue(int_shift_instr->offset().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kPointerOffset: {
+      auto pointer_offset_instr = static_cast<const ir::PointerOffsetInstr*>(instr);
+      WriteComputed(pointer_offset_instr->result().get(), encoder);
+      WriteComputed(pointer_offset_instr->pointer().get(), encoder);
+      WriteValue(pointer_offset_instr->offset().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kNilTest: {
+      auto nil_test_instr = static_cast<const ir::NilTestInstr*>(instr);
+      WriteComputed(nil_test_instr->result().get(), encoder);
+      WriteValue(nil_test_instr->tested().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kMalloc: {
+      auto malloc_instr = static_cast<const ir::MallocInstr*>(instr);
+      WriteComputed(malloc_instr->result().get(), encoder);
+      WriteValue(malloc_instr->size().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kStackAlloc: {
+      auto stack_alloc_instr = static_cast<const ir::StackAllocInstr*>(instr);
+      WriteComputed(stack_alloc_instr->result().get(), encoder);
+      WriteValue(stack_alloc_instr->size().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kLoad: {
+      auto load_instr = static_cast<const ir::LoadInstr*>(instr);
+      WriteComputed(load_instr->result().get(), encoder);
+      WriteValue(load_instr->address().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kStore: {
+      auto store_instr = static_cast<const ir::StoreInstr*>(instr);
+      WriteValue(store_instr->address().get(), encoder);
+      WriteValue(store_instr->value().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kFree: {
+      auto free_instr = static_cast<const ir::FreeInstr*>(instr);
+      WriteValue(free_instr->address().get(), encoder);
+      return;
+    }
+    case ir::InstrKind::kJump: {
+      auto jump_instr = static_cast<const ir::JumpInstr*>(instr);
+      encoder.UVarint(jump_instr->destination());
+      return;
+    }
+    case ir::InstrKind::kJumpCond: {
+      auto jump_cond_instr = static_cast<const ir::JumpCondInstr*>(instr);
+      WriteValue(jump_cond_instr->condition().get(), encoder);
+      encoder.UVarint(jump_cond_instr->destination_true());
+      encoder.UVarint(jump_cond_instr->destination_false());
+      return;
+    }
+    case ir::InstrKind::kSyscall: {
+      auto syscall_instr = static_cast<const ir::SyscallInstr*>(instr);
+      WriteComputed(syscall_instr->result().get(), encoder);
+      WriteValue(syscall_instr->syscall_num().get(), encoder);
+      WriteValues(syscall_instr->args(), encoder);
+      return;
+    }
+    case ir::InstrKind::kCall: {
+      auto call_instr = static_cast<const ir::CallInstr*>(instr);
+      WriteValue(call_instr->func().get(), encoder);
+      WriteComputeds(call_instr->results(), encoder);
+      WriteValues(call_instr->args(), encoder);
+      return;
+    }
+    case ir::InstrKind::kReturn: {
+      auto return_instr = static_cast<const ir::ReturnInstr*>(instr);
+      WriteValues(return_instr->args(), encoder);
+      return;
+    }
+    default:
+      fail("binary IR format does not support instr kind");
+  }
+}
+
+void BinaryWriter::WriteValues(const std::vector<std::shared_ptr<ir::Value>>& values,
+                               Encoder& encoder) {
+  encoder.UVarint(values.size());
+  for (const std::shared_ptr<ir::Value>& value : values) {
+    WriteValue(value.get(), encoder);
+  }
+}
+
+void BinaryWriter::WriteValue(const ir::Value* value, Encoder& encoder) {
+  switch (value->kind()) {
+    case ir::Value::Kind::kComputed:
+      encoder.U8(uint8_t(ValueTag::kComputed));
+      WriteComputed(static_cast<const ir::Computed*>(value), encoder);
+      return;
+    case ir::Value::Kind::kInherited: {
+      auto inherited = static_cast<const ir::InheritedValue*>(value);
+      encoder.U8(uint8_t(ValueTag::kInherited));
+      WriteValue(inherited->value().get(), encoder);
+      encoder.UVarint(inherited->origin());
+      return;
+    }
+    case ir::Value::Kind::kConstant:
+      break;
+  }
+  switch (value->type()->type_kind()) {
+    case ir::TypeKind::kBool:
+      encoder.U8(uint8_t(static_cast<const ir::BoolConstant*>(value)->value() ? ValueTag::kTrue
+                                                                              : ValueTag::kFalse));
+      return;
+    case ir::TypeKind::kInt: {
+      common::atomics::Int int_value = static_cast<const ir::IntConstant*>(value)->value();
+      encoder.U8(uint8_t(ValueTag::kInt));
+      WriteType(value->type(), encoder);
+      if (common::atomics::IsSigned(int_value.type())) {
+        encoder.SVarint(int_value.AsInt64());
+      } else {
+        encoder.UVarint(int_value.AsUint64());
+      }
+      return;
+    }
+    case ir::TypeKind::kPointer:
+      encoder.U8(uint8_t(ValueTag::kPointer));
+      encoder.SVarint(static_cast<const ir::PointerConstant*>(value)->value());
+      return;
+    case ir::TypeKind::kFunc:
+      encoder.U8(uint8_t(ValueTag::kFunc));
+      encoder.SVarint(static_cast<const ir::FuncConstant*>(value)->value());
+      return;
+    default:
+      fail("binary IR format does not support constant type");
+  }
+}
+
+void BinaryWriter::WriteComputeds(const std::vector<std::shared_ptr<ir::Computed>>& computeds,
+                                  Encoder& encoder) {
+  encoder.UVarint(computeds.size());
+  for (const std::shared_ptr<ir::Computed>& computed : computeds) {
+    WriteComputed(computed.get(), encoder);
+  }
+}
+
+// Computed values without a value tag occur where only computed values are allowed.
+void BinaryWriter::WriteComputed(const ir::Computed* computed, Encoder& encoder) {
+  encoder.UVarint(computed->number());
+  WriteType(computed->type(), encoder);
+}
+
+void BinaryWriter::WriteType(const ir::Type* type, Encoder& encoder) {
+  switch (type->type_kind()) {
+    case ir::TypeKind::kBool:
+      encoder.U8(uint8_t(TypeCode::kBool));
+      return;
+    case ir::TypeKind::kInt:
+      encoder.U8(uint8_t(TypeCode::kIntTypeBase) +
+                 uint8_t(static_cast<const ir::IntType*>(type)->int_type()));
+      return;
+    case ir::TypeKind::kPointer:
+      encoder.U8(uint8_t(TypeCode::kPointer));
+      return;
+    case ir::TypeKind::kFunc:
+      encoder.U8(uint8_t(TypeCode::kFunc));
+      return;
+    default:
+      fail("binary IR format does not support lang types");
+  }
+}
+
+}  // namespace
+
+std::string WriteBinary(const ir::Program* program) {
+  BinaryWriter writer(program);
+  return writer.Write();
+}
+
+void WriteBinary(const ir::Program* program, std::ostream& os) { os << WriteBinary(program); }
+
+}  // namespace ir_serialization
@@ -0,0 +1,26 @@
+//
+//  binary_writer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 11/27/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_serialization_binary_writer_h
+#define ir_serialization_binary_writer_h
+
+#include <ostream>
+#include <string>
+
+#include "src/ir/representation/program.h"
+
+namespace ir_serialization {
+
+// Encodes the program in the binary IR format (see binary_format.h). Only programs without lang
+// types and instrs (i.e. after lowering) can be encoded. Positions do not get encoded.
+std::string WriteBinary(const ir::Program* program);
+void WriteBinary(const ir::Program* program, std::ostream& os);
+
+}  // namespace ir_serialization
+
+#endif /* ir_serialization_binary_writer_h */
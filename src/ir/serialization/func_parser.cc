@@ -315,6 +315,15 @@ std::unique_ptr<ir::Instr> FuncParser::ParseInstrWithResults(
     }
     return ParseMallocInstr(results.front());
 
+  } else if (instr_name == "salloc") {
+    if (results.size() != 1) {
+      issue_tracker().Add(ir_issues::IssueKind::kStackAllocInstrDoesNotHaveOneResult,
+                          scanner().token_start(), "expected one result for salloc instruction");
+      scanner().SkipPastTokenSequence({Scanner::kNewLine});
+      return nullptr;
+    }
+    return ParseStackAllocInstr(results.front());
+
   } else if (instr_name == "load") {
     if (results.size() != 1) {
       issue_tracker().Add(ir_issues::IssueKind::kLoadInstrDoesNotHaveOneResult,
@@ -536,6 +545,15 @@ std::unique_ptr<ir::MallocInstr> FuncParser::ParseMallocInstr(
   return std::make_unique<ir::MallocInstr>(result, size);
 }
 
+// StackAllocInstr ::= Computed '=' 'salloc' Value NL
+std::unique_ptr<ir::StackAllocInstr> FuncParser::ParseStackAllocInstr(
+    std::shared_ptr<ir::Computed> result) {
+  std::shared_ptr<ir::Value> size = ParseValue(ir::i64());
+  scanner().ConsumeToken(Scanner::kNewLine);
+
+  return std::make_unique<ir::StackAllocInstr>(result, size);
+}
+
 // LoadInstr ::= Computed '=' 'load' Value NL
 std::unique_ptr<ir::LoadInstr> FuncParser::ParseLoadInstr(std::shared_ptr<ir::Computed> result) {
   std::shared_ptr<ir::Value> address = ParseValue(ir::pointer_type());
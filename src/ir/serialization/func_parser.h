@@ -83,6 +83,7 @@ class FuncParser {
       std::shared_ptr<ir::Computed> result);
   std::unique_ptr<ir::NilTestInstr> ParseNilTestInstr(std::shared_ptr<ir::Computed> result);
   std::unique_ptr<ir::MallocInstr> ParseMallocInstr(std::shared_ptr<ir::Computed> result);
+  std::unique_ptr<ir::StackAllocInstr> ParseStackAllocInstr(std::shared_ptr<ir::Computed> result);
   std::unique_ptr<ir::LoadInstr> ParseLoadInstr(std::shared_ptr<ir::Computed> result);
   std::unique_ptr<ir::StoreInstr> ParseStoreInstr();
   std::unique_ptr<ir::FreeInstr> ParseFreeInstr();
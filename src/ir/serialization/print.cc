@@ -55,7 +55,13 @@ void Print(const ir::Func* func, std::ostream& os) {
   for (auto& block : func->blocks()) {
     bnums.push_back(block->number());
   }
-  std::sort(bnums.begin(), bnums.end());
+  // The entry block gets printed first, since the parser treats the first block as entry block:
+  std::sort(bnums.begin(), bnums.end(), [func](ir::block_num_t a, ir::block_num_t b) {
+    if (a == func->entry_block_num() || b == func->entry_block_num()) {
+      return a == func->entry_block_num() && b != func->entry_block_num();
+    }
+    return a < b;
+  });
   for (ir::block_num_t bnum : bnums) {
     os << "\n";
     Print(func->GetBlock(bnum), os);
@@ -8,7 +8,8 @@
 
 #include "scanner.h"
 
-#include <cctype>
+#include <cstdint>
+#include <limits>
 
 #include "src/common/logging/logging.h"
 
@@ -17,6 +18,80 @@ namespace ir_serialization {
 using ::common::atomics::Int;
 using ::common::logging::fail;
 
+namespace {
+
+// ASCII character classes, avoiding the locale dependent functions from <cctype> in the hot loops:
+constexpr bool IsLetter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool IsLetterOrDigit(char c) { return IsLetter(c) || IsDigit(c); }
+constexpr bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Numbers get parsed directly from the token text, without creating intermediate strings.
+std::optional<Int> ParseNumber(std::string_view text) {
+  bool negative = false;
+  if (!text.empty() && (text.front() == '+' || text.front() == '-')) {
+    negative = text.front() == '-';
+    text.remove_prefix(1);
+  }
+  if (text.empty()) {
+    return std::nullopt;
+  }
+  uint64_t magnitude = 0;
+  for (char c : text) {
+    if (!IsDigit(c)) {
+      return std::nullopt;
+    }
+    uint64_t digit = c - '0';
+    if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      return std::nullopt;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  constexpr uint64_t kMaxI64 = std::numeric_limits<int64_t>::max();
+  if (negative) {
+    if (magnitude > kMaxI64 + 1) {
+      return std::nullopt;
+    }
+    return Int(int64_t(0 - magnitude));
+  } else if (magnitude <= kMaxI64) {
+    return Int(int64_t(magnitude));
+  } else {
+    return Int(magnitude);
+  }
+}
+
+std::optional<Int> ParseAddress(std::string_view text) {
+  if (!text.starts_with("0x") && !text.starts_with("0X")) {
+    return std::nullopt;
+  }
+  text.remove_prefix(2);
+  if (text.empty()) {
+    return std::nullopt;
+  }
+  uint64_t address = 0;
+  for (char c : text) {
+    uint64_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      return std::nullopt;
+    }
+    if (address >> 60 != 0) {
+      return std::nullopt;
+    }
+    address = (address << 4) | digit;
+  }
+  return Int(address);
+}
+
+}  // namespace
+
 std::string Scanner::TokenToString(Token token) {
   switch (token) {
     case kUnknown:
@@ -38,22 +113,18 @@ std::string Scanner::TokenToString(Token token) {
   }
 }
 
-std::string Scanner::token_text() const {
+std::string_view Scanner::token_text() const {
   if (token_ == kUnknown || token_ == kEoF) {
     fail("token has no associated text");
   }
-  return file_->contents(token_start_, token_end_);
+  return contents_.substr(token_start_ - contents_start_, token_end_ - token_start_ + 1);
 }
 
 Int Scanner::token_number() const {
   if (token_ != kNumber) {
     fail("token has no associated number");
   }
-  std::optional<Int> number = common::atomics::ToI64(token_text());
-  if (number.has_value()) {
-    return *number;
-  }
-  number = common::atomics::ToU64(token_text());
+  std::optional<Int> number = ParseNumber(token_text());
   if (!number.has_value()) {
     issue_tracker_.Add(ir_issues::IssueKind::kNumberCannotBeRepresented, token_start_,
                        "The token cannot be represented as a number");
@@ -67,7 +138,7 @@ Int Scanner::token_address() const {
   if (token_ != kAddress) {
     fail("token has no associated address");
   }
-  std::optional<Int> address = common::atomics::ToU64(token_text(), /*base=*/16);
+  std::optional<Int> address = ParseAddress(token_text());
   if (!address.has_value()) {
     issue_tracker_.Add(ir_issues::IssueKind::kAddressCannotBeRepresented, token_start_,
                        "The token cannot be represented as an address");
@@ -81,13 +152,15 @@ std::string Scanner::token_string() const {
   if (token_ != kString) {
     fail("token has no associated string");
   }
+  std::string_view text = token_text();
   std::string str;
-  for (std::size_t i = 1; i < token_text().length() - 1; i++) {
-    char c = token_text().at(i);
+  str.reserve(text.length() - 2);
+  for (std::size_t i = 1; i < text.length() - 1; i++) {
+    char c = text.at(i);
     if (c == '\\') {
-      c = token_text().at(++i);
+      c = text.at(++i);
     }
-    str += std::string(1, c);
+    str += c;
   }
   return str;
 }
@@ -105,13 +178,13 @@ void Scanner::NextIfPossible() {
   }
   SkipWhitespace();
   token_start_ = pos_;
-  if (pos_ == file_->end()) {
+  if (pos_ == contents_end_) {
     token_ = kEoF;
     token_end_ = pos_;
     return;
   }
 
-  char c = file_->at(pos_);
+  char c = at(pos_);
   switch (c) {
     case EOF:
       token_ = kEoF;
@@ -134,7 +207,7 @@ void Scanner::NextIfPossible() {
     case '=':
       token_ = kEqualSign;
       token_end_ = pos_++;
-      if (pos_ < file_->end() && file_->at(pos_) == '>') {
+      if (pos_ < contents_end_ && at(pos_) == '>') {
         token_ = kArrow;
         token_end_ = pos_++;
       }
@@ -145,9 +218,9 @@ void Scanner::NextIfPossible() {
     default:
       break;
   }
-  if (std::isalpha(c)) {
+  if (IsLetter(c)) {
     NextIdentifier();
-  } else if (c == '+' || c == '-' || std::isdigit(c)) {
+  } else if (c == '+' || c == '-' || IsDigit(c)) {
     NextNumberOrAddress();
   } else {
     pos_++;
@@ -156,7 +229,7 @@ void Scanner::NextIfPossible() {
 }
 
 void Scanner::SkipWhitespace() {
-  for (; pos_ < file_->end() && file_->at(pos_) != '\n' && std::isspace(file_->at(pos_)); pos_++) {
+  for (; pos_ < contents_end_ && at(pos_) != '\n' && IsSpace(at(pos_)); pos_++) {
   }
 }
 
@@ -164,7 +237,7 @@ void Scanner::NextIdentifier() {
   token_ = kIdentifier;
   token_start_ = pos_;
   token_end_ = pos_++;
-  for (; pos_ < file_->end() && (std::isalnum(file_->at(pos_)) || file_->at(pos_) == '_');
+  for (; pos_ < contents_end_ && (IsLetterOrDigit(at(pos_)) || at(pos_) == '_');
        token_end_ = pos_++) {
   }
 }
@@ -173,7 +246,7 @@ void Scanner::NextNumberOrAddress() {
   token_ = kNumber;
   token_start_ = pos_;
   token_end_ = pos_++;
-  for (; pos_ < file_->end() && std::isalnum(file_->at(pos_)); token_end_ = pos_++) {
+  for (; pos_ < contents_end_ && IsLetterOrDigit(at(pos_)); token_end_ = pos_++) {
   }
   if (token_text().starts_with("0x") || token_text().starts_with("0X")) {
     token_ = kAddress;
@@ -183,11 +256,11 @@ void Scanner::NextNumberOrAddress() {
 void Scanner::NextString() {
   token_ = kString;
   token_start_ = pos_++;
-  for (; pos_ < file_->end() && file_->at(pos_) != '"'; pos_++) {
-    if (file_->at(pos_) != '\\') {
+  for (; pos_ < contents_end_ && at(pos_) != '"'; pos_++) {
+    if (at(pos_) != '\\') {
       continue;
     }
-    if (pos_ + 1 < file_->end()) {
+    if (pos_ + 1 < contents_end_) {
       pos_++;
     } else {
       issue_tracker_.Add(ir_issues::IssueKind::kEOFInsteadOfEscapedCharacter, pos_,
@@ -197,7 +270,7 @@ void Scanner::NextString() {
       return;
     }
   }
-  if (pos_ == file_->end()) {
+  if (pos_ == contents_end_) {
     issue_tracker_.Add(ir_issues::IssueKind::kEOFInsteadOfStringEndQuote, {token_start_, pos_},
                        "String constant has no end quote.");
     token_ = kUnknown;
@@ -224,7 +297,7 @@ std::optional<std::string> Scanner::ConsumeIdentifier() {
     NextIfPossible();
     return std::nullopt;
   }
-  std::string identifier = token_text();
+  std::string identifier(token_text());
   Next();
   return identifier;
 }
@@ -259,7 +332,7 @@ void Scanner::AddErrorForUnexpectedToken(std::vector<Token> expected_tokens) {
       error += Scanner::TokenToString(token());
       break;
     default:
-      error += "'" + token_text() + "'";
+      error += "'" + std::string(token_text()) + "'";
       break;
   }
   issue_tracker_.Add(ir_issues::IssueKind::kUnexpectedToken, token_start_, error);
@@ -12,6 +12,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "src/common/atomics/atomics.h"
@@ -48,12 +49,18 @@ class Scanner {
   static std::string TokenToString(Token token);
 
   Scanner(common::positions::File* file, ir_issues::IssueTracker& issue_tracker)
-      : file_(file), issue_tracker_(issue_tracker), pos_(file->start()) {}
+      : contents_(file->contents()),
+        contents_start_(file->start()),
+        contents_end_(file->end()),
+        issue_tracker_(issue_tracker),
+        pos_(file->start()) {}
 
   Token token() const { return token_; }
   common::positions::pos_t token_start() const { return token_start_; }
   common::positions::pos_t token_end() const { return token_end_; }
-  std::string token_text() const;
+  // The returned view refers to the contents of the scanned file and stays valid while the file
+  // exists.
+  std::string_view token_text() const;
   common::atomics::Int token_number() const;
   common::atomics::Int token_address() const;
   std::string token_string() const;
@@ -74,7 +81,13 @@ class Scanner {
   void NextNumberOrAddress();
   void NextString();
 
-  const common::positions::File* file_;
+  char at(common::positions::pos_t pos) const { return contents_[pos - contents_start_]; }
+
+  // The scanner reads directly from the file contents to avoid a bounds checked access per
+  // character:
+  const std::string_view contents_;
+  const common::positions::pos_t contents_start_;
+  const common::positions::pos_t contents_end_;
   ir_issues::IssueTracker& issue_tracker_;
 
   common::positions::pos_t pos_;
@@ -0,0 +1,107 @@
+//
+//  scanner_benchmark.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/28/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "src/common/positions/positions.h"
+#include "src/ir/issues/issues.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/ir/serialization/scanner.h"
+
+namespace {
+
+// Generates a valid IR program with the given number of funcs, resembling lowered IR dumps.
+std::string GenerateProgram(int64_t func_count) {
+  std::stringstream ss;
+  for (int64_t i = 0; i < func_count; i++) {
+    ss << "@" << i << " f" << i << " (%0:i64, %1:ptr) => (i64) {\n"
+       << "{0}\n"
+       << "  %2:b = ilss %0, #" << 1000 + i << ":i64\n"
+       << "  jcc %2, {1}, {2}\n"
+       << "{1}\n"
+       << "  %3:i64 = load %1\n"
+       << "  %4:i64 = iadd %3, #-" << 12345 + i << ":i64\n"
+       << "  %5:ptr = poff %1, #8:i64\n"
+       << "  store %5, %4\n"
+       << "  %6:u64 = conv %4\n"
+       << "  %7:u64 = ishl %6, #3:u64\n"
+       << "  %8:b = ieq %7, #18446744073709551615:u64\n"
+       << "  jmp {2}\n"
+       << "{2}\n"
+       << "  %9:i64 = phi %0{0}, %4{1}\n"
+       << "  ret %9\n"
+       << "}\n"
+       << "\n";
+  }
+  return ss.str();
+}
+
+template <typename F>
+void Measure(std::string name, const std::string& text, int iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double megabytes = double(text.size()) * iterations / (1024 * 1024);
+  std::cout << name << ": " << megabytes / seconds << " MB/s\n";
+}
+
+}  // namespace
+
+// Measures the throughput of the IR scanner and parser. Usage:
+//   scanner_benchmark [path to .ir file | number of generated funcs] [iterations]
+int main(int argc, char* argv[]) {
+  std::string text;
+  if (argc > 1 && std::ifstream(argv[1]).good()) {
+    std::ifstream stream(argv[1]);
+    std::stringstream ss;
+    ss << stream.rdbuf();
+    text = ss.str();
+  } else {
+    text = GenerateProgram(argc > 1 ? std::atoll(argv[1]) : 100000);
+  }
+  int iterations = argc > 2 ? std::atoi(argv[2]) : 5;
+  std::cout << "input: " << double(text.size()) / (1024 * 1024) << " MB\n";
+
+  common::positions::FileSet file_set;
+  common::positions::File* file = file_set.AddFile("benchmark.ir", text);
+
+  int64_t token_count = 0;
+  Measure("scan", text, iterations, [&] {
+    ir_issues::IssueTracker issue_tracker(&file_set);
+    ir_serialization::Scanner scanner(file, issue_tracker);
+    do {
+      scanner.Next();
+      token_count++;
+      if (scanner.token() == ir_serialization::Scanner::kNumber) {
+        scanner.token_number();
+      }
+    } while (scanner.token() != ir_serialization::Scanner::kEoF);
+  });
+  std::cout << "tokens: " << token_count / iterations << "\n";
+
+  Measure("parse", text, iterations, [&] {
+    ir_issues::IssueTracker issue_tracker(&file_set);
+    std::unique_ptr<ir::Program> program = ir_serialization::ParseProgram(file, issue_tracker);
+    if (!issue_tracker.issues().empty()) {
+      std::cerr << "parsing benchmark input failed\n";
+      std::exit(1);
+    }
+  });
+  return 0;
+}
@@ -8,6 +8,8 @@
 
 #include "src/ir/serialization/scanner.h"
 
+#include <cstdint>
+#include <limits>
 #include <sstream>
 
 #include "gmock/gmock.h"
@@ -178,6 +180,36 @@ TEST(ScannerTest, ScansNegativeNumber) {
   EXPECT_THAT(issue_tracker.issues(), IsEmpty());
 }
 
+TEST(ScannerTest, ScansNumbersAtIntegerLimits) {
+  FileSet file_set;
+  File* file = file_set.AddFile("test.ir",
+                                "-9223372036854775808 9223372036854775808 "
+                                "18446744073709551615 18446744073709551616");
+  ir_issues::IssueTracker issue_tracker(&file_set);
+
+  ir_serialization::Scanner scanner(file, issue_tracker);
+
+  scanner.Next();
+  EXPECT_EQ(scanner.token_number().type(), common::atomics::IntType::kI64);
+  EXPECT_EQ(scanner.token_number().AsInt64(), std::numeric_limits<int64_t>::min());
+  EXPECT_THAT(issue_tracker.issues(), IsEmpty());
+
+  scanner.Next();
+  EXPECT_EQ(scanner.token_number().type(), common::atomics::IntType::kU64);
+  EXPECT_EQ(scanner.token_number().AsUint64(), uint64_t{9223372036854775808u});
+  EXPECT_THAT(issue_tracker.issues(), IsEmpty());
+
+  scanner.Next();
+  EXPECT_EQ(scanner.token_number().type(), common::atomics::IntType::kU64);
+  EXPECT_EQ(scanner.token_number().AsUint64(), std::numeric_limits<uint64_t>::max());
+  EXPECT_THAT(issue_tracker.issues(), IsEmpty());
+
+  scanner.Next();
+  EXPECT_EQ(scanner.token_text(), "18446744073709551616");
+  EXPECT_EQ(scanner.token_number().AsInt64(), 0);
+  EXPECT_THAT(issue_tracker.issues(), SizeIs(1));
+}
+
 TEST(ScannerTest, HandlesUnrepresentableNumber) {
   FileSet file_set;
   File* file = file_set.AddFile("test.ir", "+");
@@ -15,8 +15,9 @@
 
 namespace lang::ir_check {
 
-void CheckProgram(const ir::Program* program, ir_issues::IssueTracker& issue_tracker) {
-  ::ir_check::CheckProgram<Checker>(program, issue_tracker);
+void CheckProgram(const ir::Program* program, ir_issues::IssueTracker& issue_tracker,
+                  ::ir_check::CheckOptions options = {}) {
+  ::ir_check::CheckProgram<Checker>(program, issue_tracker, options);
 }
 
 }  // namespace lang::ir_check
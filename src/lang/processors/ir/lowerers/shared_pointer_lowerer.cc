@@ -11,6 +11,7 @@
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "src/lang/processors/ir/lowerers/shared_pointer_impl.h"
@@ -26,6 +27,303 @@ struct DecomposedShared {
   std::shared_ptr<ir::Computed> underlying_pointer;
 };
 
+bool IsSharedPointer(const ir::Value* value) {
+  return value->type()->type_kind() == ir::TypeKind::kLangSharedPointer;
+}
+
+bool IsStrongSharedPointer(const ir::Value* value) {
+  return IsSharedPointer(value) &&
+         static_cast<const ir_ext::SharedPointer*>(value->type())->is_strong();
+}
+
+bool IsComputed(const ir::Value* value, ir::value_num_t value_num) {
+  return value->kind() == ir::Value::Kind::kComputed &&
+         static_cast<const ir::Computed*>(value)->number() == value_num;
+}
+
+// Copies of shared pointers, whose ref count increments and the decrements of the matching
+// deletes can be omitted.
+struct ElidedRefCounts {
+  std::unordered_set<const ir::Instr*> copies;
+  std::unordered_set<const ir::Instr*> deletes;
+};
+
+// Finds copies of strong shared pointers that do not need their own reference, because the copied
+// pointer keeps the referenced object alive for as long as the copy gets used. Shared pointers
+// connected through movs and phis form an owner, which keeps its reference until it gets deleted,
+// passed to a call, or stored. Owners that were loaded from memory only borrow their reference,
+// which can additionally be dropped by any call, delete, or store of a pointer. A copy is elided if
+// it only gets used for loads and stores through it and its deletes, and no path leads from the
+// copy through a drop of the owner to a use of the copy. This covers pairs within a block, pairs
+// across blocks, and copies of func args, which never get dropped by the called func.
+class RefCountAnalyzer {
+ public:
+  RefCountAnalyzer(const ir::Func* func) : func_(func) {}
+
+  ElidedRefCounts FindElidedRefCounts();
+
+ private:
+  struct InstrPosition {
+    ir::block_num_t block;
+    std::size_t index;
+  };
+
+  void AddUse(ir::Instr* instr, const ir::Value* value);
+  void AddAlias(ir::value_num_t a, ir::value_num_t b);
+  ir::value_num_t OwnerOf(ir::value_num_t value_num);
+  bool IsDropOfOwner(ir::Instr* instr, ir::value_num_t value_num) const;
+  bool IsDropOfMemory(ir::Instr* instr) const;
+
+  bool CanElideCopy(ir_ext::CopySharedPointerInstr* copy_instr);
+  bool IsReachable(const ir::Instr* from, const ir::Instr* to);
+
+  const ir::Func* func_;
+  std::unordered_map<const ir::Instr*, InstrPosition> positions_;
+  std::unordered_map<ir::value_num_t, std::vector<ir::Instr*>> uses_;
+  std::unordered_map<ir::value_num_t, ir::value_num_t> owners_;
+  std::unordered_set<ir::value_num_t> loaded_values_;
+  std::unordered_map<ir::value_num_t, std::vector<ir::Instr*>> owner_drops_;
+  std::unordered_set<ir::value_num_t> borrowing_owners_;
+  std::vector<ir::Instr*> memory_drops_;
+  std::unordered_map<ir::block_num_t, std::unordered_set<ir::block_num_t>> reachable_blocks_;
+};
+
+void RefCountAnalyzer::AddUse(ir::Instr* instr, const ir::Value* value) {
+  if (value->kind() == ir::Value::Kind::kInherited) {
+    value = static_cast<const ir::InheritedValue*>(value)->value().get();
+  }
+  if (value->kind() != ir::Value::Kind::kComputed || !IsSharedPointer(value)) {
+    return;
+  }
+  std::vector<ir::Instr*>& uses = uses_[static_cast<const ir::Computed*>(value)->number()];
+  if (uses.empty() || uses.back() != instr) {
+    uses.push_back(instr);
+  }
+}
+
+void RefCountAnalyzer::AddAlias(ir::value_num_t a, ir::value_num_t b) {
+  a = OwnerOf(a);
+  b = OwnerOf(b);
+  if (a != b) {
+    owners_.insert_or_assign(a, b);
+  }
+}
+
+ir::value_num_t RefCountAnalyzer::OwnerOf(ir::value_num_t value_num) {
+  auto it = owners_.find(value_num);
+  if (it == owners_.end() || it->second == value_num) {
+    return value_num;
+  }
+  ir::value_num_t owner = OwnerOf(it->second);
+  owners_.insert_or_assign(value_num, owner);
+  return owner;
+}
+
+bool RefCountAnalyzer::IsDropOfOwner(ir::Instr* instr, ir::value_num_t value_num) const {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kLangDeleteSharedPointer:
+    case ir::InstrKind::kCall:
+      return true;
+    case ir::InstrKind::kStore:
+      return IsComputed(static_cast<ir::StoreInstr*>(instr)->value().get(), value_num);
+    default:
+      return false;
+  }
+}
+
+bool RefCountAnalyzer::IsDropOfMemory(ir::Instr* instr) const {
+  switch (instr->instr_kind()) {
+    case ir::InstrKind::kLangDeleteSharedPointer:
+    case ir::InstrKind::kLangDeleteUniquePointer:
+    case ir::InstrKind::kCall:
+      return true;
+    case ir::InstrKind::kStore: {
+      ir::TypeKind type_kind = static_cast<ir::StoreInstr*>(instr)->value()->type()->type_kind();
+      return type_kind == ir::TypeKind::kLangSharedPointer ||
+             type_kind == ir::TypeKind::kLangUniquePointer;
+    }
+    default:
+      return false;
+  }
+}
+
+ElidedRefCounts RefCountAnalyzer::FindElidedRefCounts() {
+  std::vector<ir_ext::CopySharedPointerInstr*> copy_instrs;
+  for (const std::unique_ptr<ir::Block>& block : func_->blocks()) {
+    for (std::size_t i = 0; i < block->instrs().size(); i++) {
+      ir::Instr* instr = block->instrs().at(i).get();
+      positions_.insert({instr, InstrPosition{.block = block->number(), .index = i}});
+      for (const std::shared_ptr<ir::Value>& value : instr->UsedValues()) {
+        AddUse(instr, value.get());
+      }
+      if (IsDropOfMemory(instr)) {
+        memory_drops_.push_back(instr);
+      }
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kMov: {
+          auto mov_instr = static_cast<ir::MovInstr*>(instr);
+          if (IsSharedPointer(mov_instr->result().get()) &&
+              mov_instr->origin()->kind() == ir::Value::Kind::kComputed) {
+            AddAlias(mov_instr->result()->number(),
+                     static_cast<ir::Computed*>(mov_instr->origin().get())->number());
+          }
+          break;
+        }
+        case ir::InstrKind::kPhi: {
+          auto phi_instr = static_cast<ir::PhiInstr*>(instr);
+          if (!IsSharedPointer(phi_instr->result().get())) {
+            break;
+          }
+          for (const std::shared_ptr<ir::InheritedValue>& arg : phi_instr->args()) {
+            if (arg->value()->kind() == ir::Value::Kind::kComputed) {
+              AddAlias(phi_instr->result()->number(),
+                       static_cast<ir::Computed*>(arg->value().get())->number());
+            }
+          }
+          break;
+        }
+        case ir::InstrKind::kLoad: {
+          auto load_instr = static_cast<ir::LoadInstr*>(instr);
+          if (IsSharedPointer(load_instr->result().get())) {
+            loaded_values_.insert(load_instr->result()->number());
+          }
+          break;
+        }
+        case ir::InstrKind::kLangCopySharedPointer:
+          copy_instrs.push_back(static_cast<ir_ext::CopySharedPointerInstr*>(instr));
+          break;
+        default:
+          break;
+      }
+    }
+  }
+  for (ir::value_num_t value_num : loaded_values_) {
+    borrowing_owners_.insert(OwnerOf(value_num));
+  }
+  for (auto& [value_num, uses] : uses_) {
+    ir::value_num_t owner = OwnerOf(value_num);
+    for (ir::Instr* use : uses) {
+      if (IsDropOfOwner(use, value_num)) {
+        owner_drops_[owner].push_back(use);
+      }
+    }
+  }
+
+  ElidedRefCounts elided;
+  for (ir_ext::CopySharedPointerInstr* copy_instr : copy_instrs) {
+    if (!CanElideCopy(copy_instr)) {
+      continue;
+    }
+    elided.copies.insert(copy_instr);
+    for (ir::Instr* use : uses_[copy_instr->result()->number()]) {
+      if (use->instr_kind() == ir::InstrKind::kLangDeleteSharedPointer) {
+        elided.deletes.insert(use);
+      }
+    }
+  }
+  return elided;
+}
+
+bool RefCountAnalyzer::CanElideCopy(ir_ext::CopySharedPointerInstr* copy_instr) {
+  if (!IsStrongSharedPointer(copy_instr->copied_shared_pointer().get())) {
+    return false;
+  }
+  ir::value_num_t copy = copy_instr->result()->number();
+  std::vector<ir::Instr*> accesses;
+  for (ir::Instr* use : uses_[copy]) {
+    switch (use->instr_kind()) {
+      case ir::InstrKind::kLangDeleteSharedPointer:
+        continue;
+      case ir::InstrKind::kLoad:
+        accesses.push_back(use);
+        continue;
+      case ir::InstrKind::kStore:
+        if (IsComputed(static_cast<ir::StoreInstr*>(use)->value().get(), copy)) {
+          return false;
+        }
+        accesses.push_back(use);
+        continue;
+      default:
+        return false;
+    }
+  }
+
+  ir::value_num_t owner = OwnerOf(copy_instr->copied_shared_pointer()->number());
+  std::vector<ir::Instr*> drops = owner_drops_[owner];
+  if (borrowing_owners_.contains(owner)) {
+    drops.insert(drops.end(), memory_drops_.begin(), memory_drops_.end());
+  }
+  for (ir::Instr* drop : drops) {
+    if (drop->instr_kind() == ir::InstrKind::kLangDeleteSharedPointer &&
+        static_cast<ir_ext::DeleteSharedPointerInstr*>(drop)->deleted_shared_pointer()->number() ==
+            copy) {
+      continue;
+    }
+    if (!IsReachable(copy_instr, drop)) {
+      continue;
+    }
+    for (ir::Instr* access : accesses) {
+      if (IsReachable(drop, access)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool RefCountAnalyzer::IsReachable(const ir::Instr* from, const ir::Instr* to) {
+  InstrPosition from_pos = positions_.at(from);
+  InstrPosition to_pos = positions_.at(to);
+  if (from_pos.block == to_pos.block && from_pos.index < to_pos.index) {
+    return true;
+  }
+  auto it = reachable_blocks_.find(from_pos.block);
+  if (it == reachable_blocks_.end()) {
+    std::unordered_set<ir::block_num_t> reachable;
+    std::vector<ir::block_num_t> worklist(func_->GetBlock(from_pos.block)->children().begin(),
+                                          func_->GetBlock(from_pos.block)->children().end());
+    while (!worklist.empty()) {
+      ir::block_num_t bnum = worklist.back();
+      worklist.pop_back();
+      if (!reachable.insert(bnum).second) {
+        continue;
+      }
+      for (ir::block_num_t child : func_->GetBlock(bnum)->children()) {
+        worklist.push_back(child);
+      }
+    }
+    it = reachable_blocks_.insert({from_pos.block, reachable}).first;
+  }
+  return it->second.contains(to_pos.block);
+}
+
+// Inserts the increment of the strong or weak ref count in the control block.
+void GenerateRefCountIncrement(ir::Func* func, ir::Block* block,
+                               std::vector<std::unique_ptr<ir::Instr>>::iterator& it,
+                               std::shared_ptr<ir::Computed> control_block_pointer,
+                               bool is_strong) {
+  std::shared_ptr<ir::Computed> ref_count_pointer = control_block_pointer;
+  if (!is_strong) {
+    ref_count_pointer =
+        std::make_shared<ir::Computed>(ir::pointer_type(), func->next_computed_number());
+    it = block->instrs().insert(it, std::make_unique<ir::PointerOffsetInstr>(
+                                        ref_count_pointer, control_block_pointer, ir::I64Eight()));
+    ++it;
+  }
+  auto old_ref_count = std::make_shared<ir::Computed>(ir::i64(), func->next_computed_number());
+  auto new_ref_count = std::make_shared<ir::Computed>(ir::i64(), func->next_computed_number());
+  it = block->instrs().insert(it,
+                              std::make_unique<ir::LoadInstr>(old_ref_count, ref_count_pointer));
+  ++it;
+  it = block->instrs().insert(
+      it, std::make_unique<ir::IntBinaryInstr>(new_ref_count, common::atomics::Int::BinaryOp::kAdd,
+                                               old_ref_count, ir::I64One()));
+  ++it;
+  it = block->instrs().insert(it,
+                              std::make_unique<ir::StoreInstr>(ref_count_pointer, new_ref_count));
+  ++it;
+}
+
 void LowerSharedPointerArgsOfFunc(
     ir::Func* func,
     std::unordered_map<ir::value_num_t, DecomposedShared>& decomposed_shared_pointers) {
@@ -105,7 +403,7 @@ void LowerMakeSharedPointerInstr(
 void LowerCopySharedPointerInstr(
     ir::Func* func, ir::Block* block, std::vector<std::unique_ptr<ir::Instr>>::iterator& it,
     std::unordered_map<ir::value_num_t, DecomposedShared>& decomposed_shared_pointers,
-    const SharedPointerLoweringFuncs& lowering_funcs) {
+    bool elide_ref_count) {
   auto copy_shared_instr = static_cast<ir_ext::CopySharedPointerInstr*>(it->get());
   ir::value_num_t copied_shared_pointer_num = copy_shared_instr->copied_shared_pointer()->number();
   ir::value_num_t result_shared_pointer_num = copy_shared_instr->result()->number();
@@ -116,20 +414,17 @@ void LowerCopySharedPointerInstr(
           std::make_shared<ir::Computed>(ir::pointer_type(), func->next_computed_number()),
   };
   std::shared_ptr<ir::Value> offset = copy_shared_instr->underlying_pointer_offset();
+  bool is_strong =
+      static_cast<const ir_ext::SharedPointer*>(copy_shared_instr->result()->type())->is_strong();
 
-  ir::func_num_t func_num =
-      static_cast<const ir_ext::SharedPointer*>(copy_shared_instr->result()->type())->is_strong()
-          ? lowering_funcs.strong_copy_shared_func_num
-          : lowering_funcs.weak_copy_shared_func_num;
-
-  auto call_instr = std::make_unique<ir::CallInstr>(
-      ir::ToFuncConstant(func_num),
-      std::vector<std::shared_ptr<ir::Computed>>{decomposed_result.underlying_pointer},
-      std::vector<std::shared_ptr<ir::Value>>{decomposed_copied.control_block_pointer,
-                                              decomposed_copied.underlying_pointer, offset});
-
+  // The fast path of the copy funcs in shared_pointer_impl.ir gets inlined:
   it = block->instrs().erase(it);
-  it = block->instrs().insert(it, std::move(call_instr));
+  if (!elide_ref_count) {
+    GenerateRefCountIncrement(func, block, it, decomposed_copied.control_block_pointer, is_strong);
+  }
+  it = block->instrs().insert(
+      it, std::make_unique<ir::PointerOffsetInstr>(decomposed_result.underlying_pointer,
+                                                   decomposed_copied.underlying_pointer, offset));
 
   decomposed_shared_pointers.emplace(result_shared_pointer_num, decomposed_result);
 }
@@ -430,6 +725,7 @@ void LowerSharedPointersInReturnInstr(
 
 void LowerSharedPointersInFunc(ir::Program* program, ir::Func* func,
                                const SharedPointerLoweringFuncs& lowering_funcs) {
+  const ElidedRefCounts elided_ref_counts = RefCountAnalyzer(func).FindElidedRefCounts();
   std::unordered_map<ir::value_num_t, DecomposedShared> decomposed_shared_pointers;
   std::vector<PhiInstrLoweringInfo> phi_instrs_lowering_info;
   LowerSharedPointerArgsOfFunc(func, decomposed_shared_pointers);
@@ -443,9 +739,15 @@ void LowerSharedPointersInFunc(ir::Program* program, ir::Func* func,
                                       lowering_funcs);
           break;
         case ir::InstrKind::kLangCopySharedPointer:
-          LowerCopySharedPointerInstr(func, block, it, decomposed_shared_pointers, lowering_funcs);
+          LowerCopySharedPointerInstr(
+              func, block, it, decomposed_shared_pointers,
+              /*elide_ref_count=*/elided_ref_counts.copies.contains(old_instr));
           break;
         case ir::InstrKind::kLangDeleteSharedPointer:
+          if (elided_ref_counts.deletes.contains(old_instr)) {
+            // Gets removed after lowering all other instrs.
+            continue;
+          }
           LowerDeleteSharedPointerInstr(block, it, decomposed_shared_pointers, lowering_funcs);
           break;
         case ir::InstrKind::kLoad:
@@ -484,6 +786,13 @@ void LowerSharedPointersInFunc(ir::Program* program, ir::Func* func,
   for (PhiInstrLoweringInfo& info : phi_instrs_lowering_info) {
     LowerSharedPointerArgsForPhiInstr(info, decomposed_shared_pointers);
   }
+  if (!elided_ref_counts.deletes.empty()) {
+    for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+      std::erase_if(block->instrs(), [&](const std::unique_ptr<ir::Instr>& instr) {
+        return elided_ref_counts.deletes.contains(instr.get());
+      });
+    }
+  }
 }
 
 }  // namespace
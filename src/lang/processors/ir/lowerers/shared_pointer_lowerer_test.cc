@@ -92,7 +92,11 @@ INSTANTIATE_TEST_SUITE_P(SharedPointerLowererTestInstance, SharedPointerLowererT
 @0 f (%0:i16, %5:ptr, %6:ptr, %2:b) => (ptr, ptr, ptr) {
   {0}
     %7:ptr, %8:ptr = call @2, #2:i64, #1:i64, @-1
-    %9:ptr = call @4, %5, %6, #0:i64
+    %10:ptr = poff %5, #8:i64
+    %11:i64 = load %10
+    %12:i64 = iadd %11, #1:i64
+    store %10, %12
+    %9:ptr = poff %6, #0:i64
     store %8, %0
     call @8, %5
     call @8, %5
@@ -102,10 +106,14 @@ INSTANTIATE_TEST_SUITE_P(SharedPointerLowererTestInstance, SharedPointerLowererT
 @1 g () => () {
   {42}
     %4:ptr, %5:ptr = call @2, #4:i64, #1:i64, @-1
-    %6:ptr = call @4, %4, %5, #0:i64
-    %7:ptr, %8:ptr, %3:ptr = call @0, #1234:i16, %4, %6, #t
+    %7:ptr = poff %4, #8:i64
+    %8:i64 = load %7
+    %9:i64 = iadd %8, #1:i64
+    store %7, %9
+    %6:ptr = poff %5, #0:i64
+    %10:ptr, %11:ptr, %3:ptr = call @0, #1234:i16, %4, %6, #t
     call @6, %4
-    call @6, %7
+    call @6, %10
     ret
 }
 )ir",
@@ -148,15 +156,15 @@ INSTANTIATE_TEST_SUITE_P(SharedPointerLowererTestInstance, SharedPointerLowererT
   {0}
     jcc %0, {1}, {2}
   {1}
-    %8:ptr, %9:ptr = call @1, #8:i64, #1:i64, @-1
+    %4:ptr, %5:ptr = call @1, #8:i64, #1:i64, @-1
     jmp {3}
   {2}
-    %4:ptr, %5:ptr = call @1, #8:i64, #1:i64, @-1
+    %6:ptr, %7:ptr = call @1, #8:i64, #1:i64, @-1
     jmp {3}
   {3}
-    %6:ptr = phi %8{1}, %4{2}
-    %7:ptr = phi %9{1}, %5{2}
-    ret %6, %7
+    %8:ptr = phi %4{1}, %6{2}
+    %9:ptr = phi %5{1}, %7{2}
+    ret %8, %9
 }
 )ir",
                              },
@@ -187,7 +195,10 @@ INSTANTIATE_TEST_SUITE_P(SharedPointerLowererTestInstance, SharedPointerLowererT
     %7:ptr = phi %5{0}, %8{2}
     jcc %0, {2}, {3}
   {2}
-    %8:ptr = call @2, %6, %7, #0:i64
+    %9:i64 = load %6
+    %10:i64 = iadd %9, #1:i64
+    store %6, %10
+    %8:ptr = poff %7, #0:i64
     call @5, %6
     jmp {1}
   {3}
@@ -329,6 +340,83 @@ INSTANTIATE_TEST_SUITE_P(SharedPointerLowererTestInstance, SharedPointerLowererT
     call @5, %7
     ret
 }
+)ir",
+                             },
+                             LowererTestParams{
+                                 .input_program = R"ir(
+@0 inc (%0:lshared_ptr<i64, s>) => () {
+  {0}
+    %1:lshared_ptr<i64, s> = mov %0
+    %2:lshared_ptr<i64, s> = copy_shared %1, #0:i64
+    %3:i64 = load %2
+    %4:i64 = iadd %3, #1:i64
+    store %2, %4
+    delete_shared %2
+    ret
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 inc (%5:ptr, %6:ptr) => () {
+  {0}
+    %7:ptr = poff %6, #0:i64
+    %3:i64 = load %7
+    %4:i64 = iadd %3, #1:i64
+    store %7, %4
+    ret
+}
+)ir",
+                             },
+                             LowererTestParams{
+                                 .input_program = R"ir(
+@0 f (%0:ptr, %1:b) => (i64) {
+  {0}
+    %2:lshared_ptr<i64, s> = load %0
+    %3:lshared_ptr<i64, s> = copy_shared %2, #0:i64
+    call @1
+    %4:i64 = load %3
+    delete_shared %3
+    %5:lshared_ptr<i64, s> = copy_shared %2, #0:i64
+    jcc %1, {1}, {2}
+  {1}
+    %6:i64 = load %5
+    delete_shared %5
+    ret %6
+  {2}
+    delete_shared %5
+    ret #0:i64
+}
+
+@1 g () => () {
+  {0}
+    ret
+}
+)ir",
+                                 .expected_program = R"ir(
+@0 f (%0:ptr, %1:b) => (i64) {
+  {0}
+    %7:ptr = load %0
+    %9:ptr = poff %0, #8:i64
+    %8:ptr = load %9
+    %11:i64 = load %7
+    %12:i64 = iadd %11, #1:i64
+    store %7, %12
+    %10:ptr = poff %8, #0:i64
+    call @1
+    %4:i64 = load %10
+    call @6, %7
+    %13:ptr = poff %8, #0:i64
+    jcc %1, {1}, {2}
+  {1}
+    %6:i64 = load %13
+    ret %6
+  {2}
+    ret #0:i64
+}
+
+@1 g () => () {
+  {0}
+    ret
+}
 )ir",
                              }));
 
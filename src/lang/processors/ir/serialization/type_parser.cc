@@ -17,12 +17,13 @@ using ::common::logging::fail;
 
 const ir::Type* TypeParser::ParseType() {
   if (scanner().token() == ::ir_serialization::Scanner::kIdentifier) {
-    std::string name = scanner().token_text();
+    std::string name(scanner().token_text());
     if (name == "lshared_ptr") {
       return ParseSharedPointer();
     } else if (name == "lunique_ptr") {
       return ParseUniquePointer();
     } else if (name == "lstr") {
+      scanner().ConsumeIdentifier();
       return ir_ext::string();
     } else if (name == "larray") {
       return ParseArray();
@@ -31,6 +32,7 @@ const ir::Type* TypeParser::ParseType() {
     } else if (name == "linterface") {
       return ParseInterface();
     } else if (name == "ltypeid") {
+      scanner().ConsumeIdentifier();
       return ir_ext::type_id();
     }
   }
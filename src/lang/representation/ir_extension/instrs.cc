@@ -12,6 +12,18 @@
 
 namespace lang {
 namespace ir_ext {
+namespace {
+
+std::shared_ptr<ir::Computed> ReplaceComputed(std::shared_ptr<ir::Computed> computed,
+                                              const ir::Instr::UsedValueReplacer& replacer) {
+  std::shared_ptr<ir::Value> value = replacer(computed);
+  if (value->kind() != ir::Value::Kind::kComputed) {
+    return computed;
+  }
+  return std::static_pointer_cast<ir::Computed>(value);
+}
+
+}  // namespace
 
 bool PanicInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangPanic) return false;
@@ -24,6 +36,10 @@ const ir_ext::SharedPointer* MakeSharedPointerInstr::pointer_type() const {
   return static_cast<const ir_ext::SharedPointer*>(result()->type());
 }
 
+void MakeSharedPointerInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  size_ = replacer(size_);
+}
+
 bool MakeSharedPointerInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangMakeSharedPointer) return false;
   auto that = static_cast<const MakeSharedPointerInstr&>(that_instr);
@@ -39,6 +55,11 @@ const ir_ext::SharedPointer* CopySharedPointerInstr::copy_pointer_type() const {
   return static_cast<const ir_ext::SharedPointer*>(result()->type());
 }
 
+void CopySharedPointerInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  copied_shared_pointer_ = ReplaceComputed(copied_shared_pointer_, replacer);
+  pointer_offset_ = replacer(pointer_offset_);
+}
+
 bool CopySharedPointerInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangCopySharedPointer) return false;
   auto that = static_cast<const CopySharedPointerInstr&>(that_instr);
@@ -54,6 +75,10 @@ const ir_ext::SharedPointer* DeleteSharedPointerInstr::pointer_type() const {
   return static_cast<const ir_ext::SharedPointer*>(deleted_shared_pointer_->type());
 }
 
+void DeleteSharedPointerInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  deleted_shared_pointer_ = ReplaceComputed(deleted_shared_pointer_, replacer);
+}
+
 bool DeleteSharedPointerInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangDeleteSharedPointer) return false;
   auto that = static_cast<const DeleteSharedPointerInstr&>(that_instr);
@@ -67,6 +92,10 @@ const ir_ext::UniquePointer* MakeUniquePointerInstr::pointer_type() const {
   return static_cast<const ir_ext::UniquePointer*>(result()->type());
 }
 
+void MakeUniquePointerInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  size_ = replacer(size_);
+}
+
 bool MakeUniquePointerInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangMakeUniquePointer) return false;
   auto that = static_cast<const MakeUniquePointerInstr&>(that_instr);
@@ -78,6 +107,10 @@ const ir_ext::UniquePointer* DeleteUniquePointerInstr::pointer_type() const {
   return static_cast<const ir_ext::UniquePointer*>(deleted_unique_pointer_->type());
 }
 
+void DeleteUniquePointerInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  deleted_unique_pointer_ = ReplaceComputed(deleted_unique_pointer_, replacer);
+}
+
 bool DeleteUniquePointerInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangDeleteUniquePointer) return false;
   auto that = static_cast<const DeleteUniquePointerInstr&>(that_instr);
@@ -87,6 +120,11 @@ bool DeleteUniquePointerInstr::operator==(const ir::Instr& that_instr) const {
   return true;
 }
 
+void StringIndexInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  string_operand_ = replacer(string_operand_);
+  index_operand_ = replacer(index_operand_);
+}
+
 bool StringIndexInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangStringIndex) return false;
   auto that = static_cast<const StringIndexInstr&>(that_instr);
@@ -96,6 +134,12 @@ bool StringIndexInstr::operator==(const ir::Instr& that_instr) const {
   return true;
 }
 
+void StringConcatInstr::ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) {
+  for (std::shared_ptr<ir::Value>& operand : operands_) {
+    operand = replacer(operand);
+  }
+}
+
 bool StringConcatInstr::operator==(const ir::Instr& that_instr) const {
   if (that_instr.instr_kind() != ir::InstrKind::kLangStringConcat) return false;
   auto that = static_cast<const StringConcatInstr&>(that_instr);
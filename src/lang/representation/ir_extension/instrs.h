@@ -51,6 +51,7 @@ class MakeSharedPointerInstr : public ir::Computation {
   std::shared_ptr<ir::Value> size() const { return size_; }
 
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override { return {size_}; }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangMakeSharedPointer; }
   std::string OperationString() const override { return "make_shared"; }
@@ -80,6 +81,7 @@ class CopySharedPointerInstr : public ir::Computation {
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override {
     return {copied_shared_pointer_, pointer_offset_};
   }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangCopySharedPointer; }
   std::string OperationString() const override { return "copy_shared"; }
@@ -105,6 +107,7 @@ class DeleteSharedPointerInstr : public ir::Instr {
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override {
     return {deleted_shared_pointer_};
   }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangDeleteSharedPointer; }
   std::string OperationString() const override { return "delete_shared"; }
@@ -127,6 +130,7 @@ class MakeUniquePointerInstr : public ir::Computation {
   std::shared_ptr<ir::Value> size() const { return size_; }
 
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override { return {size_}; }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangMakeUniquePointer; }
   std::string OperationString() const override { return "make_unique"; }
@@ -151,6 +155,7 @@ class DeleteUniquePointerInstr : public ir::Instr {
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override {
     return {deleted_unique_pointer_};
   }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangDeleteUniquePointer; }
   std::string OperationString() const override { return "delete_unique"; }
@@ -173,6 +178,7 @@ class StringIndexInstr : public ir::Computation {
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override {
     return {string_operand_, index_operand_};
   }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangStringIndex; }
   std::string OperationString() const override { return "str_index"; }
@@ -193,6 +199,7 @@ class StringConcatInstr : public ir::Computation {
   const std::vector<std::shared_ptr<ir::Value>>& operands() const { return operands_; }
 
   std::vector<std::shared_ptr<ir::Value>> UsedValues() const override { return operands_; }
+  void ReplaceUsedValues(const ir::Instr::UsedValueReplacer& replacer) override;
 
   ir::InstrKind instr_kind() const override { return ir::InstrKind::kLangStringConcat; }
   std::string OperationString() const override { return "str_cat"; }
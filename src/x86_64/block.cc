@@ -19,12 +19,15 @@ using ::common::data::DataView;
 
 Program* Block::program() const { return func_->program(); }
 
-int64_t Block::Encode(Linker& linker, DataView code) const {
+int64_t Block::Encode(Linker& linker, DataView code,
+                      const std::unordered_set<const Instr*>& short_jumps) const {
   linker.AddBlockAddr(block_id_, code.base());
 
   int64_t code_index = 0;
   for (auto& instr : instrs_) {
-    int8_t written_bytes = instr->Encode(linker, code.SubView(code_index));
+    int8_t written_bytes = short_jumps.contains(instr.get())
+                               ? instr->EncodeShort(linker, code.SubView(code_index))
+                               : instr->Encode(linker, code.SubView(code_index));
     if (written_bytes == -1) return -1;
     code_index += written_bytes;
   }
@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "src/common/data/data_view.h"
@@ -44,7 +45,14 @@ class Block {
     return instrs_.insert(it, std::make_unique<T>(args...));
   }
 
-  int64_t Encode(Linker& linker, common::data::DataView code) const;
+  std::vector<std::unique_ptr<Instr>>::const_iterator RemoveInstr(
+      std::vector<std::unique_ptr<Instr>>::const_iterator it) {
+    return instrs_.erase(it);
+  }
+
+  // Encodes the jumps in short_jumps with their short encoding (see Instr::EncodeShort).
+  int64_t Encode(Linker& linker, common::data::DataView code,
+                 const std::unordered_set<const Instr*>& short_jumps) const;
   std::string ToString() const;
 
  private:
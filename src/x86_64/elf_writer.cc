@@ -0,0 +1,471 @@
+//
+//  elf_writer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "elf_writer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/common/data/data_view.h"
+#include "src/common/logging/logging.h"
+#include "src/x86_64/func.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
+#include "src/x86_64/instrs/control_flow_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/instrs/instr_cond.h"
+#include "src/x86_64/machine_code/linker.h"
+#include "src/x86_64/ops.h"
+
+namespace x86_64 {
+namespace {
+
+using ::common::data::DataView;
+using ::common::logging::fail;
+
+// ELF64 constants, see the System V ABI and its AMD64 supplement.
+constexpr int64_t kElfHeaderSize = 64;
+constexpr int64_t kProgramHeaderSize = 56;
+constexpr int64_t kSectionHeaderSize = 64;
+constexpr int64_t kSymbolSize = 24;
+constexpr int64_t kRelocationSize = 24;
+
+constexpr uint16_t kTypeRelocatable = 1;
+constexpr uint16_t kTypeExecutable = 2;
+constexpr uint16_t kMachineX86_64 = 62;
+
+constexpr uint32_t kSegmentLoad = 1;
+constexpr uint32_t kSegmentGnuStack = 0x6474e551;
+constexpr uint32_t kSegmentExecute = 1;
+constexpr uint32_t kSegmentWrite = 2;
+constexpr uint32_t kSegmentRead = 4;
+
+constexpr uint32_t kSectionProgBits = 1;
+constexpr uint32_t kSectionSymTab = 2;
+constexpr uint32_t kSectionStrTab = 3;
+constexpr uint32_t kSectionRela = 4;
+constexpr uint64_t kSectionAlloc = 0x2;
+constexpr uint64_t kSectionExecInstr = 0x4;
+constexpr uint64_t kSectionInfoLink = 0x40;
+
+constexpr uint8_t kSymbolBindLocal = 0;
+constexpr uint8_t kSymbolBindGlobal = 1;
+constexpr uint8_t kSymbolTypeNone = 0;
+constexpr uint8_t kSymbolTypeFunc = 2;
+constexpr uint8_t kSymbolTypeSection = 3;
+
+constexpr uint32_t kRelocationPC32 = 2;
+constexpr uint32_t kRelocationPLT32 = 4;
+
+// Section indices in object files, matching the order in WriteObjectFile:
+constexpr uint16_t kTextSectionIndex = 1;
+constexpr uint16_t kSymTabSectionIndex = 3;
+constexpr uint16_t kStrTabSectionIndex = 4;
+
+constexpr uint64_t kExecutableBaseAddress = 0x400000;
+constexpr int64_t kFuncAlignment = 16;
+constexpr uint8_t kPaddingByte = 0xcc;  // int3
+
+class Encoder {
+ public:
+  Encoder(std::string& out) : out_(out) {}
+
+  void U8(uint8_t value) { out_.push_back(char(value)); }
+  void U16(uint16_t value) { Fixed(value, 2); }
+  void U32(uint32_t value) { Fixed(value, 4); }
+  void U64(uint64_t value) { Fixed(value, 8); }
+  void I64(int64_t value) { Fixed(uint64_t(value), 8); }
+
+  void Align(int64_t alignment) {
+    while (out_.size() % alignment != 0) {
+      U8(0);
+    }
+  }
+
+ private:
+  void Fixed(uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+      U8(uint8_t(value >> (8 * i)));
+    }
+  }
+
+  std::string& out_;
+};
+
+class StringTable {
+ public:
+  StringTable() : data_(1, '\0') {}
+
+  const std::string& data() const { return data_; }
+
+  uint32_t Add(std::string_view str) {
+    uint32_t index = uint32_t(data_.size());
+    data_ += str;
+    data_ += '\0';
+    return index;
+  }
+
+ private:
+  std::string data_;
+};
+
+struct Section {
+  std::string name;
+  uint32_t type;
+  uint64_t flags;
+  std::string data;
+  uint32_t link = 0;
+  uint32_t info = 0;
+  uint64_t alignment = 1;
+  uint64_t entry_size = 0;
+};
+
+struct EncodedFunc {
+  const Func* func;
+  int64_t offset;
+  int64_t size;
+};
+
+struct RuntimeFuncs {
+  func_num_t main_func_num;
+  const Func* start_func;
+  const Func* malloc_func;
+  const Func* free_func;
+};
+
+int64_t RoundUp(int64_t value, int64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+int64_t MaxTextSize(const Program* program) {
+  int64_t size = 0;
+  for (auto& func : program->defined_funcs()) {
+    size += kFuncAlignment + func->MaxEncodedSize();
+  }
+  return size;
+}
+
+// Encodes all defined funcs of the program into the text, starting at the given offset and
+// aligning each func to kFuncAlignment. Returns the offset after the last func.
+int64_t EncodeFuncs(const Program* program, Linker& linker, DataView text, int64_t offset,
+                    std::vector<EncodedFunc>& encoded_funcs) {
+  for (auto& func : program->defined_funcs()) {
+    offset = RoundUp(offset, kFuncAlignment);
+    int64_t size = func->Encode(linker, text.SubView(offset));
+    if (size == -1) {
+      fail("could not encode func " + func->name());
+    }
+    encoded_funcs.push_back(EncodedFunc{.func = func.get(), .offset = offset, .size = size});
+    offset += size;
+  }
+  return offset;
+}
+
+void WriteElfHeader(Encoder& encoder, uint16_t type, uint64_t entry, uint16_t program_header_count,
+                    uint64_t section_header_offset, uint16_t section_header_count,
+                    uint16_t section_name_section_index) {
+  encoder.U8(0x7f);
+  encoder.U8('E');
+  encoder.U8('L');
+  encoder.U8('F');
+  encoder.U8(2);  // 64-bit
+  encoder.U8(1);  // little endian
+  encoder.U8(1);  // ELF version
+  for (int i = 7; i < 16; i++) {
+    encoder.U8(0);  // System V ABI, padding
+  }
+  encoder.U16(type);
+  encoder.U16(kMachineX86_64);
+  encoder.U32(1);  // ELF version
+  encoder.U64(entry);
+  encoder.U64(program_header_count > 0 ? kElfHeaderSize : 0);
+  encoder.U64(section_header_offset);
+  encoder.U32(0);  // flags
+  encoder.U16(kElfHeaderSize);
+  encoder.U16(program_header_count > 0 ? kProgramHeaderSize : 0);
+  encoder.U16(program_header_count);
+  encoder.U16(section_header_count > 0 ? kSectionHeaderSize : 0);
+  encoder.U16(section_header_count);
+  encoder.U16(section_name_section_index);
+}
+
+void WriteProgramHeader(Encoder& encoder, uint32_t type, uint32_t flags, uint64_t size,
+                        uint64_t alignment) {
+  encoder.U32(type);
+  encoder.U32(flags);
+  encoder.U64(0);  // file offset
+  encoder.U64(size > 0 ? kExecutableBaseAddress : 0);
+  encoder.U64(size > 0 ? kExecutableBaseAddress : 0);
+  encoder.U64(size);  // file size
+  encoder.U64(size);  // memory size
+  encoder.U64(alignment);
+}
+
+void WriteSymbol(Encoder& encoder, uint32_t name, uint8_t bind, uint8_t type,
+                 uint16_t section_index, uint64_t value, uint64_t size) {
+  encoder.U32(name);
+  encoder.U8(uint8_t(bind << 4) | type);
+  encoder.U8(0);  // default visibility
+  encoder.U16(section_index);
+  encoder.U64(value);
+  encoder.U64(size);
+}
+
+// Writes the sections, followed by the section header table and a section containing the section
+// names. The section indices are one-based, index zero is the null section.
+std::string WriteRelocatableFile(std::vector<Section>& sections) {
+  sections.push_back(Section{
+      .name = ".shstrtab",
+      .type = kSectionStrTab,
+      .flags = 0,
+  });
+  StringTable section_names;
+  std::vector<uint32_t> section_name_indices;
+  for (const Section& section : sections) {
+    section_name_indices.push_back(section_names.Add(section.name));
+  }
+  sections.back().data = section_names.data();
+
+  std::string out;
+  Encoder encoder(out);
+  out.resize(kElfHeaderSize);
+  std::vector<uint64_t> section_offsets;
+  for (const Section& section : sections) {
+    encoder.Align(std::max(section.alignment, uint64_t{1}));
+    section_offsets.push_back(out.size());
+    out += section.data;
+  }
+  encoder.Align(8);
+  uint64_t section_header_offset = out.size();
+  for (int i = 0; i < kSectionHeaderSize; i++) {
+    encoder.U8(0);  // null section
+  }
+  for (std::size_t i = 0; i < sections.size(); i++) {
+    const Section& section = sections.at(i);
+    encoder.U32(section_name_indices.at(i));
+    encoder.U32(section.type);
+    encoder.U64(section.flags);
+    encoder.U64(0);  // address
+    encoder.U64(section_offsets.at(i));
+    encoder.U64(section.data.size());
+    encoder.U32(section.link);
+    encoder.U32(section.info);
+    encoder.U64(section.alignment);
+    encoder.U64(section.entry_size);
+  }
+
+  std::string header;
+  Encoder header_encoder(header);
+  WriteElfHeader(header_encoder, kTypeRelocatable, /*entry=*/0, /*program_header_count=*/0,
+                 section_header_offset, /*section_header_count=*/uint16_t(sections.size() + 1),
+                 /*section_name_section_index=*/uint16_t(sections.size()));
+  out.replace(0, kElfHeaderSize, header);
+  return out;
+}
+
+// Builds the funcs executables need in place of a C runtime. The funcs follow the System V calling
+// convention and only use the raw Linux syscall interface.
+RuntimeFuncs BuildRuntime(Program* runtime) {
+  RuntimeFuncs runtime_funcs;
+  runtime_funcs.main_func_num = runtime->DeclareFunc("main");
+
+  // _start: calls main and exits with its result.
+  Func* start_func = runtime->DefineFunc("_start");
+  Block* start_block = start_func->AddBlock();
+  start_block->AddInstr<Call>(FuncRef(runtime_funcs.main_func_num));
+  start_block->AddInstr<Mov>(edi, eax);
+  start_block->AddInstr<Mov>(eax, Imm(int32_t{60}));  // exit
+  start_block->AddInstr<Syscall>();
+  runtime_funcs.start_func = start_func;
+
+  // malloc: maps the requested size plus an 8 byte header, storing the mapping size in the header.
+  Func* malloc_func = runtime->DefineFunc("malloc");
+  Block* malloc_block = malloc_func->AddBlock();
+  malloc_block->AddInstr<Lea>(rsi, Mem(Size::k64, /*base_reg=*/uint8_t(rdi.reg()), 8));
+  malloc_block->AddInstr<Xor>(edi, edi);
+  malloc_block->AddInstr<Mov>(edx, Imm(int32_t{0x3}));    // PROT_READ | PROT_WRITE
+  malloc_block->AddInstr<Mov>(r10d, Imm(int32_t{0x22}));  // MAP_PRIVATE | MAP_ANONYMOUS
+  malloc_block->AddInstr<Mov>(r8, Imm(int32_t{-1}));
+  malloc_block->AddInstr<Xor>(r9d, r9d);
+  malloc_block->AddInstr<Mov>(eax, Imm(int32_t{9}));  // mmap
+  malloc_block->AddInstr<Syscall>();
+  malloc_block->AddInstr<Mov>(Mem(Size::k64, /*base_reg=*/uint8_t(rax.reg())), rsi);
+  malloc_block->AddInstr<Add>(rax, Imm(int8_t{8}));
+  malloc_block->AddInstr<Ret>();
+  runtime_funcs.malloc_func = malloc_func;
+
+  // free: unmaps the mapping created by malloc, ignoring nil pointers.
+  Func* free_func = runtime->DefineFunc("free");
+  Block* free_check_block = free_func->AddBlock();
+  Block* free_unmap_block = free_func->AddBlock();
+  Block* free_ret_block = free_func->AddBlock();
+  free_check_block->AddInstr<Test>(rdi, rdi);
+  free_check_block->AddInstr<Jcc>(InstrCond::kZero, free_ret_block->GetBlockRef());
+  free_unmap_block->AddInstr<Lea>(rdi, Mem(Size::k64, /*base_reg=*/uint8_t(rdi.reg()), -8));
+  free_unmap_block->AddInstr<Mov>(rsi, Mem(Size::k64, /*base_reg=*/uint8_t(rdi.reg())));
+  free_unmap_block->AddInstr<Mov>(eax, Imm(int32_t{11}));  // munmap
+  free_unmap_block->AddInstr<Syscall>();
+  free_ret_block->AddInstr<Ret>();
+  runtime_funcs.free_func = free_func;
+
+  return runtime_funcs;
+}
+
+}  // namespace
+
+std::string WriteObjectFile(const Program* program) {
+  std::string text(MaxTextSize(program), char(kPaddingByte));
+  DataView text_view((uint8_t*)text.data(), int64_t(text.size()));
+  Linker linker;
+  std::vector<EncodedFunc> encoded_funcs;
+  int64_t text_size = EncodeFuncs(program, linker, text_view, /*offset=*/0, encoded_funcs);
+  std::vector<Linker::FuncPatch> unresolved_patches = linker.ApplyResolvablePatches();
+
+  StringTable symbol_names;
+  std::string symbols;
+  Encoder symbol_encoder(symbols);
+  WriteSymbol(symbol_encoder, /*name=*/0, kSymbolBindLocal, kSymbolTypeNone, /*section_index=*/0,
+              /*value=*/0, /*size=*/0);
+  WriteSymbol(symbol_encoder, /*name=*/0, kSymbolBindLocal, kSymbolTypeSection, kTextSectionIndex,
+              /*value=*/0, /*size=*/0);
+  const uint32_t first_global_symbol_index = 2;
+  for (const EncodedFunc& encoded_func : encoded_funcs) {
+    WriteSymbol(symbol_encoder, symbol_names.Add(encoded_func.func->name()), kSymbolBindGlobal,
+                kSymbolTypeFunc, kTextSectionIndex, encoded_func.offset, encoded_func.size);
+  }
+  std::vector<std::pair<func_num_t, std::string>> declared_funcs;
+  for (auto& [name, func_num] : program->declared_funcs()) {
+    declared_funcs.push_back({func_num, name});
+  }
+  std::sort(declared_funcs.begin(), declared_funcs.end());
+  std::unordered_map<func_num_t, uint32_t> declared_func_symbol_indices;
+  for (auto& [func_num, name] : declared_funcs) {
+    declared_func_symbol_indices[func_num] = uint32_t(symbols.size() / kSymbolSize);
+    WriteSymbol(symbol_encoder, symbol_names.Add(name), kSymbolBindGlobal, kSymbolTypeNone,
+                /*section_index=*/0, /*value=*/0, /*size=*/0);
+  }
+
+  std::string relocations;
+  Encoder relocation_encoder(relocations);
+  for (const Linker::FuncPatch& patch : unresolved_patches) {
+    auto it = declared_func_symbol_indices.find(patch.func_ref.func_id());
+    if (it == declared_func_symbol_indices.end()) {
+      fail("program references unknown func " + patch.func_ref.ToString());
+    }
+    uint64_t symbol_index = it->second;
+    relocation_encoder.U64(uint64_t(patch.patch_data_view.base() - text_view.base()));
+    // Calls and jumps may go through a PLT entry, but addresses have to refer to the func itself:
+    uint32_t relocation_type = (patch.kind == Linker::FuncRefKind::kCallOrJumpTarget)
+                                   ? kRelocationPLT32
+                                   : kRelocationPC32;
+    relocation_encoder.U64((symbol_index << 32) | relocation_type);
+    relocation_encoder.I64(-4);  // the displacement is relative to the end of the patched field
+  }
+  text.resize(text_size);
+
+  std::vector<Section> sections{
+      Section{
+          .name = ".text",
+          .type = kSectionProgBits,
+          .flags = kSectionAlloc | kSectionExecInstr,
+          .data = text,
+          .alignment = uint64_t(kFuncAlignment),
+      },
+      Section{
+          .name = ".rela.text",
+          .type = kSectionRela,
+          .flags = kSectionInfoLink,
+          .data = relocations,
+          .link = kSymTabSectionIndex,
+          .info = kTextSectionIndex,
+          .alignment = 8,
+          .entry_size = kRelocationSize,
+      },
+      Section{
+          .name = ".symtab",
+          .type = kSectionSymTab,
+          .flags = 0,
+          .data = symbols,
+          .link = kStrTabSectionIndex,
+          .info = first_global_symbol_index,
+          .alignment = 8,
+          .entry_size = kSymbolSize,
+      },
+      Section{
+          .name = ".strtab",
+          .type = kSectionStrTab,
+          .flags = 0,
+          .data = symbol_names.data(),
+      },
+      // Marks the stack as non-executable.
+      Section{
+          .name = ".note.GNU-stack",
+          .type = kSectionProgBits,
+          .flags = 0,
+      },
+  };
+  return WriteRelocatableFile(sections);
+}
+
+std::string WriteExecutable(const Program* program) {
+  const Func* main_func = program->DefinedFuncWithName("main");
+  if (main_func == nullptr) {
+    fail("program has no main func");
+  }
+  Program runtime;
+  RuntimeFuncs runtime_funcs = BuildRuntime(&runtime);
+
+  // The executable consists of a single segment containing the headers, the runtime, and the
+  // program.
+  constexpr int64_t kHeadersSize = kElfHeaderSize + 2 * kProgramHeaderSize;
+  std::string image(kHeadersSize + MaxTextSize(&runtime) + MaxTextSize(program),
+                    char(kPaddingByte));
+  DataView image_view((uint8_t*)image.data(), int64_t(image.size()));
+  Linker runtime_linker;
+  Linker linker;
+  std::vector<EncodedFunc> encoded_funcs;
+  int64_t offset = EncodeFuncs(&runtime, runtime_linker, image_view, kHeadersSize, encoded_funcs);
+  offset = EncodeFuncs(program, linker, image_view, offset, encoded_funcs);
+
+  runtime_linker.AddFuncAddr(runtime_funcs.main_func_num,
+                             linker.func_addrs().at(main_func->func_num()));
+  for (auto& [name, func_num] : program->declared_funcs()) {
+    if (name == "malloc") {
+      linker.AddFuncAddr(func_num,
+                         runtime_linker.func_addrs().at(runtime_funcs.malloc_func->func_num()));
+    } else if (name == "free") {
+      linker.AddFuncAddr(func_num,
+                         runtime_linker.func_addrs().at(runtime_funcs.free_func->func_num()));
+    }
+  }
+  runtime_linker.ApplyPatches();
+  if (!linker.ApplyResolvablePatches().empty()) {
+    fail("program references funcs that are not available in executables");
+  }
+  uint64_t entry = kExecutableBaseAddress +
+                   (runtime_linker.func_addrs().at(runtime_funcs.start_func->func_num()) -
+                    image_view.base());
+  image.resize(offset);
+
+  std::string headers;
+  Encoder encoder(headers);
+  WriteElfHeader(encoder, kTypeExecutable, entry, /*program_header_count=*/2,
+                 /*section_header_offset=*/0, /*section_header_count=*/0,
+                 /*section_name_section_index=*/0);
+  WriteProgramHeader(encoder, kSegmentLoad, kSegmentRead | kSegmentExecute, image.size(),
+                     /*alignment=*/0x1000);
+  WriteProgramHeader(encoder, kSegmentGnuStack, kSegmentRead | kSegmentWrite, /*size=*/0,
+                     /*alignment=*/16);
+  image.replace(0, kHeadersSize, headers);
+  return image;
+}
+
+}  // namespace x86_64
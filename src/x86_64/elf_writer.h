@@ -0,0 +1,30 @@
+//
+//  elf_writer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef x86_64_elf_writer_h
+#define x86_64_elf_writer_h
+
+#include <string>
+
+#include "src/x86_64/program.h"
+
+namespace x86_64 {
+
+// Returns a relocatable ELF64 object file containing the program. Each defined func becomes a
+// global symbol in the .text section. References to declared funcs (malloc and free) become
+// relocations against undefined symbols, which get resolved by the system linker.
+std::string WriteObjectFile(const Program* program);
+
+// Returns a statically linked ELF64 executable for Linux without any dependencies. A minimal
+// _start stub calls main and exits with its result. malloc and free get implemented with the mmap
+// and munmap syscalls.
+std::string WriteExecutable(const Program* program);
+
+}  // namespace x86_64
+
+#endif /* x86_64_elf_writer_h */
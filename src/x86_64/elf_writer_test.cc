@@ -0,0 +1,164 @@
+//
+//  elf_writer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/x86_64/elf_writer.h"
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/ir/analyzers/interference_graph_builder.h"
+#include "src/ir/analyzers/live_range_analyzer.h"
+#include "src/ir/info/func_live_ranges.h"
+#include "src/ir/info/interference_graph.h"
+#include "src/ir/processors/phi_resolver.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/x86_64/block.h"
+#include "src/x86_64/func.h"
+#include "src/x86_64/instrs/control_flow_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/ir_translator/ir_translator.h"
+#include "src/x86_64/ops.h"
+#include "src/x86_64/program.h"
+
+namespace x86_64 {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+constexpr std::string_view kProgram = R"ir(
+@0 main () => (i64) {
+{0}
+  %0:ptr = malloc #16:i64
+  store %0, #40:i64
+  %1:i64 = call @1, %0
+  free %0
+  ret %1
+}
+
+@1 load_and_add_two (%0:ptr) => (i64) {
+{0}
+  %1:i64 = load %0
+  %2:i64 = iadd %1, #2:i64
+  ret %2
+}
+)ir";
+
+std::unique_ptr<Program> TranslateProgram(std::string_view text) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(std::string(text));
+  std::unordered_map<ir::func_num_t, const ir_info::FuncLiveRanges> live_ranges;
+  std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph> interference_graphs;
+  for (auto& func : ir_program->funcs()) {
+    const ir_info::FuncLiveRanges func_live_ranges =
+        ir_analyzers::FindLiveRangesForFunc(func.get());
+    live_ranges.insert({func->number(), func_live_ranges});
+    interference_graphs.insert(
+        {func->number(),
+         ir_analyzers::BuildInterferenceGraphForFunc(func.get(), func_live_ranges)});
+    ir_processors::ResolvePhisInFunc(func.get());
+  }
+  return ir_to_x86_64_translator::Translate(ir_program.get(), live_ranges, interference_graphs,
+                                            /*generate_debug_info=*/false)
+      .program;
+}
+
+uint16_t ReadU16(const std::string& data, int64_t offset) {
+  return uint16_t(uint8_t(data.at(offset))) | uint16_t(uint8_t(data.at(offset + 1))) << 8;
+}
+
+uint32_t ReadU32(const std::string& data, int64_t offset) {
+  return uint32_t(ReadU16(data, offset)) | uint32_t(ReadU16(data, offset + 2)) << 16;
+}
+
+uint64_t ReadU64(const std::string& data, int64_t offset) {
+  return uint64_t(ReadU32(data, offset)) | uint64_t(ReadU32(data, offset + 4)) << 32;
+}
+
+TEST(ElfWriterTest, WritesObjectFile) {
+  std::unique_ptr<Program> program = TranslateProgram(kProgram);
+  std::string object_file = WriteObjectFile(program.get());
+
+  ASSERT_GE(object_file.size(), 64);
+  EXPECT_EQ(object_file.substr(0, 4), "\x7f"
+                                      "ELF");
+  EXPECT_EQ(ReadU16(object_file, 0x10), 1);   // relocatable
+  EXPECT_EQ(ReadU16(object_file, 0x12), 62);  // x86-64
+  EXPECT_EQ(ReadU16(object_file, 0x3c), 7);   // section count
+  EXPECT_THAT(object_file, HasSubstr(std::string("main\0", 5)));
+  EXPECT_THAT(object_file, HasSubstr(std::string("load_and_add_two\0", 17)));
+  EXPECT_THAT(object_file, HasSubstr(std::string("malloc\0", 7)));
+  EXPECT_THAT(object_file, HasSubstr(std::string("free\0", 5)));
+  EXPECT_THAT(object_file, HasSubstr(std::string(".rela.text\0", 11)));
+}
+
+TEST(ElfWriterTest, WritesPC32RelocationsForFuncAddresses) {
+  Program program;
+  func_num_t callback = program.DeclareFunc("callback");
+  Block* block = program.DefineFunc("main")->AddBlock();
+  block->AddInstr<Mov>(rax, FuncRef(callback));
+  block->AddInstr<Call>(FuncRef(callback));
+  block->AddInstr<Jmp>(FuncRef(callback));
+  std::string object_file = WriteObjectFile(&program);
+
+  // Finds the relocations in the .rela.text section:
+  uint64_t section_headers_offset = ReadU64(object_file, 0x28);
+  uint16_t section_header_size = ReadU16(object_file, 0x3a);
+  uint16_t section_count = ReadU16(object_file, 0x3c);
+  std::vector<uint32_t> relocation_types;
+  for (uint16_t i = 0; i < section_count; i++) {
+    uint64_t section_header = section_headers_offset + i * section_header_size;
+    if (ReadU32(object_file, section_header + 0x04) != 4) {  // SHT_RELA
+      continue;
+    }
+    uint64_t offset = ReadU64(object_file, section_header + 0x18);
+    uint64_t size = ReadU64(object_file, section_header + 0x20);
+    for (uint64_t relocation = offset; relocation < offset + size; relocation += 24) {
+      relocation_types.push_back(ReadU32(object_file, relocation + 0x08));
+    }
+  }
+  EXPECT_THAT(relocation_types, ElementsAre(2, 4, 4));  // R_X86_64_PC32, R_X86_64_PLT32 (twice)
+}
+
+TEST(ElfWriterTest, WritesExecutable) {
+  std::unique_ptr<Program> program = TranslateProgram(kProgram);
+  std::string executable = WriteExecutable(program.get());
+
+  ASSERT_GE(executable.size(), 64);
+  EXPECT_EQ(executable.substr(0, 4), "\x7f"
+                                     "ELF");
+  EXPECT_EQ(ReadU16(executable, 0x10), 2);  // executable
+  EXPECT_EQ(ReadU16(executable, 0x38), 2);  // program header count
+
+#ifdef __linux__
+  std::string path = ::testing::TempDir() + "elf_writer_test_executable";
+  {
+    std::ofstream stream(path, std::ios::out | std::ios::binary);
+    stream << executable;
+  }
+  ASSERT_EQ(chmod(path.c_str(), S_IRWXU), 0);
+  int status = std::system(path.c_str());
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 42);
+  unlink(path.c_str());
+#endif
+}
+
+}  // namespace
+}  // namespace x86_64
@@ -8,7 +8,11 @@
 
 #include "func.h"
 
+#include <cstdint>
+#include <optional>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 
 #include "src/x86_64/program.h"
 
@@ -21,18 +25,103 @@ Block* Func::AddBlock() {
   return blocks_.emplace_back(new Block(this, block_num)).get();
 }
 
+int64_t Func::MaxEncodedSize() const {
+  int64_t size = 0;
+  for (auto& block : blocks_) {
+    size += int64_t(block->instrs().size()) * kMaxInstrSize;
+  }
+  return size;
+}
+
 int64_t Func::Encode(Linker& linker, DataView code) const {
+  std::unordered_set<const Instr*> short_jumps = FindShortJumps();
+
   linker.AddFuncAddr(func_num_, code.base());
 
   int64_t code_index = 0;
   for (auto& block : blocks_) {
-    int64_t written_bytes = block->Encode(linker, code.SubView(code_index));
+    int64_t written_bytes = block->Encode(linker, code.SubView(code_index), short_jumps);
     if (written_bytes == -1) return -1;
     code_index += written_bytes;
   }
   return code_index;
 }
 
+std::unordered_set<const Instr*> Func::FindShortJumps() const {
+  struct Jump {
+    const Instr* instr;
+    BlockRef dst;
+    std::size_t block_index;
+    std::size_t instr_index;
+    int8_t long_size;
+    int8_t short_size;
+  };
+  std::vector<std::vector<int8_t>> instr_sizes;
+  std::vector<Jump> jumps;
+  std::unordered_map<block_num_t, std::size_t> block_indices;
+
+  // Determine the size of each instr by encoding it into a scratch buffer.
+  uint8_t scratch[kMaxInstrSize];
+  Linker scratch_linker;
+  DataView scratch_view(scratch, kMaxInstrSize);
+  for (std::size_t block_index = 0; block_index < blocks_.size(); block_index++) {
+    const Block* block = blocks_.at(block_index).get();
+    block_indices[block->block_num()] = block_index;
+    std::vector<int8_t>& block_instr_sizes = instr_sizes.emplace_back();
+    for (std::size_t instr_index = 0; instr_index < block->instrs().size(); instr_index++) {
+      const Instr* instr = block->instrs().at(instr_index).get();
+      int8_t long_size = instr->Encode(scratch_linker, scratch_view);
+      block_instr_sizes.push_back(long_size);
+      std::optional<BlockRef> dst = instr->ShortEncodingDst();
+      if (dst.has_value() && long_size != -1) {
+        jumps.push_back(Jump{
+            .instr = instr,
+            .dst = *dst,
+            .block_index = block_index,
+            .instr_index = instr_index,
+            .long_size = long_size,
+            .short_size = instr->EncodeShort(scratch_linker, scratch_view),
+        });
+      }
+    }
+  }
+
+  // Start with all jumps in the short encoding and switch jumps to the long encoding while their
+  // destinations are out of range. Switching only increases displacements, so this converges.
+  std::unordered_set<const Instr*> short_jumps;
+  for (const Jump& jump : jumps) {
+    if (jump.short_size != -1 && block_indices.contains(jump.dst.block_id())) {
+      short_jumps.insert(jump.instr);
+      instr_sizes.at(jump.block_index).at(jump.instr_index) = jump.short_size;
+    }
+  }
+  for (bool changed = true; changed;) {
+    changed = false;
+    std::vector<int64_t> block_offsets;
+    int64_t offset = 0;
+    for (const std::vector<int8_t>& block_instr_sizes : instr_sizes) {
+      block_offsets.push_back(offset);
+      for (int8_t size : block_instr_sizes) {
+        offset += size;
+      }
+    }
+    for (const Jump& jump : jumps) {
+      if (!short_jumps.contains(jump.instr)) continue;
+      int64_t jump_end = block_offsets.at(jump.block_index);
+      for (std::size_t i = 0; i <= jump.instr_index; i++) {
+        jump_end += instr_sizes.at(jump.block_index).at(i);
+      }
+      int64_t displacement = block_offsets.at(block_indices.at(jump.dst.block_id())) - jump_end;
+      if (displacement < INT8_MIN || displacement > INT8_MAX) {
+        short_jumps.erase(jump.instr);
+        instr_sizes.at(jump.block_index).at(jump.instr_index) = jump.long_size;
+        changed = true;
+      }
+    }
+  }
+  return short_jumps;
+}
+
 std::string Func::ToString() const {
   std::stringstream ss;
   ss << name_ << ": ; <" << func_num_ << ">\n";
@@ -11,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "src/common/data/data_view.h"
@@ -34,6 +35,9 @@ class Func {
 
   Block* AddBlock();
 
+  // Returns an upper bound for the number of bytes Encode writes.
+  int64_t MaxEncodedSize() const;
+  // Encodes jumps between blocks of the func with 8-bit displacements where possible.
   int64_t Encode(Linker& linker, common::data::DataView code) const;
   std::string ToString() const;
 
@@ -41,6 +45,9 @@ class Func {
   Func(Program* program, func_num_t func_num, std::string name)
       : program_(program), func_num_(func_num), name_(name) {}
 
+  // Returns the jumps whose destination is in range for the short encoding.
+  std::unordered_set<const Instr*> FindShortJumps() const;
+
   Program* program_;
   func_num_t func_num_;
   std::string name_;
@@ -0,0 +1,98 @@
+//
+//  func_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/6/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/x86_64/func.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/common/data/data_view.h"
+#include "src/x86_64/block.h"
+#include "src/x86_64/instrs/control_flow_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/machine_code/linker.h"
+#include "src/x86_64/ops.h"
+#include "src/x86_64/program.h"
+
+namespace x86_64 {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::vector<uint8_t> Encode(const Func* func) {
+  std::vector<uint8_t> code(1024, 0);
+  Linker linker;
+  int64_t size = func->Encode(linker, common::data::DataView(code.data(), code.size()));
+  linker.ApplyPatches();
+  code.resize(size);
+  return code;
+}
+
+// Adds instrs with a total size of the given (even) number of bytes.
+void AddFiller(Block* block, int64_t size) {
+  for (int64_t i = 0; i < size; i += 2) {
+    block->AddInstr<Mov>(eax, ecx);
+  }
+}
+
+TEST(FuncTest, EncodesNearJumpsShort) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block_a = func->AddBlock();
+  Block* block_b = func->AddBlock();
+  Block* block_c = func->AddBlock();
+  block_a->AddInstr<Jcc>(InstrCond::kZero, block_c->GetBlockRef());
+  block_b->AddInstr<Jmp>(block_a->GetBlockRef());
+  block_c->AddInstr<Ret>();
+
+  EXPECT_THAT(Encode(func), ElementsAre(0x74, 0x02, 0xeb, 0xfc, 0xc3));
+}
+
+TEST(FuncTest, EncodesFarJumpsLong) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block_a = func->AddBlock();
+  Block* block_b = func->AddBlock();
+  Block* block_c = func->AddBlock();
+  block_a->AddInstr<Jcc>(InstrCond::kZero, block_c->GetBlockRef());
+  AddFiller(block_b, 128);
+  block_b->AddInstr<Jmp>(block_a->GetBlockRef());
+  block_c->AddInstr<Ret>();
+
+  std::vector<uint8_t> code = Encode(func);
+  ASSERT_EQ(code.size(), 6 + 128 + 5 + 1);
+  EXPECT_THAT(std::vector<uint8_t>(code.begin(), code.begin() + 6),
+              ElementsAre(0x0f, 0x84, 0x85, 0x00, 0x00, 0x00));
+  EXPECT_THAT(std::vector<uint8_t>(code.begin() + 134, code.end()),
+              ElementsAre(0xe9, 0x75, 0xff, 0xff, 0xff, 0xc3));
+}
+
+TEST(FuncTest, RelaxesJumpsUntilConvergence) {
+  // The jump in block A is only out of range once the jump in block B uses the long encoding.
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block_a = func->AddBlock();
+  Block* block_b = func->AddBlock();
+  Block* block_c = func->AddBlock();
+  Block* block_d = func->AddBlock();
+  block_a->AddInstr<Jmp>(block_c->GetBlockRef());
+  block_b->AddInstr<Jmp>(block_d->GetBlockRef());
+  AddFiller(block_b, 124);
+  AddFiller(block_c, 4);
+  block_d->AddInstr<Ret>();
+
+  std::vector<uint8_t> code = Encode(func);
+  ASSERT_EQ(code.size(), 5 + 5 + 124 + 4 + 1);
+  EXPECT_THAT(std::vector<uint8_t>(code.begin(), code.begin() + 10),
+              ElementsAre(0xe9, 0x81, 0x00, 0x00, 0x00, 0xe9, 0x80, 0x00, 0x00, 0x00));
+}
+
+}  // namespace
+}  // namespace x86_64
@@ -110,6 +110,40 @@ int8_t BinaryALInstr::Encode(Linker&, DataView code) const {
   return encoder.size();
 }
 
+ShiftInstr::ShiftInstr(RM op, Imm count) : op_(op), count_(count) {
+  if (count.size() != Size::k8) fail("unsupported imm size");
+}
+
+ShiftInstr::ShiftInstr(RM op, Reg count) : op_(op), count_(count) {
+  if (count != cl) fail("expected cl as shift count register");
+}
+
+int8_t ShiftInstr::Encode(Linker&, DataView code) const {
+  InstrEncoder encoder(code);
+
+  encoder.EncodeOperandSize(op_.size());
+  if (op_.RequiresREX()) {
+    encoder.EncodeREX();
+  }
+
+  bool is_8bit = (op_.size() == Size::k8);
+  bool is_shift_by_one = count_.is_imm() && count_.imm().value() == 1;
+  if (count_.is_reg()) {
+    encoder.EncodeOpcode(is_8bit ? 0xd2 : 0xd3);
+  } else if (is_shift_by_one) {
+    encoder.EncodeOpcode(is_8bit ? 0xd0 : 0xd1);
+  } else {
+    encoder.EncodeOpcode(is_8bit ? 0xc0 : 0xc1);
+  }
+  encoder.EncodeOpcodeExt(OpcodeExt());
+  encoder.EncodeRM(op_);
+  if (count_.is_imm() && !is_shift_by_one) {
+    encoder.EncodeImm(count_.imm());
+  }
+
+  return encoder.size();
+}
+
 uint8_t Not::Opcode() const { return (op().size() == Size::k8) ? 0xf6 : 0xf7; }
 
 uint8_t Not::OpcodeExt() const { return 2; }
@@ -505,4 +539,16 @@ int8_t Test::Encode(Linker&, DataView code) const {
 
 std::string Test::ToString() const { return "test " + op_a_.ToString() + "," + op_b_.ToString(); }
 
+uint8_t Shl::OpcodeExt() const { return 4; }
+
+std::string Shl::ToString() const { return "shl " + op().ToString() + "," + count().ToString(); }
+
+uint8_t Shr::OpcodeExt() const { return 5; }
+
+std::string Shr::ToString() const { return "shr " + op().ToString() + "," + count().ToString(); }
+
+uint8_t Sar::OpcodeExt() const { return 7; }
+
+std::string Sar::ToString() const { return "sar " + op().ToString() + "," + count().ToString(); }
+
 }  // namespace x86_64
@@ -67,10 +67,30 @@ class BinaryALInstr : public Instr {
   Operand op_b_;
 };
 
+class ShiftInstr : public Instr {
+ public:
+  ShiftInstr(RM op, Imm count);
+  ShiftInstr(RM op, Reg count);
+  virtual ~ShiftInstr() override {}
+
+  RM op() const { return op_; }
+  Operand count() const { return count_; }
+
+  int8_t Encode(Linker& linker, common::data::DataView code) const override;
+
+ protected:
+  virtual uint8_t OpcodeExt() const = 0;
+
+ private:
+  RM op_;
+  Operand count_;
+};
+
 class Not final : public UnaryALInstr {
  public:
   using UnaryALInstr::UnaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kNot; }
   std::string ToString() const override;
 
  private:
@@ -82,6 +102,7 @@ class And final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kAnd; }
   std::string ToString() const override;
 
  private:
@@ -93,6 +114,7 @@ class Or final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kOr; }
   std::string ToString() const override;
 
  private:
@@ -104,6 +126,7 @@ class Xor final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kXor; }
   std::string ToString() const override;
 
  private:
@@ -115,6 +138,7 @@ class Neg final : public UnaryALInstr {
  public:
   using UnaryALInstr::UnaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kNeg; }
   std::string ToString() const override;
 
  private:
@@ -126,6 +150,7 @@ class Add final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kAdd; }
   std::string ToString() const override;
 
  private:
@@ -137,6 +162,7 @@ class Adc final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kAdc; }
   std::string ToString() const override;
 
  private:
@@ -148,6 +174,7 @@ class Sub final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kSub; }
   std::string ToString() const override;
 
  private:
@@ -159,6 +186,7 @@ class Sbb final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kSbb; }
   std::string ToString() const override;
 
  private:
@@ -170,6 +198,7 @@ class Cmp final : public BinaryALInstr {
  public:
   using BinaryALInstr::BinaryALInstr;
 
+  InstrKind instr_kind() const override { return InstrKind::kCmp; }
   std::string ToString() const override;
 
  private:
@@ -183,6 +212,7 @@ class Mul final : public Instr {
 
   RM factor() const { return factor_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kMul; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -200,6 +230,7 @@ class Imul final : public Instr {
   RM factor_b() const { return factor_b_; }
   Imm factor_c() const { return factor_c_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kImul; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -225,6 +256,7 @@ class Div final : public Instr {
 
   RM divisor() const { return divisor_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kDiv; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -238,6 +270,7 @@ class Idiv final : public Instr {
 
   RM divisor() const { return divisor_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kIdiv; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -251,6 +284,7 @@ class SignExtendRegA final : public Instr {
 
   Size op_size() const { return op_size_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kSignExtendRegA; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -259,10 +293,12 @@ class SignExtendRegA final : public Instr {
 };
 
 class SignExtendRegAD final : public Instr {
+ public:
   SignExtendRegAD(Size op_size);
 
   Size op_size() const { return op_size_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kSignExtendRegAD; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -278,6 +314,7 @@ class Test final : public Instr {
   RM op_a() const { return op_a_; }
   Operand op_b() const { return op_b_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kTest; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -291,6 +328,39 @@ class Test final : public Instr {
   Operand op_b_;
 };
 
+class Shl final : public ShiftInstr {
+ public:
+  using ShiftInstr::ShiftInstr;
+
+  InstrKind instr_kind() const override { return InstrKind::kShl; }
+  std::string ToString() const override;
+
+ private:
+  uint8_t OpcodeExt() const override;
+};
+
+class Shr final : public ShiftInstr {
+ public:
+  using ShiftInstr::ShiftInstr;
+
+  InstrKind instr_kind() const override { return InstrKind::kShr; }
+  std::string ToString() const override;
+
+ private:
+  uint8_t OpcodeExt() const override;
+};
+
+class Sar final : public ShiftInstr {
+ public:
+  using ShiftInstr::ShiftInstr;
+
+  InstrKind instr_kind() const override { return InstrKind::kSar; }
+  std::string ToString() const override;
+
+ private:
+  uint8_t OpcodeExt() const override;
+};
+
 }  // namespace x86_64
 
 #endif /* x86_64_arithmetic_logic_instrs_h */
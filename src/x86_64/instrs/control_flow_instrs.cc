@@ -31,6 +31,15 @@ int8_t Jcc::Encode(Linker& linker, DataView code) const {
   return 6;
 }
 
+int8_t Jcc::EncodeShort(Linker& linker, DataView code) const {
+  code[0] = 0x70 | cond_;
+  code[1] = 0x00;
+
+  linker.AddBlockRef(dst_, code.SubView(1, 2));
+
+  return 2;
+}
+
 std::string Jcc::ToString() const { return "j" + to_suffix_string(cond_) + " " + dst_.ToString(); }
 
 Jmp::Jmp(RM rm) : dst_(rm) {
@@ -63,12 +72,42 @@ int8_t Jmp::Encode(Linker& linker, DataView code) const {
 
     linker.AddBlockRef(block_ref, code.SubView(1, 5));
 
+    return 5;
+  } else if (dst_.is_func_ref()) {
+    FuncRef func_ref = dst_.func_ref();
+    code[0] = 0xe9;
+    code[1] = 0x00;
+    code[2] = 0x00;
+    code[3] = 0x00;
+    code[4] = 0x00;
+
+    linker.AddFuncRef(func_ref, Linker::FuncRefKind::kCallOrJumpTarget, code.SubView(1, 5));
+
     return 5;
   } else {
     return -1;
   }
 }
 
+std::optional<BlockRef> Jmp::ShortEncodingDst() const {
+  if (dst_.is_block_ref()) {
+    return dst_.block_ref();
+  }
+  return std::nullopt;
+}
+
+int8_t Jmp::EncodeShort(Linker& linker, DataView code) const {
+  if (!dst_.is_block_ref()) {
+    return -1;
+  }
+  code[0] = 0xeb;
+  code[1] = 0x00;
+
+  linker.AddBlockRef(dst_.block_ref(), code.SubView(1, 2));
+
+  return 2;
+}
+
 std::string Jmp::ToString() const { return "jmp " + dst_.ToString(); }
 
 Call::Call(RM rm) : callee_(rm) {
@@ -98,7 +137,7 @@ int8_t Call::Encode(Linker& linker, DataView code) const {
     code[3] = 0x00;
     code[4] = 0x00;
 
-    linker.AddFuncRef(func_ref, code.SubView(1, 5));
+    linker.AddFuncRef(func_ref, Linker::FuncRefKind::kCallOrJumpTarget, code.SubView(1, 5));
 
     return 5;
   } else {
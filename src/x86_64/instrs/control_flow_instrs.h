@@ -27,9 +27,13 @@ class Jcc final : public Instr {
   InstrCond cond() const { return cond_; }
   BlockRef dst() const { return dst_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kJcc; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
+  std::optional<BlockRef> ShortEncodingDst() const override { return dst_; }
+  int8_t EncodeShort(Linker& linker, common::data::DataView code) const override;
+
  private:
   InstrCond cond_;
   BlockRef dst_;
@@ -39,10 +43,15 @@ class Jmp final : public Instr {
  public:
   Jmp(RM rm);
   Jmp(BlockRef block_ref) : dst_(block_ref) {}
+  Jmp(FuncRef func_ref) : dst_(func_ref) {}
 
+  InstrKind instr_kind() const override { return InstrKind::kJmp; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
+  std::optional<BlockRef> ShortEncodingDst() const override;
+  int8_t EncodeShort(Linker& linker, common::data::DataView code) const override;
+
  private:
   Operand dst_;
 };
@@ -52,6 +61,7 @@ class Call final : public Instr {
   Call(RM rm);
   Call(FuncRef func_ref) : callee_(func_ref) {}
 
+  InstrKind instr_kind() const override { return InstrKind::kCall; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -61,12 +71,14 @@ class Call final : public Instr {
 
 class Syscall final : public Instr {
  public:
+  InstrKind instr_kind() const override { return InstrKind::kSyscall; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 };
 
 class Ret final : public Instr {
  public:
+  InstrKind instr_kind() const override { return InstrKind::kRet; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 };
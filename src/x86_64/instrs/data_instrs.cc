@@ -47,8 +47,7 @@ Mov::Mov(RM dst, Operand src) : dst_(dst), src_(src) {
       }
 
     } else if (src.is_func_ref()) {
-      if (dst.size() != Size::k64) fail("unsupported mem size for func ref");
-      mov_type_ = MovType::kRM_FuncRef;
+      fail("unsupported mov: func ref to mem");
 
     } else if (src.is_reg()) {
       if (dst.size() != src.size()) fail("unsupported mem size, reg size combination");
@@ -69,6 +68,16 @@ Mov::Mov(RM dst, Operand src) : dst_(dst), src_(src) {
 int8_t Mov::Encode(Linker& linker, DataView code) const {
   InstrEncoder encoder(code);
 
+  if (mov_type_ == kREG_FuncRef) {
+    // Func addresses are only known relative to the instruction pointer: lea reg,[rip + disp32]
+    encoder.EncodeOperandSize(Size::k64);
+    encoder.EncodeOpcode(0x8D);
+    encoder.EncodeModRMReg(dst_.reg());
+    encoder.EncodeRIPRelativeRM();
+    linker.AddFuncRef(src_.func_ref(), Linker::FuncRefKind::kAddress, encoder.disp_view());
+    return encoder.size();
+  }
+
   encoder.EncodeOperandSize(src_.size());
   if (dst_.RequiresREX() || src_.RequiresREX()) {
     encoder.EncodeREX();
@@ -78,20 +87,20 @@ int8_t Mov::Encode(Linker& linker, DataView code) const {
     encoder.EncodeOpcode((src_.size() == Size::k8) ? 0x88 : 0x89);
   } else if (mov_type_ == kREG_RM) {
     encoder.EncodeOpcode((src_.size() == Size::k8) ? 0x8A : 0x8B);
-  } else if (mov_type_ == kREG_IMM || mov_type_ == kREG_FuncRef) {
+  } else if (mov_type_ == kREG_IMM) {
     encoder.EncodeOpcode((src_.size() == Size::k8) ? 0xB0 : 0xB8);
-  } else if (mov_type_ == kRM_IMM || mov_type_ == kRM_FuncRef) {
+  } else if (mov_type_ == kRM_IMM) {
     encoder.EncodeOpcode((src_.size() == Size::k8) ? 0xC6 : 0xC7);
     encoder.EncodeOpcodeExt(0);
   }
 
-  if (mov_type_ == kRM_REG || mov_type_ == kRM_IMM || mov_type_ == kRM_FuncRef) {
+  if (mov_type_ == kRM_REG || mov_type_ == kRM_IMM) {
     encoder.EncodeRM(dst_.rm());
 
   } else if (mov_type_ == kREG_RM) {
     encoder.EncodeModRMReg(dst_.reg());
 
-  } else if (mov_type_ == kREG_IMM || mov_type_ == kREG_FuncRef) {
+  } else if (mov_type_ == kREG_IMM) {
     encoder.EncodeOpcodeReg(dst_.reg());
   }
 
@@ -103,9 +112,6 @@ int8_t Mov::Encode(Linker& linker, DataView code) const {
 
   } else if (mov_type_ == kREG_IMM || mov_type_ == kRM_IMM) {
     encoder.EncodeImm(src_.imm());
-  } else if (mov_type_ == kREG_FuncRef || mov_type_ == kRM_FuncRef) {
-    encoder.EncodeImm(Imm(int32_t{0}));
-    linker.AddFuncRef(src_.func_ref(), encoder.imm_view());
   }
 
   return encoder.size();
@@ -113,6 +119,26 @@ int8_t Mov::Encode(Linker& linker, DataView code) const {
 
 std::string Mov::ToString() const { return "mov " + dst_.ToString() + "," + src_.ToString(); }
 
+Lea::Lea(Reg dst, Mem src) : dst_(dst), src_(src) {
+  if (dst.size() == Size::k8) fail("unsupported reg size for lea");
+}
+
+int8_t Lea::Encode(Linker&, DataView code) const {
+  InstrEncoder encoder(code);
+
+  encoder.EncodeOperandSize(dst_.size());
+  if (dst_.RequiresREX() || src_.RequiresREX()) {
+    encoder.EncodeREX();
+  }
+  encoder.EncodeOpcode(0x8D);
+  encoder.EncodeModRMReg(dst_);
+  encoder.EncodeRM(src_);
+
+  return encoder.size();
+}
+
+std::string Lea::ToString() const { return "lea " + dst_.ToString() + "," + src_.ToString(); }
+
 Xchg::Xchg(RM rm, Reg reg) : op_a_(rm), op_b_(reg) {
   if (rm.size() != reg.size()) fail("incompatible rm size, reg size combination");
 }
@@ -211,6 +237,14 @@ int8_t Pop::Encode(Linker&, DataView code) const {
 
 std::string Pop::ToString() const { return "pop " + op_.ToString(); }
 
+int8_t Leave::Encode(Linker&, DataView code) const {
+  code[0] = 0xc9;
+
+  return 1;
+}
+
+std::string Leave::ToString() const { return "leave"; }
+
 Setcc::Setcc(InstrCond cond, RM op) : cond_(cond), op_(op) {
   if (op.size() != k8) fail("unsupported rm size");
 }
@@ -232,4 +266,28 @@ std::string Setcc::ToString() const {
   return "set" + to_suffix_string(cond_) + " " + op_.ToString();
 }
 
+Cmov::Cmov(InstrCond cond, Reg dst, RM src) : cond_(cond), dst_(dst), src_(src) {
+  if (dst.size() == k8) fail("unsupported reg size");
+  if (dst.size() != src.size()) fail("incompatible reg size, rm size combination");
+}
+
+int8_t Cmov::Encode(Linker&, DataView code) const {
+  InstrEncoder encoder(code);
+
+  encoder.EncodeOperandSize(dst_.size());
+  if (dst_.RequiresREX() || src_.RequiresREX()) {
+    encoder.EncodeREX();
+  }
+
+  encoder.EncodeOpcode(0x0f, 0x40 | cond_);
+  encoder.EncodeModRMReg(dst_);
+  encoder.EncodeRM(src_);
+
+  return encoder.size();
+}
+
+std::string Cmov::ToString() const {
+  return "cmov" + to_suffix_string(cond_) + " " + dst_.ToString() + "," + src_.ToString();
+}
+
 }  // namespace x86_64
@@ -27,17 +27,34 @@ class Mov final : public Instr {
   RM dst() const { return dst_; }
   Operand src() const { return src_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kMov; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
  private:
-  typedef enum : uint8_t { kRM_REG, kREG_RM, kREG_IMM, kRM_IMM, kREG_FuncRef, kRM_FuncRef } MovType;
+  typedef enum : uint8_t { kRM_REG, kREG_RM, kREG_IMM, kRM_IMM, kREG_FuncRef } MovType;
 
   MovType mov_type_;
   RM dst_;
   Operand src_;
 };
 
+class Lea final : public Instr {
+ public:
+  Lea(Reg dst, Mem src);
+
+  Reg dst() const { return dst_; }
+  Mem src() const { return src_; }
+
+  InstrKind instr_kind() const override { return InstrKind::kLea; }
+  int8_t Encode(Linker& linker, common::data::DataView code) const override;
+  std::string ToString() const override;
+
+ private:
+  Reg dst_;
+  Mem src_;
+};
+
 class Xchg final : public Instr {
  public:
   Xchg(RM rm, Reg reg);
@@ -45,6 +62,7 @@ class Xchg final : public Instr {
   RM op_a() const { return op_a_; }
   Reg op_b() const { return op_b_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kXchg; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -62,6 +80,7 @@ class Push final : public Instr {
 
   Operand op() const { return op_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kPush; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -75,6 +94,7 @@ class Pop final : public Instr {
 
   RM op() const { return op_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kPop; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -82,6 +102,13 @@ class Pop final : public Instr {
   RM op_;
 };
 
+class Leave final : public Instr {
+ public:
+  InstrKind instr_kind() const override { return InstrKind::kLeave; }
+  int8_t Encode(Linker& linker, common::data::DataView code) const override;
+  std::string ToString() const override;
+};
+
 class Setcc final : public Instr {
  public:
   Setcc(InstrCond cond, RM op);
@@ -89,6 +116,7 @@ class Setcc final : public Instr {
   InstrCond cond() const { return cond_; }
   RM op() const { return op_; }
 
+  InstrKind instr_kind() const override { return InstrKind::kSetcc; }
   int8_t Encode(Linker& linker, common::data::DataView code) const override;
   std::string ToString() const override;
 
@@ -97,6 +125,24 @@ class Setcc final : public Instr {
   RM op_;
 };
 
+class Cmov final : public Instr {
+ public:
+  Cmov(InstrCond cond, Reg dst, RM src);
+
+  InstrCond cond() const { return cond_; }
+  Reg dst() const { return dst_; }
+  RM src() const { return src_; }
+
+  InstrKind instr_kind() const override { return InstrKind::kCmov; }
+  int8_t Encode(Linker& linker, common::data::DataView code) const override;
+  std::string ToString() const override;
+
+ private:
+  InstrCond cond_;
+  Reg dst_;
+  RM src_;
+};
+
 }  // namespace x86_64
 
 #endif /* x86_64_data_instrs_h */
@@ -10,23 +10,76 @@
 #define x86_64_instr_h
 
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "src/common/data/data_view.h"
 #include "src/x86_64/machine_code/linker.h"
+#include "src/x86_64/ops.h"
 
 namespace x86_64 {
 
+// Upper bound for the number of bytes an encoded instruction can occupy.
+constexpr int64_t kMaxInstrSize = 15;
+
 // TODO:
-// SAL/SAR/SHL/SHR      (shift)
 // RCL/RCR/ROL/ROR      (rotate)
 
+enum class InstrKind {
+  // arithmetic and logic instrs:
+  kNot,
+  kAnd,
+  kOr,
+  kXor,
+  kNeg,
+  kAdd,
+  kAdc,
+  kSub,
+  kSbb,
+  kCmp,
+  kMul,
+  kImul,
+  kDiv,
+  kIdiv,
+  kSignExtendRegA,
+  kSignExtendRegAD,
+  kTest,
+  kShl,
+  kShr,
+  kSar,
+
+  // control flow instrs:
+  kJcc,
+  kJmp,
+  kCall,
+  kSyscall,
+  kRet,
+
+  // data instrs:
+  kMov,
+  kLea,
+  kXchg,
+  kPush,
+  kPop,
+  kLeave,
+  kSetcc,
+  kCmov,
+};
+
 class Instr {
  public:
   virtual ~Instr() {}
 
+  virtual InstrKind instr_kind() const = 0;
+
   virtual int8_t Encode(Linker& linker, common::data::DataView code) const = 0;
   virtual std::string ToString() const = 0;
+
+  // Jumps to blocks also have a short encoding with an 8-bit displacement, which can be used if
+  // the destination block is close enough (see Func::Encode). Returns the destination block of
+  // such jumps and nullopt for all other instrs.
+  virtual std::optional<BlockRef> ShortEncodingDst() const { return std::nullopt; }
+  virtual int8_t EncodeShort(Linker&, common::data::DataView) const { return -1; }
 };
 
 }  // namespace x86_64
@@ -109,6 +109,23 @@ void InstrEncoder::EncodeRM(const RM& rm) {
   rm.EncodeInModRM_SIB_Disp(rex_, modrm_, sib_, disp_);
 }
 
+void InstrEncoder::EncodeRIPRelativeRM() {
+  if (opcode_ == nullptr) fail("attempted to encode rip relative rm without opcode");
+  if (sib_ != nullptr || disp_ != nullptr) fail("attempted to encode ModRM twice");
+  if (imm_ != nullptr) fail("attempted to encode rm after imm");
+  if (modrm_ == nullptr) {
+    modrm_ = &code_[size_++];
+  }
+  *modrm_ &= 0x38;  // Mod = 00, keep Reg
+  *modrm_ |= 0x05;  // RM = 101
+  disp_ = &code_[size_];
+  disp_view_.emplace(&code_[size_], 4);
+  for (int i = 0; i < 4; i++) {
+    code_[size_++] = 0;
+  }
+  if (size_ > code_.size()) fail("instruction exceeds code capacity");
+}
+
 void InstrEncoder::EncodeImm(const Imm& imm) {
   if (opcode_ == nullptr) fail("attempted to encode imm without opcode");
   if (imm_ != nullptr) fail("attempted to encode imm twice");
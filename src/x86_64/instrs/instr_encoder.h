@@ -23,6 +23,7 @@ struct InstrEncoder final {
 
   uint8_t size() const { return size_; }
   common::data::DataView imm_view() const { return imm_view_.value(); }
+  common::data::DataView disp_view() const { return disp_view_.value(); }
 
   void EncodeOperandSize(Size op_size);
 
@@ -37,6 +38,8 @@ struct InstrEncoder final {
   void EncodeOpcodeReg(const Reg& reg, uint8_t opcode_index = 0, uint8_t lshift = 0);
   void EncodeModRMReg(const Reg& reg);
   void EncodeRM(const RM& rm);
+  // Encode [rip + disp32] in ModRM with a zero displacement, to be patched by the linker:
+  void EncodeRIPRelativeRM();
   void EncodeImm(const Imm& imm);
 
  private:
@@ -49,6 +52,7 @@ struct InstrEncoder final {
   uint8_t* sib_ = nullptr;
   uint8_t* disp_ = nullptr;
   uint8_t* imm_ = nullptr;
+  std::optional<common::data::DataView> disp_view_;
   std::optional<common::data::DataView> imm_view_;
 };
 
@@ -0,0 +1,263 @@
+//
+//  address_selector.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/8/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "address_selector.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "src/common/atomics/atomics.h"
+#include "src/common/logging/logging.h"
+#include "src/ir/info/block_live_ranges.h"
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+#include "src/x86_64/ir_translator/register_allocator.h"
+
+namespace ir_to_x86_64_translator {
+
+using ::common::logging::fail;
+
+namespace {
+
+std::unordered_map<ir::value_num_t, int64_t> CountUsesInFunc(const ir::Func* ir_func) {
+  std::unordered_map<ir::value_num_t, int64_t> use_counts;
+  for (auto& ir_block : ir_func->blocks()) {
+    for (auto& ir_instr : ir_block->instrs()) {
+      for (auto& ir_value : ir_instr->UsedValues()) {
+        if (ir_value->kind() == ir::Value::Kind::kComputed) {
+          use_counts[static_cast<ir::Computed*>(ir_value.get())->number()]++;
+        }
+      }
+    }
+  }
+  return use_counts;
+}
+
+std::optional<int64_t> IntConstantValue(ir::Value* ir_value) {
+  if (ir_value->kind() != ir::Value::Kind::kConstant ||
+      ir_value->type()->type_kind() != ir::TypeKind::kInt) {
+    return std::nullopt;
+  }
+  common::atomics::Int value = static_cast<ir::IntConstant*>(ir_value)->value();
+  if (!value.IsRepresentableAsInt64()) {
+    return std::nullopt;
+  }
+  return value.AsInt64();
+}
+
+bool IsInReg(ir::Computed* ir_value, FuncContext& ctx) {
+  ir_info::color_t color = ctx.interference_graph_colors().GetColor(ir_value->number());
+  return ColorAndSizeToOperand(color, x86_64::k64).is_reg();
+}
+
+// Returns the operand and scale if the given instr multiplies its operand by two, four, or eight.
+std::optional<std::pair<ir::Computed*, x86_64::Scale>> FindScaledOperand(
+    const ir::Instr* ir_instr) {
+  ir::Value* ir_operand = nullptr;
+  int64_t factor = 0;
+  if (ir_instr->instr_kind() == ir::InstrKind::kIntBinary) {
+    auto ir_binary_instr = static_cast<const ir::IntBinaryInstr*>(ir_instr);
+    if (ir_binary_instr->operation() != common::atomics::Int::BinaryOp::kMul) {
+      return std::nullopt;
+    }
+    if (std::optional<int64_t> b = IntConstantValue(ir_binary_instr->operand_b().get())) {
+      ir_operand = ir_binary_instr->operand_a().get();
+      factor = *b;
+    } else if (std::optional<int64_t> a = IntConstantValue(ir_binary_instr->operand_a().get())) {
+      ir_operand = ir_binary_instr->operand_b().get();
+      factor = *a;
+    }
+  } else if (ir_instr->instr_kind() == ir::InstrKind::kIntShift) {
+    auto ir_shift_instr = static_cast<const ir::IntShiftInstr*>(ir_instr);
+    if (ir_shift_instr->operation() != common::atomics::Int::ShiftOp::kLeft) {
+      return std::nullopt;
+    }
+    if (std::optional<int64_t> shift = IntConstantValue(ir_shift_instr->offset().get());
+        shift.has_value() && 1 <= *shift && *shift <= 3) {
+      ir_operand = ir_shift_instr->shifted().get();
+      factor = int64_t{1} << *shift;
+    }
+  }
+  if (ir_operand == nullptr || ir_operand->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  switch (factor) {
+    case 2:
+      return std::make_pair(static_cast<ir::Computed*>(ir_operand), x86_64::Scale::kS01);
+    case 4:
+      return std::make_pair(static_cast<ir::Computed*>(ir_operand), x86_64::Scale::kS10);
+    case 8:
+      return std::make_pair(static_cast<ir::Computed*>(ir_operand), x86_64::Scale::kS11);
+    default:
+      return std::nullopt;
+  }
+}
+
+class AddressFolder {
+ public:
+  AddressFolder(const ir::Block* ir_block, const ir::Instr* ir_instr,
+                const std::unordered_map<ir::value_num_t, int64_t>& use_counts, FuncContext& ctx)
+      : ir_block_(ir_block),
+        ir_instr_(ir_instr),
+        live_ranges_(ctx.live_ranges().GetBlockLiveRanges(ir_block->number())),
+        use_counts_(use_counts),
+        ctx_(ctx) {}
+
+  void Fold(ir::Computed* ir_address);
+
+ private:
+  // Returns the instr defining the given value, if the value has no other use and the instr is in
+  // the same block as the load or store.
+  const ir::Instr* FoldableDefinitionOf(ir::Computed* ir_value) const;
+  // Returns if the value can be used by the load or store instead of the given (folded) user.
+  bool IsAvailable(ir::Computed* ir_value, const ir::Instr* ir_user);
+
+  const ir::Block* ir_block_;
+  const ir::Instr* ir_instr_;
+  const ir_info::BlockLiveRanges& live_ranges_;
+  const std::unordered_map<ir::value_num_t, int64_t>& use_counts_;
+  FuncContext& ctx_;
+
+  std::unordered_set<const ir::Instr*> chain_;
+  std::optional<std::unordered_set<ir::value_num_t>> live_set_;
+};
+
+const ir::Instr* AddressFolder::FoldableDefinitionOf(ir::Computed* ir_value) const {
+  if (auto it = use_counts_.find(ir_value->number()); it == use_counts_.end() || it->second != 1) {
+    return nullptr;
+  }
+  return live_ranges_.ValueDefinitionOf(ir_value->number());
+}
+
+bool AddressFolder::IsAvailable(ir::Computed* ir_value, const ir::Instr* ir_user) {
+  if (!IsInReg(ir_value, ctx_)) {
+    return false;
+  }
+  if (!live_set_.has_value()) {
+    live_set_ = live_ranges_.GetLiveSet(ir_instr_);
+  }
+  if (live_set_->contains(ir_value->number())) {
+    return true;
+  }
+  // The register of the value can get reused after the value's last use, unless all instrs
+  // between the user and the load or store get folded and therefore emit no code:
+  bool between = false;
+  for (auto& ir_instr : ir_block_->instrs()) {
+    if (ir_instr.get() == ir_instr_) {
+      return true;
+    } else if (ir_instr.get() == ir_user) {
+      between = true;
+    } else if (between && !chain_.contains(ir_instr.get())) {
+      return false;
+    }
+  }
+  fail("load or store instr not found in block");
+}
+
+void AddressFolder::Fold(ir::Computed* ir_address) {
+  FoldedAddress address{.base = ir_address};
+  const ir::Instr* ir_base_user = nullptr;
+  const ir::Instr* ir_index_user = nullptr;
+  while (const ir::Instr* ir_def = FoldableDefinitionOf(address.base)) {
+    if (ir_def->instr_kind() != ir::InstrKind::kPointerOffset) {
+      break;
+    }
+    auto ir_pointer_offset = static_cast<const ir::PointerOffsetInstr*>(ir_def);
+    ir::Value* ir_offset = ir_pointer_offset->offset().get();
+    if (std::optional<int64_t> offset = IntConstantValue(ir_offset)) {
+      int64_t disp = address.disp + *offset;
+      if (disp < std::numeric_limits<int32_t>::min() ||
+          disp > std::numeric_limits<int32_t>::max()) {
+        break;
+      }
+      address.disp = int32_t(disp);
+    } else if (ir_offset->kind() == ir::Value::Kind::kComputed && address.index == nullptr) {
+      address.index = static_cast<ir::Computed*>(ir_offset);
+      ir_index_user = ir_def;
+    } else {
+      break;
+    }
+    address.base = ir_pointer_offset->pointer().get();
+    ir_base_user = ir_def;
+    chain_.insert(ir_def);
+  }
+  if (chain_.empty()) {
+    return;
+  }
+  if (address.index != nullptr) {
+    if (const ir::Instr* ir_def = FoldableDefinitionOf(address.index)) {
+      if (auto scaled_operand = FindScaledOperand(ir_def);
+          scaled_operand.has_value() && IsAvailable(scaled_operand->first, ir_def)) {
+        address.index = scaled_operand->first;
+        address.scale = scaled_operand->second;
+        ir_index_user = ir_def;
+        chain_.insert(ir_def);
+      }
+    }
+    if (!IsAvailable(address.index, ir_index_user)) {
+      return;
+    }
+  }
+  if (!IsAvailable(address.base, ir_base_user)) {
+    return;
+  }
+  for (const ir::Instr* ir_folded_instr : chain_) {
+    ctx_.AddFoldedInstr(ir_folded_instr);
+  }
+  ctx_.SetFoldedAddress(ir_instr_, address);
+}
+
+}  // namespace
+
+void FoldAddressesInFunc(FuncContext& ctx) {
+  const std::unordered_map<ir::value_num_t, int64_t> use_counts = CountUsesInFunc(ctx.ir_func());
+  for (auto& ir_block : ctx.ir_func()->blocks()) {
+    for (auto& ir_instr : ir_block->instrs()) {
+      ir::Value* ir_address = nullptr;
+      if (ir_instr->instr_kind() == ir::InstrKind::kLoad) {
+        ir_address = static_cast<ir::LoadInstr*>(ir_instr.get())->address().get();
+      } else if (ir_instr->instr_kind() == ir::InstrKind::kStore) {
+        ir_address = static_cast<ir::StoreInstr*>(ir_instr.get())->address().get();
+      }
+      if (ir_address == nullptr || ir_address->kind() != ir::Value::Kind::kComputed) {
+        continue;
+      }
+      AddressFolder folder(ir_block.get(), ir_instr.get(), use_counts, ctx);
+      folder.Fold(static_cast<ir::Computed*>(ir_address));
+    }
+  }
+}
+
+x86_64::Mem GenerateFoldedAddress(const FoldedAddress& address, x86_64::Size size,
+                                  const ir::Instr* instr, BlockContext& ctx) {
+  const ir_info::InterferenceGraphColors& colors = ctx.func_ctx().interference_graph_colors();
+  ir_info::color_t base_color = colors.GetColor(address.base->number());
+  ctx.AddTemporaryColorUsedDuringInstr(instr, base_color);
+  uint8_t base_reg = ColorAndSizeToOperand(base_color, x86_64::k64).reg().reg();
+  if (address.index == nullptr) {
+    return x86_64::Mem(size, base_reg, /*disp=*/address.disp);
+  }
+  ir_info::color_t index_color = colors.GetColor(address.index->number());
+  ctx.AddTemporaryColorUsedDuringInstr(instr, index_color);
+  uint8_t index_reg = ColorAndSizeToOperand(index_color, x86_64::k64).reg().reg();
+  if (index_reg == x86_64::rsp.reg()) {
+    if (address.scale != x86_64::Scale::kS00) {
+      fail("stack pointer can not be used as scaled index register");
+    }
+    std::swap(base_reg, index_reg);
+  }
+  return x86_64::Mem(size, base_reg, index_reg, address.scale, address.disp);
+}
+
+}  // namespace ir_to_x86_64_translator
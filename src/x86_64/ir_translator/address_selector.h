@@ -0,0 +1,32 @@
+//
+//  address_selector.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/8/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_to_x86_64_translator_address_selector_h
+#define ir_to_x86_64_translator_address_selector_h
+
+#include "src/ir/representation/instrs.h"
+#include "src/x86_64/ir_translator/context.h"
+#include "src/x86_64/ops.h"
+
+namespace ir_to_x86_64_translator {
+
+// Folds the address computations of loads and stores into their memory operands. Chains of
+// pointer offset instrs with constant offsets and at most one computed offset, optionally scaled
+// by a multiplication or left shift, become base + index * scale + disp. Only instrs in the same
+// block as the load or store whose results have no other use get folded, and only if the base and
+// index values are in registers and still hold their values at the load or store.
+void FoldAddressesInFunc(FuncContext& ctx);
+
+// Returns the memory operand for the folded address of the given load or store. The registers of
+// the base and index values are not available as temporary registers for the instr.
+x86_64::Mem GenerateFoldedAddress(const FoldedAddress& address, x86_64::Size size,
+                                  const ir::Instr* instr, BlockContext& ctx);
+
+}  // namespace ir_to_x86_64_translator
+
+#endif /* ir_to_x86_64_translator_address_selector_h */
@@ -8,7 +8,14 @@
 
 #include "call_generator.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <unordered_set>
+
 #include "src/common/logging/logging.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
 #include "src/x86_64/instrs/control_flow_instrs.h"
 #include "src/x86_64/instrs/data_instrs.h"
 #include "src/x86_64/ir_translator/mov_generator.h"
@@ -59,10 +66,59 @@ void GenerateCallerRegisterRestores(const std::vector<x86_64::Reg>& caller_saved
                 [&](x86_64::Reg reg) { ctx.x86_64_block()->AddInstr<x86_64::Pop>(reg); });
 }
 
+// Returns the number of bytes of padding reserved above the stack args and result buffer, such
+// that the stack pointer is 16 byte aligned at the call. Funcs keep the stack pointer aligned after
+// their prologue, so only the stack slots pushed or reserved for the call need to be considered.
+int32_t StackPaddingForCall(std::size_t caller_saved_reg_count, int stack_arg_count,
+                            int stack_result_count) {
+  int64_t slot_count = int64_t(caller_saved_reg_count) + stack_arg_count + stack_result_count;
+  return (slot_count % 2 == 0) ? 0 : 8;
+}
+
+void GenerateStackPointerAdjustment(int32_t delta, BlockContext& ctx) {
+  if (delta == 0) {
+    return;
+  }
+  x86_64::Imm imm = (-128 < delta && delta < 128) ? x86_64::Imm(int8_t(std::abs(delta)))
+                                                  : x86_64::Imm(int32_t(std::abs(delta)));
+  if (delta > 0) {
+    ctx.x86_64_block()->AddInstr<x86_64::Add>(x86_64::rsp, imm);
+  } else {
+    ctx.x86_64_block()->AddInstr<x86_64::Sub>(x86_64::rsp, imm);
+  }
+}
+
+void GenerateStackArgPushes(std::vector<ir::Value*> ir_args, BlockContext& ctx) {
+  for (std::size_t arg_index = ir_args.size(); arg_index > std::size_t(kMaxArgsInRegs);
+       arg_index--) {
+    ir::Value* ir_arg_value = ir_args.at(arg_index - 1);
+    x86_64::Operand x86_64_arg_value =
+        TranslateValue(ir_arg_value, IntNarrowing::k64To32BitIfPossible, ctx.func_ctx());
+    if (x86_64_arg_value.is_rm()) {
+      // Stack slots are always eight bytes wide, the called func ignores the upper bytes:
+      ctx.x86_64_block()->AddInstr<x86_64::Push>(
+          x86_64::Resize(x86_64_arg_value.rm(), x86_64::k64));
+    } else if (x86_64_arg_value.is_imm() && x86_64_arg_value.size() != x86_64::k64) {
+      ctx.x86_64_block()->AddInstr<x86_64::Push>(
+          x86_64::Imm(int32_t(x86_64_arg_value.imm().value())));
+    } else {
+      // 64-bit immediates and func refs can only be pushed through a register:
+      ctx.x86_64_block()->AddInstr<x86_64::Sub>(x86_64::rsp, x86_64::Imm(int8_t{8}));
+      ctx.x86_64_block()->AddInstr<x86_64::Push>(x86_64::rax);
+      ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64::rax, x86_64_arg_value);
+      ctx.x86_64_block()->AddInstr<x86_64::Mov>(
+          x86_64::Mem(x86_64::k64, /*base_reg=*/uint8_t(x86_64::rsp.reg()), /*disp=*/8),
+          x86_64::rax);
+      ctx.x86_64_block()->AddInstr<x86_64::Pop>(x86_64::rax);
+    }
+  }
+}
+
 void GenerateArgMoves(ir::Instr* ir_instr, std::vector<ir::Value*> ir_args, BlockContext& ctx) {
   std::vector<MoveOperation> arg_moves;
   arg_moves.reserve(ir_args.size());
-  for (std::size_t arg_index = 0; arg_index < ir_args.size(); arg_index++) {
+  for (std::size_t arg_index = 0;
+       arg_index < ir_args.size() && arg_index < std::size_t(kMaxArgsInRegs); arg_index++) {
     ir::Value* ir_arg_value = ir_args.at(arg_index);
     x86_64::Operand x86_64_arg_value =
         TranslateValue(ir_arg_value, IntNarrowing::kNone, ctx.func_ctx());
@@ -73,18 +129,28 @@ void GenerateArgMoves(ir::Instr* ir_instr, std::vector<ir::Value*> ir_args, Bloc
   GenerateMovs(arg_moves, ir_instr, ctx);
 }
 
+// Expects the stack pointer to point at the result buffer.
 void GenerateResultMoves(ir::Instr* ir_instr, std::vector<ir::Computed*> results,
                          BlockContext& ctx) {
   std::vector<MoveOperation> result_moves;
   result_moves.reserve(results.size());
-  for (std::size_t result_index = 0; result_index < results.size(); result_index++) {
+  for (std::size_t result_index = 0;
+       result_index < results.size() && result_index < std::size_t(kMaxResultsInRegs);
+       result_index++) {
     ir::Computed* ir_result = results.at(result_index);
     x86_64::RM x86_64_result = TranslateComputed(ir_result, ctx.func_ctx());
     x86_64::Size x86_64_result_size = TranslateSizeOfType(ir_result->type());
-    x86_64::RM x86_64_result_location = OperandForResult(int(result_index), x86_64_result_size);
+    x86_64::RM x86_64_result_location =
+        OperandForResult(int(result_index), /*arg_count=*/0, x86_64_result_size);
     result_moves.push_back(MoveOperation(x86_64_result, x86_64_result_location));
   }
   GenerateMovs(result_moves, ir_instr, ctx);
+  // Pops the results from the buffer, which also releases the buffer:
+  for (std::size_t result_index = kMaxResultsInRegs; result_index < results.size();
+       result_index++) {
+    x86_64::RM x86_64_result = TranslateComputed(results.at(result_index), ctx.func_ctx());
+    ctx.x86_64_block()->AddInstr<x86_64::Pop>(x86_64::Resize(x86_64_result, x86_64::k64));
+  }
 }
 
 void GenerateCallInstr(ir::Value* ir_called_func, BlockContext& ctx) {
@@ -99,28 +165,131 @@ void GenerateCallInstr(ir::Value* ir_called_func, BlockContext& ctx) {
   }
 }
 
-}  // namespace
-
-void GenerateCall(ir::Instr* ir_instr, ir::Value* ir_called_func,
-                  std::vector<ir::Computed*> ir_results, std::vector<ir::Value*> ir_args,
-                  BlockContext& ctx) {
+// Generates a call with the given args and results around the call instr generated by the given
+// func. The stack layout at the call (from higher to lower addresses) is: caller saved regs,
+// padding, result buffer, stack args.
+void GenerateCallSequence(ir::Instr* ir_instr, std::function<void()> generate_call_instr,
+                          std::vector<ir::Computed*> ir_results, std::vector<ir::Value*> ir_args,
+                          BlockContext& ctx) {
   std::vector<x86_64::Reg> caller_saved_registers = GetCallerSavedRegisters(ir_instr, ctx);
+  int stack_arg_count = StackArgCount(int(ir_args.size()));
+  int stack_result_count = StackResultCount(int(ir_results.size()));
+  int32_t padding =
+      StackPaddingForCall(caller_saved_registers.size(), stack_arg_count, stack_result_count);
+
   GenerateCallerRegisterSaves(caller_saved_registers, ctx);
+  GenerateStackPointerAdjustment(-(padding + 8 * stack_result_count), ctx);
+  GenerateStackArgPushes(ir_args, ctx);
   GenerateArgMoves(ir_instr, ir_args, ctx);
-  GenerateCallInstr(ir_called_func, ctx);
+  generate_call_instr();
+  GenerateStackPointerAdjustment(8 * stack_arg_count, ctx);
   GenerateResultMoves(ir_instr, ir_results, ctx);
+  GenerateStackPointerAdjustment(padding, ctx);
   GenerateCallerRegisterRestores(caller_saved_registers, ctx);
 }
 
+}  // namespace
+
+ir::CallInstr* FindSiblingCall(const ir::Func* ir_func, const ir::Block* ir_block) {
+  const std::vector<std::unique_ptr<ir::Instr>>& ir_instrs = ir_block->instrs();
+  if (ir_instrs.size() < 2 || ir_instrs.back()->instr_kind() != ir::InstrKind::kReturn ||
+      ir_instrs.at(ir_instrs.size() - 2)->instr_kind() != ir::InstrKind::kCall) {
+    return nullptr;
+  }
+  auto ir_call_instr = static_cast<ir::CallInstr*>(ir_instrs.at(ir_instrs.size() - 2).get());
+  auto ir_return_instr = static_cast<ir::ReturnInstr*>(ir_instrs.back().get());
+  if (ir_call_instr->func()->kind() != ir::Value::Kind::kConstant ||
+      ir_call_instr->func().get() == ir::NilFunc().get() ||
+      ir_call_instr->args().size() > std::size_t(kMaxArgsInRegs) ||
+      ir_call_instr->results().size() != ir_return_instr->args().size()) {
+    return nullptr;
+  }
+  if (ir_call_instr->results().size() > std::size_t(kMaxResultsInRegs) &&
+      ir_func->args().size() > std::size_t(kMaxArgsInRegs)) {
+    // The called func would store the results in the wrong place, since the result buffer is
+    // located above the stack args of the calling func:
+    return nullptr;
+  }
+  for (std::size_t i = 0; i < ir_return_instr->args().size(); i++) {
+    ir::Value* ir_returned_value = ir_return_instr->args().at(i).get();
+    if (ir_returned_value->kind() != ir::Value::Kind::kComputed ||
+        static_cast<ir::Computed*>(ir_returned_value)->number() !=
+            ir_call_instr->results().at(i)->number()) {
+      return nullptr;
+    }
+  }
+  for (const std::unique_ptr<ir::Block>& block : ir_func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() == ir::InstrKind::kStackAlloc) {
+        return nullptr;
+      }
+    }
+  }
+  return ir_call_instr;
+}
+
+void GenerateFuncArgMoves(BlockContext& ctx) {
+  ir::Instr* ir_first_instr = ctx.ir_block()->instrs().front().get();
+  const std::unordered_set<ir::value_num_t> ir_live_args = ctx.live_ranges().GetEntrySet();
+  std::vector<MoveOperation> reg_arg_moves;
+  std::vector<MoveOperation> stack_arg_moves;
+  for (std::size_t arg_index = 0; arg_index < ctx.ir_func()->args().size(); arg_index++) {
+    ir::Computed* ir_arg = ctx.ir_func()->args().at(arg_index).get();
+    if (!ir_live_args.contains(ir_arg->number())) {
+      continue;
+    }
+    x86_64::RM x86_64_arg = TranslateComputed(ir_arg, ctx.func_ctx());
+    x86_64::Size x86_64_arg_size = TranslateSizeOfType(ir_arg->type());
+    x86_64::RM x86_64_arg_location = OperandForArg(int(arg_index), x86_64_arg_size);
+    if (arg_index < std::size_t(kMaxArgsInRegs)) {
+      reg_arg_moves.push_back(MoveOperation(x86_64_arg, x86_64_arg_location));
+    } else {
+      stack_arg_moves.push_back(MoveOperation(x86_64_arg, x86_64_arg_location));
+    }
+  }
+  GenerateMovs(reg_arg_moves, ir_first_instr, ctx);
+  // Stack args can only be moved after the register args, since their origins do not have colors
+  // and their results might be registers of other args:
+  for (const MoveOperation& stack_arg_move : stack_arg_moves) {
+    GenerateMov(stack_arg_move.result(), stack_arg_move.origin(), ir_first_instr, ctx);
+  }
+}
+
+void GenerateSiblingCallArgMoves(ir::CallInstr* ir_call_instr, BlockContext& ctx) {
+  std::vector<ir::Value*> args;
+  args.reserve(ir_call_instr->args().size());
+  for (const auto& arg : ir_call_instr->args()) {
+    args.push_back(arg.get());
+  }
+  GenerateArgMoves(ir_call_instr, args, ctx);
+}
+
+void GenerateSiblingCallJump(ir::CallInstr* ir_call_instr, BlockContext& ctx) {
+  x86_64::Operand x86_64_called_func =
+      TranslateValue(ir_call_instr->func().get(), IntNarrowing::kNone, ctx.func_ctx());
+  if (!x86_64_called_func.is_func_ref()) {
+    fail("unexpected sibling call func operand");
+  }
+  ctx.x86_64_block()->AddInstr<x86_64::Jmp>(x86_64_called_func.func_ref());
+}
+
+void GenerateCall(ir::Instr* ir_instr, ir::Value* ir_called_func,
+                  std::vector<ir::Computed*> ir_results, std::vector<ir::Value*> ir_args,
+                  BlockContext& ctx) {
+  GenerateCallSequence(
+      ir_instr, [ir_called_func, &ctx]() { GenerateCallInstr(ir_called_func, ctx); }, ir_results,
+      ir_args, ctx);
+}
+
 void GenerateCall(ir::Instr* ir_instr, x86_64::FuncRef x86_64_called_func,
                   std::vector<ir::Computed*> ir_results, std::vector<ir::Value*> ir_args,
                   BlockContext& ctx) {
-  std::vector<x86_64::Reg> caller_saved_registers = GetCallerSavedRegisters(ir_instr, ctx);
-  GenerateCallerRegisterSaves(caller_saved_registers, ctx);
-  GenerateArgMoves(ir_instr, ir_args, ctx);
-  ctx.x86_64_block()->AddInstr<x86_64::Call>(x86_64_called_func);
-  GenerateResultMoves(ir_instr, ir_results, ctx);
-  GenerateCallerRegisterRestores(caller_saved_registers, ctx);
+  GenerateCallSequence(
+      ir_instr,
+      [x86_64_called_func, &ctx]() {
+        ctx.x86_64_block()->AddInstr<x86_64::Call>(x86_64_called_func);
+      },
+      ir_results, ir_args, ctx);
 }
 
 }  // namespace ir_to_x86_64_translator
@@ -11,6 +11,8 @@
 
 #include <vector>
 
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/func.h"
 #include "src/ir/representation/instrs.h"
 #include "src/ir/representation/num_types.h"
 #include "src/ir/representation/values.h"
@@ -19,6 +21,20 @@
 
 namespace ir_to_x86_64_translator {
 
+// Moves the args of the func from the locations defined by the calling convention to their colors.
+// Gets generated at the start of the entry block.
+void GenerateFuncArgMoves(BlockContext& ctx);
+
+// Returns the call instr if the block ends with a sibling call, otherwise nullptr. A sibling call
+// is a direct call that is directly followed by a return of exactly its results and passes all
+// args in registers. Sibling calls get translated to jumps that reuse the return address of the
+// calling func: the args get moved in place of the call, the called func gets jumped to after the
+// epilogue of the calling func, and the return instr gets omitted. Funcs with stack allocations
+// never make sibling calls, since the args might point into the frame of the calling func.
+ir::CallInstr* FindSiblingCall(const ir::Func* ir_func, const ir::Block* ir_block);
+void GenerateSiblingCallArgMoves(ir::CallInstr* ir_call_instr, BlockContext& ctx);
+void GenerateSiblingCallJump(ir::CallInstr* ir_call_instr, BlockContext& ctx);
+
 void GenerateCall(ir::Instr* ir_instr, ir::Value* ir_called_func,
                   std::vector<ir::Computed*> ir_results, std::vector<ir::Value*> ir_args,
                   BlockContext& ctx);
@@ -9,6 +9,8 @@
 #include "src/x86_64/ir_translator/call_generator.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -66,14 +68,120 @@ TEST_F(GenerateCallTest, SavesCallerSavedRegs) {
                /*results=*/{ir_operand_f.get()},
                /*args=*/{ir_operand_b.get(), ir_operand_c.get()}, block_ctx());
 
-  EXPECT_EQ(x86_64_block()->instrs().size(), 7);
+  EXPECT_EQ(x86_64_block()->instrs().size(), 9);
   EXPECT_EQ(x86_64_block()->instrs().at(0)->ToString(), "push rcx");
   EXPECT_EQ(x86_64_block()->instrs().at(1)->ToString(), "push rdx");
   EXPECT_EQ(x86_64_block()->instrs().at(2)->ToString(), "push rsi");
-  EXPECT_EQ(x86_64_block()->instrs().at(3)->ToString(), "call rcx");
-  EXPECT_EQ(x86_64_block()->instrs().at(4)->ToString(), "pop rsi");
-  EXPECT_EQ(x86_64_block()->instrs().at(5)->ToString(), "pop rdx");
-  EXPECT_EQ(x86_64_block()->instrs().at(6)->ToString(), "pop rcx");
+  // Keeps the stack pointer aligned at the call:
+  EXPECT_EQ(x86_64_block()->instrs().at(3)->ToString(), "sub rsp,0x08");
+  EXPECT_EQ(x86_64_block()->instrs().at(4)->ToString(), "call rcx");
+  EXPECT_EQ(x86_64_block()->instrs().at(5)->ToString(), "add rsp,0x08");
+  EXPECT_EQ(x86_64_block()->instrs().at(6)->ToString(), "pop rsi");
+  EXPECT_EQ(x86_64_block()->instrs().at(7)->ToString(), "pop rdx");
+  EXPECT_EQ(x86_64_block()->instrs().at(8)->ToString(), "pop rcx");
+}
+
+TEST_F(GenerateCallTest, PassesArgsAndResultsOnStack) {
+  std::vector<std::shared_ptr<ir::Value>> ir_args;
+  for (int i = 0; i < 8; i++) {
+    ir_args.push_back(ir_func_builder().AddArg(ir::i64()));
+  }
+  ir_func_builder().AddResultType(ir::i64());
+  ir_func_builder().AddResultType(ir::i64());
+  ir_func_builder().AddResultType(ir::i64());
+
+  std::vector<std::shared_ptr<ir::Computed>> call_results =
+      ir_block_builder().Call(ir::ToFuncConstant(ir_func()->number()),
+                              /*result_types=*/{ir::i64(), ir::i64(), ir::i64()}, ir_args);
+  ir_block_builder().Return({call_results.at(0), call_results.at(1), call_results.at(2)});
+
+  GenerateIRInfo();
+
+  // Args in the registers used by the calling convention:
+  interference_graph_colors().SetColor(ir_func()->args().at(0)->number(), 5);  // rdi
+  interference_graph_colors().SetColor(ir_func()->args().at(1)->number(), 4);  // rsi
+  interference_graph_colors().SetColor(ir_func()->args().at(2)->number(), 2);  // rdx
+  interference_graph_colors().SetColor(ir_func()->args().at(3)->number(), 1);  // rcx
+  interference_graph_colors().SetColor(ir_func()->args().at(4)->number(), 6);  // r8
+  interference_graph_colors().SetColor(ir_func()->args().at(5)->number(), 7);  // r9
+  interference_graph_colors().SetColor(ir_func()->args().at(6)->number(), 8);  // r10
+  interference_graph_colors().SetColor(ir_func()->args().at(7)->number(), 9);  // r11
+  interference_graph_colors().SetColor(call_results.at(0)->number(), 0);       // rax
+  interference_graph_colors().SetColor(call_results.at(1)->number(), 2);       // rdx
+  interference_graph_colors().SetColor(call_results.at(2)->number(), 3);       // rbx
+
+  GenerateTranslationContexts();
+  program_ctx().set_x86_64_func_num_for_ir_func_num(ir_func()->number(),
+                                                    x86_64_func()->func_num());
+
+  auto ir_call_instr = static_cast<ir::CallInstr*>(ir_block()->instrs().front().get());
+  std::vector<ir::Value*> args;
+  for (auto& ir_arg : ir_args) {
+    args.push_back(ir_arg.get());
+  }
+  GenerateCall(ir_call_instr, ir_call_instr->func().get(),
+               /*results=*/
+               {call_results.at(0).get(), call_results.at(1).get(), call_results.at(2).get()},
+               args, block_ctx());
+
+  std::string func_ref = "<" + std::to_string(x86_64_func()->func_num()) + ">";
+  EXPECT_EQ(x86_64_block()->instrs().size(), 7);
+  // Reserves the result buffer and padding:
+  EXPECT_EQ(x86_64_block()->instrs().at(0)->ToString(), "sub rsp,0x10");
+  EXPECT_EQ(x86_64_block()->instrs().at(1)->ToString(), "push r11");
+  EXPECT_EQ(x86_64_block()->instrs().at(2)->ToString(), "push r10");
+  EXPECT_EQ(x86_64_block()->instrs().at(3)->ToString(), "call " + func_ref);
+  EXPECT_EQ(x86_64_block()->instrs().at(4)->ToString(), "add rsp,0x10");
+  EXPECT_EQ(x86_64_block()->instrs().at(5)->ToString(), "pop rbx");
+  EXPECT_EQ(x86_64_block()->instrs().at(6)->ToString(), "add rsp,0x08");
+}
+
+TEST_F(GenerateCallTest, GeneratesSiblingCallAsJump) {
+  std::shared_ptr<ir::Computed> ir_operand_a = ir_func_builder().AddArg(ir::i64());
+  std::shared_ptr<ir::Computed> ir_operand_b = ir_func_builder().AddArg(ir::i64());
+  ir_func_builder().AddResultType(ir::i64());
+
+  std::vector<std::shared_ptr<ir::Computed>> call_results =
+      ir_block_builder().Call(ir::ToFuncConstant(ir_func()->number()),
+                              /*result_types=*/{ir::i64()},
+                              /*args=*/{ir_operand_b, ir_operand_a});
+  std::shared_ptr<ir::Computed> ir_operand_c = call_results.front();
+  ir_block_builder().Return({ir_operand_c});
+
+  GenerateIRInfo();
+
+  interference_graph_colors().SetColor(ir_operand_a->number(), 5);  // rdi - 1st arg
+  interference_graph_colors().SetColor(ir_operand_b->number(), 4);  // rsi - 2nd arg
+  interference_graph_colors().SetColor(ir_operand_c->number(), 0);  // rax - result
+
+  GenerateTranslationContexts();
+  program_ctx().set_x86_64_func_num_for_ir_func_num(ir_func()->number(),
+                                                    x86_64_func()->func_num());
+
+  ir::CallInstr* ir_sibling_call = FindSiblingCall(ir_func(), ir_block());
+  ASSERT_EQ(ir_sibling_call, ir_block()->instrs().front().get());
+
+  GenerateSiblingCallArgMoves(ir_sibling_call, block_ctx());
+  GenerateSiblingCallJump(ir_sibling_call, block_ctx());
+
+  EXPECT_EQ(x86_64_block()->instrs().size(), 2);
+  EXPECT_EQ(x86_64_block()->instrs().at(0)->ToString(), "xchg rdi,rsi");
+  EXPECT_EQ(x86_64_block()->instrs().at(1)->ToString(),
+            "jmp <" + std::to_string(x86_64_func()->func_num()) + ">");
+}
+
+TEST_F(GenerateCallTest, DoesNotFindSiblingCallWithModifiedResult) {
+  std::shared_ptr<ir::Computed> ir_operand_a = ir_func_builder().AddArg(ir::i64());
+  ir_func_builder().AddResultType(ir::i64());
+
+  std::vector<std::shared_ptr<ir::Computed>> call_results =
+      ir_block_builder().Call(ir::ToFuncConstant(ir_func()->number()),
+                              /*result_types=*/{ir::i64()}, /*args=*/{ir_operand_a});
+  std::shared_ptr<ir::Value> ir_operand_b =
+      ir_block_builder().IntAdd(call_results.front(), ir_operand_a);
+  ir_block_builder().Return({ir_operand_b});
+
+  EXPECT_EQ(FindSiblingCall(ir_func(), ir_block()), nullptr);
 }
 
 }  // namespace ir_to_x86_64_translator
@@ -8,8 +8,17 @@
 
 #include "context.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "src/common/logging/logging.h"
+#include "src/ir/representation/values.h"
+#include "src/x86_64/ir_translator/register_allocator.h"
+
 namespace ir_to_x86_64_translator {
 
+using ::common::logging::fail;
+
 x86_64::func_num_t ProgramContext::x86_64_func_num_for_ir_func_num(
     ir::func_num_t ir_func_num) const {
   return ir_to_x86_64_func_nums_.at(ir_func_num);
@@ -30,6 +39,74 @@ void FuncContext::set_x86_64_block_num_for_ir_block_num(ir::block_num_t ir_block
   ir_to_x86_64_block_nums_.insert_or_assign(ir_block_num, x86_64_block_num);
 }
 
+void FuncContext::set_ir_block_layout(std::vector<const ir::Block*> ir_block_layout) {
+  ir_block_layout_ = ir_block_layout;
+  ir_block_nums_after_.clear();
+  for (std::size_t i = 1; i < ir_block_layout_.size(); i++) {
+    ir_block_nums_after_.insert({ir_block_layout_.at(i - 1)->number(),
+                                 ir_block_layout_.at(i)->number()});
+  }
+}
+
+ir::block_num_t FuncContext::ir_block_num_after(ir::block_num_t ir_block_num) const {
+  if (auto it = ir_block_nums_after_.find(ir_block_num); it != ir_block_nums_after_.end()) {
+    return it->second;
+  }
+  return ir::kNoBlockNum;
+}
+
+const FoldedAddress* FuncContext::FoldedAddressOf(const ir::Instr* instr) const {
+  if (auto it = folded_addresses_.find(instr); it != folded_addresses_.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+void FuncContext::SetFoldedAddress(const ir::Instr* instr, FoldedAddress address) {
+  folded_addresses_.insert_or_assign(instr, address);
+}
+
+const Select* FuncContext::SelectOf(ir::block_num_t ir_block_num) const {
+  if (auto it = selects_.find(ir_block_num); it != selects_.end()) {
+    return &it->second;
+  }
+  return nullptr;
+}
+
+void FuncContext::AddSelect(ir::block_num_t ir_block_num, Select select) {
+  for (ir::block_num_t branch : {select.unconditional_branch, select.conditional_branch}) {
+    if (branch != ir::kNoBlockNum) {
+      select_branches_.insert(branch);
+    }
+  }
+  selects_.insert_or_assign(ir_block_num, select);
+}
+
+int32_t FuncContext::StackAllocOffset(const ir::StackAllocInstr* instr) {
+  if (auto it = stack_alloc_offsets_.find(instr); it != stack_alloc_offsets_.end()) {
+    return it->second;
+  }
+  int64_t size = static_cast<ir::IntConstant*>(instr->size().get())->value().AsInt64();
+  stack_allocs_size_ += (size + 7) / 8 * 8;
+  if (frame_size() > std::numeric_limits<int32_t>::max()) {
+    fail("stack allocs exceed maximum frame size");
+  }
+  int32_t offset = int32_t(-frame_size());
+  stack_alloc_offsets_.insert({instr, offset});
+  return offset;
+}
+
+int64_t FuncContext::SpillSlotsSize(const std::unordered_set<ir_info::color_t>& used_colors) {
+  int64_t spill_slots_size = 0;
+  for (ir_info::color_t color : used_colors) {
+    x86_64::RM operand = ColorAndSizeToOperand(color, x86_64::k64);
+    if (operand.is_mem()) {
+      spill_slots_size = std::max(spill_slots_size, int64_t{-operand.mem().disp()});
+    }
+  }
+  return spill_slots_size;
+}
+
 bool BlockContext::IsTemporaryColorUsedDuringInstr(const ir::Instr* instr,
                                                    ir_info::color_t temporary_color) const {
   if (auto it = instr_temporary_colors_.find(instr); it != instr_temporary_colors_.end()) {
@@ -12,16 +12,19 @@
 #include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "src/ir/info/block_live_ranges.h"
 #include "src/ir/info/func_live_ranges.h"
 #include "src/ir/info/interference_graph.h"
 #include "src/ir/representation/block.h"
 #include "src/ir/representation/func.h"
+#include "src/ir/representation/instrs.h"
 #include "src/ir/representation/num_types.h"
 #include "src/ir/representation/program.h"
 #include "src/x86_64/block.h"
 #include "src/x86_64/func.h"
+#include "src/x86_64/ops.h"
 #include "src/x86_64/program.h"
 
 namespace ir_to_x86_64_translator {
@@ -54,6 +57,26 @@ class ProgramContext {
   std::unordered_map<ir::func_num_t, x86_64::func_num_t> ir_to_x86_64_func_nums_;
 };
 
+// Memory operand base + index * scale + disp of a load or store whose address computation got
+// folded into the memory operand (see FoldAddressesInFunc).
+struct FoldedAddress {
+  ir::Computed* base = nullptr;
+  ir::Computed* index = nullptr;  // nullptr if the address has no index
+  x86_64::Scale scale = x86_64::Scale::kS00;
+  int32_t disp = 0;
+};
+
+// Conditional jump to branches that only move values to phi results in the join block. The jump
+// gets replaced by conditional moves (see FindSelectsInFunc). The movs of the unconditional branch
+// get executed first, followed by the movs of the conditional branch as conditional moves. The
+// branches are ir::kNoBlockNum if the conditional jump goes directly to the join block.
+struct Select {
+  ir::block_num_t unconditional_branch = ir::kNoBlockNum;
+  ir::block_num_t conditional_branch = ir::kNoBlockNum;
+  bool conditional_branch_is_true_destination = true;
+  ir::block_num_t join_block = ir::kNoBlockNum;
+};
+
 class FuncContext {
  public:
   FuncContext(ProgramContext& program_ctx, const ir::Func* ir_func, x86_64::Func* x86_64_func,
@@ -66,7 +89,8 @@ class FuncContext {
         live_ranges_(live_ranges),
         interference_graph_(interference_graph),
         interference_graph_colors_(interference_graph_colors),
-        used_colors_(interference_graph_colors.GetColors(interference_graph.values())) {}
+        used_colors_(interference_graph_colors.GetColors(interference_graph.values())),
+        spill_slots_size_(SpillSlotsSize(used_colors_)) {}
 
   ProgramContext& program_ctx() const { return program_ctx_; }
 
@@ -85,10 +109,41 @@ class FuncContext {
 
   void AddUsedColor(ir_info::color_t color) { used_colors_.insert(color); }
 
+  // Returns the offset of the stack slot for the stack alloc instr relative to the base pointer.
+  // Slots get assigned on the first request and are placed below the spill slots of the func.
+  int32_t StackAllocOffset(const ir::StackAllocInstr* instr);
+  // Returns the number of bytes below the base pointer covering all spill and stack alloc slots.
+  int64_t frame_size() const { return spill_slots_size_ + stack_allocs_size_; }
+
   x86_64::block_num_t x86_64_block_num_for_ir_block_num(ir::block_num_t ir_block_num) const;
   void set_x86_64_block_num_for_ir_block_num(ir::block_num_t ir_block_num,
                                              x86_64::block_num_t x86_64_block_num);
 
+  // The order in which the blocks of the func get placed in the translated func.
+  const std::vector<const ir::Block*>& ir_block_layout() const { return ir_block_layout_; }
+  void set_ir_block_layout(std::vector<const ir::Block*> ir_block_layout);
+  // Returns the block placed directly after the given block or ir::kNoBlockNum if the given block
+  // is placed last. Control flow to that block can fall through without a jump.
+  ir::block_num_t ir_block_num_after(ir::block_num_t ir_block_num) const;
+
+  // Folded instrs do not get translated, since all uses of their results got folded into the
+  // memory operands of loads and stores.
+  bool IsFoldedInstr(const ir::Instr* instr) const { return folded_instrs_.contains(instr); }
+  void AddFoldedInstr(const ir::Instr* instr) { folded_instrs_.insert(instr); }
+  // Returns the folded address of the given load or store or nullptr if its address did not get
+  // folded.
+  const FoldedAddress* FoldedAddressOf(const ir::Instr* instr) const;
+  void SetFoldedAddress(const ir::Instr* instr, FoldedAddress address);
+
+  // Returns the select replacing the conditional jump at the end of the given block or nullptr if
+  // the conditional jump did not get replaced.
+  const Select* SelectOf(ir::block_num_t ir_block_num) const;
+  void AddSelect(ir::block_num_t ir_block_num, Select select);
+  // Select branches do not get translated, since their movs get generated in the branching block.
+  bool IsSelectBranch(ir::block_num_t ir_block_num) const {
+    return select_branches_.contains(ir_block_num);
+  }
+
  private:
   ProgramContext& program_ctx_;
 
@@ -100,7 +155,21 @@ class FuncContext {
   const ir_info::InterferenceGraphColors& interference_graph_colors_;
   std::unordered_set<ir_info::color_t> used_colors_;
 
+  static int64_t SpillSlotsSize(const std::unordered_set<ir_info::color_t>& used_colors);
+
+  std::unordered_map<const ir::StackAllocInstr*, int32_t> stack_alloc_offsets_;
+  int64_t spill_slots_size_;
+  int64_t stack_allocs_size_ = 0;
+
   std::unordered_map<ir::block_num_t, x86_64::block_num_t> ir_to_x86_64_block_nums_;
+  std::vector<const ir::Block*> ir_block_layout_;
+  std::unordered_map<ir::block_num_t, ir::block_num_t> ir_block_nums_after_;
+
+  std::unordered_set<const ir::Instr*> folded_instrs_;
+  std::unordered_map<const ir::Instr*, FoldedAddress> folded_addresses_;
+
+  std::unordered_map<ir::block_num_t, Select> selects_;
+  std::unordered_set<ir::block_num_t> select_branches_;
 };
 
 class BlockContext {
@@ -0,0 +1,71 @@
+//
+//  div_magic.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "div_magic.h"
+
+#include <bit>
+
+namespace ir_to_x86_64_translator {
+namespace {
+
+// Quotient of 2^p / d with up to 65 bits, and the remainder.
+struct PowerOfTwoQuotient {
+  bool bit_64;
+  uint64_t low_bits;
+  uint64_t remainder;
+};
+
+PowerOfTwoQuotient DividePowerOfTwo(int p, uint64_t d) {
+  PowerOfTwoQuotient quotient{.bit_64 = false, .low_bits = 0, .remainder = 1};
+  for (int i = 0; i < p; i++) {
+    quotient.bit_64 = (quotient.low_bits >> 63) != 0;
+    quotient.low_bits <<= 1;
+    // Doubles the remainder without overflowing 64 bits:
+    if (quotient.remainder >= d - quotient.remainder) {
+      quotient.remainder -= d - quotient.remainder;
+      quotient.low_bits |= 1;
+    } else {
+      quotient.remainder <<= 1;
+    }
+  }
+  return quotient;
+}
+
+}  // namespace
+
+DivMagic UnsignedDivMagic(uint64_t divisor, int8_t bit_size) {
+  // Finds the smallest multiplier m = ceil(2^p / d) with m * d - 2^p <= 2^(p - bit_size), which
+  // exists for p <= bit_size + ceil(log2(d)):
+  for (int p = bit_size;; p++) {
+    PowerOfTwoQuotient quotient = DividePowerOfTwo(p, divisor);
+    uint64_t error = divisor - quotient.remainder;
+    if (p - bit_size < 64 && error > (uint64_t{1} << (p - bit_size))) {
+      continue;
+    }
+    uint64_t multiplier = quotient.low_bits + 1;
+    if (p < 64) {
+      return DivMagic{.multiplier = multiplier << (64 - p), .add_dividend = false, .shift = 0};
+    }
+    return DivMagic{.multiplier = multiplier,
+                    .add_dividend = quotient.bit_64 || multiplier == 0,
+                    .shift = p - 64};
+  }
+}
+
+DivMagic SignedDivMagic(uint64_t abs_divisor, int8_t bit_size) {
+  int log2_divisor = 64 - std::countl_zero(abs_divisor - 1);
+  int p = bit_size - 1 + log2_divisor;
+  uint64_t multiplier = DividePowerOfTwo(p, abs_divisor).low_bits + 1;
+  if (p < 64) {
+    return DivMagic{.multiplier = multiplier << (64 - p), .add_dividend = false, .shift = 0};
+  }
+  return DivMagic{
+      .multiplier = multiplier, .add_dividend = (multiplier >> 63) != 0, .shift = p - 64};
+}
+
+}  // namespace ir_to_x86_64_translator
@@ -0,0 +1,36 @@
+//
+//  div_magic.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_to_x86_64_translator_div_magic_h
+#define ir_to_x86_64_translator_div_magic_h
+
+#include <cstdint>
+
+namespace ir_to_x86_64_translator {
+
+// Describes the multiply-high sequence replacing a division by a constant (see Granlund and
+// Montgomery, "Division by Invariant Integers using Multiplication"). The dividend, extended to 64
+// bits, gets multiplied with the multiplier and the high half of the product gets shifted right.
+struct DivMagic {
+  uint64_t multiplier;
+  // Unsigned: the multiplier has an additional 65th bit, which gets accounted for by adding the
+  // dividend to the high half of the product. Signed: the multiplier is negative when interpreted
+  // as a signed value, which gets accounted for by adding the dividend to the high half.
+  bool add_dividend;
+  int shift;
+};
+
+// Returns the magic numbers for unsigned divisors that are not a power of two.
+DivMagic UnsignedDivMagic(uint64_t divisor, int8_t bit_size);
+
+// Returns the magic numbers for the absolute value of signed divisors that are not a power of two.
+DivMagic SignedDivMagic(uint64_t abs_divisor, int8_t bit_size);
+
+}  // namespace ir_to_x86_64_translator
+
+#endif /* ir_to_x86_64_translator_div_magic_h */
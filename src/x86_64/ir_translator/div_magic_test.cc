@@ -0,0 +1,71 @@
+//
+//  div_magic_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/21/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/x86_64/ir_translator/div_magic.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ir_to_x86_64_translator {
+
+struct DivMagicTestCase {
+  uint64_t divisor;
+  int8_t bit_size;
+  uint64_t multiplier;
+  bool add_dividend;
+  int shift;
+};
+
+TEST(DivMagicTest, FindsUnsignedMagicNumbers) {
+  for (auto [divisor, bit_size, multiplier, add_dividend, shift] : std::vector<DivMagicTestCase>{
+           DivMagicTestCase{3, 8, 0x5580000000000000, false, 0},
+           DivMagicTestCase{7, 8, 0x24a0000000000000, false, 0},
+           DivMagicTestCase{10, 8, 0x19a0000000000000, false, 0},
+           DivMagicTestCase{255, 8, 0x0102000000000000, false, 0},
+           DivMagicTestCase{7, 16, 0x2492600000000000, false, 0},
+           DivMagicTestCase{3, 32, 0x5555555580000000, false, 0},
+           DivMagicTestCase{7, 32, 0x24924924a0000000, false, 0},
+           DivMagicTestCase{641, 32, 0x00663d8100000000, false, 0},
+           DivMagicTestCase{0xffffffff, 32, 0x0000000100000002, false, 0},
+           DivMagicTestCase{3, 64, 0xaaaaaaaaaaaaaaab, false, 1},
+           DivMagicTestCase{7, 64, 0x2492492492492493, true, 3},
+           DivMagicTestCase{10, 64, 0xcccccccccccccccd, false, 3},
+           DivMagicTestCase{0x8000000000000001, 64, 0xffffffffffffffff, false, 63},
+           DivMagicTestCase{0xffffffffffffffff, 64, 0x8000000000000001, false, 63}}) {
+    DivMagic magic = UnsignedDivMagic(divisor, bit_size);
+    EXPECT_EQ(magic.multiplier, multiplier) << "u" << int{bit_size} << " / " << divisor;
+    EXPECT_EQ(magic.add_dividend, add_dividend) << "u" << int{bit_size} << " / " << divisor;
+    EXPECT_EQ(magic.shift, shift) << "u" << int{bit_size} << " / " << divisor;
+  }
+}
+
+TEST(DivMagicTest, FindsSignedMagicNumbers) {
+  for (auto [abs_divisor, bit_size, multiplier, add_dividend, shift] :
+       std::vector<DivMagicTestCase>{
+           DivMagicTestCase{3, 8, 0x5580000000000000, false, 0},
+           DivMagicTestCase{7, 8, 0x24c0000000000000, false, 0},
+           DivMagicTestCase{127, 8, 0x0208000000000000, false, 0},
+           DivMagicTestCase{7, 16, 0x2492800000000000, false, 0},
+           DivMagicTestCase{3, 32, 0x5555555580000000, false, 0},
+           DivMagicTestCase{5, 32, 0x3333333340000000, false, 0},
+           DivMagicTestCase{7, 32, 0x24924924c0000000, false, 0},
+           DivMagicTestCase{0x7fffffff, 32, 0x0000000200000008, false, 0},
+           DivMagicTestCase{3, 64, 0xaaaaaaaaaaaaaaab, true, 1},
+           DivMagicTestCase{7, 64, 0x924924924924924a, true, 2},
+           DivMagicTestCase{10, 64, 0xcccccccccccccccd, true, 3},
+           DivMagicTestCase{0x7fffffffffffffff, 64, 0x8000000000000002, true, 62}}) {
+    DivMagic magic = SignedDivMagic(abs_divisor, bit_size);
+    EXPECT_EQ(magic.multiplier, multiplier) << "i" << int{bit_size} << " / " << abs_divisor;
+    EXPECT_EQ(magic.add_dividend, add_dividend) << "i" << int{bit_size} << " / " << abs_divisor;
+    EXPECT_EQ(magic.shift, shift) << "i" << int{bit_size} << " / " << abs_divisor;
+  }
+}
+
+}  // namespace ir_to_x86_64_translator
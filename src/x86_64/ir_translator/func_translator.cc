@@ -9,16 +9,29 @@
 #include "func_translator.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_set>
 #include <vector>
 
+#include "src/common/logging/logging.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/info/loop_info.h"
 #include "src/ir/representation/block.h"
 #include "src/x86_64/block.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
 #include "src/x86_64/instrs/control_flow_instrs.h"
 #include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/ir_translator/address_selector.h"
+#include "src/x86_64/ir_translator/call_generator.h"
 #include "src/x86_64/ir_translator/instrs_translator.h"
 #include "src/x86_64/ir_translator/register_allocator.h"
+#include "src/x86_64/ir_translator/select_generator.h"
 
 namespace ir_to_x86_64_translator {
+
+using ::common::logging::fail;
+
 namespace {
 
 std::vector<const ir::Block*> GetSortedBlocksInFunc(const ir::Func* ir_func) {
@@ -41,26 +54,92 @@ std::vector<const ir::Block*> GetSortedBlocksInFunc(const ir::Func* ir_func) {
   return ir_blocks;
 }
 
-std::vector<x86_64::Block*> PrepareBlocks(std::vector<const ir::Block*>& ir_blocks,
-                                          FuncContext& func_ctx) {
-  std::vector<x86_64::Block*> x86_64_blocks;
-  x86_64_blocks.reserve(ir_blocks.size());
-  for (const ir::Block* ir_block : ir_blocks) {
-    x86_64::Block* x86_64_block = func_ctx.x86_64_func()->AddBlock();
+// Returns the unplaced child of the given block that should be placed directly after it, such that
+// control flow can fall through to the child. Children inside the most deeply nested loop are
+// preferred, which keeps loop bodies contiguous and places loop exits out of line. Returns nullptr
+// if all children are already placed. The only child of blocks ending in a select is the join
+// block.
+const ir::Block* FindFallThroughChild(const ir::Func* ir_func, const ir::Block* ir_block,
+                                      const ir_info::LoopInfo& loop_info,
+                                      const std::unordered_set<ir::block_num_t>& placed_blocks,
+                                      const FuncContext& ctx) {
+  std::unordered_set<ir::block_num_t> children = ir_block->children();
+  if (const Select* select = ctx.SelectOf(ir_block->number())) {
+    children = {select->join_block};
+  }
+  const ir::Block* best_child = nullptr;
+  int64_t best_depth = -1;
+  for (ir::block_num_t child_num : children) {
+    if (placed_blocks.contains(child_num)) {
+      continue;
+    }
+    int64_t depth = loop_info.LoopDepthOfBlock(child_num);
+    if (depth > best_depth || (depth == best_depth && child_num < best_child->number())) {
+      best_child = ir_func->GetBlock(child_num);
+      best_depth = depth;
+    }
+  }
+  return best_child;
+}
 
-    x86_64_blocks.push_back(x86_64_block);
-    func_ctx.set_x86_64_block_num_for_ir_block_num(ir_block->number(), x86_64_block->block_num());
+// Returns the blocks of the func in the order they get placed in the translated func. Starting at
+// the entry block, blocks get chained to their preferred child (see FindFallThroughChild). When a
+// chain ends, the next chain starts at the unplaced block with the lowest number. Select branches
+// do not get placed.
+std::vector<const ir::Block*> GetBlockLayoutForFunc(const FuncContext& ctx) {
+  const ir::Func* ir_func = ctx.ir_func();
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(ir_func);
+  std::vector<const ir::Block*> sorted_blocks = GetSortedBlocksInFunc(ir_func);
+  std::vector<const ir::Block*> layout;
+  layout.reserve(sorted_blocks.size());
+  std::unordered_set<ir::block_num_t> placed_blocks;
+  for (const ir::Block* ir_block : sorted_blocks) {
+    if (ctx.IsSelectBranch(ir_block->number())) {
+      placed_blocks.insert(ir_block->number());
+    }
   }
-  return x86_64_blocks;
+  auto next_unplaced_it = sorted_blocks.begin();
+  const ir::Block* ir_block = ir_func->entry_block();
+  while (ir_block != nullptr) {
+    layout.push_back(ir_block);
+    placed_blocks.insert(ir_block->number());
+
+    ir_block = FindFallThroughChild(ir_func, ir_block, loop_info, placed_blocks, ctx);
+    if (ir_block != nullptr) {
+      continue;
+    }
+    while (next_unplaced_it != sorted_blocks.end() &&
+           placed_blocks.contains((*next_unplaced_it)->number())) {
+      ++next_unplaced_it;
+    }
+    if (next_unplaced_it != sorted_blocks.end()) {
+      ir_block = *next_unplaced_it;
+    }
+  }
+  return layout;
 }
 
 void TranslateBlock(BlockContext& ctx) {
+  if (ctx.ir_block()->number() == ctx.ir_func()->entry_block_num()) {
+    GenerateFuncArgMoves(ctx);
+  }
+  ir::CallInstr* ir_sibling_call = FindSiblingCall(ctx.ir_func(), ctx.ir_block());
   for (auto& ir_instr : ctx.ir_block()->instrs()) {
+    if (ctx.func_ctx().IsFoldedInstr(ir_instr.get())) {
+      continue;
+    }
+    if (ir_instr.get() == ir_sibling_call) {
+      // The return instr following the sibling call gets replaced by the jump to the called func:
+      GenerateSiblingCallArgMoves(ir_sibling_call, ctx);
+      break;
+    }
     TranslateInstr(ir_instr.get(), ctx);
   }
 }
 
-void ForEachUsedCalleeSavedRegister(std::function<void(x86_64::Reg)> func, FuncContext& ctx) {
+// Returns the callee saved registers used in the func, sorted by register number.
+std::vector<x86_64::Reg> GetUsedCalleeSavedRegisters(FuncContext& ctx) {
+  std::vector<x86_64::Reg> regs;
   for (ir_info::color_t color : ctx.used_colors()) {
     x86_64::RM rm = ColorAndSizeToOperand(color, x86_64::k64);
     if (!rm.is_reg()) {
@@ -70,59 +149,132 @@ void ForEachUsedCalleeSavedRegister(std::function<void(x86_64::Reg)> func, FuncC
     if (SavingBehaviourForReg(reg) != RegSavingBehaviour::kByCallee) {
       continue;
     }
-    func(reg);
+    regs.push_back(reg);
   }
+  std::sort(regs.begin(), regs.end(),
+            [](x86_64::Reg reg_x, x86_64::Reg reg_y) { return reg_x.reg() < reg_y.reg(); });
+  return regs;
 }
 
-void GenerateFuncPrologue(BlockContext& ctx) {
+bool MakesCalls(const x86_64::Func* x86_64_func) {
+  for (auto& x86_64_block : x86_64_func->blocks()) {
+    for (auto& x86_64_instr : x86_64_block->instrs()) {
+      if (x86_64_instr->instr_kind() == x86_64::InstrKind::kCall) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+struct FrameLayout {
+  // Leaf funcs without spill slots, stack allocs, or args and results passed on the stack do not
+  // set up the base pointer.
+  bool uses_base_pointer;
+  // The number of bytes reserved below the base pointer, including padding that keeps the stack
+  // pointer 16 byte aligned for calls made from the func.
+  int64_t frame_size;
+  // The callee saved registers used in the func, pushed below the frame.
+  std::vector<x86_64::Reg> callee_saved_regs;
+};
+
+FrameLayout GetFrameLayout(FuncContext& ctx) {
+  const ir::Func* ir_func = ctx.ir_func();
+  bool makes_calls = MakesCalls(ctx.x86_64_func());
+  FrameLayout layout{
+      .uses_base_pointer = makes_calls || ctx.frame_size() > 0 ||
+                           StackArgCount(int(ir_func->args().size())) > 0 ||
+                           StackResultCount(int(ir_func->result_types().size())) > 0,
+      .frame_size = (ctx.frame_size() + 7) / 8 * 8,
+      .callee_saved_regs = GetUsedCalleeSavedRegisters(ctx),
+  };
+  if (makes_calls && (layout.frame_size / 8 + layout.callee_saved_regs.size()) % 2 == 1) {
+    // The return address and base pointer already take up 16 bytes:
+    layout.frame_size += 8;
+  }
+  return layout;
+}
+
+void GenerateFuncPrologue(const FrameLayout& layout, BlockContext& ctx) {
   std::vector<std::unique_ptr<x86_64::Instr>>::const_iterator it =
       ctx.x86_64_block()->instrs().begin();
-  it = ctx.x86_64_block()->InsertInstr<x86_64::Push>(it, x86_64::rbp);
-  ++it;
-  it = ctx.x86_64_block()->InsertInstr<x86_64::Mov>(it, x86_64::rbp, x86_64::rsp);
-  ++it;
-  ForEachUsedCalleeSavedRegister(
-      [&it, &ctx](x86_64::Reg reg) {
-        it = ctx.x86_64_block()->InsertInstr<x86_64::Push>(it, reg);
-        ++it;
-      },
-      ctx.func_ctx());
-  // TODO: reserve stack space
+  if (layout.uses_base_pointer) {
+    it = ctx.x86_64_block()->InsertInstr<x86_64::Push>(it, x86_64::rbp);
+    ++it;
+    it = ctx.x86_64_block()->InsertInstr<x86_64::Mov>(it, x86_64::rbp, x86_64::rsp);
+    ++it;
+  }
+  if (layout.frame_size > std::numeric_limits<int8_t>::max()) {
+    it = ctx.x86_64_block()->InsertInstr<x86_64::Sub>(it, x86_64::rsp,
+                                                      x86_64::Imm(int32_t(layout.frame_size)));
+    ++it;
+  } else if (layout.frame_size > 0) {
+    it = ctx.x86_64_block()->InsertInstr<x86_64::Sub>(it, x86_64::rsp,
+                                                      x86_64::Imm(int8_t(layout.frame_size)));
+    ++it;
+  }
+  for (x86_64::Reg reg : layout.callee_saved_regs) {
+    it = ctx.x86_64_block()->InsertInstr<x86_64::Push>(it, reg);
+    ++it;
+  }
 }
 
-void GenerateFuncEpilogue(BlockContext& ctx) {
-  // TODO: revert stack pointer
-  ForEachUsedCalleeSavedRegister(
-      [&ctx](x86_64::Reg reg) { ctx.x86_64_block()->AddInstr<x86_64::Pop>(reg); }, ctx.func_ctx());
-  ctx.x86_64_block()->AddInstr<x86_64::Pop>(x86_64::rbp);
-  ctx.x86_64_block()->AddInstr<x86_64::Ret>();
+void GenerateFuncEpilogue(const FrameLayout& layout, BlockContext& ctx) {
+  for (auto it = layout.callee_saved_regs.rbegin(); it != layout.callee_saved_regs.rend(); ++it) {
+    ctx.x86_64_block()->AddInstr<x86_64::Pop>(*it);
+  }
+  if (layout.frame_size > 0) {
+    ctx.x86_64_block()->AddInstr<x86_64::Leave>();
+  } else if (layout.uses_base_pointer) {
+    ctx.x86_64_block()->AddInstr<x86_64::Pop>(x86_64::rbp);
+  }
 }
 
 }  // namespace
 
+void PrepareFunc(FuncContext& func_ctx) {
+  FindSelectsInFunc(func_ctx);
+  func_ctx.set_ir_block_layout(GetBlockLayoutForFunc(func_ctx));
+  for (const ir::Block* ir_block : func_ctx.ir_block_layout()) {
+    x86_64::Block* x86_64_block = func_ctx.x86_64_func()->AddBlock();
+
+    func_ctx.set_x86_64_block_num_for_ir_block_num(ir_block->number(), x86_64_block->block_num());
+  }
+}
+
 void TranslateFunc(FuncContext& func_ctx) {
-  std::vector<const ir::Block*> ir_blocks = GetSortedBlocksInFunc(func_ctx.ir_func());
-  std::vector<x86_64::Block*> x86_64_blocks = PrepareBlocks(ir_blocks, func_ctx);
+  const std::vector<const ir::Block*>& ir_blocks = func_ctx.ir_block_layout();
+  const std::vector<std::unique_ptr<x86_64::Block>>& x86_64_blocks =
+      func_ctx.x86_64_func()->blocks();
+  if (x86_64_blocks.size() != ir_blocks.size()) {
+    fail("attempted to translate func that was not prepared");
+  }
+  FoldAddressesInFunc(func_ctx);
 
   for (std::size_t i = 0; i < ir_blocks.size(); i++) {
     const ir::Block* ir_block = ir_blocks.at(i);
-    x86_64::Block* x86_64_block = x86_64_blocks.at(i);
+    x86_64::Block* x86_64_block = x86_64_blocks.at(i).get();
 
     BlockContext block_ctx(func_ctx, ir_block, x86_64_block);
     TranslateBlock(block_ctx);
   }
 
+  const FrameLayout frame_layout = GetFrameLayout(func_ctx);
   for (std::size_t i = 0; i < ir_blocks.size(); i++) {
     const ir::Block* ir_block = ir_blocks.at(i);
-    x86_64::Block* x86_64_block = x86_64_blocks.at(i);
+    x86_64::Block* x86_64_block = x86_64_blocks.at(i).get();
 
     BlockContext block_ctx(func_ctx, ir_block, x86_64_block);
 
     if (ir_block->number() == func_ctx.ir_func()->entry_block_num()) {
-      GenerateFuncPrologue(block_ctx);
+      GenerateFuncPrologue(frame_layout, block_ctx);
     }
-    if (ir_block->instrs().back()->instr_kind() == ir::InstrKind::kReturn) {
-      GenerateFuncEpilogue(block_ctx);
+    if (ir::CallInstr* ir_sibling_call = FindSiblingCall(func_ctx.ir_func(), ir_block)) {
+      GenerateFuncEpilogue(frame_layout, block_ctx);
+      GenerateSiblingCallJump(ir_sibling_call, block_ctx);
+    } else if (ir_block->instrs().back()->instr_kind() == ir::InstrKind::kReturn) {
+      GenerateFuncEpilogue(frame_layout, block_ctx);
+      block_ctx.x86_64_block()->AddInstr<x86_64::Ret>();
     }
   }
 }
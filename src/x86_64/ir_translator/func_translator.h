@@ -13,6 +13,12 @@
 
 namespace ir_to_x86_64_translator {
 
+// Adds an x86_64 block for every IR block. Block numbers are shared across the x86_64 program, so
+// funcs have to be prepared one after another and in a fixed order.
+void PrepareFunc(FuncContext& func_ctx);
+
+// Translates the IR blocks into the x86_64 blocks added by PrepareFunc. Different funcs can be
+// translated concurrently.
 void TranslateFunc(FuncContext& func_ctx);
 
 }
@@ -8,9 +8,13 @@
 
 #include "arithmetic_logic_instrs_translator.h"
 
+#include <bit>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "src/common/logging/logging.h"
 #include "src/ir/representation/values.h"
@@ -18,7 +22,9 @@
 #include "src/x86_64/instrs/data_instrs.h"
 #include "src/x86_64/instrs/instr.h"
 #include "src/x86_64/instrs/instr_cond.h"
+#include "src/x86_64/ir_translator/div_magic.h"
 #include "src/x86_64/ir_translator/mov_generator.h"
+#include "src/x86_64/ir_translator/register_allocator.h"
 #include "src/x86_64/ir_translator/size_translator.h"
 #include "src/x86_64/ir_translator/temporary_reg.h"
 #include "src/x86_64/ir_translator/value_translator.h"
@@ -137,10 +143,10 @@ void TranslateIntUnaryInstr(ir::IntUnaryInstr* ir_int_unary_instr, BlockContext&
 
   switch (ir_int_unary_instr->operation()) {
     case Int::UnaryOp::kNot:
-      ctx.x86_64_block()->AddInstr<x86_64::Not>(x86_64_operand);
+      ctx.x86_64_block()->AddInstr<x86_64::Not>(x86_64_result);
       break;
     case Int::UnaryOp::kNeg:
-      ctx.x86_64_block()->AddInstr<x86_64::Neg>(x86_64_operand);
+      ctx.x86_64_block()->AddInstr<x86_64::Neg>(x86_64_result);
       break;
     default:
       fail("unexpected unary int op");
@@ -359,8 +365,327 @@ void TranslateIntMulInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext&
   }
 }
 
+namespace {
+
+using ::common::atomics::IntType;
+
+// Returns an imm with the given value for an operand of the given size, using the shortest
+// encoding. The value has to be representable as a (sign extended) imm of the operand size.
+x86_64::Imm SmallestImmForSize(int32_t value, x86_64::Size size) {
+  if (std::numeric_limits<int8_t>::min() <= value && value <= std::numeric_limits<int8_t>::max()) {
+    return x86_64::Imm(int8_t(value));
+  } else if (size == x86_64::k16) {
+    return x86_64::Imm(int16_t(value));
+  }
+  return x86_64::Imm(int32_t(value));
+}
+
+x86_64::Imm ZeroImmForSize(x86_64::Size size) {
+  switch (size) {
+    case x86_64::k8:
+      return x86_64::Imm(int8_t{0});
+    case x86_64::k16:
+      return x86_64::Imm(int16_t{0});
+    case x86_64::k32:
+      return x86_64::Imm(int32_t{0});
+    case x86_64::k64:
+      return x86_64::Imm(int64_t{0});
+  }
+}
+
+// Returns if the register holds a value that is still needed after the instr. Results of the instr
+// and values last used by the instr do not need to be preserved.
+bool IsRegLiveAfterInstr(x86_64::Reg reg, const ir::Instr* instr, BlockContext& ctx) {
+  ir_info::color_t reg_color = OperandToColor(reg);
+  for (ir::value_num_t live_value : ctx.live_ranges().GetLiveSet(instr)) {
+    if (ctx.live_ranges().ValueDefinitionOf(live_value) == instr ||
+        ctx.live_ranges().LastValueUseOf(live_value) == instr) {
+      continue;
+    }
+    if (ctx.func_ctx().interference_graph_colors().GetColor(live_value) == reg_color) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Reserves rax and rdx, which get used implicitly by mul, imul, div, and idiv, for the instr. The
+// registers get pushed if they hold values needed after the instr. Returns the pushed registers.
+std::vector<x86_64::Reg> ReserveRegsAD(const ir::Instr* instr, BlockContext& ctx) {
+  std::vector<x86_64::Reg> saved_regs;
+  for (x86_64::Reg reg : {x86_64::rax, x86_64::rdx}) {
+    ir_info::color_t color = OperandToColor(reg);
+    ctx.func_ctx().AddUsedColor(color);
+    ctx.AddTemporaryColorUsedDuringInstr(instr, color);
+    if (IsRegLiveAfterInstr(reg, instr, ctx)) {
+      ctx.x86_64_block()->AddInstr<x86_64::Push>(reg);
+      saved_regs.push_back(reg);
+    }
+  }
+  return saved_regs;
+}
+
+void RestoreRegsAD(const std::vector<x86_64::Reg>& saved_regs, BlockContext& ctx) {
+  for (auto it = saved_regs.rbegin(); it != saved_regs.rend(); ++it) {
+    ctx.x86_64_block()->AddInstr<x86_64::Pop>(*it);
+  }
+}
+
+// Moves the int operand to the 64-bit register, sign or zero extended depending on the int type.
+void GenerateExtendingMov(x86_64::Reg reg, x86_64::Operand operand, IntType int_type,
+                          BlockContext& ctx) {
+  int8_t bit_size = common::atomics::BitSizeOf(int_type);
+  ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64::Resize(reg, operand.size()), operand);
+  if (bit_size == 64 || (bit_size == 32 && common::atomics::IsUnsigned(int_type))) {
+    // 32-bit movs clear the upper half of the register.
+    return;
+  }
+  if (common::atomics::IsUnsigned(int_type)) {
+    ctx.x86_64_block()->AddInstr<x86_64::And>(x86_64::Resize(reg, x86_64::k32),
+                                              x86_64::Imm(int32_t((1 << bit_size) - 1)));
+  } else {
+    x86_64::Imm shift(int8_t(64 - bit_size));
+    ctx.x86_64_block()->AddInstr<x86_64::Shl>(reg, shift);
+    ctx.x86_64_block()->AddInstr<x86_64::Sar>(reg, shift);
+  }
+}
+
+void GenerateUnsignedDivOrRemByPowerOfTwo(ir::IntBinaryInstr* ir_int_binary_instr,
+                                          x86_64::RM x86_64_result,
+                                          x86_64::Operand x86_64_dividend, uint64_t divisor,
+                                          BlockContext& ctx) {
+  GenerateMov(x86_64_result, x86_64_dividend, ir_int_binary_instr, ctx);
+  if (ir_int_binary_instr->operation() == Int::BinaryOp::kDiv) {
+    ctx.x86_64_block()->AddInstr<x86_64::Shr>(x86_64_result,
+                                              x86_64::Imm(int8_t(std::countr_zero(divisor))));
+    return;
+  }
+  uint64_t mask = divisor - 1;
+  if (mask <= uint64_t{std::numeric_limits<int32_t>::max()}) {
+    ctx.x86_64_block()->AddInstr<x86_64::And>(
+        x86_64_result, SmallestImmForSize(int32_t(mask), x86_64_result.size()));
+  } else {
+    TemporaryReg tmp = TemporaryReg::ForOperand(x86_64::Imm(int64_t(mask)),
+                                                /*can_use_result_reg=*/false, ir_int_binary_instr,
+                                                ctx);
+    ctx.x86_64_block()->AddInstr<x86_64::And>(x86_64_result, tmp.reg());
+    tmp.Restore(ctx);
+  }
+}
+
+// Signed division by 2^k rounds towards zero, which requires adding 2^k - 1 to negative dividends
+// before shifting. The remainder is the dividend minus the rounded dividend with the lower k bits
+// cleared.
+void GenerateSignedDivOrRemByPowerOfTwo(ir::IntBinaryInstr* ir_int_binary_instr,
+                                        x86_64::RM x86_64_result, x86_64::Operand x86_64_dividend,
+                                        uint64_t abs_divisor, bool divisor_is_negative,
+                                        BlockContext& ctx) {
+  x86_64::Size x86_64_size = x86_64_result.size();
+  int8_t bit_size = int8_t(x86_64_size);
+  int8_t shift = int8_t(std::countr_zero(abs_divisor));
+
+  TemporaryReg dividend = TemporaryReg::ForOperand(
+      x86_64_dividend, /*can_use_result_reg=*/true, ir_int_binary_instr, ctx);
+  TemporaryReg rounded = TemporaryReg::Prepare(x86_64_size, /*can_use_result_reg=*/false,
+                                               ir_int_binary_instr, ctx);
+  ctx.x86_64_block()->AddInstr<x86_64::Mov>(rounded.reg(), dividend.reg());
+  if (shift > 1) {
+    ctx.x86_64_block()->AddInstr<x86_64::Sar>(rounded.reg(), x86_64::Imm(int8_t(bit_size - 1)));
+  }
+  ctx.x86_64_block()->AddInstr<x86_64::Shr>(rounded.reg(), x86_64::Imm(int8_t(bit_size - shift)));
+  ctx.x86_64_block()->AddInstr<x86_64::Add>(rounded.reg(), dividend.reg());
+
+  if (ir_int_binary_instr->operation() == Int::BinaryOp::kDiv) {
+    ctx.x86_64_block()->AddInstr<x86_64::Sar>(rounded.reg(), x86_64::Imm(shift));
+    if (divisor_is_negative) {
+      ctx.x86_64_block()->AddInstr<x86_64::Neg>(rounded.reg());
+    }
+    GenerateMov(x86_64_result, rounded.reg(), ir_int_binary_instr, ctx);
+  } else {
+    if (shift < 32) {
+      ctx.x86_64_block()->AddInstr<x86_64::And>(
+          rounded.reg(), SmallestImmForSize(int32_t(-(int64_t{1} << shift)), x86_64_size));
+    } else {
+      ctx.x86_64_block()->AddInstr<x86_64::Sar>(rounded.reg(), x86_64::Imm(shift));
+      ctx.x86_64_block()->AddInstr<x86_64::Shl>(rounded.reg(), x86_64::Imm(shift));
+    }
+    ctx.x86_64_block()->AddInstr<x86_64::Sub>(dividend.reg(), rounded.reg());
+    GenerateMov(x86_64_result, dividend.reg(), ir_int_binary_instr, ctx);
+  }
+
+  rounded.Restore(ctx);
+  dividend.Restore(ctx);
+}
+
+void GenerateDivOrRemByMagicNumber(ir::IntBinaryInstr* ir_int_binary_instr,
+                                   x86_64::RM x86_64_result, x86_64::Operand x86_64_dividend,
+                                   Int divisor, uint64_t abs_divisor, BlockContext& ctx) {
+  IntType int_type = divisor.type();
+  int8_t bit_size = common::atomics::BitSizeOf(int_type);
+  bool is_signed = common::atomics::IsSigned(int_type);
+  DivMagic magic =
+      is_signed ? SignedDivMagic(abs_divisor, bit_size) : UnsignedDivMagic(abs_divisor, bit_size);
+
+  std::vector<x86_64::Reg> saved_regs = ReserveRegsAD(ir_int_binary_instr, ctx);
+  TemporaryReg dividend =
+      TemporaryReg::Prepare(x86_64::k64, /*can_use_result_reg=*/true, ir_int_binary_instr, ctx);
+  GenerateExtendingMov(dividend.reg(), x86_64_dividend, int_type, ctx);
+
+  ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64::rax, x86_64::Imm(int64_t(magic.multiplier)));
+  x86_64::Reg quotient = x86_64::rdx;
+  if (is_signed) {
+    // quotient = ((dividend * multiplier) >> (64 + shift)) + (dividend < 0 ? 1 : 0)
+    ctx.x86_64_block()->AddInstr<x86_64::Imul>(dividend.reg());
+    if (magic.add_dividend) {
+      ctx.x86_64_block()->AddInstr<x86_64::Add>(x86_64::rdx, dividend.reg());
+    }
+    if (magic.shift > 0) {
+      ctx.x86_64_block()->AddInstr<x86_64::Sar>(x86_64::rdx, x86_64::Imm(int8_t(magic.shift)));
+    }
+    ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64::rax, dividend.reg());
+    ctx.x86_64_block()->AddInstr<x86_64::Sar>(x86_64::rax, x86_64::Imm(int8_t{63}));
+    ctx.x86_64_block()->AddInstr<x86_64::Sub>(x86_64::rdx, x86_64::rax);
+    if (divisor.IsLessThanZero()) {
+      ctx.x86_64_block()->AddInstr<x86_64::Neg>(x86_64::rdx);
+    }
+  } else {
+    // quotient = (dividend * multiplier) >> (64 + shift)
+    ctx.x86_64_block()->AddInstr<x86_64::Mul>(dividend.reg());
+    if (magic.add_dividend) {
+      // Adds the dividend to the high half without overflowing 64 bits:
+      // quotient = (((dividend - high) >> 1) + high) >> (shift - 1)
+      ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64::rax, dividend.reg());
+      ctx.x86_64_block()->AddInstr<x86_64::Sub>(x86_64::rax, x86_64::rdx);
+      ctx.x86_64_block()->AddInstr<x86_64::Shr>(x86_64::rax, x86_64::Imm(int8_t{1}));
+      ctx.x86_64_block()->AddInstr<x86_64::Add>(x86_64::rax, x86_64::rdx);
+      if (magic.shift > 1) {
+        ctx.x86_64_block()->AddInstr<x86_64::Shr>(x86_64::rax,
+                                                  x86_64::Imm(int8_t(magic.shift - 1)));
+      }
+      quotient = x86_64::rax;
+    } else if (magic.shift > 0) {
+      ctx.x86_64_block()->AddInstr<x86_64::Shr>(x86_64::rdx, x86_64::Imm(int8_t(magic.shift)));
+    }
+  }
+
+  if (ir_int_binary_instr->operation() == Int::BinaryOp::kDiv) {
+    GenerateMov(x86_64_result, x86_64::Resize(quotient, x86_64_result.size()),
+                ir_int_binary_instr, ctx);
+  } else {
+    // remainder = dividend - quotient * divisor
+    int64_t divisor_value = is_signed ? divisor.AsInt64() : int64_t(abs_divisor);
+    if (is_signed ? divisor_value >= std::numeric_limits<int32_t>::min() &&
+                        divisor_value <= std::numeric_limits<int32_t>::max()
+                  : abs_divisor <= uint64_t{std::numeric_limits<int32_t>::max()}) {
+      ctx.x86_64_block()->AddInstr<x86_64::Imul>(
+          quotient, quotient, SmallestImmForSize(int32_t(divisor_value), x86_64::k64));
+    } else {
+      x86_64::Reg factor = (quotient == x86_64::rax) ? x86_64::rdx : x86_64::rax;
+      ctx.x86_64_block()->AddInstr<x86_64::Mov>(factor, x86_64::Imm(divisor_value));
+      ctx.x86_64_block()->AddInstr<x86_64::Imul>(quotient, factor);
+    }
+    ctx.x86_64_block()->AddInstr<x86_64::Sub>(dividend.reg(), quotient);
+    GenerateMov(x86_64_result, x86_64::Resize(dividend.reg(), x86_64_result.size()),
+                ir_int_binary_instr, ctx);
+  }
+
+  dividend.Restore(ctx);
+  RestoreRegsAD(saved_regs, ctx);
+}
+
+}  // namespace
+
 void TranslateIntDivOrRemInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext& ctx) {
-  // TODO: implement
+  if (ir::Value* ir_divisor = ir_int_binary_instr->operand_b().get();
+      ir_divisor->kind() == ir::Value::Kind::kConstant &&
+      static_cast<ir::IntConstant*>(ir_divisor)->value().IsNotZero()) {
+    TranslateIntDivOrRemByConstantInstr(ir_int_binary_instr, ctx);
+  } else {
+    TranslateIntDivOrRemByValueInstr(ir_int_binary_instr, ctx);
+  }
+}
+
+void TranslateIntDivOrRemByConstantInstr(ir::IntBinaryInstr* ir_int_binary_instr,
+                                         BlockContext& ctx) {
+  // Note: It is assumed that the dividend is not a constant. A constant folding optimization pass
+  // should ensure this.
+  Int divisor = static_cast<ir::IntConstant*>(ir_int_binary_instr->operand_b().get())->value();
+  bool is_signed = common::atomics::IsSigned(divisor.type());
+  bool divisor_is_negative = divisor.IsLessThanZero();
+  uint64_t abs_divisor = !is_signed             ? divisor.AsUint64()
+                         : divisor_is_negative ? uint64_t{0} - uint64_t(divisor.AsInt64())
+                                               : uint64_t(divisor.AsInt64());
+
+  x86_64::RM x86_64_result = TranslateComputed(ir_int_binary_instr->result().get(), ctx.func_ctx());
+  x86_64::Operand x86_64_dividend = TranslateValue(ir_int_binary_instr->operand_a().get(),
+                                                   IntNarrowing::kNone, ctx.func_ctx());
+
+  if (abs_divisor == 1) {
+    if (ir_int_binary_instr->operation() == Int::BinaryOp::kRem) {
+      GenerateMov(x86_64_result, ZeroImmForSize(x86_64_result.size()), ir_int_binary_instr, ctx);
+      return;
+    }
+    GenerateMov(x86_64_result, x86_64_dividend, ir_int_binary_instr, ctx);
+    if (divisor_is_negative) {
+      ctx.x86_64_block()->AddInstr<x86_64::Neg>(x86_64_result);
+    }
+  } else if (std::has_single_bit(abs_divisor)) {
+    if (is_signed) {
+      GenerateSignedDivOrRemByPowerOfTwo(ir_int_binary_instr, x86_64_result, x86_64_dividend,
+                                         abs_divisor, divisor_is_negative, ctx);
+    } else {
+      GenerateUnsignedDivOrRemByPowerOfTwo(ir_int_binary_instr, x86_64_result, x86_64_dividend,
+                                           abs_divisor, ctx);
+    }
+  } else {
+    GenerateDivOrRemByMagicNumber(ir_int_binary_instr, x86_64_result, x86_64_dividend, divisor,
+                                  abs_divisor, ctx);
+  }
+}
+
+void TranslateIntDivOrRemByValueInstr(ir::IntBinaryInstr* ir_int_binary_instr,
+                                      BlockContext& ctx) {
+  auto ir_type = static_cast<const ir::IntType*>(ir_int_binary_instr->result()->type());
+  IntType int_type = ir_type->int_type();
+  bool is_signed = common::atomics::IsSigned(int_type);
+  x86_64::RM x86_64_result = TranslateComputed(ir_int_binary_instr->result().get(), ctx.func_ctx());
+  x86_64::Operand x86_64_dividend = TranslateValue(ir_int_binary_instr->operand_a().get(),
+                                                   IntNarrowing::kNone, ctx.func_ctx());
+  x86_64::Operand x86_64_divisor = TranslateValue(ir_int_binary_instr->operand_b().get(),
+                                                  IntNarrowing::kNone, ctx.func_ctx());
+  // Divisions of 8-bit and 16-bit ints are performed on 32-bit ints, since 8-bit divisions store
+  // the remainder in ah:
+  x86_64::Size x86_64_size = x86_64_result.size();
+  x86_64::Size x86_64_div_size = (x86_64_size == x86_64::k64) ? x86_64::k64 : x86_64::k32;
+
+  std::vector<x86_64::Reg> saved_regs = ReserveRegsAD(ir_int_binary_instr, ctx);
+  std::optional<TemporaryReg> divisor;
+  if (x86_64_divisor.is_imm() || x86_64_size != x86_64_div_size ||
+      (x86_64_divisor.is_reg() && (x86_64_divisor.reg().reg() == x86_64::rax.reg() ||
+                                   x86_64_divisor.reg().reg() == x86_64::rdx.reg()))) {
+    divisor =
+        TemporaryReg::Prepare(x86_64::k64, /*can_use_result_reg=*/true, ir_int_binary_instr, ctx);
+    GenerateExtendingMov(divisor->reg(), x86_64_divisor, int_type, ctx);
+    x86_64_divisor = x86_64::Resize(divisor->reg(), x86_64_div_size);
+  }
+  GenerateExtendingMov(x86_64::rax, x86_64_dividend, int_type, ctx);
+
+  if (is_signed) {
+    ctx.x86_64_block()->AddInstr<x86_64::SignExtendRegAD>(x86_64_div_size);
+    ctx.x86_64_block()->AddInstr<x86_64::Idiv>(x86_64_divisor.rm());
+  } else {
+    ctx.x86_64_block()->AddInstr<x86_64::Xor>(x86_64::edx, x86_64::edx);
+    ctx.x86_64_block()->AddInstr<x86_64::Div>(x86_64_divisor.rm());
+  }
+  x86_64::Reg x86_64_quotient_or_remainder =
+      (ir_int_binary_instr->operation() == Int::BinaryOp::kDiv) ? x86_64::rax : x86_64::rdx;
+  GenerateMov(x86_64_result, x86_64::Resize(x86_64_quotient_or_remainder, x86_64_size),
+              ir_int_binary_instr, ctx);
+
+  if (divisor.has_value()) {
+    divisor->Restore(ctx);
+  }
+  RestoreRegsAD(saved_regs, ctx);
 }
 
 void TranslateIntShiftInstr(ir::IntShiftInstr* ir_int_shift_instr, BlockContext& ctx) {
@@ -378,6 +703,20 @@ void TranslatePointerOffsetInstr(ir::PointerOffsetInstr* ir_pointer_offset_instr
   x86_64::Operand x86_64_operand_b = TranslateValue(
       ir_pointer_offset_instr->offset().get(), IntNarrowing::k64To32BitIfPossible, ctx.func_ctx());
 
+  if (x86_64_result.is_reg() && x86_64_operand_a.is_reg() &&
+      ((x86_64_operand_b.is_imm() && x86_64_operand_b.size() != x86_64::k64) ||
+       (x86_64_operand_b.is_reg() && x86_64_operand_b.reg() != x86_64::rsp))) {
+    // Computes the address with lea, which needs no mov and leaves the operands unchanged:
+    x86_64::Mem address =
+        x86_64_operand_b.is_imm()
+            ? x86_64::Mem(x86_64::k64, /*base_reg=*/uint8_t(x86_64_operand_a.reg().reg()),
+                          /*disp=*/int32_t(x86_64_operand_b.imm().value()))
+            : x86_64::Mem(x86_64::k64, /*base_reg=*/uint8_t(x86_64_operand_a.reg().reg()),
+                          /*index_reg=*/uint8_t(x86_64_operand_b.reg().reg()), x86_64::Scale::kS00);
+    ctx.x86_64_block()->AddInstr<x86_64::Lea>(x86_64_result.reg(), address);
+    return;
+  }
+
   if (x86_64_result == x86_64_operand_b) {
     x86_64_operand_b = x86_64_operand_a;
   } else {
@@ -386,7 +725,7 @@ void TranslatePointerOffsetInstr(ir::PointerOffsetInstr* ir_pointer_offset_instr
 
   std::optional<TemporaryReg> tmp;
   if ((x86_64_operand_b.is_imm() && x86_64_operand_b.size() == x86_64::k64) ||
-      (x86_64_operand_a.is_mem() && x86_64_result.is_mem())) {
+      (x86_64_operand_b.is_mem() && x86_64_result.is_mem())) {
     tmp = TemporaryReg::ForOperand(x86_64_operand_b, /*can_be_result_reg=*/false,
                                    ir_pointer_offset_instr, ctx);
     x86_64_operand_b = tmp->reg();
@@ -26,6 +26,9 @@ void TranslateIntCommutativeALInstr(ir::IntBinaryInstr* ir_int_binary_instr, Blo
 void TranslateIntSubInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext& ctx);
 void TranslateIntMulInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext& ctx);
 void TranslateIntDivOrRemInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext& ctx);
+void TranslateIntDivOrRemByConstantInstr(ir::IntBinaryInstr* ir_int_binary_instr,
+                                         BlockContext& ctx);
+void TranslateIntDivOrRemByValueInstr(ir::IntBinaryInstr* ir_int_binary_instr, BlockContext& ctx);
 void TranslateIntShiftInstr(ir::IntShiftInstr* ir_int_shift_instr, BlockContext& ctx);
 
 void TranslatePointerOffsetInstr(ir::PointerOffsetInstr* ir_pointer_offset_instr,
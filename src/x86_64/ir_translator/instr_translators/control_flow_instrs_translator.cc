@@ -18,7 +18,9 @@
 #include "src/x86_64/instrs/control_flow_instrs.h"
 #include "src/x86_64/instrs/data_instrs.h"
 #include "src/x86_64/ir_translator/call_generator.h"
+#include "src/x86_64/ir_translator/mov_generator.h"
 #include "src/x86_64/ir_translator/register_allocator.h"
+#include "src/x86_64/ir_translator/select_generator.h"
 #include "src/x86_64/ir_translator/size_translator.h"
 #include "src/x86_64/ir_translator/value_translator.h"
 #include "src/x86_64/ops.h"
@@ -27,40 +29,60 @@ namespace ir_to_x86_64_translator {
 
 using ::common::logging::fail;
 
-void TranslateJumpInstr(ir::JumpInstr* ir_jump_instr, BlockContext& ctx) {
-  ir::block_num_t ir_destination = ir_jump_instr->destination();
-  x86_64::BlockRef x86_64_destination = TranslateBlockValue(ir_destination, ctx.func_ctx());
+namespace {
 
+void GenerateJump(ir::block_num_t ir_destination, BlockContext& ctx) {
+  if (ir_destination == ctx.func_ctx().ir_block_num_after(ctx.ir_block()->number())) {
+    // Falls through to the destination placed directly after the block.
+    return;
+  }
+  x86_64::BlockRef x86_64_destination = TranslateBlockValue(ir_destination, ctx.func_ctx());
   ctx.x86_64_block()->AddInstr<x86_64::Jmp>(x86_64_destination);
 }
 
+}  // namespace
+
+void TranslateJumpInstr(ir::JumpInstr* ir_jump_instr, BlockContext& ctx) {
+  GenerateJump(ir_jump_instr->destination(), ctx);
+}
+
 void TranslateJumpCondInstr(ir::JumpCondInstr* ir_jump_cond_instr, BlockContext& ctx) {
   auto ir_condition = ir_jump_cond_instr->condition().get();
   ir::block_num_t ir_destination_true = ir_jump_cond_instr->destination_true();
   ir::block_num_t ir_destination_false = ir_jump_cond_instr->destination_false();
 
-  x86_64::BlockRef x86_64_destination_true =
-      TranslateBlockValue(ir_destination_true, ctx.func_ctx());
-  x86_64::BlockRef x86_64_destination_false =
-      TranslateBlockValue(ir_destination_false, ctx.func_ctx());
-
   switch (ir_condition->kind()) {
     case ir::Value::Kind::kConstant: {
       auto ir_condition_constant = static_cast<ir::BoolConstant*>(ir_condition);
       if (ir_condition_constant->value()) {
-        ctx.x86_64_block()->AddInstr<x86_64::Jmp>(x86_64_destination_true);
+        GenerateJump(ir_destination_true, ctx);
       } else {
-        ctx.x86_64_block()->AddInstr<x86_64::Jmp>(x86_64_destination_false);
+        GenerateJump(ir_destination_false, ctx);
       }
       return;
     }
     case ir::Value::Kind::kComputed: {
+      if (const Select* select = ctx.func_ctx().SelectOf(ctx.ir_block()->number())) {
+        GenerateSelect(ir_jump_cond_instr, *select, ctx);
+        GenerateJump(select->join_block, ctx);
+        return;
+      }
       auto ir_condition_computed = static_cast<ir::Computed*>(ir_condition);
       x86_64::RM x86_64_condition = TranslateComputed(ir_condition_computed, ctx.func_ctx());
 
       ctx.x86_64_block()->AddInstr<x86_64::Test>(x86_64_condition, x86_64::Imm(int8_t{-1}));
+      if (ir_destination_false == ctx.func_ctx().ir_block_num_after(ctx.ir_block()->number())) {
+        // Inverts the branch such that the false destination is reached by falling through:
+        x86_64::BlockRef x86_64_destination_true =
+            TranslateBlockValue(ir_destination_true, ctx.func_ctx());
+        ctx.x86_64_block()->AddInstr<x86_64::Jcc>(x86_64::InstrCond::kNoZero,
+                                                  x86_64_destination_true);
+        return;
+      }
+      x86_64::BlockRef x86_64_destination_false =
+          TranslateBlockValue(ir_destination_false, ctx.func_ctx());
       ctx.x86_64_block()->AddInstr<x86_64::Jcc>(x86_64::InstrCond::kZero, x86_64_destination_false);
-      ctx.x86_64_block()->AddInstr<x86_64::Jmp>(x86_64_destination_true);
+      GenerateJump(ir_destination_true, ctx);
       return;
     }
     case ir::Value::Kind::kInherited:
@@ -83,32 +105,26 @@ void TranslateCallInstr(ir::CallInstr* ir_call_instr, BlockContext& ctx) {
 }
 
 void TranslateReturnInstr(ir::ReturnInstr* ir_return_instr, BlockContext& ctx) {
-  struct ArgInfo {
-    x86_64::Operand x86_64_arg_value;
-    x86_64::RM x86_64_arg_location;
-  };
-  std::vector<ArgInfo> arg_infos;
-  arg_infos.reserve(ir_return_instr->args().size());
-  for (std::size_t arg_index = 0; arg_index < ir_return_instr->args().size(); arg_index++) {
-    ir::Value* ir_arg_value = ir_return_instr->args().at(arg_index).get();
-    x86_64::Operand x86_64_arg_value =
-        TranslateValue(ir_arg_value, IntNarrowing::kNone, ctx.func_ctx());
-    x86_64::Size x86_64_arg_size = TranslateSizeOfType(ir_arg_value->type());
-    x86_64::RM x86_64_arg_location = OperandForResult(int(arg_index), x86_64_arg_size);
-    arg_infos.push_back(ArgInfo{
-        .x86_64_arg_value = x86_64_arg_value,
-        .x86_64_arg_location = x86_64_arg_location,
-    });
-  }
-
-  for (ArgInfo& arg_info : arg_infos) {
-    if (arg_info.x86_64_arg_location != arg_info.x86_64_arg_value) {
-      ctx.x86_64_block()->AddInstr<x86_64::Mov>(arg_info.x86_64_arg_location,
-                                                arg_info.x86_64_arg_value);
+  int arg_count = int(ctx.ir_func()->args().size());
+  std::vector<MoveOperation> result_moves;
+  result_moves.reserve(ir_return_instr->args().size());
+  for (std::size_t result_index = 0; result_index < ir_return_instr->args().size();
+       result_index++) {
+    ir::Value* ir_result_value = ir_return_instr->args().at(result_index).get();
+    x86_64::Operand x86_64_result_value =
+        TranslateValue(ir_result_value, IntNarrowing::kNone, ctx.func_ctx());
+    x86_64::Size x86_64_result_size = TranslateSizeOfType(ir_result_value->type());
+    x86_64::RM x86_64_result_location =
+        OperandForResult(int(result_index), arg_count, x86_64_result_size);
+    if (result_index < std::size_t(kMaxResultsInRegs)) {
+      result_moves.push_back(MoveOperation(x86_64_result_location, x86_64_result_value));
+    } else {
+      // Results in the result buffer get stored first, since the moves to result registers might
+      // overwrite their values:
+      GenerateMov(x86_64_result_location, x86_64_result_value, ir_return_instr, ctx);
     }
   }
-
-  // TODO: improve
+  GenerateMovs(result_moves, ir_return_instr, ctx);
 }
 
 }  // namespace ir_to_x86_64_translator
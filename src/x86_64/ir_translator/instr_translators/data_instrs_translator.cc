@@ -11,10 +11,12 @@
 #include <cstdint>
 
 #include "src/common/logging/logging.h"
+#include "src/ir/representation/types.h"
 #include "src/ir/representation/values.h"
 #include "src/x86_64/instrs/control_flow_instrs.h"
 #include "src/x86_64/instrs/data_instrs.h"
 #include "src/x86_64/instrs/instr.h"
+#include "src/x86_64/ir_translator/address_selector.h"
 #include "src/x86_64/ir_translator/call_generator.h"
 #include "src/x86_64/ir_translator/context.h"
 #include "src/x86_64/ir_translator/mov_generator.h"
@@ -35,12 +37,47 @@ void TranslateMovInstr(ir::MovInstr* ir_mov_instr, BlockContext& ctx) {
   GenerateMov(x86_64_result, x86_64_origin, ir_mov_instr, ctx);
 }
 
+void TranslateConversion(ir::Conversion* ir_conversion, BlockContext& ctx) {
+  auto ir_operand_type = static_cast<const ir::AtomicType*>(ir_conversion->operand()->type());
+  auto ir_result_type = static_cast<const ir::AtomicType*>(ir_conversion->result()->type());
+  // Only conversions that keep the bits of the operand unchanged are supported:
+  if (ir_operand_type->bit_size() != ir_result_type->bit_size() ||
+      ir_operand_type->type_kind() == ir::TypeKind::kBool ||
+      ir_result_type->type_kind() == ir::TypeKind::kBool) {
+    fail("unsupported conversion: " + ir_conversion->RefString());
+  }
+  x86_64::RM x86_64_result = TranslateComputed(ir_conversion->result().get(), ctx.func_ctx());
+  x86_64::Operand x86_64_operand = TranslateValue(
+      ir_conversion->operand().get(), IntNarrowing::k64To32BitIfPossible, ctx.func_ctx());
+
+  GenerateMov(x86_64_result, x86_64_operand, ir_conversion, ctx);
+}
+
 void TranslateMallocInstr(ir::MallocInstr* ir_malloc_instr, BlockContext& ctx) {
   x86_64::FuncRef malloc_ref(ctx.x86_64_program()->declared_funcs().at("malloc"));
   GenerateCall(ir_malloc_instr, malloc_ref, /*ir_results=*/{ir_malloc_instr->result().get()},
                /*ir_args=*/{ir_malloc_instr->size().get()}, ctx);
 }
 
+void TranslateStackAllocInstr(ir::StackAllocInstr* ir_stack_alloc_instr, BlockContext& ctx) {
+  x86_64::RM x86_64_result =
+      TranslateComputed(ir_stack_alloc_instr->result().get(), ctx.func_ctx());
+  x86_64::Mem slot = x86_64::Mem::BasePointerDisp(
+      x86_64::k64, ctx.func_ctx().StackAllocOffset(ir_stack_alloc_instr));
+
+  if (x86_64_result.is_reg()) {
+    ctx.x86_64_block()->AddInstr<x86_64::Lea>(x86_64_result.reg(), slot);
+  } else if (x86_64_result.is_mem()) {
+    TemporaryReg tmp = TemporaryReg::Prepare(x86_64::k64, /*can_use_result_reg=*/false,
+                                             ir_stack_alloc_instr, ctx);
+    ctx.x86_64_block()->AddInstr<x86_64::Lea>(tmp.reg(), slot);
+    ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64_result, tmp.reg());
+    tmp.Restore(ctx);
+  } else {
+    fail("unexpected stack alloc result operand");
+  }
+}
+
 void TranslateLoadInstr(ir::LoadInstr* ir_load_instr, BlockContext& ctx) {
   ir::Value* ir_address = ir_load_instr->address().get();
   ir::Computed* ir_result = ir_load_instr->result().get();
@@ -52,7 +89,10 @@ void TranslateLoadInstr(ir::LoadInstr* ir_load_instr, BlockContext& ctx) {
 
   x86_64::Mem mem(x86_64_size, /*disp=*/int32_t{0});
   std::optional<TemporaryReg> tmp;
-  if (x86_64_address.is_imm()) {
+  if (const FoldedAddress* folded_address = ctx.func_ctx().FoldedAddressOf(ir_load_instr)) {
+    mem = GenerateFoldedAddress(*folded_address, x86_64_size, ir_load_instr, ctx);
+
+  } else if (x86_64_address.is_imm()) {
     mem = x86_64::Mem(x86_64_size, /*disp=*/int32_t(x86_64_address.imm().value()));
 
   } else {
@@ -93,6 +133,13 @@ void TranslateStoreInstr(ir::StoreInstr* ir_store_instr, BlockContext& ctx) {
   x86_64::Operand x86_64_value = TranslateValue(ir_value, IntNarrowing::kNone, ctx.func_ctx());
   x86_64::Size x86_64_size = TranslateSizeOfType(ir_value->type());
 
+  x86_64::Mem mem(x86_64_size, /*disp=*/int32_t{0});
+  const FoldedAddress* folded_address = ctx.func_ctx().FoldedAddressOf(ir_store_instr);
+  if (folded_address != nullptr) {
+    // Reserves the registers of the address before any temporary registers get prepared:
+    mem = GenerateFoldedAddress(*folded_address, x86_64_size, ir_store_instr, ctx);
+  }
+
   std::optional<TemporaryReg> value_tmp;
   if ((x86_64_value.is_imm() && x86_64_value.size() == 64) || x86_64_value.is_mem()) {
     value_tmp =
@@ -101,20 +148,21 @@ void TranslateStoreInstr(ir::StoreInstr* ir_store_instr, BlockContext& ctx) {
   }
 
   std::optional<TemporaryReg> address_tmp;
-  x86_64::Mem mem(x86_64_size, /*disp=*/int32_t{0});
-  if (x86_64_address.is_imm()) {
-    mem = x86_64::Mem(x86_64_size, /*disp=*/int32_t(x86_64_address.imm().value()));
+  if (folded_address == nullptr) {
+    if (x86_64_address.is_imm()) {
+      mem = x86_64::Mem(x86_64_size, /*disp=*/int32_t(x86_64_address.imm().value()));
 
-  } else {
-    x86_64::Reg x86_64_address_reg = x86_64::rax;
-    if (x86_64_address.is_reg()) {
-      x86_64_address_reg = x86_64_address.reg();
     } else {
-      address_tmp = TemporaryReg::ForOperand(x86_64_address, /*can_use_result_reg=*/false,
-                                             ir_store_instr, ctx);
-      x86_64_address_reg = address_tmp->reg();
+      x86_64::Reg x86_64_address_reg = x86_64::rax;
+      if (x86_64_address.is_reg()) {
+        x86_64_address_reg = x86_64_address.reg();
+      } else {
+        address_tmp = TemporaryReg::ForOperand(x86_64_address, /*can_use_result_reg=*/false,
+                                               ir_store_instr, ctx);
+        x86_64_address_reg = address_tmp->reg();
+      }
+      mem = x86_64::Mem(x86_64_size, /*base_reg=*/uint8_t(x86_64_address_reg.reg()));
     }
-    mem = x86_64::Mem(x86_64_size, /*base_reg=*/uint8_t(x86_64_address_reg.reg()));
   }
 
   ctx.x86_64_block()->AddInstr<x86_64::Mov>(mem, x86_64_value);
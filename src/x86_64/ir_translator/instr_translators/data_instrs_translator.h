@@ -15,7 +15,9 @@
 namespace ir_to_x86_64_translator {
 
 void TranslateMovInstr(ir::MovInstr* ir_mov_instr, BlockContext& ctx);
+void TranslateConversion(ir::Conversion* ir_conversion, BlockContext& ctx);
 void TranslateMallocInstr(ir::MallocInstr* ir_malloc_instr, BlockContext& ctx);
+void TranslateStackAllocInstr(ir::StackAllocInstr* ir_stack_alloc_instr, BlockContext& ctx);
 void TranslateLoadInstr(ir::LoadInstr* ir_load_instr, BlockContext& ctx);
 void TranslateStoreInstr(ir::StoreInstr* ir_store_instr, BlockContext& ctx);
 void TranslateFreeInstr(ir::FreeInstr* ir_free_instr, BlockContext& ctx);
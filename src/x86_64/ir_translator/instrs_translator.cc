@@ -22,6 +22,9 @@ void TranslateInstr(ir::Instr* ir_instr, BlockContext& ctx) {
     case ir::InstrKind::kMov:
       TranslateMovInstr(static_cast<ir::MovInstr*>(ir_instr), ctx);
       break;
+    case ir::InstrKind::kConversion:
+      TranslateConversion(static_cast<ir::Conversion*>(ir_instr), ctx);
+      break;
     case ir::InstrKind::kBoolNot:
       TranslateBoolNotInstr(static_cast<ir::BoolNotInstr*>(ir_instr), ctx);
       break;
@@ -49,6 +52,9 @@ void TranslateInstr(ir::Instr* ir_instr, BlockContext& ctx) {
     case ir::InstrKind::kMalloc:
       TranslateMallocInstr(static_cast<ir::MallocInstr*>(ir_instr), ctx);
       break;
+    case ir::InstrKind::kStackAlloc:
+      TranslateStackAllocInstr(static_cast<ir::StackAllocInstr*>(ir_instr), ctx);
+      break;
     case ir::InstrKind::kLoad:
       TranslateLoadInstr(static_cast<ir::LoadInstr*>(ir_instr), ctx);
       break;
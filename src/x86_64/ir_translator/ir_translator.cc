@@ -8,6 +8,7 @@
 
 #include "ir_translator.h"
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -42,7 +43,13 @@ TranslationResults Translate(
     const ir::Program* ir_program,
     const std::unordered_map<ir::func_num_t, const ir_info::FuncLiveRanges>& live_ranges,
     const std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph>& interference_graphs,
-    bool generate_debug_info) {
+    bool generate_debug_info, common::concurrency::ThreadPool* thread_pool) {
+  std::optional<common::concurrency::ThreadPool> serial_thread_pool;
+  if (thread_pool == nullptr) {
+    thread_pool = &serial_thread_pool.emplace(/*thread_count=*/1);
+  }
+  const std::size_t func_count = ir_program->funcs().size();
+
   auto x86_64_program = std::make_unique<x86_64::Program>();
 
   x86_64::func_num_t malloc_func_num = x86_64_program->DeclareFunc("malloc");
@@ -50,22 +57,42 @@ TranslationResults Translate(
   ProgramContext program_ctx(ir_program, x86_64_program.get(), malloc_func_num, free_func_num);
   std::vector<x86_64::Func*> x86_64_funcs = PrepareFuncs(program_ctx);
 
-  std::unordered_map<ir::func_num_t, x86_64::func_num_t> ir_to_x86_64_func_nums;
+  std::vector<std::optional<const ir_info::InterferenceGraphColors>> func_colors(func_count);
+  common::concurrency::ParallelFor(
+      *thread_pool, func_count, [&](int64_t i) {
+        const ir::Func* ir_func = ir_program->funcs().at(i).get();
+        func_colors.at(i).emplace(
+            AllocateRegistersInFunc(ir_func, interference_graphs.at(ir_func->number())));
+      });
   std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraphColors>
-      interference_graph_colors = AllocateRegisters(ir_program, interference_graphs);
+      interference_graph_colors;
+  interference_graph_colors.reserve(func_count);
+  for (std::size_t i = 0; i < func_count; i++) {
+    interference_graph_colors.emplace(ir_program->funcs().at(i)->number(), *func_colors.at(i));
+  }
 
-  for (std::size_t i = 0; i < ir_program->funcs().size(); i++) {
+  // Blocks get numbered in program order before funcs get translated concurrently, which keeps the
+  // translation results independent of scheduling.
+  std::vector<std::unique_ptr<FuncContext>> func_ctxs;
+  func_ctxs.reserve(func_count);
+  for (std::size_t i = 0; i < func_count; i++) {
     ir::Func* ir_func = ir_program->funcs().at(i).get();
     ir::func_num_t ir_func_num = ir_func->number();
     x86_64::Func* x86_64_func = x86_64_funcs.at(i);
 
-    FuncContext func_ctx(program_ctx, ir_func, x86_64_func, live_ranges.at(ir_func_num),
-                         interference_graphs.at(ir_func_num),
-                         interference_graph_colors.at(ir_func_num));
-    TranslateFunc(func_ctx);
+    FuncContext& func_ctx = *func_ctxs.emplace_back(std::make_unique<FuncContext>(
+        program_ctx, ir_func, x86_64_func, live_ranges.at(ir_func_num),
+        interference_graphs.at(ir_func_num), interference_graph_colors.at(ir_func_num)));
+    PrepareFunc(func_ctx);
+  }
+  common::concurrency::ParallelFor(*thread_pool, func_count,
+                                   [&func_ctxs](int64_t i) { TranslateFunc(*func_ctxs.at(i)); });
 
-    if (generate_debug_info) {
-      ir_to_x86_64_func_nums.insert({ir_func_num, x86_64_func->func_num()});
+  std::unordered_map<ir::func_num_t, x86_64::func_num_t> ir_to_x86_64_func_nums;
+  if (generate_debug_info) {
+    for (std::size_t i = 0; i < func_count; i++) {
+      ir_to_x86_64_func_nums.insert(
+          {ir_program->funcs().at(i)->number(), x86_64_funcs.at(i)->func_num()});
     }
   }
 
@@ -12,6 +12,7 @@
 #include <memory>
 #include <unordered_map>
 
+#include "src/common/concurrency/thread_pool.h"
 #include "src/ir/info/func_live_ranges.h"
 #include "src/ir/info/interference_graph.h"
 #include "src/ir/representation/num_types.h"
@@ -29,11 +30,13 @@ struct TranslationResults {
       interference_graph_colors;
 };
 
+// Translates the given IR program to x86_64. If a thread pool is provided, register allocation and
+// translation of individual functions run on the pool. The result does not depend on the pool.
 TranslationResults Translate(
     const ir::Program* program,
     const std::unordered_map<ir::func_num_t, const ir_info::FuncLiveRanges>& live_ranges,
     const std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph>& interference_graphs,
-    bool generate_debug_info = false);
+    bool generate_debug_info = false, common::concurrency::ThreadPool* thread_pool = nullptr);
 
 }  // namespace ir_to_x86_64_translator
 
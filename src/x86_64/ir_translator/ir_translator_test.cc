@@ -0,0 +1,411 @@
+//
+//  ir_translator_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 11/5/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/x86_64/ir_translator/ir_translator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "src/common/atomics/atomics.h"
+#include "src/common/concurrency/thread_pool.h"
+#include "src/common/data/data_view.h"
+#include "src/common/memory/code_heap.h"
+#include "src/ir/analyzers/interference_graph_builder.h"
+#include "src/ir/analyzers/live_range_analyzer.h"
+#include "src/ir/info/func_live_ranges.h"
+#include "src/ir/info/interference_graph.h"
+#include "src/ir/processors/phi_resolver.h"
+#include "src/ir/representation/program.h"
+#include "src/ir/serialization/parse.h"
+#include "src/x86_64/machine_code/linker.h"
+#include "src/x86_64/program.h"
+
+namespace ir_to_x86_64_translator {
+namespace {
+
+using ::common::atomics::IntType;
+using ::common::memory::CodeHeap;
+using ::common::memory::Permissions;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+constexpr std::string_view kProgram = R"ir(
+@0 add (%0:i64, %1:i64) => (i64) {
+{0}
+  %2:i64 = iadd %0, %1
+  ret %2:i64
+}
+
+@1 sum (%0:i64) => (i64) {
+{0}
+  jmp {1}
+{1}
+  %1:i64 = phi #0:i64{0}, %4{2}
+  %2:i64 = phi #0:i64{0}, %5{2}
+  %3:b = ilss %1:i64, %0
+  jcc %3, {2}, {3}
+{2}
+  %4:i64 = iadd %1, #1:i64
+  %5:i64 = call @0, %2, %1
+  jmp {1}
+{3}
+  ret %2
+}
+
+@2 fib (%0:i64) => (i64) {
+{0}
+  %1:b = ilss %0:i64, #2:i64
+  jcc %1, {1}, {2}
+{1}
+  ret #1:i64
+{2}
+  %2:i64 = isub %0, #1:i64
+  %3:i64 = call @2, %2
+  %4:i64 = isub %0, #2:i64
+  %5:i64 = call @2, %4
+  %6:i64 = iadd %3, %5
+  ret %6
+}
+
+@3 main () => (i64) {
+{0}
+  %0:i64 = call @1, #10:i64
+  %1:i64 = call @2, %0
+  ret %1
+}
+)ir";
+
+TranslationResults TranslateProgram(ir::Program* program,
+                                    common::concurrency::ThreadPool* thread_pool) {
+  std::unordered_map<ir::func_num_t, const ir_info::FuncLiveRanges> live_ranges;
+  std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph> interference_graphs;
+  for (auto& func : program->funcs()) {
+    const ir_info::FuncLiveRanges func_live_ranges =
+        ir_analyzers::FindLiveRangesForFunc(func.get());
+    live_ranges.insert({func->number(), func_live_ranges});
+    interference_graphs.insert(
+        {func->number(),
+         ir_analyzers::BuildInterferenceGraphForFunc(func.get(), func_live_ranges)});
+    ir_processors::ResolvePhisInFunc(func.get());
+  }
+  return Translate(program, live_ranges, interference_graphs, /*generate_debug_info=*/true,
+                   thread_pool);
+}
+
+std::vector<uint8_t> Encode(x86_64::Program* program) {
+  std::vector<uint8_t> code(4096, 0);
+  x86_64::Linker linker;
+  int64_t size = program->Encode(linker, common::data::DataView(code.data(), code.size()));
+  code.resize(size);
+  return code;
+}
+
+TEST(TranslateTest, ParallelTranslationMatchesSerialTranslation) {
+  std::unique_ptr<ir::Program> serial_ir_program =
+      ir_serialization::ParseProgramOrDie(std::string(kProgram));
+  std::unique_ptr<ir::Program> parallel_ir_program =
+      ir_serialization::ParseProgramOrDie(std::string(kProgram));
+
+  TranslationResults serial_results =
+      TranslateProgram(serial_ir_program.get(), /*thread_pool=*/nullptr);
+  common::concurrency::ThreadPool thread_pool(/*thread_count=*/4);
+  TranslationResults parallel_results = TranslateProgram(parallel_ir_program.get(), &thread_pool);
+
+  EXPECT_EQ(serial_results.program->ToString(), parallel_results.program->ToString());
+  EXPECT_EQ(Encode(serial_results.program.get()), Encode(parallel_results.program.get()));
+  EXPECT_EQ(serial_results.ir_to_x86_64_func_nums, parallel_results.ir_to_x86_64_func_nums);
+}
+
+TEST(TranslateTest, PlacesLoopBodyBeforeLoopExit) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 count (%0:i64) => (i64) {
+{0}
+  jmp {1}
+{1}
+  %1:i64 = phi #0:i64{0}, %3{3}
+  %2:b = ilss %1:i64, %0
+  jcc %2, {3}, {2}
+{2}
+  ret %1
+{3}
+  %3:i64 = iadd %1, #1:i64
+  jmp {1}
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  // The entry block falls through to the loop header, the loop header falls through to the loop
+  // body, and the loop exit is placed last:
+  EXPECT_THAT(code, HasSubstr("\tje BB3\nBB2:\n"));
+  EXPECT_THAT(code, HasSubstr("\tjmp BB1\nBB3:\n"));
+  EXPECT_THAT(code, Not(HasSubstr("jmp BB2")));
+  EXPECT_THAT(code, Not(HasSubstr("jmp BB3")));
+}
+
+TEST(TranslateTest, FoldsPointerOffsetsIntoMemoryOperands) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 load_field (%0:ptr) => (i64) {
+{0}
+  %1:ptr = poff %0, #16:i64
+  %2:ptr = poff %1, #8:i64
+  %3:i64 = load %2
+  ret %3
+}
+
+@1 store_element (%0:ptr, %1:i64, %2:i64) => () {
+{0}
+  %3:i64 = ishl %1, #3:u64
+  %4:ptr = poff %0, %3
+  %5:ptr = poff %4, #8:i64
+  store %5, %2
+  ret
+}
+
+@2 element_address (%0:ptr, %1:i64) => (ptr) {
+{0}
+  %2:ptr = poff %0, %1
+  ret %2
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  EXPECT_THAT(code, HasSubstr("\tmov rax,[rdi+24]\n"));
+  EXPECT_THAT(code, HasSubstr("\tmov [rdi+8*rsi+8],rdx\n"));
+  EXPECT_THAT(code, HasSubstr("\tlea rax,[rdi+1*rsi]\n"));
+  EXPECT_THAT(code, Not(HasSubstr("\tadd ")));
+  EXPECT_THAT(code, Not(HasSubstr("\tshl ")));
+}
+
+TEST(TranslateTest, OmitsFramePointerInLeafFuncs) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 add (%0:i64, %1:i64) => (i64) {
+{0}
+  %2:i64 = iadd %0, %1
+  ret %2:i64
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  EXPECT_THAT(code, Not(HasSubstr("rbp")));
+  EXPECT_THAT(code, Not(HasSubstr("push")));
+  EXPECT_THAT(code, Not(HasSubstr("rsp")));
+}
+
+TEST(TranslateTest, PadsFrameToAlignStackForCalls) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 read (%0:ptr) => (i64) {
+{0}
+  %1:i64 = load %0
+  ret %1
+}
+
+@1 local () => (i64) {
+{0}
+  %0:ptr = salloc #8:i64
+  store %0, #42:i64
+  %1:i64 = call @0, %0
+  ret %1
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  // The eight byte stack alloc gets padded to keep the stack pointer aligned for the call:
+  EXPECT_THAT(code, HasSubstr("\tpush rbp\n\tmov rbp,rsp\n\tsub rsp,0x10\n"));
+  EXPECT_THAT(code, HasSubstr("\tcall <2>\n\tleave\n\tret"));
+}
+
+TEST(TranslateTest, DividesByConstantsWithoutDivInstrs) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 div_by_eight (%0:i64) => (i64) {
+{0}
+  %1:i64 = idiv %0, #8:i64
+  ret %1
+}
+
+@1 rem_by_seven (%0:u32) => (u32) {
+{0}
+  %1:u32 = irem %0, #7:u32
+  ret %1
+}
+
+@2 div (%0:i64, %1:i64) => (i64) {
+{0}
+  %2:i64 = idiv %0, %1
+  ret %2
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  // Signed division by a power of two rounds negative dividends towards zero before shifting:
+  EXPECT_THAT(code, HasSubstr("\tshr rcx,0x3d\n\tadd rcx,rax\n\tsar rcx,0x03\n"));
+  EXPECT_THAT(code, HasSubstr("\tmul rcx\n\timul rdx,rdx,0x07\n\tsub rcx,rdx\n"));
+  EXPECT_THAT(code, HasSubstr("\tcqo\n\tidiv rsi\n"));
+  EXPECT_THAT(code, Not(HasSubstr("\tdiv ")));
+}
+
+// Returns values of the given int type that are likely to hit edge cases of divisions, such as
+// small odd divisors, powers of two, the extremes of the type and their negations.
+template <typename T>
+std::vector<T> DivisionEdgeCases() {
+  constexpr T kMin = std::numeric_limits<T>::min();
+  constexpr T kMax = std::numeric_limits<T>::max();
+  std::vector<T> values{kMin, T(kMin + 1), T(kMin / 2), kMax, T(kMax - 1), T(kMax / 2),
+                        T(kMax / 2 + 1)};
+  for (int64_t value : {0, 1, 2, 3, 5, 6, 7, 10, 16, 25, 125, 641, 1000, 65535, 1000000007}) {
+    if (!std::in_range<T>(value)) {
+      continue;
+    }
+    values.push_back(T(value));
+    if constexpr (std::is_signed_v<T>) {
+      values.push_back(T(-value));
+    }
+  }
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+// Returns all values of 8-bit and 16-bit int types. For wider types, returns the edge cases, their
+// neighbours and random values.
+template <typename T>
+std::vector<T> Dividends() {
+  std::vector<T> dividends;
+  if constexpr (sizeof(T) <= 2) {
+    for (int64_t value = std::numeric_limits<T>::min(); value <= std::numeric_limits<T>::max();
+         value++) {
+      dividends.push_back(T(value));
+    }
+    return dividends;
+  }
+  typedef std::make_unsigned_t<T> U;
+  for (T value : DivisionEdgeCases<T>()) {
+    dividends.push_back(T(U(value) - 1));
+    dividends.push_back(value);
+    dividends.push_back(T(U(value) + 1));
+  }
+  std::mt19937_64 random(/*seed=*/42);
+  for (int i = 0; i < 1000; i++) {
+    dividends.push_back(T(random()));
+  }
+  return dividends;
+}
+
+// Translates and executes divisions and remainders of the given int type by constant divisors and
+// checks that they compute the same results as C++.
+template <typename T>
+void ExpectDivisionsByConstantsMatchCpp(IntType int_type) {
+  std::string type = common::atomics::ToString(int_type);
+  std::vector<T> divisors = DivisionEdgeCases<T>();
+  divisors.erase(std::find(divisors.begin(), divisors.end(), T{0}));
+
+  std::string ir_program_str;
+  for (std::size_t i = 0; i < divisors.size(); i++) {
+    std::string divisor = "#" + std::to_string(divisors.at(i)) + ":" + type;
+    for (std::string op : {"idiv", "irem"}) {
+      ir_program_str += "@" + std::to_string(2 * i + (op == "irem")) + " f (%0:" + type +
+                        ") => (" + type + ") {\n{0}\n  %1:" + type + " = " + op + " %0, " +
+                        divisor + "\n  ret %1\n}\n\n";
+    }
+  }
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(ir_program_str);
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+
+  x86_64::Linker linker;
+  CodeHeap code_heap(/*reserved_size=*/CodeHeap::kSegmentSize * 4);
+  ASSERT_NE(results.program->Encode(linker, code_heap), -1);
+  linker.ApplyPatches();
+  code_heap.ChangePermissions(Permissions::kExecute);
+
+  std::vector<T> dividends = Dividends<T>();
+  for (std::size_t i = 0; i < divisors.size(); i++) {
+    T divisor = divisors.at(i);
+    T (*div)(T) = (T(*)(T))(linker.func_addrs().at(results.ir_to_x86_64_func_nums.at(2 * i)));
+    T (*rem)(T) = (T(*)(T))(linker.func_addrs().at(results.ir_to_x86_64_func_nums.at(2 * i + 1)));
+    for (T dividend : dividends) {
+      if (std::is_signed_v<T> && dividend == std::numeric_limits<T>::min() && divisor == T(-1)) {
+        continue;
+      }
+      ASSERT_EQ(div(dividend), T(dividend / divisor))
+          << type << ": " << +dividend << " / " << +divisor;
+      ASSERT_EQ(rem(dividend), T(dividend % divisor))
+          << type << ": " << +dividend << " % " << +divisor;
+    }
+  }
+}
+
+TEST(TranslateTest, DividesSignedIntsByConstantsLikeCpp) {
+  ExpectDivisionsByConstantsMatchCpp<int8_t>(IntType::kI8);
+  ExpectDivisionsByConstantsMatchCpp<int16_t>(IntType::kI16);
+  ExpectDivisionsByConstantsMatchCpp<int32_t>(IntType::kI32);
+  ExpectDivisionsByConstantsMatchCpp<int64_t>(IntType::kI64);
+}
+
+TEST(TranslateTest, DividesUnsignedIntsByConstantsLikeCpp) {
+  ExpectDivisionsByConstantsMatchCpp<uint8_t>(IntType::kU8);
+  ExpectDivisionsByConstantsMatchCpp<uint16_t>(IntType::kU16);
+  ExpectDivisionsByConstantsMatchCpp<uint32_t>(IntType::kU32);
+  ExpectDivisionsByConstantsMatchCpp<uint64_t>(IntType::kU64);
+}
+
+TEST(TranslateTest, SelectsValuesOfSmallBranchesWithoutJumps) {
+  std::unique_ptr<ir::Program> ir_program = ir_serialization::ParseProgramOrDie(R"ir(
+@0 max (%0:i64, %1:i64) => (i64) {
+{0}
+  %2:b = igtr %0, %1
+  jcc %2, {1}, {2}
+{1}
+  jmp {2}
+{2}
+  %3:i64 = phi %1{0}, %0{1}
+  ret %3
+}
+
+@1 is_neg (%0:i64) => (b) {
+{0}
+  %1:b = ilss %0, #0:i64
+  jcc %1, {1}, {2}
+{1}
+  jmp {3}
+{2}
+  jmp {3}
+{3}
+  %2:b = phi #t{1}, #f{2}
+  ret %2
+}
+)ir");
+
+  TranslationResults results = TranslateProgram(ir_program.get(), /*thread_pool=*/nullptr);
+  std::string code = results.program->ToString();
+
+  EXPECT_THAT(code, HasSubstr("\tcmovne rax,rdi\n"));
+  EXPECT_THAT(code, HasSubstr("\tsetne al\n"));
+  EXPECT_THAT(code, Not(HasSubstr("\tj")));
+}
+
+}  // namespace
+}  // namespace ir_to_x86_64_translator
@@ -43,7 +43,7 @@ bool MovNeedsTmpReg(x86_64::RM x86_64_result, x86_64::Operand x86_64_origin) {
   }
   if (x86_64_origin.is_imm()) {
     return x86_64_origin.size() == x86_64::k64;
-  } else if (x86_64_origin.is_mem()) {
+  } else if (x86_64_origin.is_mem() || x86_64_origin.is_func_ref()) {
     return true;
   }
   return false;
@@ -291,10 +291,10 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForSimpleMemMoves) {
   GenerateIRInfo();
 
   interference_graph_colors().SetColor(
-      ir_operand_a->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, 0)));
+      ir_operand_a->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, -8)));
   interference_graph_colors().SetColor(ir_operand_b->number(), 0);
   interference_graph_colors().SetColor(
-      ir_operand_c->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -8)));
+      ir_operand_c->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -16)));
 
   GenerateTranslationContexts();
 
@@ -305,10 +305,10 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForSimpleMemMoves) {
   x86_64::Imm x86_64_operand_e(kE);
 
   x86_64::Reg x86_64_result_a = x86_64::edx;
-  x86_64::Mem x86_64_result_b = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -16);
-  x86_64::Mem x86_64_result_c = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -24);
-  x86_64::Mem x86_64_result_d = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -32);
-  x86_64::Mem x86_64_result_e = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -40);
+  x86_64::Mem x86_64_result_b = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -24);
+  x86_64::Mem x86_64_result_c = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -32);
+  x86_64::Mem x86_64_result_d = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -40);
+  x86_64::Mem x86_64_result_e = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -48);
 
   std::vector<MoveOperation> operations{MoveOperation(x86_64_result_a, x86_64_operand_a),
                                         MoveOperation(x86_64_result_b, x86_64_operand_b),
@@ -377,7 +377,7 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForLargeMoveChain) {
   interference_graph_colors().SetColor(ir_operand_a->number(), 0);
   interference_graph_colors().SetColor(ir_operand_b->number(), 1);
   interference_graph_colors().SetColor(
-      ir_operand_c->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, 0)));
+      ir_operand_c->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, -8)));
 
   GenerateTranslationContexts();
 
@@ -386,7 +386,7 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForLargeMoveChain) {
   x86_64::RM x86_64_operand_c = TranslateComputed(ir_operand_c.get(), func_ctx());
   x86_64::Imm x86_64_operand_d(kD);
 
-  x86_64::Mem x86_64_result_a = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, 0);
+  x86_64::Mem x86_64_result_a = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -8);
   x86_64::Reg x86_64_result_b = x86_64::al;
   x86_64::Reg x86_64_result_c = x86_64::r8d;
   x86_64::Reg x86_64_result_d = x86_64::cx;
@@ -466,16 +466,16 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForCyclesWithAttchedAndSeparateChains) {
   GenerateIRInfo();
 
   interference_graph_colors().SetColor(
-      ir_operand_a->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, 0)));
+      ir_operand_a->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k32, -8)));
   interference_graph_colors().SetColor(ir_operand_b->number(), 0);
   interference_graph_colors().SetColor(ir_operand_c->number(), 5);
   interference_graph_colors().SetColor(ir_operand_d->number(), 11);
   interference_graph_colors().SetColor(
-      ir_operand_e->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -8)));
+      ir_operand_e->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -16)));
   interference_graph_colors().SetColor(
-      ir_operand_f->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -16)));
+      ir_operand_f->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -24)));
   interference_graph_colors().SetColor(
-      ir_operand_g->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -32)));
+      ir_operand_g->number(), OperandToColor(x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -40)));
   interference_graph_colors().SetColor(ir_operand_h->number(), 2);
   interference_graph_colors().SetColor(ir_operand_i->number(), 13);
 
@@ -495,13 +495,13 @@ TEST_F(GenerateMovsTest, GeneratesInstrsForCyclesWithAttchedAndSeparateChains) {
   x86_64::Reg x86_64_result_a_1 = x86_64::eax;
   x86_64::Reg x86_64_result_a_2 = x86_64::r13d;
   x86_64::Reg x86_64_result_b = x86_64::dil;
-  x86_64::Mem x86_64_result_c = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, 0);
-  x86_64::Mem x86_64_result_d = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -8);
-  x86_64::Mem x86_64_result_e = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -40);
-  x86_64::Mem x86_64_result_f = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -32);
-  x86_64::Mem x86_64_result_g_1 = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -16);
+  x86_64::Mem x86_64_result_c = x86_64::Mem::BasePointerDisp(x86_64::Size::k8, -8);
+  x86_64::Mem x86_64_result_d = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -16);
+  x86_64::Mem x86_64_result_e = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -48);
+  x86_64::Mem x86_64_result_f = x86_64::Mem::BasePointerDisp(x86_64::Size::k64, -40);
+  x86_64::Mem x86_64_result_g_1 = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -24);
   x86_64::Reg x86_64_result_g_2 = x86_64::dx;
-  x86_64::Mem x86_64_result_h = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -48);
+  x86_64::Mem x86_64_result_h = x86_64::Mem::BasePointerDisp(x86_64::Size::k16, -56);
   x86_64::Reg x86_64_result_i = x86_64::rcx;
   x86_64::Reg x86_64_result_j = x86_64::r15;
 
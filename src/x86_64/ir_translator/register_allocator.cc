@@ -8,8 +8,15 @@
 
 #include "register_allocator.h"
 
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
 #include "src/common/logging/logging.h"
 #include "src/ir/analyzers/interference_graph_colorer.h"
+#include "src/ir/analyzers/loop_analyzer.h"
+#include "src/ir/info/loop_info.h"
 #include "src/ir/representation/block.h"
 #include "src/ir/representation/func.h"
 #include "src/ir/representation/instrs.h"
@@ -19,39 +26,52 @@ namespace ir_to_x86_64_translator {
 
 using ::common::logging::fail;
 
+namespace {
+
+// Offset of the first stack arg relative to the base pointer of the called func, skipping the
+// pushed base pointer and return address.
+constexpr int32_t kStackArgsOffset = 16;
+
+// Colors below the first spill color correspond to registers, colors starting at the first spill
+// color correspond to spill slots below the base pointer.
+constexpr ir_info::color_t kFirstSpillColor = 14;
+
+}  // namespace
+
+int StackArgCount(int arg_count) { return std::max(arg_count - kMaxArgsInRegs, 0); }
+
+int StackResultCount(int result_count) { return std::max(result_count - kMaxResultsInRegs, 0); }
+
 x86_64::RM OperandForArg(int arg_index, x86_64::Size size) {
   switch (arg_index) {
     case 0:
       return x86_64::Reg(size, 7);  // rdi
-      return x86_64::rdi;
     case 1:
       return x86_64::Reg(size, 6);  // rsi
-      return x86_64::rsi;
     case 2:
       return x86_64::Reg(size, 2);  // rdx
-      return x86_64::rdx;
     case 3:
       return x86_64::Reg(size, 1);  // rcx
-      return x86_64::rcx;
     case 4:
       return x86_64::Reg(size, 8);  // r8
-      return x86_64::r8;
     case 5:
       return x86_64::Reg(size, 9);  // r9
-      return x86_64::r9;
     default:
-      fail("can not handle functions with more than six arguments");
+      return x86_64::Mem::BasePointerDisp(
+          size, kStackArgsOffset + 8 * int32_t(arg_index - kMaxArgsInRegs));
   }
 }
 
-x86_64::RM OperandForResult(int result_index, x86_64::Size size) {
+x86_64::RM OperandForResult(int result_index, int arg_count, x86_64::Size size) {
   switch (result_index) {
     case 0:
       return x86_64::Reg(size, 0);  // rax
     case 1:
       return x86_64::Reg(size, 2);  // rdx
     default:
-      fail("can not handle functions with more than two return values");
+      return x86_64::Mem::BasePointerDisp(
+          size, kStackArgsOffset + 8 * int32_t(StackArgCount(arg_count)) +
+                    8 * int32_t(result_index - kMaxResultsInRegs));
   }
 }
 
@@ -78,7 +98,7 @@ x86_64::RM ColorAndSizeToOperand(ir_info::color_t color, x86_64::Size size) {
   } else if (4 <= color && color <= 13) {
     return x86_64::Reg(size, color + 2);
   } else {
-    return x86_64::Mem::BasePointerDisp(size, int32_t(-8 * (color - 14)));
+    return x86_64::Mem::BasePointerDisp(size, int32_t(-8 * (color - kFirstSpillColor + 1)));
   }
 }
 
@@ -94,7 +114,10 @@ ir_info::color_t OperandToColor(x86_64::RM operand) {
     }
   } else if (operand.is_mem()) {
     int32_t disp = operand.mem().disp();
-    return ir_info::color_t((disp / -8) + 14);
+    if (operand.mem().base_reg() != x86_64::rbp.reg() || disp >= 0) {
+      fail("attempted to convert stack arg or result to interference graph color");
+    }
+    return ir_info::color_t((disp / -8) - 1 + kFirstSpillColor);
   } else {
     fail("attempted to convert unexpected x86_64 RM to interference graph color");
   }
@@ -104,7 +127,8 @@ namespace {
 
 void AddPreferredColorsForFuncArgs(const ir::Func* func,
                                    ir_info::InterferenceGraphColors& preferred_colors) {
-  for (size_t arg_index = 0; arg_index < func->args().size(); arg_index++) {
+  for (size_t arg_index = 0; arg_index < func->args().size() && arg_index < size_t(kMaxArgsInRegs);
+       arg_index++) {
     ir::value_num_t arg_value = func->args().at(arg_index)->number();
     x86_64::RM arg_operand = OperandForArg(int(arg_index), x86_64::Size::k64);
     preferred_colors.SetColor(arg_value, OperandToColor(arg_operand));
@@ -113,7 +137,9 @@ void AddPreferredColorsForFuncArgs(const ir::Func* func,
 
 void AddPreferredColorsForFuncResults(const ir::ReturnInstr* return_instr,
                                       ir_info::InterferenceGraphColors& preferred_colors) {
-  for (size_t result_index = 0; result_index < return_instr->args().size(); result_index++) {
+  for (size_t result_index = 0;
+       result_index < return_instr->args().size() && result_index < size_t(kMaxResultsInRegs);
+       result_index++) {
     ir::value_num_t result_value;
     if (ir::Value* v = return_instr->args().at(result_index).get();
         v->kind() == ir::Value::Kind::kComputed) {
@@ -121,11 +147,177 @@ void AddPreferredColorsForFuncResults(const ir::ReturnInstr* return_instr,
     } else {
       continue;
     }
-    x86_64::RM result_operand = OperandForResult(int(result_index), x86_64::Size::k64);
+    x86_64::RM result_operand =
+        OperandForResult(int(result_index), /*arg_count=*/0, x86_64::Size::k64);
     preferred_colors.SetColor(result_value, OperandToColor(result_operand));
   }
 }
 
+// Estimates the cost of spilling each value as the number of its definitions and uses, weighted by
+// the expected execution frequency of the blocks containing them. Each level of loop nesting is
+// assumed to multiply the execution frequency by eight.
+std::unordered_map<ir::value_num_t, int64_t> ComputeSpillCosts(const ir::Func* func) {
+  constexpr int64_t kMaxLoopDepth = 6;
+  const ir_info::LoopInfo loop_info = ir_analyzers::FindLoopsInFunc(func);
+  std::unordered_map<ir::value_num_t, int64_t> spill_costs;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    int64_t loop_depth = std::min(loop_info.LoopDepthOfBlock(block->number()), kMaxLoopDepth);
+    int64_t weight = int64_t{1} << (3 * loop_depth);
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      for (const std::shared_ptr<ir::Computed>& defined_value : instr->DefinedValues()) {
+        spill_costs[defined_value->number()] += weight;
+      }
+      for (std::shared_ptr<ir::Value> used_value : instr->UsedValues()) {
+        if (used_value->kind() == ir::Value::Kind::kInherited) {
+          used_value = std::static_pointer_cast<ir::InheritedValue>(used_value)->value();
+        }
+        if (used_value->kind() == ir::Value::Kind::kComputed) {
+          spill_costs[static_cast<ir::Computed*>(used_value.get())->number()] += weight;
+        }
+      }
+    }
+  }
+  return spill_costs;
+}
+
+bool FuncMakesCalls(const ir::Func* func) {
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      switch (instr->instr_kind()) {
+        case ir::InstrKind::kCall:
+        case ir::InstrKind::kMalloc:
+        case ir::InstrKind::kFree:
+          return true;
+        default:
+          break;
+      }
+    }
+  }
+  return false;
+}
+
+// Values in callee saved registers require the func to save and restore the registers. Funcs that
+// make no calls can use unused caller saved registers instead, which is done by swapping colors.
+ir_info::InterferenceGraphColors MoveValuesToCallerSavedRegs(
+    const ir_info::InterferenceGraph& graph, const ir_info::InterferenceGraphColors& colors) {
+  const std::unordered_set<ir_info::color_t> used_colors = colors.GetColors(graph.values());
+  std::vector<ir_info::color_t> unused_caller_saved_colors;
+  for (ir_info::color_t color = 0; color < kFirstSpillColor; color++) {
+    if (!used_colors.contains(color) &&
+        SavingBehaviourForReg(ColorAndSizeToOperand(color, x86_64::k64).reg()) ==
+            RegSavingBehaviour::kByCaller) {
+      unused_caller_saved_colors.push_back(color);
+    }
+  }
+  std::unordered_map<ir_info::color_t, ir_info::color_t> color_swaps;
+  for (ir_info::color_t color = 0;
+       color < kFirstSpillColor && color_swaps.size() < unused_caller_saved_colors.size();
+       color++) {
+    if (used_colors.contains(color) &&
+        SavingBehaviourForReg(ColorAndSizeToOperand(color, x86_64::k64).reg()) ==
+            RegSavingBehaviour::kByCallee) {
+      color_swaps.insert({color, unused_caller_saved_colors.at(color_swaps.size())});
+    }
+  }
+  ir_info::InterferenceGraphColors result_colors;
+  for (ir::value_num_t value : graph.values()) {
+    ir_info::color_t color = colors.GetColor(value);
+    if (auto it = color_swaps.find(color); it != color_swaps.end()) {
+      color = it->second;
+    }
+    result_colors.SetColor(value, color);
+  }
+  return result_colors;
+}
+
+// Returns the values connected to each value by mov instrs. Most mov instrs originate from
+// resolved phis and become no-ops if their origin and result share the same location.
+std::unordered_map<ir::value_num_t, std::vector<ir::value_num_t>> FindMoveRelatedValues(
+    const ir::Func* func) {
+  std::unordered_map<ir::value_num_t, std::vector<ir::value_num_t>> move_related_values;
+  for (const std::unique_ptr<ir::Block>& block : func->blocks()) {
+    for (const std::unique_ptr<ir::Instr>& instr : block->instrs()) {
+      if (instr->instr_kind() != ir::InstrKind::kMov) {
+        continue;
+      }
+      auto mov_instr = static_cast<ir::MovInstr*>(instr.get());
+      if (mov_instr->origin()->kind() != ir::Value::Kind::kComputed) {
+        continue;
+      }
+      ir::value_num_t result = mov_instr->result()->number();
+      ir::value_num_t origin = static_cast<ir::Computed*>(mov_instr->origin().get())->number();
+      move_related_values[result].push_back(origin);
+      move_related_values[origin].push_back(result);
+    }
+  }
+  return move_related_values;
+}
+
+// Assigns spill slots to the values that did not receive a register. Spilled values only conflict
+// with spilled neighbors in the interference graph, so slots get shared by all spilled values that
+// do not interfere. A value gets the slot of a value it is moved from or to if possible, which
+// turns the mov into a no-op. Otherwise it gets the lowest free slot. Values get slots in order of
+// decreasing spill cost, such that frequently used values get slots close to the base pointer,
+// which have shorter encodings.
+ir_info::InterferenceGraphColors AllocateSpillSlots(
+    const ir::Func* func, const ir_info::InterferenceGraph& graph,
+    const std::unordered_map<ir::value_num_t, int64_t>& spill_costs,
+    const ir_info::InterferenceGraphColors& colors) {
+  ir_info::InterferenceGraphColors result_colors;
+  std::vector<ir::value_num_t> spilled_values;
+  for (ir::value_num_t value : graph.values()) {
+    ir_info::color_t color = colors.GetColor(value);
+    if (color < kFirstSpillColor) {
+      result_colors.SetColor(value, color);
+    } else {
+      spilled_values.push_back(value);
+    }
+  }
+  if (spilled_values.empty()) {
+    return result_colors;
+  }
+  auto spill_cost = [&spill_costs](ir::value_num_t value) -> int64_t {
+    auto it = spill_costs.find(value);
+    return (it != spill_costs.end()) ? it->second : 0;
+  };
+  std::sort(spilled_values.begin(), spilled_values.end(),
+            [&](ir::value_num_t a, ir::value_num_t b) {
+              int64_t cost_a = spill_cost(a);
+              int64_t cost_b = spill_cost(b);
+              return (cost_a != cost_b) ? cost_a > cost_b : a < b;
+            });
+  const std::unordered_map<ir::value_num_t, std::vector<ir::value_num_t>> move_related_values =
+      FindMoveRelatedValues(func);
+  std::unordered_map<ir::value_num_t, ir_info::color_t> slots;
+  for (ir::value_num_t value : spilled_values) {
+    std::unordered_set<ir_info::color_t> neighbor_slots;
+    for (ir::value_num_t neighbor : graph.GetNeighbors(value)) {
+      if (auto it = slots.find(neighbor); it != slots.end()) {
+        neighbor_slots.insert(it->second);
+      }
+    }
+    ir_info::color_t slot = ir_info::kNoColor;
+    if (auto it = move_related_values.find(value); it != move_related_values.end()) {
+      for (ir::value_num_t related_value : it->second) {
+        auto slot_it = slots.find(related_value);
+        if (slot_it != slots.end() && !neighbor_slots.contains(slot_it->second)) {
+          slot = slot_it->second;
+          break;
+        }
+      }
+    }
+    if (slot == ir_info::kNoColor) {
+      for (slot = kFirstSpillColor; neighbor_slots.contains(slot); slot++) {
+      }
+    }
+    slots.insert({value, slot});
+    result_colors.SetColor(value, slot);
+  }
+  return result_colors;
+}
+
+}  // namespace
+
 const ir_info::InterferenceGraphColors AllocateRegistersInFunc(
     const ir::Func* func, const ir_info::InterferenceGraph& graph) {
   ir_info::InterferenceGraphColors preferred_colors;
@@ -142,11 +334,15 @@ const ir_info::InterferenceGraphColors AllocateRegistersInFunc(
     AddPreferredColorsForFuncResults(return_instr, preferred_colors);
   }
 
-  return ir_analyzers::ColorInterferenceGraph(graph, preferred_colors);
+  const std::unordered_map<ir::value_num_t, int64_t> spill_costs = ComputeSpillCosts(func);
+  ir_info::InterferenceGraphColors colors =
+      ir_analyzers::ColorInterferenceGraph(graph, preferred_colors, spill_costs);
+  if (!FuncMakesCalls(func)) {
+    colors = MoveValuesToCallerSavedRegs(graph, colors);
+  }
+  return AllocateSpillSlots(func, graph, spill_costs, colors);
 }
 
-}  // namespace
-
 std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraphColors> AllocateRegisters(
     const ir::Program* program,
     const std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph>&
@@ -12,6 +12,7 @@
 #include <unordered_map>
 
 #include "src/ir/info/interference_graph.h"
+#include "src/ir/representation/func.h"
 #include "src/ir/representation/num_types.h"
 #include "src/ir/representation/program.h"
 #include "src/x86_64/ops.h"
@@ -23,14 +24,30 @@ enum class RegSavingBehaviour {
   kByCallee,
 };
 
+// The first six args and the first two results get passed in registers. Further args get passed on
+// the stack, pushed by the caller in reverse order such that they are located directly above the
+// return address. Further results get returned through a buffer reserved by the caller directly
+// above the stack args.
+constexpr int kMaxArgsInRegs = 6;
+constexpr int kMaxResultsInRegs = 2;
+
+int StackArgCount(int arg_count);
+int StackResultCount(int result_count);
+
+// Returns the location of the arg with the given index as seen by the called func.
 x86_64::RM OperandForArg(int arg_index, x86_64::Size size);
-x86_64::RM OperandForResult(int result_index, x86_64::Size size);
+// Returns the location of the result with the given index as seen by the called func, which has
+// the given number of args.
+x86_64::RM OperandForResult(int result_index, int arg_count, x86_64::Size size);
 
 RegSavingBehaviour SavingBehaviourForReg(x86_64::Reg reg);
 
 x86_64::RM ColorAndSizeToOperand(ir_info::color_t color, x86_64::Size size);
 ir_info::color_t OperandToColor(x86_64::RM operand);
 
+const ir_info::InterferenceGraphColors AllocateRegistersInFunc(
+    const ir::Func* func, const ir_info::InterferenceGraph& graph);
+
 std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraphColors> AllocateRegisters(
     const ir::Program* program,
     const std::unordered_map<ir::func_num_t, const ir_info::InterferenceGraph>&
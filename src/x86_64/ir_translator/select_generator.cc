@@ -0,0 +1,302 @@
+//
+//  select_generator.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/22/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "select_generator.h"
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/ir/representation/block.h"
+#include "src/ir/representation/num_types.h"
+#include "src/ir/representation/types.h"
+#include "src/ir/representation/values.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/instrs/instr_cond.h"
+#include "src/x86_64/ir_translator/mov_generator.h"
+#include "src/x86_64/ir_translator/temporary_reg.h"
+#include "src/x86_64/ir_translator/value_translator.h"
+#include "src/x86_64/ops.h"
+
+namespace ir_to_x86_64_translator {
+namespace {
+
+// Branches with more movs are likely to cost more when executed as conditional moves than a
+// mispredicted branch.
+constexpr std::size_t kMaxMovsPerBranch = 4;
+
+std::vector<const ir::MovInstr*> MovsOfBranch(const ir::Func* ir_func,
+                                              ir::block_num_t ir_branch_num) {
+  std::vector<const ir::MovInstr*> ir_movs;
+  if (ir_branch_num == ir::kNoBlockNum) {
+    return ir_movs;
+  }
+  const ir::Block* ir_branch = ir_func->GetBlock(ir_branch_num);
+  ir_movs.reserve(ir_branch->instrs().size() - 1);
+  for (auto it = ir_branch->instrs().begin(); it != ir_branch->instrs().end() - 1; ++it) {
+    ir_movs.push_back(static_cast<const ir::MovInstr*>(it->get()));
+  }
+  return ir_movs;
+}
+
+// Returns the block the given branch jumps to, if the branch only consists of movs and a jump.
+// Otherwise, returns ir::kNoBlockNum.
+ir::block_num_t JoinBlockOfBranch(const ir::Func* ir_func, const ir::Block* ir_branching_block,
+                                  ir::block_num_t ir_branch_num) {
+  const ir::Block* ir_branch = ir_func->GetBlock(ir_branch_num);
+  if (ir_branch == ir_branching_block || ir_branch->parents().size() != 1 ||
+      ir_branch->instrs().size() > kMaxMovsPerBranch + 1) {
+    return ir::kNoBlockNum;
+  }
+  const ir::Instr* ir_control_flow_instr = ir_branch->instrs().back().get();
+  if (ir_control_flow_instr->instr_kind() != ir::InstrKind::kJump) {
+    return ir::kNoBlockNum;
+  }
+  for (auto it = ir_branch->instrs().begin(); it != ir_branch->instrs().end() - 1; ++it) {
+    if ((*it)->instr_kind() != ir::InstrKind::kMov) {
+      return ir::kNoBlockNum;
+    }
+  }
+  ir::block_num_t ir_join_block_num =
+      static_cast<const ir::JumpInstr*>(ir_control_flow_instr)->destination();
+  if (ir_join_block_num == ir_branching_block->number() || ir_join_block_num == ir_branch_num) {
+    return ir::kNoBlockNum;
+  }
+  return ir_join_block_num;
+}
+
+std::optional<ir_info::color_t> ColorOf(ir::Value* ir_value, const FuncContext& ctx) {
+  if (ir_value->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  return ctx.interference_graph_colors().GetColor(static_cast<ir::Computed*>(ir_value)->number());
+}
+
+// Returns if the movs of the conditional branch can be executed after the movs of the
+// unconditional branch, which is the case if the unconditional movs do not overwrite any values
+// moved by the conditional movs.
+bool CanExecuteAfter(const std::vector<const ir::MovInstr*>& ir_conditional_movs,
+                     const std::vector<const ir::MovInstr*>& ir_unconditional_movs,
+                     const FuncContext& ctx) {
+  std::unordered_set<ir_info::color_t> overwritten_colors;
+  for (const ir::MovInstr* ir_mov : ir_unconditional_movs) {
+    overwritten_colors.insert(*ColorOf(ir_mov->result().get(), ctx));
+  }
+  for (const ir::MovInstr* ir_mov : ir_conditional_movs) {
+    std::optional<ir_info::color_t> color = ColorOf(ir_mov->origin().get(), ctx);
+    if (color.has_value() && overwritten_colors.contains(*color)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::optional<Select> FindSelect(const ir::Block* ir_block, const FuncContext& ctx) {
+  const ir::Func* ir_func = ctx.ir_func();
+  if (ir_block->instrs().empty() ||
+      ir_block->instrs().back()->instr_kind() != ir::InstrKind::kJumpCond) {
+    return std::nullopt;
+  }
+  auto ir_jump_cond_instr = static_cast<const ir::JumpCondInstr*>(ir_block->instrs().back().get());
+  if (ir_jump_cond_instr->condition()->kind() != ir::Value::Kind::kComputed) {
+    return std::nullopt;
+  }
+  ir::block_num_t ir_true_num = ir_jump_cond_instr->destination_true();
+  ir::block_num_t ir_false_num = ir_jump_cond_instr->destination_false();
+  if (ir_true_num == ir_false_num) {
+    return std::nullopt;
+  }
+  ir::block_num_t ir_true_join_num = JoinBlockOfBranch(ir_func, ir_block, ir_true_num);
+  ir::block_num_t ir_false_join_num = JoinBlockOfBranch(ir_func, ir_block, ir_false_num);
+  if (ir_true_join_num != ir::kNoBlockNum && ir_true_join_num == ir_false_join_num) {
+    std::vector<const ir::MovInstr*> ir_true_movs = MovsOfBranch(ir_func, ir_true_num);
+    std::vector<const ir::MovInstr*> ir_false_movs = MovsOfBranch(ir_func, ir_false_num);
+    if (CanExecuteAfter(ir_true_movs, ir_false_movs, ctx)) {
+      return Select{.unconditional_branch = ir_false_num,
+                    .conditional_branch = ir_true_num,
+                    .conditional_branch_is_true_destination = true,
+                    .join_block = ir_true_join_num};
+    } else if (CanExecuteAfter(ir_false_movs, ir_true_movs, ctx)) {
+      return Select{.unconditional_branch = ir_true_num,
+                    .conditional_branch = ir_false_num,
+                    .conditional_branch_is_true_destination = false,
+                    .join_block = ir_true_join_num};
+    }
+  } else if (ir_true_join_num == ir_false_num) {
+    // The movs for the direct jump to the join block precede the conditional jump.
+    return Select{.conditional_branch = ir_true_num,
+                  .conditional_branch_is_true_destination = true,
+                  .join_block = ir_false_num};
+  } else if (ir_false_join_num == ir_true_num) {
+    return Select{.conditional_branch = ir_false_num,
+                  .conditional_branch_is_true_destination = false,
+                  .join_block = ir_true_num};
+  }
+  return std::nullopt;
+}
+
+// Returns if the mov of the conditional branch and the mov of the unconditional branch select
+// between true and false, such that setcc can set the result directly.
+bool SelectsBetweenBoolConstants(const ir::MovInstr* ir_conditional_mov,
+                                 const ir::MovInstr* ir_unconditional_mov) {
+  ir::Value* ir_conditional_origin = ir_conditional_mov->origin().get();
+  ir::Value* ir_unconditional_origin = ir_unconditional_mov->origin().get();
+  if (ir_conditional_origin->kind() != ir::Value::Kind::kConstant ||
+      ir_conditional_origin->type()->type_kind() != ir::TypeKind::kBool ||
+      ir_unconditional_origin->kind() != ir::Value::Kind::kConstant ||
+      ir_unconditional_origin->type()->type_kind() != ir::TypeKind::kBool) {
+    return false;
+  }
+  return static_cast<ir::BoolConstant*>(ir_conditional_origin)->value() !=
+         static_cast<ir::BoolConstant*>(ir_unconditional_origin)->value();
+}
+
+// Returns the movs of the unconditional branch that can get replaced by setcc, mapped to the
+// corresponding movs of the conditional branch. Results also moved by other movs or read by any
+// mov are excluded, since setcc replaces both movs at the position of the conditional mov.
+std::unordered_map<const ir::MovInstr*, const ir::MovInstr*> FindSetccMovs(
+    const std::vector<const ir::MovInstr*>& ir_conditional_movs,
+    const std::vector<const ir::MovInstr*>& ir_unconditional_movs) {
+  std::unordered_map<ir::value_num_t, int64_t> result_counts;
+  std::unordered_set<ir::value_num_t> read_values;
+  for (const auto& ir_movs : {ir_conditional_movs, ir_unconditional_movs}) {
+    for (const ir::MovInstr* ir_mov : ir_movs) {
+      result_counts[ir_mov->result()->number()]++;
+      if (ir_mov->origin()->kind() == ir::Value::Kind::kComputed) {
+        read_values.insert(static_cast<ir::Computed*>(ir_mov->origin().get())->number());
+      }
+    }
+  }
+  std::unordered_map<const ir::MovInstr*, const ir::MovInstr*> ir_setcc_movs;
+  for (const ir::MovInstr* ir_conditional_mov : ir_conditional_movs) {
+    ir::value_num_t result_num = ir_conditional_mov->result()->number();
+    if (result_counts.at(result_num) != 2 || read_values.contains(result_num)) {
+      continue;
+    }
+    for (const ir::MovInstr* ir_unconditional_mov : ir_unconditional_movs) {
+      if (ir_unconditional_mov->result()->number() == result_num &&
+          SelectsBetweenBoolConstants(ir_conditional_mov, ir_unconditional_mov)) {
+        ir_setcc_movs.insert({ir_unconditional_mov, ir_conditional_mov});
+      }
+    }
+  }
+  return ir_setcc_movs;
+}
+
+void GenerateConditionalMov(x86_64::InstrCond x86_64_cond, const ir::MovInstr* ir_mov,
+                            const ir::Instr* ir_jump_cond_instr, BlockContext& ctx) {
+  x86_64::RM x86_64_result = TranslateComputed(ir_mov->result().get(), ctx.func_ctx());
+  x86_64::Operand x86_64_origin =
+      TranslateValue(ir_mov->origin().get(), IntNarrowing::kNone, ctx.func_ctx());
+  if (x86_64_result == x86_64_origin) {
+    return;
+  }
+  // cmov has no 8-bit form, which gets replaced by the 32-bit form on registers:
+  x86_64::Size x86_64_size = x86_64_result.size();
+  x86_64::Size x86_64_cmov_size = (x86_64_size == x86_64::k8) ? x86_64::k32 : x86_64_size;
+
+  std::optional<TemporaryReg> origin_tmp;
+  if (x86_64_origin.is_imm() || (x86_64_size == x86_64::k8 && x86_64_origin.is_mem())) {
+    origin_tmp = TemporaryReg::ForOperand(x86_64_origin, /*can_use_result_reg=*/false,
+                                          ir_jump_cond_instr, ctx);
+    x86_64_origin = origin_tmp->reg();
+  }
+  std::optional<TemporaryReg> result_tmp;
+  if (x86_64_result.is_mem()) {
+    result_tmp = TemporaryReg::ForOperand(x86_64_result, /*can_use_result_reg=*/false,
+                                          ir_jump_cond_instr, ctx);
+  }
+  x86_64::Reg x86_64_result_reg = result_tmp.has_value() ? result_tmp->reg() : x86_64_result.reg();
+
+  x86_64::RM x86_64_cmov_origin = x86_64_origin.is_reg()
+                                      ? x86_64::RM(x86_64::Resize(x86_64_origin.reg(),
+                                                                  x86_64_cmov_size))
+                                      : x86_64_origin.rm();
+  ctx.x86_64_block()->AddInstr<x86_64::Cmov>(
+      x86_64_cond, x86_64::Resize(x86_64_result_reg, x86_64_cmov_size), x86_64_cmov_origin);
+
+  if (result_tmp.has_value()) {
+    ctx.x86_64_block()->AddInstr<x86_64::Mov>(x86_64_result, result_tmp->reg());
+    result_tmp->Restore(ctx);
+  }
+  if (origin_tmp.has_value()) {
+    origin_tmp->Restore(ctx);
+  }
+}
+
+}  // namespace
+
+void FindSelectsInFunc(FuncContext& ctx) {
+  for (auto& ir_block : ctx.ir_func()->blocks()) {
+    if (std::optional<Select> select = FindSelect(ir_block.get(), ctx)) {
+      ctx.AddSelect(ir_block->number(), select.value());
+    }
+  }
+}
+
+void GenerateSelect(ir::JumpCondInstr* ir_jump_cond_instr, const Select& select,
+                    BlockContext& ctx) {
+  const ir::Func* ir_func = ctx.ir_func();
+  std::vector<const ir::MovInstr*> ir_conditional_movs =
+      MovsOfBranch(ir_func, select.conditional_branch);
+  std::vector<const ir::MovInstr*> ir_unconditional_movs =
+      MovsOfBranch(ir_func, select.unconditional_branch);
+
+  // Live ranges only cover values of the branching block. The values moved by the branches are not
+  // available as temporary registers:
+  for (const auto& ir_movs : {ir_conditional_movs, ir_unconditional_movs}) {
+    for (const ir::MovInstr* ir_mov : ir_movs) {
+      for (ir::Value* ir_value : {static_cast<ir::Value*>(ir_mov->result().get()),
+                                  ir_mov->origin().get()}) {
+        if (std::optional<ir_info::color_t> color = ColorOf(ir_value, ctx.func_ctx())) {
+          ctx.AddTemporaryColorUsedDuringInstr(ir_jump_cond_instr, *color);
+        }
+      }
+    }
+  }
+
+  // The condition gets tested first, since the branch movs might overwrite it:
+  x86_64::RM x86_64_condition = TranslateComputed(
+      static_cast<ir::Computed*>(ir_jump_cond_instr->condition().get()), ctx.func_ctx());
+  ctx.x86_64_block()->AddInstr<x86_64::Test>(x86_64_condition, x86_64::Imm(int8_t{-1}));
+  x86_64::InstrCond x86_64_cond = select.conditional_branch_is_true_destination
+                                      ? x86_64::InstrCond::kNoZero
+                                      : x86_64::InstrCond::kZero;
+  x86_64::InstrCond x86_64_inverted_cond = select.conditional_branch_is_true_destination
+                                               ? x86_64::InstrCond::kZero
+                                               : x86_64::InstrCond::kNoZero;
+
+  std::unordered_map<const ir::MovInstr*, const ir::MovInstr*> ir_setcc_movs =
+      FindSetccMovs(ir_conditional_movs, ir_unconditional_movs);
+  std::unordered_set<const ir::MovInstr*> ir_setcc_conditional_movs;
+  for (const ir::MovInstr* ir_mov : ir_unconditional_movs) {
+    if (auto it = ir_setcc_movs.find(ir_mov); it != ir_setcc_movs.end()) {
+      ir_setcc_conditional_movs.insert(it->second);
+      continue;
+    }
+    x86_64::RM x86_64_result = TranslateComputed(ir_mov->result().get(), ctx.func_ctx());
+    x86_64::Operand x86_64_origin =
+        TranslateValue(ir_mov->origin().get(), IntNarrowing::kNone, ctx.func_ctx());
+    GenerateMov(x86_64_result, x86_64_origin, ir_jump_cond_instr, ctx);
+  }
+  for (const ir::MovInstr* ir_mov : ir_conditional_movs) {
+    if (ir_setcc_conditional_movs.contains(ir_mov)) {
+      bool conditional_value = static_cast<ir::BoolConstant*>(ir_mov->origin().get())->value();
+      x86_64::RM x86_64_result = TranslateComputed(ir_mov->result().get(), ctx.func_ctx());
+      ctx.x86_64_block()->AddInstr<x86_64::Setcc>(
+          conditional_value ? x86_64_cond : x86_64_inverted_cond, x86_64_result);
+      continue;
+    }
+    GenerateConditionalMov(x86_64_cond, ir_mov, ir_jump_cond_instr, ctx);
+  }
+}
+
+}  // namespace ir_to_x86_64_translator
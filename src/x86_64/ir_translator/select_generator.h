@@ -0,0 +1,30 @@
+//
+//  select_generator.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/22/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef ir_to_x86_64_translator_select_generator_h
+#define ir_to_x86_64_translator_select_generator_h
+
+#include "src/ir/representation/instrs.h"
+#include "src/x86_64/ir_translator/context.h"
+
+namespace ir_to_x86_64_translator {
+
+// Finds conditional jumps to diamonds and triangles whose branches only move values to the phi
+// results of the join block (after phi resolution) and records them as selects. Diamonds only get
+// converted if the movs of one branch do not overwrite the values moved by the other branch.
+void FindSelectsInFunc(FuncContext& ctx);
+
+// Generates the movs of the unconditional branch and the conditional moves (or setcc for bools
+// selected from constants) of the conditional branch of the select ending the block. Does not
+// generate the jump to the join block.
+void GenerateSelect(ir::JumpCondInstr* ir_jump_cond_instr, const Select& select,
+                    BlockContext& ctx);
+
+}  // namespace ir_to_x86_64_translator
+
+#endif /* ir_to_x86_64_translator_select_generator_h */
@@ -128,9 +128,19 @@ std::optional<std::pair<x86_64::Reg, ir_info::color_t>> FindRegWithSizeAndColorI
 std::optional<TemporaryReg> TemporaryReg::PrepareFromUnusedInFunc(x86_64::Size x86_64_size,
                                                                   const ir::Instr* instr,
                                                                   BlockContext& ctx) {
-  auto reg_and_color = FindRegWithSizeAndColorIf(
-      x86_64_size, instr, ctx,
-      [ctx](ir_info::color_t color) { return !ctx.func_ctx().used_colors().contains(color); });
+  // Caller saved registers are preferred since callee saved registers would need to get saved in
+  // the func prologue:
+  auto reg_and_color =
+      FindRegWithSizeAndColorIf(x86_64_size, instr, ctx, [ctx](ir_info::color_t color) {
+        return !ctx.func_ctx().used_colors().contains(color) &&
+               SavingBehaviourForReg(ColorAndSizeToOperand(color, x86_64::k64).reg()) ==
+                   RegSavingBehaviour::kByCaller;
+      });
+  if (!reg_and_color) {
+    reg_and_color = FindRegWithSizeAndColorIf(
+        x86_64_size, instr, ctx,
+        [ctx](ir_info::color_t color) { return !ctx.func_ctx().used_colors().contains(color); });
+  }
   if (reg_and_color) {
     auto [reg, color] = reg_and_color.value();
     ctx.func_ctx().AddUsedColor(color);
@@ -68,7 +68,8 @@ x86_64::Imm TranslateIntConstant(ir::IntConstant* constant, IntNarrowing narrowi
     }
     case IntType::kU64: {
       Int value = constant->value();
-      if (narrowing == IntNarrowing::k64To32BitIfPossible && value.CanConvertTo(IntType::kU32)) {
+      // 32-bit imms get sign extended to 64 bits:
+      if (narrowing == IntNarrowing::k64To32BitIfPossible && value.CanConvertTo(IntType::kI32)) {
         return x86_64::Imm(int32_t(value.AsInt64()));
       } else {
         return x86_64::Imm(int64_t(value.AsInt64()));
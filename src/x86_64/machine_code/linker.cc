@@ -8,9 +8,35 @@
 
 #include "linker.h"
 
+#include <cstdint>
+
+#include "src/common/logging/logging.h"
+
 namespace x86_64 {
 
 using ::common::data::DataView;
+using ::common::logging::fail;
+
+namespace {
+
+// Patches an 8-bit or 32-bit displacement relative to the end of the patched data.
+void Patch(uint8_t* dest_addr, DataView patch_data_view) {
+  int64_t offset = dest_addr - (patch_data_view.base() + patch_data_view.size());
+
+  if (patch_data_view.size() == 1) {
+    if (offset < INT8_MIN || offset > INT8_MAX) {
+      fail("8-bit displacement out of range");
+    }
+    patch_data_view[0x00] = offset & 0x000000FF;
+    return;
+  }
+  patch_data_view[0x00] = (offset >> 0) & 0x000000FF;
+  patch_data_view[0x01] = (offset >> 8) & 0x000000FF;
+  patch_data_view[0x02] = (offset >> 16) & 0x000000FF;
+  patch_data_view[0x03] = (offset >> 24) & 0x000000FF;
+}
+
+}  // namespace
 
 void Linker::AddFuncAddr(int64_t func_id, uint8_t* func_addr) { func_addrs_[func_id] = func_addr; }
 
@@ -18,8 +44,8 @@ void Linker::AddBlockAddr(int64_t block_id, uint8_t* block_addr) {
   block_addrs_[block_id] = block_addr;
 }
 
-void Linker::AddFuncRef(const FuncRef& func_ref, DataView patch_data_view) {
-  func_patches_.push_back(FuncPatch{func_ref, patch_data_view});
+void Linker::AddFuncRef(const FuncRef& func_ref, FuncRefKind kind, DataView patch_data_view) {
+  func_patches_.push_back(FuncPatch{func_ref, kind, patch_data_view});
 }
 
 void Linker::AddBlockRef(const BlockRef& block_ref, DataView patch_data_view) {
@@ -28,28 +54,27 @@ void Linker::AddBlockRef(const BlockRef& block_ref, DataView patch_data_view) {
 
 void Linker::ApplyPatches() const {
   for (auto func_patch : func_patches_) {
-    FuncRef func_ref = func_patch.func_ref;
-    DataView patch_data_view = func_patch.patch_data_view;
-    uint8_t* dest_func_addr = func_addrs_.at(func_ref.func_id());
-    int64_t offset = dest_func_addr - (patch_data_view.base() + 0x04);
-
-    patch_data_view[0x00] = (offset >> 0) & 0x000000FF;
-    patch_data_view[0x01] = (offset >> 8) & 0x000000FF;
-    patch_data_view[0x02] = (offset >> 16) & 0x000000FF;
-    patch_data_view[0x03] = (offset >> 24) & 0x000000FF;
+    Patch(func_addrs_.at(func_patch.func_ref.func_id()), func_patch.patch_data_view);
+  }
+  for (auto block_patch : block_patches_) {
+    Patch(block_addrs_.at(block_patch.block_ref.block_id()), block_patch.patch_data_view);
   }
+}
 
+std::vector<Linker::FuncPatch> Linker::ApplyResolvablePatches() const {
+  std::vector<FuncPatch> unresolved_func_patches;
+  for (auto func_patch : func_patches_) {
+    auto it = func_addrs_.find(func_patch.func_ref.func_id());
+    if (it == func_addrs_.end()) {
+      unresolved_func_patches.push_back(func_patch);
+      continue;
+    }
+    Patch(it->second, func_patch.patch_data_view);
+  }
   for (auto block_patch : block_patches_) {
-    BlockRef block_ref = block_patch.block_ref;
-    DataView patch_data_view = block_patch.patch_data_view;
-    uint8_t* dest_block_addr = block_addrs_.at(block_ref.block_id());
-    int64_t offset = dest_block_addr - (patch_data_view.base() + 0x04);
-
-    patch_data_view[0x00] = (offset >> 0) & 0x000000FF;
-    patch_data_view[0x01] = (offset >> 8) & 0x000000FF;
-    patch_data_view[0x02] = (offset >> 16) & 0x000000FF;
-    patch_data_view[0x03] = (offset >> 24) & 0x000000FF;
+    Patch(block_addrs_.at(block_patch.block_ref.block_id()), block_patch.patch_data_view);
   }
+  return unresolved_func_patches;
 }
 
 }  // namespace x86_64
@@ -21,24 +21,35 @@ namespace x86_64 {
 
 class Linker {
  public:
+  enum class FuncRefKind {
+    kCallOrJumpTarget,  // the rel32 operand of a call or jmp instr
+    kAddress,           // the displacement of a rip relative address, e.g. in a lea instr
+  };
+
+  struct FuncPatch {
+    FuncRef func_ref;
+    FuncRefKind kind;
+    common::data::DataView patch_data_view;
+  };
+
   const std::unordered_map<int64_t, uint8_t*>& func_addrs() const { return func_addrs_; }
 
   void AddFuncAddr(int64_t func_id, uint8_t* func_addr);
   void AddBlockAddr(int64_t block_id, uint8_t* block_addr);
 
-  void AddFuncRef(const FuncRef& func_ref, common::data::DataView patch_data_view);
+  void AddFuncRef(const FuncRef& func_ref, FuncRefKind kind,
+                  common::data::DataView patch_data_view);
   void AddBlockRef(const BlockRef& block_ref, common::data::DataView patch_data_view);
 
   void ApplyPatches() const;
+  // Applies all patches with known destinations and returns the patches referring to funcs without
+  // an address (e.g. external funcs), such that they can be turned into relocations.
+  std::vector<FuncPatch> ApplyResolvablePatches() const;
 
  private:
   std::unordered_map<int64_t, uint8_t*> func_addrs_;
   std::unordered_map<int64_t, uint8_t*> block_addrs_;
 
-  struct FuncPatch {
-    FuncRef func_ref;
-    common::data::DataView patch_data_view;
-  };
   struct BlockPatch {
     BlockRef block_ref;
     common::data::DataView patch_data_view;
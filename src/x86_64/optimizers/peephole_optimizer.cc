@@ -0,0 +1,328 @@
+//
+//  peephole_optimizer.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/7/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "peephole_optimizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+
+#include "src/x86_64/block.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
+#include "src/x86_64/instrs/control_flow_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/instrs/instr.h"
+#include "src/x86_64/instrs/instr_cond.h"
+#include "src/x86_64/ops.h"
+
+namespace x86_64_optimizers {
+namespace {
+
+using ::x86_64::InstrKind;
+
+enum class FlagUse {
+  kNone,
+  kZeroAndSign,
+  kAll,
+};
+
+// Returns which flags get read after the instr at the given index, before they get overwritten.
+FlagUse FindFlagUseAfter(const x86_64::Block* block, std::size_t index) {
+  FlagUse use = FlagUse::kNone;
+  for (std::size_t i = index + 1; i < block->instrs().size(); i++) {
+    const x86_64::Instr* instr = block->instrs().at(i).get();
+    switch (instr->instr_kind()) {
+      case InstrKind::kJcc:
+      case InstrKind::kSetcc:
+      case InstrKind::kCmov: {
+        x86_64::InstrCond cond = [instr]() {
+          switch (instr->instr_kind()) {
+            case InstrKind::kJcc:
+              return static_cast<const x86_64::Jcc*>(instr)->cond();
+            case InstrKind::kSetcc:
+              return static_cast<const x86_64::Setcc*>(instr)->cond();
+            default:
+              return static_cast<const x86_64::Cmov*>(instr)->cond();
+          }
+        }();
+        if (cond != x86_64::InstrCond::kZero && cond != x86_64::InstrCond::kNoZero &&
+            cond != x86_64::InstrCond::kSign && cond != x86_64::InstrCond::kNoSign) {
+          return FlagUse::kAll;
+        }
+        use = FlagUse::kZeroAndSign;
+        break;
+      }
+      case InstrKind::kAdc:
+      case InstrKind::kSbb:
+        return FlagUse::kAll;
+      case InstrKind::kAnd:
+      case InstrKind::kOr:
+      case InstrKind::kXor:
+      case InstrKind::kNeg:
+      case InstrKind::kAdd:
+      case InstrKind::kSub:
+      case InstrKind::kCmp:
+      case InstrKind::kMul:
+      case InstrKind::kImul:
+      case InstrKind::kDiv:
+      case InstrKind::kIdiv:
+      case InstrKind::kTest:
+      case InstrKind::kJmp:
+      case InstrKind::kCall:
+      case InstrKind::kSyscall:
+      case InstrKind::kRet:
+        return use;
+      default:
+        break;
+    }
+  }
+  return use;
+}
+
+bool IsReg(const x86_64::Operand& operand, x86_64::Reg reg) {
+  return operand.is_reg() && operand.reg() == reg;
+}
+
+bool IsImm(const x86_64::Operand& operand, int64_t value) {
+  return operand.is_imm() && operand.imm().value() == value;
+}
+
+x86_64::Imm SmallestImm(int32_t value) {
+  if (std::numeric_limits<int8_t>::min() <= value && value <= std::numeric_limits<int8_t>::max()) {
+    return x86_64::Imm(int8_t(value));
+  }
+  return x86_64::Imm(value);
+}
+
+void RemoveInstrs(x86_64::Block* block, std::size_t index, std::size_t count) {
+  auto it = block->instrs().begin() + index;
+  for (std::size_t i = 0; i < count; i++) {
+    it = block->RemoveInstr(it);
+  }
+}
+
+template <class T, class... Args>
+void ReplaceInstrs(x86_64::Block* block, std::size_t index, std::size_t count, Args&&... args) {
+  RemoveInstrs(block, index, count);
+  block->InsertInstr<T>(block->instrs().begin() + index, args...);
+}
+
+// mov r,r => (nothing)
+// 32-bit moves are kept because they clear the upper half of the 64-bit register.
+bool RemoveSelfMove(x86_64::Block* block, std::size_t index) {
+  const x86_64::Instr* instr = block->instrs().at(index).get();
+  if (instr->instr_kind() != InstrKind::kMov) {
+    return false;
+  }
+  auto mov = static_cast<const x86_64::Mov*>(instr);
+  if (!mov->dst().is_reg() || !IsReg(mov->src(), mov->dst().reg()) ||
+      mov->dst().size() == x86_64::Size::k32) {
+    return false;
+  }
+  RemoveInstrs(block, index, 1);
+  return true;
+}
+
+// mov r,0 => xor r,r
+bool ZeroRegisterWithXor(x86_64::Block* block, std::size_t index) {
+  const x86_64::Instr* instr = block->instrs().at(index).get();
+  if (instr->instr_kind() != InstrKind::kMov) {
+    return false;
+  }
+  auto mov = static_cast<const x86_64::Mov*>(instr);
+  if (!mov->dst().is_reg() || !IsImm(mov->src(), 0) ||
+      FindFlagUseAfter(block, index) != FlagUse::kNone) {
+    return false;
+  }
+  x86_64::Reg reg = mov->dst().reg();
+  if (reg.size() == x86_64::Size::k64) {
+    // The 32-bit xor also clears the upper half and has a shorter encoding:
+    reg = x86_64::Resize(reg, x86_64::Size::k32);
+  }
+  ReplaceInstrs<x86_64::Xor>(block, index, 1, reg, reg);
+  return true;
+}
+
+// mov r,s; add r,imm => lea r,[s+imm]
+// mov r,s; sub r,imm => lea r,[s-imm]
+// mov r,s; add r,t   => lea r,[s+t]
+bool FoldMoveAndAddIntoLea(x86_64::Block* block, std::size_t index) {
+  if (index + 1 >= block->instrs().size()) {
+    return false;
+  }
+  const x86_64::Instr* instr_a = block->instrs().at(index).get();
+  const x86_64::Instr* instr_b = block->instrs().at(index + 1).get();
+  if (instr_a->instr_kind() != InstrKind::kMov ||
+      (instr_b->instr_kind() != InstrKind::kAdd && instr_b->instr_kind() != InstrKind::kSub)) {
+    return false;
+  }
+  auto mov = static_cast<const x86_64::Mov*>(instr_a);
+  auto arithmetic = static_cast<const x86_64::BinaryALInstr*>(instr_b);
+  if (!mov->dst().is_reg() || !mov->src().is_reg()) {
+    return false;
+  }
+  x86_64::Reg dst = mov->dst().reg();
+  x86_64::Reg src = mov->src().reg();
+  if ((dst.size() != x86_64::Size::k32 && dst.size() != x86_64::Size::k64) ||
+      dst.reg() == src.reg() || !IsReg(arithmetic->op_a(), dst) ||
+      FindFlagUseAfter(block, index + 1) != FlagUse::kNone) {
+    return false;
+  }
+  x86_64::Operand offset = arithmetic->op_b();
+  if (offset.is_imm()) {
+    int64_t disp = offset.imm().value();
+    if (instr_b->instr_kind() == InstrKind::kSub) {
+      if (disp == std::numeric_limits<int32_t>::min()) {
+        return false;
+      }
+      disp = -disp;
+    }
+    ReplaceInstrs<x86_64::Lea>(block, index, 2, dst,
+                               x86_64::Mem(dst.size(), /*base_reg=*/uint8_t(src.reg()),
+                                           /*disp=*/int32_t(disp)));
+    return true;
+
+  } else if (offset.is_reg() && instr_b->instr_kind() == InstrKind::kAdd &&
+             offset.reg().reg() != dst.reg()) {
+    uint8_t base_reg = src.reg();
+    uint8_t index_reg = offset.reg().reg();
+    if (index_reg == x86_64::rsp.reg()) {
+      // The stack pointer can not be used as index register:
+      std::swap(base_reg, index_reg);
+    }
+    if (index_reg == x86_64::rsp.reg()) {
+      return false;
+    }
+    ReplaceInstrs<x86_64::Lea>(block, index, 2, dst,
+                               x86_64::Mem(dst.size(), base_reg, index_reg, x86_64::Scale::kS00));
+    return true;
+  }
+  return false;
+}
+
+// Returns the operand compared with zero if the instr is cmp rm,0, test rm,rm, or test rm,-1.
+std::optional<x86_64::RM> OperandComparedWithZero(const x86_64::Instr* instr) {
+  if (instr->instr_kind() == InstrKind::kCmp) {
+    auto cmp = static_cast<const x86_64::Cmp*>(instr);
+    if (IsImm(cmp->op_b(), 0)) {
+      return cmp->op_a();
+    }
+  } else if (instr->instr_kind() == InstrKind::kTest) {
+    auto test = static_cast<const x86_64::Test*>(instr);
+    if (test->op_b() == test->op_a() || IsImm(test->op_b(), -1)) {
+      return test->op_a();
+    }
+  }
+  return std::nullopt;
+}
+
+// cmp r,0 => (nothing) if the preceding instr already set the flags for r or the flags are unused
+// test r,r => (nothing) under the same conditions
+bool RemoveRedundantCompare(x86_64::Block* block, std::size_t index) {
+  std::optional<x86_64::RM> compared = OperandComparedWithZero(block->instrs().at(index).get());
+  if (!compared.has_value()) {
+    return false;
+  }
+  FlagUse use = FindFlagUseAfter(block, index);
+  if (use == FlagUse::kNone) {
+    RemoveInstrs(block, index, 1);
+    return true;
+  }
+  if (index == 0 || !compared->is_reg()) {
+    return false;
+  }
+  const x86_64::Instr* prev_instr = block->instrs().at(index - 1).get();
+  switch (prev_instr->instr_kind()) {
+    case InstrKind::kAnd:
+    case InstrKind::kOr:
+    case InstrKind::kXor:
+      // Logic instrs set all flags used by conditions like the comparison with zero.
+      break;
+    case InstrKind::kAdd:
+    case InstrKind::kSub:
+      // Arithmetic instrs set the carry and overflow flags differently from the comparison.
+      if (use != FlagUse::kZeroAndSign) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+  }
+  auto prev_al_instr = static_cast<const x86_64::BinaryALInstr*>(prev_instr);
+  if (!IsReg(prev_al_instr->op_a(), compared->reg())) {
+    return false;
+  }
+  RemoveInstrs(block, index, 1);
+  return true;
+}
+
+// add rsp,a; sub rsp,b => add rsp,a-b (and similar)
+bool MergeStackAdjustments(x86_64::Block* block, std::size_t index) {
+  if (index + 1 >= block->instrs().size()) {
+    return false;
+  }
+  int64_t delta = 0;
+  for (std::size_t i = index; i < index + 2; i++) {
+    const x86_64::Instr* instr = block->instrs().at(i).get();
+    if (instr->instr_kind() != InstrKind::kAdd && instr->instr_kind() != InstrKind::kSub) {
+      return false;
+    }
+    auto al_instr = static_cast<const x86_64::BinaryALInstr*>(instr);
+    if (!IsReg(al_instr->op_a(), x86_64::rsp) || !al_instr->op_b().is_imm()) {
+      return false;
+    }
+    int64_t value = al_instr->op_b().imm().value();
+    delta += (instr->instr_kind() == InstrKind::kAdd) ? value : -value;
+  }
+  if (delta <= std::numeric_limits<int32_t>::min() || delta > std::numeric_limits<int32_t>::max() ||
+      FindFlagUseAfter(block, index + 1) != FlagUse::kNone) {
+    return false;
+  }
+  if (delta == 0) {
+    RemoveInstrs(block, index, 2);
+  } else if (delta > 0) {
+    ReplaceInstrs<x86_64::Add>(block, index, 2, x86_64::rsp, SmallestImm(int32_t(delta)));
+  } else {
+    ReplaceInstrs<x86_64::Sub>(block, index, 2, x86_64::rsp, SmallestImm(int32_t(-delta)));
+  }
+  return true;
+}
+
+void OptimizePeepholesInBlock(x86_64::Block* block) {
+  std::size_t index = 0;
+  while (index < block->instrs().size()) {
+    if (RemoveSelfMove(block, index) || RemoveRedundantCompare(block, index) ||
+        FoldMoveAndAddIntoLea(block, index) || MergeStackAdjustments(block, index) ||
+        ZeroRegisterWithXor(block, index)) {
+      // The rewritten instrs might form a new pattern with the preceding instr:
+      if (index > 0) {
+        index--;
+      }
+      continue;
+    }
+    index++;
+  }
+}
+
+}  // namespace
+
+void OptimizePeepholesInFunc(x86_64::Func* func) {
+  for (auto& block : func->blocks()) {
+    OptimizePeepholesInBlock(block.get());
+  }
+}
+
+void OptimizePeepholesInProgram(x86_64::Program* program) {
+  for (auto& func : program->defined_funcs()) {
+    OptimizePeepholesInFunc(func.get());
+  }
+}
+
+}  // namespace x86_64_optimizers
@@ -0,0 +1,29 @@
+//
+//  peephole_optimizer.h
+//  Katara
+//
+//  Created by Arne Philipeit on 12/7/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#ifndef x86_64_optimizers_peephole_optimizer_h
+#define x86_64_optimizers_peephole_optimizer_h
+
+#include "src/x86_64/func.h"
+#include "src/x86_64/program.h"
+
+namespace x86_64_optimizers {
+
+// Rewrites short instr sequences within each block into cheaper equivalents:
+// - removes moves of registers to themselves
+// - zeroes registers with xor instead of moving zero into them
+// - folds a register move followed by an addition into lea
+// - removes comparisons that repeat the flags set by the preceding instr or whose flags are unused
+// - merges adjacent stack pointer adjustments
+// Flags are assumed to be dead at the end of each block, which holds for translated IR programs.
+void OptimizePeepholesInFunc(x86_64::Func* func);
+void OptimizePeepholesInProgram(x86_64::Program* program);
+
+}  // namespace x86_64_optimizers
+
+#endif /* x86_64_optimizers_peephole_optimizer_h */
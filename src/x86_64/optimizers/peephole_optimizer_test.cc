@@ -0,0 +1,173 @@
+//
+//  peephole_optimizer_test.cc
+//  Katara
+//
+//  Created by Arne Philipeit on 12/7/22.
+//  Copyright © 2022 Arne Philipeit. All rights reserved.
+//
+
+#include "src/x86_64/optimizers/peephole_optimizer.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/x86_64/block.h"
+#include "src/x86_64/func.h"
+#include "src/x86_64/instrs/arithmetic_logic_instrs.h"
+#include "src/x86_64/instrs/control_flow_instrs.h"
+#include "src/x86_64/instrs/data_instrs.h"
+#include "src/x86_64/ops.h"
+#include "src/x86_64/program.h"
+
+namespace x86_64_optimizers {
+namespace {
+
+using namespace ::x86_64;
+
+std::string InstrsToString(const Block* block) {
+  std::string result;
+  for (auto& instr : block->instrs()) {
+    result += instr->ToString() + "\n";
+  }
+  return result;
+}
+
+TEST(PeepholeOptimizerTest, RemovesSelfMoves) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block = func->AddBlock();
+  block->AddInstr<Mov>(rax, rax);
+  block->AddInstr<Mov>(cx, cx);
+  block->AddInstr<Mov>(edx, edx);
+  block->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block),
+            "mov edx,edx\n"
+            "ret\n");
+}
+
+TEST(PeepholeOptimizerTest, ZeroesRegistersWithXor) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block = func->AddBlock();
+  block->AddInstr<Mov>(rax, Imm(int32_t{0}));
+  block->AddInstr<Mov>(r9d, Imm(int32_t{0}));
+  block->AddInstr<Cmp>(rdi, rsi);
+  block->AddInstr<Mov>(edx, Imm(int32_t{0}));
+  block->AddInstr<Setcc>(InstrCond::kLess, dl);
+  block->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block),
+            "xor eax,eax\n"
+            "xor r9d,r9d\n"
+            "cmp rdi,rsi\n"
+            "mov edx,0x00000000\n"
+            "setl dl\n"
+            "ret\n");
+}
+
+TEST(PeepholeOptimizerTest, FoldsMovesAndAdditionsIntoLea) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block = func->AddBlock();
+  block->AddInstr<Mov>(rax, rdi);
+  block->AddInstr<Add>(rax, Imm(int8_t{8}));
+  block->AddInstr<Mov>(ecx, esi);
+  block->AddInstr<Sub>(ecx, Imm(int32_t{1000}));
+  block->AddInstr<Mov>(rdx, rsp);
+  block->AddInstr<Add>(rdx, rsi);
+  block->AddInstr<Mov>(r8, rdi);
+  block->AddInstr<Add>(r8, rsp);
+  block->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block),
+            "lea rax,[rdi+8]\n"
+            "lea ecx,[rsi-1000]\n"
+            "lea rdx,[rsp+1*rsi]\n"
+            "lea r8,[rsp+1*rdi]\n"
+            "ret\n");
+}
+
+TEST(PeepholeOptimizerTest, KeepsAdditionsSettingUsedFlags) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block_a = func->AddBlock();
+  Block* block_b = func->AddBlock();
+  block_a->AddInstr<Mov>(rax, rdi);
+  block_a->AddInstr<Add>(rax, rsi);
+  block_a->AddInstr<Jcc>(InstrCond::kOverflow, block_b->GetBlockRef());
+  block_a->AddInstr<Mov>(rcx, rdi);
+  block_a->AddInstr<Add>(rcx, rcx);
+  block_b->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block_a),
+            "mov rax,rdi\n"
+            "add rax,rsi\n"
+            "jo BB1\n"
+            "mov rcx,rdi\n"
+            "add rcx,rcx\n");
+}
+
+TEST(PeepholeOptimizerTest, RemovesRedundantCompares) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block_a = func->AddBlock();
+  Block* block_b = func->AddBlock();
+  block_a->AddInstr<And>(rax, rcx);
+  block_a->AddInstr<Cmp>(rax, Imm(int8_t{0}));
+  block_a->AddInstr<Jcc>(InstrCond::kLess, block_b->GetBlockRef());
+  block_a->AddInstr<Sub>(rdx, rcx);
+  block_a->AddInstr<x86_64::Test>(rdx, rdx);
+  block_a->AddInstr<Jcc>(InstrCond::kZero, block_b->GetBlockRef());
+  block_a->AddInstr<Add>(rsi, rcx);
+  block_a->AddInstr<x86_64::Test>(rsi, rsi);
+  block_a->AddInstr<Jcc>(InstrCond::kLess, block_b->GetBlockRef());
+  block_a->AddInstr<Cmp>(rdi, Imm(int8_t{0}));
+  block_b->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block_a),
+            "and rax,rcx\n"
+            "jl BB1\n"
+            "sub rdx,rcx\n"
+            "je BB1\n"
+            "add rsi,rcx\n"
+            "test rsi,rsi\n"
+            "jl BB1\n");
+}
+
+TEST(PeepholeOptimizerTest, MergesStackAdjustments) {
+  Program program;
+  Func* func = program.DefineFunc("f");
+  Block* block = func->AddBlock();
+  block->AddInstr<Sub>(rsp, Imm(int8_t{8}));
+  block->AddInstr<Sub>(rsp, Imm(int32_t{0x100}));
+  block->AddInstr<Push>(rdi);
+  block->AddInstr<Add>(rsp, Imm(int8_t{8}));
+  block->AddInstr<Sub>(rsp, Imm(int8_t{8}));
+  block->AddInstr<Pop>(rdi);
+  block->AddInstr<Add>(rsp, Imm(int32_t{0x100}));
+  block->AddInstr<Add>(rsp, Imm(int8_t{8}));
+  block->AddInstr<Ret>();
+
+  OptimizePeepholesInFunc(func);
+
+  EXPECT_EQ(InstrsToString(block),
+            "sub rsp,0x00000108\n"
+            "push rdi\n"
+            "pop rdi\n"
+            "add rsp,0x00000108\n"
+            "ret\n");
+}
+
+}  // namespace
+}  // namespace x86_64_optimizers
@@ -13,6 +13,7 @@
 namespace x86_64 {
 
 using ::common::data::DataView;
+using ::common::memory::CodeHeap;
 
 func_num_t Program::DeclareFunc(std::string func_name) {
   func_num_t func_num = defined_funcs_.size() + declared_funcs_.size();
@@ -53,6 +54,16 @@ int64_t Program::Encode(Linker& linker, DataView code) const {
   return c;
 }
 
+int64_t Program::Encode(Linker& linker, CodeHeap& code_heap) const {
+  for (auto& func : defined_funcs_) {
+    DataView code = code_heap.BeginAllocation(func->MaxEncodedSize());
+    int64_t r = func->Encode(linker, code);
+    if (r == -1) return -1;
+    code_heap.EndAllocation(r);
+  }
+  return code_heap.code().size();
+}
+
 std::string Program::ToString() const {
   std::stringstream ss;
   for (size_t i = 0; i < defined_funcs_.size(); i++) {
@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "src/common/data/data_view.h"
+#include "src/common/memory/code_heap.h"
 #include "src/x86_64/block.h"
 #include "src/x86_64/func.h"
 #include "src/x86_64/machine_code/linker.h"
@@ -33,6 +34,9 @@ class Program {
   int64_t block_count() const { return block_count_; }
 
   int64_t Encode(Linker& linker, common::data::DataView code) const;
+  // Encodes each func into a separate, cache line aligned allocation in the code heap. Returns the
+  // number of bytes used in the code heap, including alignment padding.
+  int64_t Encode(Linker& linker, common::memory::CodeHeap& code_heap) const;
   std::string ToString() const;
 
  private: